@@ -128,7 +128,8 @@
    G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_ALLOW_ANONYMOUS | \
    G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION | \
    G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING | \
-   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_REQUIRE_SAME_USER)
+   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_REQUIRE_SAME_USER | \
+   G_DBUS_CONNECTION_FLAGS_SHARDED_WORKER_THREAD)
 
 /**
  * SECTION:gdbusconnection
@@ -2608,6 +2609,7 @@ initable_init (GInitable     *initable,
   connection->worker = _g_dbus_worker_new (connection->stream,
                                            connection->capabilities,
                                            ((connection->flags & G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING) != 0),
+                                           ((connection->flags & G_DBUS_CONNECTION_FLAGS_SHARDED_WORKER_THREAD) != 0),
                                            on_worker_message_received,
                                            on_worker_message_about_to_be_sent,
                                            on_worker_closed,
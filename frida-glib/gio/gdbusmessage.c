@@ -54,6 +54,7 @@
 #include "gioerror.h"
 #include "gdbusprivate.h"
 #include "gutilsprivate.h"
+#include "glib-private.h"
 
 #ifdef G_OS_UNIX
 #include "gunixfdlist.h"
@@ -73,6 +74,10 @@ struct _GMemoryBuffer
   gsize pos;
   gchar *data;
   GDataStreamByteOrder byte_order;
+  /* if not NULL, owns @data and large values may be sliced out of it */
+  GBytes *bytes;
+  /* TRUE if validate_value_in_blob() already accepted the data */
+  gboolean validated;
 };
 
 static gboolean
@@ -495,6 +500,13 @@ struct _GDBusMessageClass
  *
  * Since: 2.26
  */
+/* Header fields are kept in a fixed array indexed by field, which covers
+ * every field defined by the D-Bus specification with room to spare. The
+ * specification requires unknown fields to be accepted too, so anything
+ * beyond the array goes to a hash table that is only allocated if needed.
+ */
+#define N_HEADER_SLOTS 16
+
 struct _GDBusMessage
 {
   /*< private >*/
@@ -506,8 +518,16 @@ struct _GDBusMessage
   GDBusMessageByteOrder byte_order;
   guchar major_protocol_version;
   guint32 serial;
-  GHashTable *headers;
-  GVariant *body;
+  GVariant *header_slots[N_HEADER_SLOTS];
+  guint16 header_mask;  /* bit n is set if header_slots[n] is */
+  GHashTable *extra_headers;  /* (nullable) */
+  GVariant *body;  /* (atomic) */
+  /* if not NULL, the body was validated but not parsed yet; it is found
+   * at lazy_body_offset in lazy_blob and is parsed on first use, see
+   * ensure_body(), which then drops lazy_blob (protected by lazy_body) */
+  GBytes *lazy_blob;
+  gsize lazy_body_offset;
+  GVariantType *lazy_body_type;
 #ifdef G_OS_UNIX
   GUnixFDList *fd_list;
 #endif
@@ -521,15 +541,111 @@ enum
 
 G_DEFINE_TYPE (GDBusMessage, g_dbus_message, G_TYPE_OBJECT)
 
+static GVariant *ensure_body (GDBusMessage *message);
+static void clear_lazy_body (GDBusMessage *message);
+
+static inline GVariant *
+lookup_header (GDBusMessage *message,
+               guint         header_field)
+{
+  if (G_LIKELY (header_field < N_HEADER_SLOTS))
+    return message->header_slots[header_field];
+
+  if (message->extra_headers == NULL)
+    return NULL;
+
+  return g_hash_table_lookup (message->extra_headers, GUINT_TO_POINTER (header_field));
+}
+
+/* takes ownership of @value, which may be %NULL to remove the field */
+static void
+store_header (GDBusMessage *message,
+              guint         header_field,
+              GVariant     *value)
+{
+  if (G_LIKELY (header_field < N_HEADER_SLOTS))
+    {
+      if (message->header_slots[header_field] != NULL)
+        g_variant_unref (message->header_slots[header_field]);
+      message->header_slots[header_field] = value;
+
+      if (value != NULL)
+        message->header_mask |= 1 << header_field;
+      else
+        message->header_mask &= ~(1 << header_field);
+    }
+  else if (value != NULL)
+    {
+      if (message->extra_headers == NULL)
+        message->extra_headers = g_hash_table_new_full (g_direct_hash,
+                                                        g_direct_equal,
+                                                        NULL,
+                                                        (GDestroyNotify) g_variant_unref);
+      g_hash_table_insert (message->extra_headers, GUINT_TO_POINTER (header_field), value);
+    }
+  else if (message->extra_headers != NULL)
+    {
+      g_hash_table_remove (message->extra_headers, GUINT_TO_POINTER (header_field));
+    }
+}
+
+static gint
+compare_header_fields (gconstpointer a,
+                       gconstpointer b)
+{
+  return *(const guchar *) a - *(const guchar *) b;
+}
+
+/* Fills @fields with the fields that are set, in ascending order, and
+ * returns how many there are. */
+static guint
+collect_header_fields (GDBusMessage *message,
+                       guchar        fields[256])
+{
+  guint n = 0;
+  guint mask;
+
+  for (mask = message->header_mask; mask != 0; mask &= mask - 1)
+    fields[n++] = g_bit_nth_lsf (mask, -1);
+
+  if (message->extra_headers != NULL)
+    {
+      GHashTableIter iter;
+      gpointer key;
+      guint n_extra = 0;
+
+      g_hash_table_iter_init (&iter, message->extra_headers);
+      while (g_hash_table_iter_next (&iter, &key, NULL))
+        fields[n + n_extra++] = GPOINTER_TO_UINT (key);
+      qsort (fields + n, n_extra, 1, compare_header_fields);
+      n += n_extra;
+    }
+
+  return n;
+}
+
+static void
+clear_headers (GDBusMessage *message)
+{
+  guint mask;
+
+  for (mask = message->header_mask; mask != 0; mask &= mask - 1)
+    g_variant_unref (message->header_slots[g_bit_nth_lsf (mask, -1)]);
+  memset (message->header_slots, 0, sizeof (message->header_slots));
+  message->header_mask = 0;
+
+  g_clear_pointer (&message->extra_headers, g_hash_table_unref);
+}
+
 static void
 g_dbus_message_finalize (GObject *object)
 {
   GDBusMessage *message = G_DBUS_MESSAGE (object);
 
-  if (message->headers != NULL)
-    g_hash_table_unref (message->headers);
+  clear_headers (message);
   if (message->body != NULL)
     g_variant_unref (message->body);
+  clear_lazy_body (message);
 #ifdef G_OS_UNIX
   if (message->fd_list != NULL)
     g_object_unref (message->fd_list);
@@ -602,10 +718,6 @@ g_dbus_message_init (GDBusMessage *message)
   /* this could also be G_PDP_ENDIAN */
   message->byte_order = G_DBUS_MESSAGE_BYTE_ORDER_BIG_ENDIAN;
 #endif
-  message->headers = g_hash_table_new_full (g_direct_hash,
-                                            g_direct_equal,
-                                            NULL,
-                                            (GDestroyNotify) g_variant_unref);
 }
 
 /**
@@ -1040,7 +1152,7 @@ g_dbus_message_get_header (GDBusMessage             *message,
 {
   g_return_val_if_fail (G_IS_DBUS_MESSAGE (message), NULL);
   g_return_val_if_fail ((guint) header_field < 256, NULL);
-  return g_hash_table_lookup (message->headers, GUINT_TO_POINTER (header_field));
+  return lookup_header (message, header_field);
 }
 
 /**
@@ -1069,14 +1181,7 @@ g_dbus_message_set_header (GDBusMessage             *message,
       return;
     }
 
-  if (value == NULL)
-    {
-      g_hash_table_remove (message->headers, GUINT_TO_POINTER (header_field));
-    }
-  else
-    {
-      g_hash_table_insert (message->headers, GUINT_TO_POINTER (header_field), g_variant_ref_sink (value));
-    }
+  store_header (message, header_field, (value != NULL) ? g_variant_ref_sink (value) : NULL);
 }
 
 /**
@@ -1094,22 +1199,16 @@ g_dbus_message_set_header (GDBusMessage             *message,
 guchar *
 g_dbus_message_get_header_fields (GDBusMessage  *message)
 {
-  GList *keys;
+  guchar fields[256];
   guchar *ret;
-  guint num_keys;
-  GList *l;
   guint n;
 
   g_return_val_if_fail (G_IS_DBUS_MESSAGE (message), NULL);
 
-  keys = g_hash_table_get_keys (message->headers);
-  num_keys = g_list_length (keys);
-  ret = g_new (guchar, num_keys + 1);
-  for (l = keys, n = 0; l != NULL; l = l->next, n++)
-    ret[n] = GPOINTER_TO_UINT (l->data);
-  g_assert (n == num_keys);
+  n = collect_header_fields (message, fields);
+  ret = g_new (guchar, n + 1);
+  memcpy (ret, fields, n);
   ret[n] = G_DBUS_MESSAGE_HEADER_FIELD_INVALID;
-  g_list_free (keys);
 
   return ret;
 }
@@ -1131,7 +1230,7 @@ GVariant *
 g_dbus_message_get_body (GDBusMessage  *message)
 {
   g_return_val_if_fail (G_IS_DBUS_MESSAGE (message), NULL);
-  return message->body;
+  return ensure_body (message);
 }
 
 /**
@@ -1162,6 +1261,7 @@ g_dbus_message_set_body (GDBusMessage  *message,
 
   if (message->body != NULL)
     g_variant_unref (message->body);
+  clear_lazy_body (message);
   if (body == NULL)
     {
       message->body = NULL;
@@ -1435,7 +1535,7 @@ read_string (GMemoryBuffer  *mbuf,
   str = mbuf->data + mbuf->pos;
   mbuf->pos += len + 1;
 
-  if G_UNLIKELY (!g_utf8_validate (str, -1, &end_valid))
+  if G_UNLIKELY (!mbuf->validated && !g_utf8_validate (str, -1, &end_valid))
     {
       gint offset;
       gchar *valid_str;
@@ -1485,6 +1585,227 @@ read_bytes (GMemoryBuffer  *mbuf,
   return result;
 }
 
+/* Reads the string, object path or signature (as given by @type_char) at
+ * the current, already aligned, position of @buf and checks its validity.
+ * Returns a pointer into @buf or %NULL if @error is set.
+ */
+static const gchar *
+read_string_value (GMemoryBuffer  *buf,
+                   gchar           type_char,
+                   gsize          *out_len,
+                   GError        **error)
+{
+  GError *local_error = NULL;
+  gsize len;
+  const gchar *v;
+
+  if (type_char == 'g')
+    len = g_memory_buffer_read_byte (buf, &local_error);
+  else
+    len = g_memory_buffer_read_uint32 (buf, &local_error);
+  if (local_error)
+    {
+      g_propagate_error (error, local_error);
+      return NULL;
+    }
+
+  v = read_string (buf, len, error);
+  if (v == NULL)
+    return NULL;
+
+  if (type_char == 'o' && !buf->validated && !g_variant_is_object_path (v))
+    {
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_INVALID_ARGUMENT,
+                   _("Parsed value “%s” is not a valid D-Bus object path"),
+                   v);
+      return NULL;
+    }
+  else if (type_char == 'g' && !buf->validated && !g_variant_is_signature (v))
+    {
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_INVALID_ARGUMENT,
+                   _("Parsed value “%s” is not a valid D-Bus signature"),
+                   v);
+      return NULL;
+    }
+
+  if (out_len != NULL)
+    *out_len = len;
+  return v;
+}
+
+/* Reads the signature of a variant nested at @max_depth. The returned type
+ * points into @buf, or is %NULL if @error is set.
+ */
+static const GVariantType *
+read_variant_type (GMemoryBuffer  *buf,
+                   guint           max_depth,
+                   GError        **error)
+{
+  GError *local_error = NULL;
+  guchar siglen;
+  const gchar *sig;
+
+  siglen = g_memory_buffer_read_byte (buf, &local_error);
+  if (local_error)
+    {
+      g_propagate_error (error, local_error);
+      return NULL;
+    }
+  sig = read_string (buf, (gsize) siglen, error);
+  if (sig == NULL)
+    return NULL;
+  if (!g_variant_is_signature (sig) ||
+      !g_variant_type_string_is_valid (sig))
+    {
+      /* A D-Bus signature can contain zero or more complete types,
+       * but a GVariant has to be exactly one complete type. */
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_INVALID_ARGUMENT,
+                   _("Parsed value “%s” for variant is not a valid D-Bus signature"),
+                   sig);
+      return NULL;
+    }
+
+  if (max_depth <= g_variant_type_string_get_depth_ (sig))
+    {
+      /* Catch the type nesting being too deep without having to
+       * parse the data. We don’t have to check this for static
+       * container types (like arrays and tuples) because the
+       * g_variant_type_string_is_valid() check performed before
+       * the initial parse_value_from_blob() call should check the
+       * static type nesting. */
+      g_set_error_literal (error,
+                           G_IO_ERROR,
+                           G_IO_ERROR_INVALID_ARGUMENT,
+                           _("Value nested too deeply"));
+      return NULL;
+    }
+
+  /* already validated above */
+  return (const GVariantType *) sig;
+}
+
+/* Reads the length of an array of @type. For arrays of fixed-size elements
+ * the length is checked against the element size, @buf is aligned to the
+ * first element and @out_fixed_size is set to the element size; otherwise
+ * it is set to 0.
+ */
+static gboolean
+read_array_header (GMemoryBuffer       *buf,
+                   const GVariantType  *type,
+                   guint                max_depth,
+                   guint32             *out_array_len,
+                   guint               *out_fixed_size,
+                   GError             **error)
+{
+  GError *local_error = NULL;
+  guint32 array_len;
+  const GVariantType *element_type;
+  guint fixed_size;
+
+  array_len = g_memory_buffer_read_uint32 (buf, &local_error);
+  if (local_error)
+    {
+      g_propagate_error (error, local_error);
+      return FALSE;
+    }
+
+#ifdef DEBUG_SERIALIZER
+  g_print (": array spans 0x%04x bytes\n", array_len);
+#endif /* DEBUG_SERIALIZER */
+
+  if (array_len > (2<<26))
+    {
+      /* G_GUINT32_FORMAT doesn't work with gettext, so use u */
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_INVALID_ARGUMENT,
+                   g_dngettext (GETTEXT_PACKAGE,
+                                "Encountered array of length %u byte. Maximum length is 2<<26 bytes (64 MiB).",
+                                "Encountered array of length %u bytes. Maximum length is 2<<26 bytes (64 MiB).",
+                                array_len),
+                   array_len);
+      return FALSE;
+    }
+
+  element_type = g_variant_type_element (type);
+  fixed_size = get_type_fixed_size (element_type);
+
+  if (fixed_size != 0)
+    {
+      if (array_len % fixed_size != 0)
+        {
+          g_set_error (error,
+                       G_IO_ERROR,
+                       G_IO_ERROR_INVALID_ARGUMENT,
+                       _("Encountered array of type “a%c”, expected to have a length a multiple "
+                         "of %u bytes, but found to be %u bytes in length"),
+                       g_variant_type_peek_string (element_type)[0], fixed_size, array_len);
+          return FALSE;
+        }
+
+      if (max_depth == 1)
+        {
+          /* If we had recursed into parse_value_from_blob() again to
+           * parse the array values, this would have been emitted. */
+          g_set_error_literal (error,
+                               G_IO_ERROR,
+                               G_IO_ERROR_INVALID_ARGUMENT,
+                               _("Value nested too deeply"));
+          return FALSE;
+        }
+
+      ensure_input_padding (buf, fixed_size);
+    }
+
+  *out_array_len = array_len;
+  *out_fixed_size = fixed_size;
+  return TRUE;
+}
+
+/* Values at least this big are sliced out of the receive buffer instead of
+ * being copied; smaller ones aren't worth pinning the buffer for. */
+#define G_DBUS_MESSAGE_MIN_SLICE_SIZE 256
+
+/* Received messages at least this big have their body parsed lazily and
+ * sliced out of the receive buffer; smaller ones are parsed right away. */
+#define G_DBUS_MESSAGE_MIN_LAZY_SIZE 4096
+
+/* Returns a (floating) GVariant sharing @len bytes at @data with the buffer's
+ * backing GBytes, or %NULL if the value must be copied instead. */
+static GVariant *
+g_memory_buffer_new_variant_slice (GMemoryBuffer      *mbuf,
+                                   const GVariantType *type,
+                                   gconstpointer       data,
+                                   gsize               len,
+                                   gsize               alignment,
+                                   gboolean            trusted)
+{
+  GBytes *slice;
+  GVariant *ret;
+
+  if (mbuf->bytes == NULL ||
+      len < G_DBUS_MESSAGE_MIN_SLICE_SIZE ||
+      ((gsize) data & (alignment - 1)) != 0)
+    return NULL;
+
+  slice = g_bytes_new_from_bytes (mbuf->bytes, (const gchar *) data - mbuf->data, len);
+  ret = g_variant_new_from_bytes (type, slice, trusted);
+  g_bytes_unref (slice);
+
+  return ret;
+}
+
+static GVariant *transcode_value_from_blob (GMemoryBuffer       *buf,
+                                           const GVariantType  *type,
+                                           guint                max_depth,
+                                           GError             **error);
+
 /* if just_align==TRUE, don't read a value, just align the input stream wrt padding */
 
 /* returns a non-floating GVariant! */
@@ -1647,15 +1968,17 @@ parse_value_from_blob (GMemoryBuffer       *buf,
       ensure_input_padding (buf, 4);
       if (!just_align)
         {
-          guint32 len;
+          gsize len;
           const gchar *v;
-          len = g_memory_buffer_read_uint32 (buf, &local_error);
-          if (local_error)
-            goto fail;
-          v = read_string (buf, (gsize) len, &local_error);
+          v = read_string_value (buf, 's', &len, &local_error);
           if (v == NULL)
             goto fail;
-          ret = g_variant_new_string (v);
+          /* The wire format of a string (including its NUL) is also its
+           * GVariant serialisation, as long as there is no embedded NUL. */
+          if (strlen (v) == len)
+            ret = g_memory_buffer_new_variant_slice (buf, G_VARIANT_TYPE_STRING, v, len + 1, 1, TRUE);
+          if (ret == NULL)
+            ret = g_variant_new_string (v);
         }
       break;
 
@@ -1663,23 +1986,10 @@ parse_value_from_blob (GMemoryBuffer       *buf,
       ensure_input_padding (buf, 4);
       if (!just_align)
         {
-          guint32 len;
           const gchar *v;
-          len = g_memory_buffer_read_uint32 (buf, &local_error);
-          if (local_error)
-            goto fail;
-          v = read_string (buf, (gsize) len, &local_error);
+          v = read_string_value (buf, 'o', NULL, &local_error);
           if (v == NULL)
             goto fail;
-          if (!g_variant_is_object_path (v))
-            {
-              g_set_error (&local_error,
-                           G_IO_ERROR,
-                           G_IO_ERROR_INVALID_ARGUMENT,
-                           _("Parsed value “%s” is not a valid D-Bus object path"),
-                           v);
-              goto fail;
-            }
           ret = g_variant_new_object_path (v);
         }
       break;
@@ -1687,23 +1997,10 @@ parse_value_from_blob (GMemoryBuffer       *buf,
     case 'g': /* G_VARIANT_TYPE_SIGNATURE */
       if (!just_align)
         {
-          guchar len;
           const gchar *v;
-          len = g_memory_buffer_read_byte (buf, &local_error);
-          if (local_error)
-            goto fail;
-          v = read_string (buf, (gsize) len, &local_error);
+          v = read_string_value (buf, 'g', NULL, &local_error);
           if (v == NULL)
             goto fail;
-          if (!g_variant_is_signature (v))
-            {
-              g_set_error (&local_error,
-                           G_IO_ERROR,
-                           G_IO_ERROR_INVALID_ARGUMENT,
-                           _("Parsed value “%s” is not a valid D-Bus signature"),
-                       v);
-              goto fail;
-            }
           ret = g_variant_new_signature (v);
         }
       break;
@@ -1735,128 +2032,46 @@ parse_value_from_blob (GMemoryBuffer       *buf,
           const GVariantType *element_type;
           guint fixed_size;
 
-          array_len = g_memory_buffer_read_uint32 (buf, &local_error);
-          if (local_error)
-            goto fail;
-
 #ifdef DEBUG_SERIALIZER
           is_leaf = FALSE;
-          g_print (": array spans 0x%04x bytes\n", array_len);
 #endif /* DEBUG_SERIALIZER */
 
-          if (array_len > (2<<26))
-            {
-              /* G_GUINT32_FORMAT doesn't work with gettext, so use u */
-              g_set_error (&local_error,
-                           G_IO_ERROR,
-                           G_IO_ERROR_INVALID_ARGUMENT,
-                           g_dngettext (GETTEXT_PACKAGE,
-                                        "Encountered array of length %u byte. Maximum length is 2<<26 bytes (64 MiB).",
-                                        "Encountered array of length %u bytes. Maximum length is 2<<26 bytes (64 MiB).",
-                                        array_len),
-                           array_len);
-              goto fail;
-            }
-
           element_type = g_variant_type_element (type);
-          fixed_size = get_type_fixed_size (element_type);
 
-          /* Fast-path the cases like 'ay', etc. */
-          if (fixed_size != 0)
+          /* Arrays of anything but fixed-size basic types, like 'as' and
+           * 'a{sv}', are transcoded straight into their serialised form
+           * rather than built up one element at a time. */
+          if (get_type_fixed_size (element_type) == 0)
             {
-              gconstpointer array_data;
-
-              if (array_len % fixed_size != 0)
-                {
-                  g_set_error (&local_error,
-                               G_IO_ERROR,
-                               G_IO_ERROR_INVALID_ARGUMENT,
-                               _("Encountered array of type “a%c”, expected to have a length a multiple "
-                                 "of %u bytes, but found to be %u bytes in length"),
-                               g_variant_type_peek_string (element_type)[0], fixed_size, array_len);
-                  goto fail;
-                }
-
-              if (max_depth == 1)
-                {
-                  /* If we had recursed into parse_value_from_blob() again to
-                   * parse the array values, this would have been emitted. */
-                  g_set_error_literal (&local_error,
-                                       G_IO_ERROR,
-                                       G_IO_ERROR_INVALID_ARGUMENT,
-                                       _("Value nested too deeply"));
-                  goto fail;
-                }
-
-              ensure_input_padding (buf, fixed_size);
-              array_data = read_bytes (buf, array_len, &local_error);
-              if (array_data == NULL)
+              ret = transcode_value_from_blob (buf, type, max_depth, &local_error);
+              if (ret == NULL)
                 goto fail;
-
-              ret = g_variant_new_fixed_array (element_type, array_data, array_len / fixed_size, fixed_size);
-
-              if (g_memory_buffer_is_byteswapped (buf))
-                {
-                  GVariant *tmp = g_variant_ref_sink (ret);
-                  ret = g_variant_byteswap (tmp);
-                  g_variant_unref (tmp);
-                }
+              break;
             }
-          else
-            {
-              GVariantBuilder builder;
-              goffset offset;
-              goffset target;
 
-              g_variant_builder_init (&builder, type);
+          if (!read_array_header (buf, type, max_depth, &array_len, &fixed_size, &local_error))
+            goto fail;
 
-              if (array_len == 0)
-                {
-                  GVariant *item G_GNUC_UNUSED  /* when compiling with G_DISABLE_ASSERT */;
-                  item = parse_value_from_blob (buf,
-                                                element_type,
-                                                max_depth - 1,
-                                                TRUE,
-                                                indent + 2,
-                                                NULL);
-                  g_assert (item == NULL);
-                }
-              else
-                {
-                  offset = buf->pos;
-                  target = offset + array_len;
-                  while (offset < target)
-                    {
-                      GVariant *item;
-                      item = parse_value_from_blob (buf,
-                                                    element_type,
-                                                    max_depth - 1,
-                                                    FALSE,
-                                                    indent + 2,
-                                                    &local_error);
-                      if (item == NULL)
-                        {
-                          g_variant_builder_clear (&builder);
-                          goto fail;
-                        }
-                      g_variant_builder_add_value (&builder, item);
-                      g_variant_unref (item);
+          /* Fast-path the cases like 'ay', etc. */
+          {
+            gconstpointer array_data;
 
-                      /* Array elements must not be zero-length. There are no
-                       * valid zero-length serialisations of any types which
-                       * can be array elements in the D-Bus wire format, so this
-                       * assertion should always hold.
-                       *
-                       * See https://gitlab.gnome.org/GNOME/glib/-/issues/2557
-                       */
-                      g_assert (buf->pos > (gsize) offset);
+            array_data = read_bytes (buf, array_len, &local_error);
+            if (array_data == NULL)
+              goto fail;
 
-                      offset = buf->pos;
-                    }
-                }
+            if (!g_memory_buffer_is_byteswapped (buf))
+              ret = g_memory_buffer_new_variant_slice (buf, type, array_data, array_len, fixed_size, FALSE);
+            if (ret == NULL)
+              ret = g_variant_new_fixed_array (element_type, array_data, array_len / fixed_size, fixed_size);
 
-              ret = g_variant_builder_end (&builder);
-            }
+            if (g_memory_buffer_is_byteswapped (buf))
+              {
+                GVariant *tmp = g_variant_ref_sink (ret);
+                ret = g_variant_byteswap (tmp);
+                g_variant_unref (tmp);
+              }
+          }
         }
       break;
 
@@ -1960,53 +2175,19 @@ parse_value_from_blob (GMemoryBuffer       *buf,
 
           if (!just_align)
             {
-              guchar siglen;
-              const gchar *sig;
-              GVariantType *variant_type;
+              const GVariantType *variant_type;
               GVariant *value;
 
-              siglen = g_memory_buffer_read_byte (buf, &local_error);
-              if (local_error)
-                goto fail;
-              sig = read_string (buf, (gsize) siglen, &local_error);
-              if (sig == NULL)
+              variant_type = read_variant_type (buf, max_depth, &local_error);
+              if (variant_type == NULL)
                 goto fail;
-              if (!g_variant_is_signature (sig) ||
-                  !g_variant_type_string_is_valid (sig))
-                {
-                  /* A D-Bus signature can contain zero or more complete types,
-                   * but a GVariant has to be exactly one complete type. */
-                  g_set_error (&local_error,
-                               G_IO_ERROR,
-                               G_IO_ERROR_INVALID_ARGUMENT,
-                               _("Parsed value “%s” for variant is not a valid D-Bus signature"),
-                               sig);
-                  goto fail;
-                }
-
-              if (max_depth <= g_variant_type_string_get_depth_ (sig))
-                {
-                  /* Catch the type nesting being too deep without having to
-                   * parse the data. We don’t have to check this for static
-                   * container types (like arrays and tuples, above) because
-                   * the g_variant_type_string_is_valid() check performed before
-                   * the initial parse_value_from_blob() call should check the
-                   * static type nesting. */
-                  g_set_error_literal (&local_error,
-                                       G_IO_ERROR,
-                                       G_IO_ERROR_INVALID_ARGUMENT,
-                                       _("Value nested too deeply"));
-                  goto fail;
-                }
 
-              variant_type = g_variant_type_new (sig);
               value = parse_value_from_blob (buf,
                                              variant_type,
                                              max_depth - 1,
                                              FALSE,
                                              indent + 2,
                                              &local_error);
-              g_variant_type_free (variant_type);
               if (value == NULL)
                 goto fail;
               ret = g_variant_new_variant (value);
@@ -2068,7 +2249,772 @@ parse_value_from_blob (GMemoryBuffer       *buf,
   return NULL;
 }
 
-/* ---------------------------------------------------------------------------------------------------- */
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Checks that a value of @type can be parsed from @buf by
+ * parse_value_from_blob(), failing in the same way, but without building
+ * it. This is used for message bodies that are only parsed on demand.
+ */
+static gboolean
+validate_value_in_blob (GMemoryBuffer       *buf,
+                        const GVariantType  *type,
+                        guint                max_depth,
+                        gboolean             just_align,
+                        GError             **error)
+{
+  GError *local_error = NULL;
+  const gchar *type_string;
+
+  if (max_depth == 0)
+    {
+      g_set_error_literal (error,
+                           G_IO_ERROR,
+                           G_IO_ERROR_INVALID_ARGUMENT,
+                           _("Value nested too deeply"));
+      return FALSE;
+    }
+
+  type_string = g_variant_type_peek_string (type);
+
+  switch (type_string[0])
+    {
+    case 'y': /* G_VARIANT_TYPE_BYTE */
+      if (!just_align)
+        g_memory_buffer_read_byte (buf, &local_error);
+      break;
+
+    case 'n': /* G_VARIANT_TYPE_INT16 */
+    case 'q': /* G_VARIANT_TYPE_UINT16 */
+      ensure_input_padding (buf, 2);
+      if (!just_align)
+        g_memory_buffer_read_uint16 (buf, &local_error);
+      break;
+
+    case 'b': /* G_VARIANT_TYPE_BOOLEAN */
+    case 'i': /* G_VARIANT_TYPE_INT32 */
+    case 'u': /* G_VARIANT_TYPE_UINT32 */
+    case 'h': /* G_VARIANT_TYPE_HANDLE */
+      ensure_input_padding (buf, 4);
+      if (!just_align)
+        g_memory_buffer_read_uint32 (buf, &local_error);
+      break;
+
+    case 'x': /* G_VARIANT_TYPE_INT64 */
+    case 't': /* G_VARIANT_TYPE_UINT64 */
+    case 'd': /* G_VARIANT_TYPE_DOUBLE */
+      ensure_input_padding (buf, 8);
+      if (!just_align)
+        g_memory_buffer_read_uint64 (buf, &local_error);
+      break;
+
+    case 's': /* G_VARIANT_TYPE_STRING */
+    case 'o': /* G_VARIANT_TYPE_OBJECT_PATH */
+      ensure_input_padding (buf, 4);
+      if (!just_align)
+        read_string_value (buf, type_string[0], NULL, &local_error);
+      break;
+
+    case 'g': /* G_VARIANT_TYPE_SIGNATURE */
+      if (!just_align)
+        read_string_value (buf, 'g', NULL, &local_error);
+      break;
+
+    case 'a': /* G_VARIANT_TYPE_ARRAY */
+      ensure_input_padding (buf, 4);
+      if (!just_align)
+        {
+          const GVariantType *element_type;
+          guint32 array_len;
+          guint fixed_size;
+
+          if (!read_array_header (buf, type, max_depth, &array_len, &fixed_size, &local_error))
+            break;
+
+          element_type = g_variant_type_element (type);
+
+          if (fixed_size != 0)
+            {
+              read_bytes (buf, array_len, &local_error);
+            }
+          else if (array_len == 0)
+            {
+              validate_value_in_blob (buf, element_type, max_depth - 1, TRUE, NULL);
+            }
+          else
+            {
+              goffset offset;
+              goffset target;
+
+              offset = buf->pos;
+              target = offset + array_len;
+              while (offset < target)
+                {
+                  if (!validate_value_in_blob (buf, element_type, max_depth - 1, FALSE, &local_error))
+                    break;
+
+                  /* see parse_value_from_blob() */
+                  g_assert (buf->pos > (gsize) offset);
+
+                  offset = buf->pos;
+                }
+            }
+        }
+      break;
+
+    default:
+      if (g_variant_type_is_dict_entry (type))
+        {
+          ensure_input_padding (buf, 8);
+          if (!just_align &&
+              validate_value_in_blob (buf, g_variant_type_key (type), max_depth - 1, FALSE, &local_error))
+            validate_value_in_blob (buf, g_variant_type_value (type), max_depth - 1, FALSE, &local_error);
+        }
+      else if (g_variant_type_is_tuple (type))
+        {
+          ensure_input_padding (buf, 8);
+          if (!just_align)
+            {
+              const GVariantType *element_type;
+
+              element_type = g_variant_type_first (type);
+              if (!element_type)
+                {
+                  g_set_error_literal (&local_error,
+                                       G_IO_ERROR,
+                                       G_IO_ERROR_INVALID_ARGUMENT,
+                                       _("Empty structures (tuples) are not allowed in D-Bus"));
+                  break;
+                }
+
+              while (element_type != NULL &&
+                     validate_value_in_blob (buf, element_type, max_depth - 1, FALSE, &local_error))
+                element_type = g_variant_type_next (element_type);
+            }
+        }
+      else if (g_variant_type_is_variant (type))
+        {
+          if (!just_align)
+            {
+              const GVariantType *variant_type;
+
+              variant_type = read_variant_type (buf, max_depth, &local_error);
+              if (variant_type != NULL)
+                validate_value_in_blob (buf, variant_type, max_depth - 1, FALSE, &local_error);
+            }
+        }
+      else
+        {
+          gchar *s;
+          s = g_variant_type_dup_string (type);
+          g_set_error (&local_error,
+                       G_IO_ERROR,
+                       G_IO_ERROR_INVALID_ARGUMENT,
+                       _("Error deserializing GVariant with type string “%s” from the D-Bus wire format"),
+                       s);
+          g_free (s);
+        }
+      break;
+    }
+
+  if (local_error != NULL)
+    {
+      g_propagate_error (error, local_error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Transcoding between the D-Bus wire format and the serialised GVariant
+ * format. Containers are written out in a single pass over their contents,
+ * without building (or, in the other direction, extracting) a GVariant for
+ * every value they hold.
+ *
+ * The layout rules follow gvariant-serialiser.c; the GVariantTypeInfo that
+ * caches them there is private to GLib, so get_variant_layout() works them
+ * out from the type string instead.
+ */
+
+static void
+get_variant_layout (const GVariantType *type,
+                    gsize              *out_alignment,
+                    gsize              *out_fixed_size)
+{
+  gsize alignment;
+  gsize fixed_size;
+
+  switch (*g_variant_type_peek_string (type))
+    {
+    case 'b': case 'y':
+      alignment = fixed_size = 1;
+      break;
+
+    case 'n': case 'q':
+      alignment = fixed_size = 2;
+      break;
+
+    case 'i': case 'u': case 'h':
+      alignment = fixed_size = 4;
+      break;
+
+    case 'x': case 't': case 'd':
+      alignment = fixed_size = 8;
+      break;
+
+    case 'v':
+      alignment = 8;
+      fixed_size = 0;
+      break;
+
+    case 'a': case 'm':
+      get_variant_layout (g_variant_type_element (type), &alignment, NULL);
+      fixed_size = 0;
+      break;
+
+    case '(': case '{':
+      {
+        const GVariantType *member;
+        gboolean is_fixed = TRUE;
+        gsize offset = 0;
+
+        alignment = 1;
+        for (member = g_variant_type_first (type); member != NULL; member = g_variant_type_next (member))
+          {
+            gsize member_alignment;
+            gsize member_fixed_size;
+
+            get_variant_layout (member, &member_alignment, &member_fixed_size);
+            alignment = MAX (alignment, member_alignment);
+            offset += (-offset) & (member_alignment - 1);
+            offset += member_fixed_size;
+            is_fixed = is_fixed && member_fixed_size != 0;
+          }
+
+        /* the unit type has a size of one byte */
+        fixed_size = is_fixed ? MAX (offset + ((-offset) & (alignment - 1)), 1) : 0;
+      }
+      break;
+
+    default: /* G_VARIANT_TYPE_STRING, G_VARIANT_TYPE_OBJECT_PATH, G_VARIANT_TYPE_SIGNATURE */
+      alignment = 1;
+      fixed_size = 0;
+      break;
+    }
+
+  *out_alignment = alignment;
+  if (out_fixed_size != NULL)
+    *out_fixed_size = fixed_size;
+}
+
+static guint
+get_framing_offset_size (gsize container_size)
+{
+  if (container_size > G_MAXUINT32)
+    return 8;
+  else if (container_size > G_MAXUINT16)
+    return 4;
+  else if (container_size > G_MAXUINT8)
+    return 2;
+  else if (container_size > 0)
+    return 1;
+
+  return 0;
+}
+
+static gsize
+read_framing_offset (const guchar *data,
+                     guint         offset_size)
+{
+  guint64 offset = 0;
+
+  memcpy (&offset, data, offset_size);
+
+  return GUINT64_FROM_LE (offset);
+}
+
+static void
+byteswap_fixed_array (guchar *data,
+                      gsize   size,
+                      guint   element_size)
+{
+  gsize i;
+
+  switch (element_size)
+    {
+    case 2:
+      for (i = 0; i < size; i += 2)
+        *(guint16 *) (data + i) = GUINT16_SWAP_LE_BE (*(guint16 *) (data + i));
+      break;
+
+    case 4:
+      for (i = 0; i < size; i += 4)
+        *(guint32 *) (data + i) = GUINT32_SWAP_LE_BE (*(guint32 *) (data + i));
+      break;
+
+    case 8:
+      for (i = 0; i < size; i += 8)
+        *(guint64 *) (data + i) = GUINT64_SWAP_LE_BE (*(guint64 *) (data + i));
+      break;
+    }
+}
+
+typedef struct
+{
+  GMemoryBuffer *buf;
+  GByteArray    *out;
+  /* end offsets of the children of the containers being written, used
+   * as a stack by nested containers */
+  GArray        *offsets;
+} WireTranscoder;
+
+static void
+transcoder_put_padding (WireTranscoder *t,
+                        gsize           alignment)
+{
+  static const guchar zeros[8] = { 0, };
+  gsize padding;
+
+  padding = (-(gsize) t->out->len) & (alignment - 1);
+  if (padding != 0)
+    g_byte_array_append (t->out, zeros, padding);
+}
+
+/* Appends the framing offsets pushed since @first_offset to the container
+ * written since @container_start, in the smallest size that can express
+ * them. Tuples store them in reverse.
+ */
+static void
+transcoder_put_framing_offsets (WireTranscoder *t,
+                                gsize           container_start,
+                                guint           first_offset,
+                                gboolean        reverse)
+{
+  gsize n_offsets;
+  gsize body_size;
+  guint offset_size;
+  gsize i;
+
+  n_offsets = t->offsets->len - first_offset;
+  body_size = t->out->len - container_start;
+
+  if (body_size + n_offsets <= G_MAXUINT8)
+    offset_size = 1;
+  else if (body_size + 2 * n_offsets <= G_MAXUINT16)
+    offset_size = 2;
+  else if (body_size + 4 * n_offsets <= G_MAXUINT32)
+    offset_size = 4;
+  else
+    offset_size = 8;
+
+  for (i = 0; i < n_offsets; i++)
+    {
+      guint64 offset;
+
+      offset = g_array_index (t->offsets, gsize,
+                              reverse ? t->offsets->len - 1 - i : first_offset + i);
+      offset = GUINT64_TO_LE (offset);
+      g_byte_array_append (t->out, (const guchar *) &offset, offset_size);
+    }
+
+  g_array_set_size (t->offsets, first_offset);
+}
+
+static void
+transcoder_push_framing_offset (WireTranscoder *t,
+                                gsize           container_start)
+{
+  gsize offset = t->out->len - container_start;
+
+  g_array_append_val (t->offsets, offset);
+}
+
+/* Reads a value of @type from the wire, like parse_value_from_blob(), and
+ * appends its serialisation to @t->out.
+ */
+static gboolean
+transcode_value (WireTranscoder      *t,
+                 const GVariantType  *type,
+                 guint                max_depth,
+                 GError             **error)
+{
+  GMemoryBuffer *buf = t->buf;
+  GError *local_error = NULL;
+  const gchar *type_string;
+
+  if (max_depth == 0)
+    {
+      g_set_error_literal (error,
+                           G_IO_ERROR,
+                           G_IO_ERROR_INVALID_ARGUMENT,
+                           _("Value nested too deeply"));
+      return FALSE;
+    }
+
+  type_string = g_variant_type_peek_string (type);
+
+  switch (type_string[0])
+    {
+    case 'b': /* G_VARIANT_TYPE_BOOLEAN */
+      {
+        guchar v;
+
+        ensure_input_padding (buf, 4);
+        v = g_memory_buffer_read_uint32 (buf, &local_error) != 0;
+        g_byte_array_append (t->out, &v, 1);
+      }
+      break;
+
+    case 'y': /* G_VARIANT_TYPE_BYTE */
+      {
+        guchar v;
+
+        v = g_memory_buffer_read_byte (buf, &local_error);
+        g_byte_array_append (t->out, &v, 1);
+      }
+      break;
+
+    case 'n': /* G_VARIANT_TYPE_INT16 */
+    case 'q': /* G_VARIANT_TYPE_UINT16 */
+      {
+        guint16 v;
+
+        ensure_input_padding (buf, 2);
+        v = g_memory_buffer_read_uint16 (buf, &local_error);
+        transcoder_put_padding (t, 2);
+        g_byte_array_append (t->out, (const guchar *) &v, 2);
+      }
+      break;
+
+    case 'i': /* G_VARIANT_TYPE_INT32 */
+    case 'u': /* G_VARIANT_TYPE_UINT32 */
+    case 'h': /* G_VARIANT_TYPE_HANDLE */
+      {
+        guint32 v;
+
+        ensure_input_padding (buf, 4);
+        v = g_memory_buffer_read_uint32 (buf, &local_error);
+        transcoder_put_padding (t, 4);
+        g_byte_array_append (t->out, (const guchar *) &v, 4);
+      }
+      break;
+
+    case 'x': /* G_VARIANT_TYPE_INT64 */
+    case 't': /* G_VARIANT_TYPE_UINT64 */
+    case 'd': /* G_VARIANT_TYPE_DOUBLE */
+      {
+        guint64 v;
+
+        ensure_input_padding (buf, 8);
+        v = g_memory_buffer_read_uint64 (buf, &local_error);
+        transcoder_put_padding (t, 8);
+        g_byte_array_append (t->out, (const guchar *) &v, 8);
+      }
+      break;
+
+    case 's': /* G_VARIANT_TYPE_STRING */
+    case 'o': /* G_VARIANT_TYPE_OBJECT_PATH */
+    case 'g': /* G_VARIANT_TYPE_SIGNATURE */
+      {
+        const gchar *v;
+
+        if (type_string[0] != 'g')
+          ensure_input_padding (buf, 4);
+        v = read_string_value (buf, type_string[0], NULL, error);
+        if (v == NULL)
+          return FALSE;
+
+        /* Like g_variant_new_string(), this stops at an embedded NUL. */
+        g_byte_array_append (t->out, (const guchar *) v, strlen (v) + 1);
+      }
+      break;
+
+    case 'a': /* G_VARIANT_TYPE_ARRAY */
+      {
+        const GVariantType *element_type;
+        gsize element_alignment;
+        gsize element_fixed_size;
+        guint32 array_len;
+        guint fixed_size;
+
+        ensure_input_padding (buf, 4);
+        if (!read_array_header (buf, type, max_depth, &array_len, &fixed_size, error))
+          return FALSE;
+
+        element_type = g_variant_type_element (type);
+        get_variant_layout (element_type, &element_alignment, &element_fixed_size);
+        transcoder_put_padding (t, element_alignment);
+
+        if (fixed_size != 0)
+          {
+            /* Arrays like 'ay' have the same layout in both formats, so
+             * they are copied in one go. */
+            gconstpointer array_data;
+            gsize start;
+
+            array_data = read_bytes (buf, array_len, error);
+            if (array_data == NULL)
+              return FALSE;
+
+            start = t->out->len;
+            g_byte_array_append (t->out, array_data, array_len);
+            if (g_memory_buffer_is_byteswapped (buf))
+              byteswap_fixed_array (t->out->data + start, array_len, fixed_size);
+          }
+        else if (array_len == 0)
+          {
+            /* see parse_value_from_blob() */
+            validate_value_in_blob (buf, element_type, max_depth - 1, TRUE, NULL);
+          }
+        else
+          {
+            gsize container_start = t->out->len;
+            guint first_offset = t->offsets->len;
+            goffset offset;
+            goffset target;
+
+            offset = buf->pos;
+            target = offset + array_len;
+            while (offset < target)
+              {
+                if (!transcode_value (t, element_type, max_depth - 1, error))
+                  return FALSE;
+
+                /* see parse_value_from_blob() */
+                g_assert (buf->pos > (gsize) offset);
+                offset = buf->pos;
+
+                if (element_fixed_size == 0)
+                  transcoder_push_framing_offset (t, container_start);
+              }
+
+            if (element_fixed_size == 0)
+              transcoder_put_framing_offsets (t, container_start, first_offset, FALSE);
+          }
+      }
+      break;
+
+    case 'v': /* G_VARIANT_TYPE_VARIANT */
+      {
+        const GVariantType *variant_type;
+
+        variant_type = read_variant_type (buf, max_depth, error);
+        if (variant_type == NULL)
+          return FALSE;
+
+        transcoder_put_padding (t, 8);
+        if (!transcode_value (t, variant_type, max_depth - 1, error))
+          return FALSE;
+
+        g_byte_array_append (t->out, (const guchar *) "", 1);
+        g_byte_array_append (t->out,
+                             (const guchar *) g_variant_type_peek_string (variant_type),
+                             g_variant_type_get_string_length (variant_type));
+      }
+      break;
+
+    case '(': /* G_VARIANT_TYPE_TUPLE */
+    case '{': /* G_VARIANT_TYPE_DICT_ENTRY */
+      {
+        const GVariantType *member;
+        gsize container_start;
+        guint first_offset;
+        gsize alignment;
+        gsize fixed_size;
+
+        ensure_input_padding (buf, 8);
+
+        member = g_variant_type_first (type);
+        if (member == NULL)
+          {
+            g_set_error_literal (error,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_INVALID_ARGUMENT,
+                                 _("Empty structures (tuples) are not allowed in D-Bus"));
+            return FALSE;
+          }
+
+        get_variant_layout (type, &alignment, &fixed_size);
+        transcoder_put_padding (t, alignment);
+        container_start = t->out->len;
+        first_offset = t->offsets->len;
+
+        while (member != NULL)
+          {
+            const GVariantType *next = g_variant_type_next (member);
+            gsize member_alignment;
+            gsize member_fixed_size;
+
+            if (!transcode_value (t, member, max_depth - 1, error))
+              return FALSE;
+
+            /* all variable-size members but the last are framed */
+            get_variant_layout (member, &member_alignment, &member_fixed_size);
+            if (next != NULL && member_fixed_size == 0)
+              transcoder_push_framing_offset (t, container_start);
+
+            member = next;
+          }
+
+        if (fixed_size != 0)
+          transcoder_put_padding (t, alignment);
+        else
+          transcoder_put_framing_offsets (t, container_start, first_offset, TRUE);
+      }
+      break;
+
+    default:
+      {
+        gchar *s;
+        s = g_variant_type_dup_string (type);
+        g_set_error (error,
+                     G_IO_ERROR,
+                     G_IO_ERROR_INVALID_ARGUMENT,
+                     _("Error deserializing GVariant with type string “%s” from the D-Bus wire format"),
+                     s);
+        g_free (s);
+        return FALSE;
+      }
+    }
+
+  if (local_error != NULL)
+    {
+      g_propagate_error (error, local_error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Returns a (floating) GVariant of @type read from @buf, in serialised form. */
+static GVariant *
+transcode_value_from_blob (GMemoryBuffer       *buf,
+                           const GVariantType  *type,
+                           guint                max_depth,
+                           GError             **error)
+{
+  WireTranscoder t;
+  GBytes *bytes;
+  GVariant *ret;
+
+  t.buf = buf;
+  t.out = g_byte_array_new ();
+  t.offsets = g_array_new (FALSE, FALSE, sizeof (gsize));
+
+  if (!transcode_value (&t, type, max_depth, error))
+    {
+      g_byte_array_unref (t.out);
+      g_array_unref (t.offsets);
+      return NULL;
+    }
+
+  bytes = g_byte_array_free_to_bytes (t.out);
+  g_array_unref (t.offsets);
+
+  /* All strings were validated, padding is zeroed and offsets are minimal,
+   * so the result is in normal form. */
+  ret = g_variant_new_from_bytes (type, bytes, TRUE);
+  g_bytes_unref (bytes);
+
+  return ret;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+G_LOCK_DEFINE_STATIC (lazy_body);
+
+/* Returns the body of @message if it was parsed, or %NULL. In the latter
+ * case @out_blob is set to a new reference to the wire blob holding the
+ * body if it still has to be parsed, and to %NULL if there is no body.
+ */
+static GVariant *
+peek_body (GDBusMessage  *message,
+           GBytes       **out_blob)
+{
+  GVariant *body;
+
+  *out_blob = NULL;
+
+  body = g_atomic_pointer_get (&message->body);
+  if (body != NULL)
+    return body;
+
+  G_LOCK (lazy_body);
+  body = g_atomic_pointer_get (&message->body);
+  if (body == NULL && message->lazy_blob != NULL)
+    *out_blob = g_bytes_ref (message->lazy_blob);
+  G_UNLOCK (lazy_body);
+
+  return body;
+}
+
+/* Parses the body of a message received with _g_dbus_message_new_from_bytes(),
+ * if that hasn't happened yet, and drops the message's reference to the wire
+ * blob. Locked messages may be shared between threads, so the result is
+ * published under the lazy_body lock.
+ */
+static GVariant *
+ensure_body (GDBusMessage *message)
+{
+  GVariant *body;
+  GBytes *blob;
+  GMemoryBuffer mbuf;
+  GError *error = NULL;
+
+  body = peek_body (message, &blob);
+  if (blob == NULL)
+    return body;
+
+  memset (&mbuf, 0, sizeof (mbuf));
+  mbuf.bytes = blob;
+  mbuf.data = (gchar *) g_bytes_get_data (blob, &mbuf.len);
+  mbuf.valid_len = mbuf.len;
+  mbuf.pos = message->lazy_body_offset;
+  mbuf.byte_order = (mbuf.data[0] == 'B') ? G_DATA_STREAM_BYTE_ORDER_BIG_ENDIAN
+                                          : G_DATA_STREAM_BYTE_ORDER_LITTLE_ENDIAN;
+  mbuf.validated = TRUE;
+
+  body = parse_value_from_blob (&mbuf,
+                                message->lazy_body_type,
+                                G_DBUS_MAX_TYPE_DEPTH + 1 /* for the surrounding tuple */,
+                                FALSE,
+                                2,
+                                &error);
+  if (body == NULL)
+    {
+      /* can't happen, the body was validated when the message was received */
+      g_critical ("%s: Failed to parse validated message body: %s", G_STRFUNC, error->message);
+      g_error_free (error);
+      g_bytes_unref (blob);
+      return NULL;
+    }
+
+  G_LOCK (lazy_body);
+  if (g_atomic_pointer_get (&message->body) == NULL)
+    {
+      g_atomic_pointer_set (&message->body, body);
+      g_clear_pointer (&message->lazy_blob, g_bytes_unref);
+    }
+  else
+    {
+      g_variant_unref (body);
+      body = g_atomic_pointer_get (&message->body);
+    }
+  G_UNLOCK (lazy_body);
+
+  g_bytes_unref (blob);
+
+  return body;
+}
+
+static void
+clear_lazy_body (GDBusMessage *message)
+{
+  g_clear_pointer (&message->lazy_blob, g_bytes_unref);
+  g_clear_pointer (&message->lazy_body_type, g_variant_type_free);
+  message->lazy_body_offset = 0;
+}
 
 /* message_header must be at least 16 bytes */
 
@@ -2140,6 +3086,70 @@ g_dbus_message_bytes_needed (guchar  *blob,
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+/* Parses the a{yv} of header fields straight into @message, without
+ * building the array as a GVariant first. Fails the same way as
+ * parse_value_from_blob() would for that type.
+ */
+static gboolean
+parse_header_fields_from_blob (GMemoryBuffer  *buf,
+                               GDBusMessage   *message,
+                               GError        **error)
+{
+  const GVariantType *type = G_VARIANT_TYPE ("a{yv}");
+  guint32 array_len;
+  guint fixed_size;
+  goffset offset;
+  goffset target;
+
+  ensure_input_padding (buf, 4);
+  if (!read_array_header (buf, type, G_DBUS_MAX_TYPE_DEPTH + 2, &array_len, &fixed_size, error))
+    return FALSE;
+
+  /* align to the first {yv}, even if there is none */
+  ensure_input_padding (buf, 8);
+
+  offset = buf->pos;
+  target = offset + array_len;
+  while (offset < target)
+    {
+      GError *local_error = NULL;
+      guchar header_field;
+      const GVariantType *value_type;
+      GVariant *value;
+
+      ensure_input_padding (buf, 8);
+
+      header_field = g_memory_buffer_read_byte (buf, &local_error);
+      if (local_error)
+        {
+          g_propagate_error (error, local_error);
+          return FALSE;
+        }
+
+      /* the array and dict entry are two levels of nesting, the variant
+       * another one */
+      value_type = read_variant_type (buf, G_DBUS_MAX_TYPE_DEPTH, error);
+      if (value_type == NULL)
+        return FALSE;
+
+      value = parse_value_from_blob (buf,
+                                     value_type,
+                                     G_DBUS_MAX_TYPE_DEPTH - 1,
+                                     FALSE,
+                                     2,
+                                     error);
+      if (value == NULL)
+        return FALSE;
+
+      store_header (message, header_field, value);
+
+      g_assert (buf->pos > (gsize) offset);
+      offset = buf->pos;
+    }
+
+  return TRUE;
+}
+
 /**
  * g_dbus_message_new_from_blob:
  * @blob: (array length=blob_len) (element-type guint8): A blob representing a binary D-Bus message.
@@ -2165,27 +3175,64 @@ g_dbus_message_new_from_blob (guchar                *blob,
                               GDBusCapabilityFlags   capabilities,
                               GError               **error)
 {
+  GBytes *bytes;
+  GDBusMessage *message;
+
+  g_return_val_if_fail (blob != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  bytes = g_bytes_new (blob, blob_len);
+  message = _g_dbus_message_new_from_bytes (bytes, capabilities, error);
+  g_bytes_unref (bytes);
+
+  return message;
+}
+
+/*
+ * _g_dbus_message_new_from_bytes:
+ * @bytes: A #GBytes holding a binary D-Bus message.
+ * @capabilities: A #GDBusCapabilityFlags describing what protocol features are supported.
+ * @error: Return location for error or %NULL.
+ *
+ * Like g_dbus_message_new_from_blob() but without copying @bytes. For
+ * messages of at least %G_DBUS_MESSAGE_MIN_LAZY_SIZE bytes, the message
+ * keeps a reference to it until the body is needed: the body is only
+ * validated here and parsed on first use, and large strings and
+ * fixed-size arrays in it then reference the memory of @bytes instead of
+ * being copied out. Smaller messages are parsed right away and don't
+ * reference @bytes.
+ *
+ * Returns: A new #GDBusMessage or %NULL if @error is set.
+ */
+GDBusMessage *
+_g_dbus_message_new_from_bytes (GBytes                *bytes,
+                                GDBusCapabilityFlags   capabilities,
+                                GError               **error)
+{
+  const guchar *blob;
+  gsize blob_len;
   GError *local_error = NULL;
   GMemoryBuffer mbuf;
   GDBusMessage *message;
   guchar endianness;
   guchar major_protocol_version;
   guint32 message_body_len;
-  GVariant *headers;
-  GVariant *item;
-  GVariantIter iter;
   GVariant *signature;
 
   /* TODO: check against @capabilities */
 
-  g_return_val_if_fail (blob != NULL, NULL);
+  g_return_val_if_fail (bytes != NULL, NULL);
   g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+  blob = g_bytes_get_data (bytes, &blob_len);
+
   message = g_dbus_message_new ();
 
   memset (&mbuf, 0, sizeof (mbuf));
   mbuf.data = (gchar *)blob;
   mbuf.len = mbuf.valid_len = blob_len;
+  /* small messages are copied out rather than keeping @bytes alive */
+  mbuf.bytes = blob_len >= G_DBUS_MESSAGE_MIN_LAZY_SIZE ? bytes : NULL;
 
   endianness = g_memory_buffer_read_byte (&mbuf, &local_error);
   if (local_error)
@@ -2248,28 +3295,8 @@ g_dbus_message_new_from_blob (guchar                *blob,
 #ifdef DEBUG_SERIALIZER
   g_print ("Parsing headers (blob_len = 0x%04x bytes)\n", (gint) blob_len);
 #endif /* DEBUG_SERIALIZER */
-  headers = parse_value_from_blob (&mbuf,
-                                   G_VARIANT_TYPE ("a{yv}"),
-                                   G_DBUS_MAX_TYPE_DEPTH + 2 /* for the a{yv} */,
-                                   FALSE,
-                                   2,
-                                   &local_error);
-  if (headers == NULL)
+  if (!parse_header_fields_from_blob (&mbuf, message, &local_error))
     goto fail;
-  g_variant_iter_init (&iter, headers);
-  while ((item = g_variant_iter_next_value (&iter)) != NULL)
-    {
-      guchar header_field;
-      GVariant *value;
-      g_variant_get (item,
-                     "{yv}",
-                     &header_field,
-                     &value);
-      g_dbus_message_set_header (message, header_field, value);
-      g_variant_unref (value);
-      g_variant_unref (item);
-    }
-  g_variant_unref (headers);
 
   signature = g_dbus_message_get_header (message, G_DBUS_MESSAGE_HEADER_FIELD_SIGNATURE);
   if (signature != NULL)
@@ -2320,15 +3347,37 @@ g_dbus_message_new_from_blob (guchar                *blob,
 #ifdef DEBUG_SERIALIZER
           g_print ("Parsing body (blob_len = 0x%04x bytes)\n", (gint) blob_len);
 #endif /* DEBUG_SERIALIZER */
-          message->body = parse_value_from_blob (&mbuf,
-                                                 variant_type,
-                                                 G_DBUS_MAX_TYPE_DEPTH + 1 /* for the surrounding tuple */,
-                                                 FALSE,
-                                                 2,
-                                                 &local_error);
-          g_variant_type_free (variant_type);
-          if (message->body == NULL)
-            goto fail;
+          if (mbuf.bytes == NULL)
+            {
+              message->body = parse_value_from_blob (&mbuf,
+                                                     variant_type,
+                                                     G_DBUS_MAX_TYPE_DEPTH + 1 /* for the surrounding tuple */,
+                                                     FALSE,
+                                                     2,
+                                                     &local_error);
+              g_variant_type_free (variant_type);
+              if (message->body == NULL)
+                goto fail;
+            }
+          else
+            {
+              /* Only check that the body is well-formed for now; it is
+               * parsed on first use, see ensure_body(). Messages that are
+               * only routed or forwarded never need it. */
+              ensure_input_padding (&mbuf, 8);
+              message->lazy_body_offset = mbuf.pos;
+              if (!validate_value_in_blob (&mbuf,
+                                           variant_type,
+                                           G_DBUS_MAX_TYPE_DEPTH + 1 /* for the surrounding tuple */,
+                                           FALSE,
+                                           &local_error))
+                {
+                  g_variant_type_free (variant_type);
+                  goto fail;
+                }
+              message->lazy_blob = g_bytes_ref (bytes);
+              message->lazy_body_type = variant_type;
+            }
         }
     }
   else
@@ -2384,6 +3433,295 @@ ensure_output_padding (GMemoryBuffer  *mbuf,
   return padding_needed;
 }
 
+static gboolean append_value_to_blob (GVariant            *value,
+                                      const GVariantType  *type,
+                                      GMemoryBuffer       *mbuf,
+                                      gsize               *out_padding_added,
+                                      GError             **error);
+
+/* Like append_value_to_blob(), but for a value of @type in normal form
+ * given by its serialised @data, which is walked directly instead of
+ * going through a GVariant for every child.
+ */
+static gboolean
+append_serialised_to_blob (const GVariantType  *type,
+                           const guchar        *data,
+                           gsize                size,
+                           GMemoryBuffer       *mbuf,
+                           gsize               *out_padding_added,
+                           GError             **error)
+{
+  gsize padding_added;
+  const gchar *type_string;
+
+  type_string = g_variant_type_peek_string (type);
+
+  padding_added = 0;
+
+  switch (type_string[0])
+    {
+    case 'b': /* G_VARIANT_TYPE_BOOLEAN */
+      padding_added = ensure_output_padding (mbuf, 4);
+      g_memory_buffer_put_uint32 (mbuf, data[0]);
+      break;
+
+    case 'y': /* G_VARIANT_TYPE_BYTE */
+      g_memory_buffer_put_byte (mbuf, data[0]);
+      break;
+
+    case 'n': /* G_VARIANT_TYPE_INT16 */
+    case 'q': /* G_VARIANT_TYPE_UINT16 */
+      {
+        guint16 v;
+
+        padding_added = ensure_output_padding (mbuf, 2);
+        memcpy (&v, data, sizeof (v));
+        g_memory_buffer_put_uint16 (mbuf, v);
+      }
+      break;
+
+    case 'i': /* G_VARIANT_TYPE_INT32 */
+    case 'u': /* G_VARIANT_TYPE_UINT32 */
+    case 'h': /* G_VARIANT_TYPE_HANDLE */
+      {
+        guint32 v;
+
+        padding_added = ensure_output_padding (mbuf, 4);
+        memcpy (&v, data, sizeof (v));
+        g_memory_buffer_put_uint32 (mbuf, v);
+      }
+      break;
+
+    case 'x': /* G_VARIANT_TYPE_INT64 */
+    case 't': /* G_VARIANT_TYPE_UINT64 */
+    case 'd': /* G_VARIANT_TYPE_DOUBLE */
+      {
+        guint64 v;
+
+        padding_added = ensure_output_padding (mbuf, 8);
+        memcpy (&v, data, sizeof (v));
+        g_memory_buffer_put_uint64 (mbuf, v);
+      }
+      break;
+
+    case 's': /* G_VARIANT_TYPE_STRING */
+    case 'o': /* G_VARIANT_TYPE_OBJECT_PATH */
+      /* the serialised string already ends with its nul byte */
+      padding_added = ensure_output_padding (mbuf, 4);
+      g_memory_buffer_put_uint32 (mbuf, size - 1);
+      g_memory_buffer_write (mbuf, data, size);
+      break;
+
+    case 'g': /* G_VARIANT_TYPE_SIGNATURE */
+      g_memory_buffer_put_byte (mbuf, size - 1);
+      g_memory_buffer_write (mbuf, data, size);
+      break;
+
+    case 'a': /* G_VARIANT_TYPE_ARRAY */
+      {
+        const GVariantType *element_type;
+        gsize element_alignment;
+        gsize element_fixed_size;
+        goffset array_len_offset;
+        goffset array_payload_begin_offset;
+        goffset cur_offset;
+        guint fixed_size;
+
+        padding_added = ensure_output_padding (mbuf, 4);
+
+        /* see append_value_to_blob() */
+        array_len_offset = mbuf->valid_len;
+        g_memory_buffer_put_uint32 (mbuf, 0xF00DFACE);
+        array_payload_begin_offset = mbuf->valid_len;
+
+        element_type = g_variant_type_element (type);
+        fixed_size = get_type_fixed_size (element_type);
+        get_variant_layout (element_type, &element_alignment, &element_fixed_size);
+
+        if (size == 0)
+          {
+            gsize padding_added_for_item;
+            if (!append_value_to_blob (NULL,
+                                       element_type,
+                                       mbuf,
+                                       &padding_added_for_item,
+                                       error))
+              goto fail;
+            array_payload_begin_offset += padding_added_for_item;
+          }
+        else if (fixed_size != 0)
+          {
+            array_payload_begin_offset += ensure_output_padding (mbuf, fixed_size);
+            g_memory_buffer_write (mbuf, data, size);
+            if (g_memory_buffer_is_byteswapped (mbuf))
+              byteswap_fixed_array ((guchar *) mbuf->data + mbuf->pos - size, size, fixed_size);
+          }
+        else
+          {
+            const guchar *offsets = NULL;
+            guint offset_size = 0;
+            gsize n_elements;
+            gsize start;
+            gsize n;
+
+            if (element_fixed_size != 0)
+              {
+                n_elements = size / element_fixed_size;
+              }
+            else
+              {
+                offset_size = get_framing_offset_size (size);
+                start = read_framing_offset (data + size - offset_size, offset_size);
+                offsets = data + start;
+                n_elements = (size - start) / offset_size;
+              }
+
+            start = 0;
+            for (n = 0; n < n_elements; n++)
+              {
+                gsize padding_added_for_item;
+                gsize end;
+
+                if (element_fixed_size != 0)
+                  {
+                    end = start + element_fixed_size;
+                  }
+                else
+                  {
+                    start += (-start) & (element_alignment - 1);
+                    end = read_framing_offset (offsets + n * offset_size, offset_size);
+                  }
+
+                if (!append_serialised_to_blob (element_type,
+                                                data + start,
+                                                end - start,
+                                                mbuf,
+                                                &padding_added_for_item,
+                                                error))
+                  goto fail;
+                if (n == 0)
+                  array_payload_begin_offset += padding_added_for_item;
+
+                start = end;
+              }
+          }
+
+        cur_offset = mbuf->valid_len;
+        mbuf->pos = array_len_offset;
+        g_memory_buffer_put_uint32 (mbuf, cur_offset - array_payload_begin_offset);
+        mbuf->pos = cur_offset;
+      }
+      break;
+
+    case 'v': /* G_VARIANT_TYPE_VARIANT */
+      {
+        gsize type_start;
+
+        /* the child is followed by a nul byte and its type string */
+        type_start = size;
+        while (data[type_start - 1] != '\0')
+          type_start--;
+
+        g_memory_buffer_put_byte (mbuf, size - type_start);
+        g_memory_buffer_write (mbuf, data + type_start, size - type_start);
+        g_memory_buffer_put_byte (mbuf, '\0');
+        if (!append_serialised_to_blob ((const GVariantType *) (data + type_start),
+                                        data,
+                                        type_start - 1,
+                                        mbuf,
+                                        NULL,
+                                        error))
+          goto fail;
+      }
+      break;
+
+    case '(': /* G_VARIANT_TYPE_TUPLE */
+    case '{': /* G_VARIANT_TYPE_DICT_ENTRY */
+      {
+        const GVariantType *member;
+        guint offset_size;
+        gsize offsets_end;
+        gsize start;
+
+        member = g_variant_type_first (type);
+        if (member == NULL)
+          {
+            g_set_error_literal (error,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_INVALID_ARGUMENT,
+                                 _("Empty structures (tuples) are not allowed in D-Bus"));
+            goto fail;
+          }
+
+        padding_added = ensure_output_padding (mbuf, 8);
+
+        /* the framing offsets of the members are stored backwards from
+         * the end of the tuple */
+        offset_size = get_framing_offset_size (size);
+        offsets_end = size;
+        start = 0;
+
+        while (member != NULL)
+          {
+            const GVariantType *next = g_variant_type_next (member);
+            gsize member_alignment;
+            gsize member_fixed_size;
+            gsize end;
+
+            get_variant_layout (member, &member_alignment, &member_fixed_size);
+            start += (-start) & (member_alignment - 1);
+
+            if (member_fixed_size != 0)
+              {
+                end = start + member_fixed_size;
+              }
+            else if (next != NULL)
+              {
+                offsets_end -= offset_size;
+                end = read_framing_offset (data + offsets_end, offset_size);
+              }
+            else
+              {
+                end = offsets_end;
+              }
+
+            if (!append_serialised_to_blob (member,
+                                            data + start,
+                                            end - start,
+                                            mbuf,
+                                            NULL,
+                                            error))
+              goto fail;
+
+            start = end;
+            member = next;
+          }
+      }
+      break;
+
+    default:
+      {
+        gchar *s;
+        s = g_variant_type_dup_string (type);
+        g_set_error (error,
+                     G_IO_ERROR,
+                     G_IO_ERROR_INVALID_ARGUMENT,
+                     _("Error serializing GVariant with type string “%s” to the D-Bus wire format"),
+                     s);
+        g_free (s);
+        goto fail;
+      }
+    }
+
+  if (out_padding_added != NULL)
+    *out_padding_added = padding_added;
+
+  return TRUE;
+
+ fail:
+  return FALSE;
+}
+
 /* note that value can be NULL for e.g. empty arrays - type is never NULL */
 static gboolean
 append_value_to_blob (GVariant            *value,
@@ -2549,6 +3887,28 @@ append_value_to_blob (GVariant            *value,
         gsize array_len;
         guint fixed_size;
 
+        element_type = g_variant_type_element (type);
+
+        /* Arrays of anything but fixed-size basic types, like 'as' and
+         * 'a{sv}', are written straight from their serialised form if they
+         * have one, as they do when received from another peer. Values
+         * built up from their children are walked as before rather than
+         * serialised just for this. */
+        if (value != NULL &&
+            get_type_fixed_size (element_type) == 0 &&
+            GLIB_PRIVATE_CALL (g_variant_is_serialised) (value) &&
+            g_variant_is_normal_form (value))
+          {
+            if (!append_serialised_to_blob (type,
+                                            g_variant_get_data (value),
+                                            g_variant_get_size (value),
+                                            mbuf,
+                                            &padding_added,
+                                            error))
+              goto fail;
+            break;
+          }
+
         padding_added = ensure_output_padding (mbuf, 4);
         if (value != NULL)
           {
@@ -2571,7 +3931,6 @@ append_value_to_blob (GVariant            *value,
              */
             array_payload_begin_offset = mbuf->valid_len;
 
-            element_type = g_variant_type_element (type);
             fixed_size = get_type_fixed_size (element_type);
 
             if (g_variant_n_children (value) == 0)
@@ -2713,6 +4072,51 @@ append_value_to_blob (GVariant            *value,
   return FALSE;
 }
 
+/* Serializes the header fields of @message as an a{yv}, in ascending
+ * order of field.
+ */
+static gboolean
+append_header_fields_to_blob (GDBusMessage   *message,
+                              GMemoryBuffer  *mbuf,
+                              GError        **error)
+{
+  guchar fields[256];
+  guint n_fields, n;
+  goffset array_len_offset;
+  goffset array_payload_begin_offset;
+  goffset cur_offset;
+
+  ensure_output_padding (mbuf, 4);
+
+  /* array length - will be filled in later, see append_value_to_blob() */
+  array_len_offset = mbuf->valid_len;
+  g_memory_buffer_put_uint32 (mbuf, 0xF00DFACE);
+  array_payload_begin_offset = mbuf->valid_len;
+  array_payload_begin_offset += ensure_output_padding (mbuf, 8);
+
+  n_fields = collect_header_fields (message, fields);
+  for (n = 0; n != n_fields; n++)
+    {
+      GVariant *value = lookup_header (message, fields[n]);
+      const gchar *signature = g_variant_get_type_string (value);
+
+      ensure_output_padding (mbuf, 8);
+      g_memory_buffer_put_byte (mbuf, fields[n]);
+      g_memory_buffer_put_byte (mbuf, strlen (signature));
+      g_memory_buffer_put_string (mbuf, signature);
+      g_memory_buffer_put_byte (mbuf, '\0');
+      if (!append_value_to_blob (value, g_variant_get_type (value), mbuf, NULL, error))
+        return FALSE;
+    }
+
+  cur_offset = mbuf->valid_len;
+  mbuf->pos = array_len_offset;
+  g_memory_buffer_put_uint32 (mbuf, cur_offset - array_payload_begin_offset);
+  mbuf->pos = cur_offset;
+
+  return TRUE;
+}
+
 static gboolean
 append_body_to_blob (GVariant       *value,
                      GMemoryBuffer  *mbuf,
@@ -2780,12 +4184,9 @@ g_dbus_message_to_blob (GDBusMessage          *message,
   goffset body_len_offset;
   goffset body_start_offset;
   gsize body_size;
-  GVariant *header_fields;
-  GVariantBuilder builder;
-  GHashTableIter hash_iter;
-  gpointer key;
-  GVariant *header_value;
   GVariant *signature;
+  GVariant *body;
+  GBytes *lazy_blob = NULL;
   const gchar *signature_str;
   gint num_fds_in_message;
   gint num_fds_according_to_header;
@@ -2846,27 +4247,8 @@ g_dbus_message_to_blob (GDBusMessage          *message,
       goto out;
     }
 
-  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{yv}"));
-  g_hash_table_iter_init (&hash_iter, message->headers);
-  while (g_hash_table_iter_next (&hash_iter, &key, (gpointer) &header_value))
-    {
-      g_variant_builder_add (&builder,
-                             "{yv}",
-                             (guchar) GPOINTER_TO_UINT (key),
-                             header_value);
-    }
-  header_fields = g_variant_builder_end (&builder);
-
-  if (!append_value_to_blob (header_fields,
-                             g_variant_get_type (header_fields),
-                             &mbuf,
-                             NULL,
-                             error))
-    {
-      g_variant_unref (header_fields);
-      goto out;
-    }
-  g_variant_unref (header_fields);
+  if (!append_header_fields_to_blob (message, &mbuf, error))
+    goto out;
 
   /* header size must be a multiple of 8 */
   ensure_output_padding (&mbuf, 8);
@@ -2887,31 +4269,57 @@ g_dbus_message_to_blob (GDBusMessage          *message,
   signature_str = NULL;
   if (signature != NULL)
       signature_str = g_variant_get_string (signature, NULL);
-  if (message->body != NULL)
+  body = peek_body (message, &lazy_blob);
+  if (body != NULL || lazy_blob != NULL)
     {
       gchar *tupled_signature_str;
+      gchar *body_type_str;
+
+      if (body != NULL)
+        body_type_str = g_strdup (g_variant_get_type_string (body));
+      else
+        body_type_str = g_variant_type_dup_string (message->lazy_body_type);
+
       if (signature == NULL)
         {
           g_set_error (error,
                        G_IO_ERROR,
                        G_IO_ERROR_INVALID_ARGUMENT,
                        _("Message body has signature “%s” but there is no signature header"),
-                       g_variant_get_type_string (message->body));
+                       body_type_str);
+          g_free (body_type_str);
           goto out;
         }
       tupled_signature_str = g_strdup_printf ("(%s)", signature_str);
-      if (g_strcmp0 (tupled_signature_str, g_variant_get_type_string (message->body)) != 0)
+      if (g_strcmp0 (tupled_signature_str, body_type_str) != 0)
         {
           g_set_error (error,
                        G_IO_ERROR,
                        G_IO_ERROR_INVALID_ARGUMENT,
                        _("Message body has type signature “%s” but signature in the header field is “%s”"),
-                       g_variant_get_type_string (message->body), tupled_signature_str);
+                       body_type_str, tupled_signature_str);
           g_free (tupled_signature_str);
+          g_free (body_type_str);
           goto out;
         }
       g_free (tupled_signature_str);
-      if (!append_body_to_blob (message->body, &mbuf, error))
+      g_free (body_type_str);
+
+      if (body == NULL &&
+          message->byte_order == (GDBusMessageByteOrder) ((const guchar *) g_bytes_get_data (lazy_blob, NULL))[0])
+        {
+          gconstpointer data;
+          gsize data_len;
+
+          /* The body was received in the same byte order and starts at an
+           * offset aligned to 8 in both messages, so its wire encoding can
+           * be forwarded without parsing it. */
+          data = g_bytes_get_data (lazy_blob, &data_len);
+          g_memory_buffer_write (&mbuf,
+                                 (const gchar *) data + message->lazy_body_offset,
+                                 data_len - message->lazy_body_offset);
+        }
+      else if (!append_body_to_blob (ensure_body (message), &mbuf, error))
         goto out;
     }
   else
@@ -2941,6 +4349,7 @@ g_dbus_message_to_blob (GDBusMessage          *message,
  out:
   if (ret == NULL)
     g_free (mbuf.data);
+  g_clear_pointer (&lazy_blob, g_bytes_unref);
 
   return ret;
 }
@@ -2955,7 +4364,7 @@ get_uint32_header (GDBusMessage            *message,
   guint32 ret;
 
   ret = 0;
-  value = g_hash_table_lookup (message->headers, GUINT_TO_POINTER (header_field));
+  value = lookup_header (message, header_field);
   if (value != NULL && g_variant_is_of_type (value, G_VARIANT_TYPE_UINT32))
     ret = g_variant_get_uint32 (value);
 
@@ -2970,7 +4379,7 @@ get_string_header (GDBusMessage            *message,
   const gchar *ret;
 
   ret = NULL;
-  value = g_hash_table_lookup (message->headers, GUINT_TO_POINTER (header_field));
+  value = lookup_header (message, header_field);
   if (value != NULL && g_variant_is_of_type (value, G_VARIANT_TYPE_STRING))
     ret = g_variant_get_string (value, NULL);
 
@@ -2985,7 +4394,7 @@ get_object_path_header (GDBusMessage            *message,
   const gchar *ret;
 
   ret = NULL;
-  value = g_hash_table_lookup (message->headers, GUINT_TO_POINTER (header_field));
+  value = lookup_header (message, header_field);
   if (value != NULL && g_variant_is_of_type (value, G_VARIANT_TYPE_OBJECT_PATH))
     ret = g_variant_get_string (value, NULL);
 
@@ -3000,7 +4409,7 @@ get_signature_header (GDBusMessage            *message,
   const gchar *ret;
 
   ret = NULL;
-  value = g_hash_table_lookup (message->headers, GUINT_TO_POINTER (header_field));
+  value = lookup_header (message, header_field);
   if (value != NULL && g_variant_is_of_type (value, G_VARIANT_TYPE_SIGNATURE))
     ret = g_variant_get_string (value, NULL);
 
@@ -3367,15 +4776,17 @@ const gchar *
 g_dbus_message_get_arg0 (GDBusMessage  *message)
 {
   const gchar *ret;
+  GVariant *body;
 
   g_return_val_if_fail (G_IS_DBUS_MESSAGE (message), NULL);
 
   ret = NULL;
 
-  if (message->body != NULL && g_variant_is_of_type (message->body, G_VARIANT_TYPE_TUPLE))
+  body = ensure_body (message);
+  if (body != NULL && g_variant_is_of_type (body, G_VARIANT_TYPE_TUPLE))
     {
       GVariant *item;
-      item = g_variant_get_child_value (message->body, 0);
+      item = g_variant_get_child_value (body, 0);
       if (g_variant_is_of_type (item, G_VARIANT_TYPE_STRING))
         ret = g_variant_get_string (item, NULL);
       g_variant_unref (item);
@@ -3536,19 +4947,6 @@ flags_to_string (GType flags_type, guint value)
   return g_string_free (s, FALSE);
 }
 
-static gint
-_sort_keys_func (gconstpointer a,
-                 gconstpointer b)
-{
-  gint ia;
-  gint ib;
-
-  ia = GPOINTER_TO_INT (a);
-  ib = GPOINTER_TO_INT (b);
-
-  return ia - ib;
-}
-
 /**
  * g_dbus_message_print:
  * @message: A #GDBusMessage.
@@ -3599,8 +4997,9 @@ g_dbus_message_print (GDBusMessage *message,
 {
   GString *str;
   gchar *s;
-  GList *keys;
-  GList *l;
+  guchar fields[256];
+  guint n_fields, n;
+  GVariant *body;
 
   g_return_val_if_fail (G_IS_DBUS_MESSAGE (message), NULL);
 
@@ -3616,17 +5015,16 @@ g_dbus_message_print (GDBusMessage *message,
   g_string_append_printf (str, "%*sSerial:  %d\n", indent, "", message->serial);
 
   g_string_append_printf (str, "%*sHeaders:\n", indent, "");
-  keys = g_hash_table_get_keys (message->headers);
-  keys = g_list_sort (keys, _sort_keys_func);
-  if (keys != NULL)
+  n_fields = collect_header_fields (message, fields);
+  if (n_fields != 0)
     {
-      for (l = keys; l != NULL; l = l->next)
+      for (n = 0; n != n_fields; n++)
         {
-          gint key = GPOINTER_TO_INT (l->data);
+          gint key = fields[n];
           GVariant *value;
           gchar *value_str;
 
-          value = g_hash_table_lookup (message->headers, l->data);
+          value = lookup_header (message, key);
           g_assert (value != NULL);
 
           s = _g_dbus_enum_to_string (G_TYPE_DBUS_MESSAGE_HEADER_FIELD, key);
@@ -3640,11 +5038,11 @@ g_dbus_message_print (GDBusMessage *message,
     {
       g_string_append_printf (str, "%*s  (none)\n", indent, "");
     }
-  g_list_free (keys);
   g_string_append_printf (str, "%*sBody: ", indent, "");
-  if (message->body != NULL)
+  body = ensure_body (message);
+  if (body != NULL)
     {
-      g_variant_print_string (message->body,
+      g_variant_print_string (body,
                               str,
                               TRUE);
     }
@@ -3783,9 +5181,9 @@ g_dbus_message_copy (GDBusMessage  *message,
                      GError       **error)
 {
   GDBusMessage *ret;
-  GHashTableIter iter;
-  gpointer header_key;
-  GVariant *header_value;
+  guchar fields[256];
+  guint n_fields, n;
+  GVariant *body;
 
   g_return_val_if_fail (G_IS_DBUS_MESSAGE (message), NULL);
   g_return_val_if_fail (error == NULL || *error == NULL, NULL);
@@ -3823,10 +5221,16 @@ g_dbus_message_copy (GDBusMessage  *message,
   /* see https://bugzilla.gnome.org/show_bug.cgi?id=624546#c8 for why it's fine
    * to just ref (as opposed to deep-copying) the GVariant instances
    */
-  ret->body = message->body != NULL ? g_variant_ref (message->body) : NULL;
-  g_hash_table_iter_init (&iter, message->headers);
-  while (g_hash_table_iter_next (&iter, &header_key, (gpointer) &header_value))
-    g_hash_table_insert (ret->headers, header_key, g_variant_ref (header_value));
+  body = peek_body (message, &ret->lazy_blob);
+  ret->body = body != NULL ? g_variant_ref (body) : NULL;
+  if (ret->lazy_blob != NULL)
+    {
+      ret->lazy_body_offset = message->lazy_body_offset;
+      ret->lazy_body_type = g_variant_type_copy (message->lazy_body_type);
+    }
+  n_fields = collect_header_fields (message, fields);
+  for (n = 0; n != n_fields; n++)
+    store_header (ret, fields[n], g_variant_ref (lookup_header (message, fields[n])));
 
 #ifdef G_OS_UNIX
  out:
@@ -272,15 +272,23 @@ ensure_required_types (void)
 }
 /* ---------------------------------------------------------------------------------------------------- */
 
-typedef struct
+typedef struct _SharedThreadData SharedThreadData;
+
+struct _SharedThreadData
 {
   gint refcount;  /* (atomic) */
   GThread *thread;
   GMainContext *context;
   GMainLoop *loop;
-} SharedThreadData;
+  SharedThreadData **slot;
+};
+
+/* Connections with G_DBUS_CONNECTION_FLAGS_SHARDED_WORKER_THREAD are spread
+ * over up to one thread per processor, the rest share a single thread. */
+#define MAX_SHARDED_THREADS 16
 
 static SharedThreadData * gdbus_shared_thread_data = NULL;
+static SharedThreadData * gdbus_sharded_thread_data[MAX_SHARDED_THREADS];
 G_LOCK_DEFINE_STATIC (gdbus_shared_thread_data);
 
 static gpointer
@@ -335,28 +343,61 @@ gdbus_shared_thread_stop (SharedThreadData *data)
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+static guint
+get_n_sharded_threads (void)
+{
+  return CLAMP (g_get_num_processors (), 1, MAX_SHARDED_THREADS);
+}
+
+/* Must be called with gdbus_shared_thread_data lock held */
+static SharedThreadData **
+pick_sharded_thread_slot (void)
+{
+  SharedThreadData **best = NULL;
+  guint n, i;
+
+  /* Start every thread before doubling up, then keep the load even */
+  n = get_n_sharded_threads ();
+  for (i = 0; i != n; i++)
+    {
+      SharedThreadData **slot = &gdbus_sharded_thread_data[i];
+
+      if (*slot == NULL)
+        return slot;
+
+      if (best == NULL || (*slot)->refcount < (*best)->refcount)
+        best = slot;
+    }
+
+  return best;
+}
+
 static SharedThreadData *
-_g_dbus_shared_thread_ref (void)
+_g_dbus_shared_thread_ref (gboolean sharded)
 {
+  SharedThreadData **slot;
   SharedThreadData *ret;
 
   G_LOCK (gdbus_shared_thread_data);
 
-  if (gdbus_shared_thread_data == NULL)
+  slot = sharded ? pick_sharded_thread_slot () : &gdbus_shared_thread_data;
+
+  if (*slot == NULL)
     {
       SharedThreadData *data;
 
       data = g_new0 (SharedThreadData, 1);
       data->refcount = 1; /* Keep it around until deinit */
-      
+      data->slot = slot;
+
       data->context = g_main_context_new ();
       data->loop = g_main_loop_new (data->context, FALSE);
       gdbus_shared_thread_start (data);
 
-      gdbus_shared_thread_data = data;
+      *slot = data;
     }
 
-  ret = gdbus_shared_thread_data;
+  ret = *slot;
   ret->refcount++;
 
   G_UNLOCK (gdbus_shared_thread_data);
@@ -375,8 +416,8 @@ _g_dbus_shared_thread_unref (SharedThreadData *data)
 
       g_main_loop_unref (data->loop);
       g_main_context_unref (data->context);
+      *data->slot = NULL;
       g_free (data);
-      gdbus_shared_thread_data = NULL;
   }
 
   G_UNLOCK (gdbus_shared_thread_data);
@@ -391,6 +432,56 @@ typedef enum {
   READ_PAUSED
 } ReadState;
 
+/* Socket connections read as much as is available into a ReadSlab.
+ * Messages of at least READ_SLAB_SHARE_MIN_SIZE are parsed from a GBytes
+ * referencing the slab rather than from a private copy, and large values
+ * in them keep referencing it, so a slab is only rewound and reused once
+ * nobody else holds a reference to it. Smaller messages are copied out,
+ * as pinning a whole slab for each of them would cost more than the copy.
+ */
+typedef struct
+{
+  gint   ref_count;  /* (atomic) */
+  gsize  size;
+  gchar *data;
+} ReadSlab;
+
+#define READ_SLAB_SIZE            (64 * 1024)
+#define READ_SLAB_MIN_READ_SIZE   4096
+#define READ_SLAB_SHARE_MIN_SIZE  4096
+
+static ReadSlab *
+read_slab_new (gsize size)
+{
+  ReadSlab *slab;
+
+  slab = g_new (ReadSlab, 1);
+  slab->ref_count = 1;
+  slab->size = size;
+  slab->data = g_malloc (size);
+
+  return slab;
+}
+
+static ReadSlab *
+read_slab_ref (ReadSlab *slab)
+{
+  g_atomic_int_inc (&slab->ref_count);
+  return slab;
+}
+
+static void
+read_slab_unref (gpointer data)
+{
+  ReadSlab *slab = data;
+
+  if (g_atomic_int_dec_and_test (&slab->ref_count))
+    {
+      g_free (slab->data);
+      g_free (slab);
+    }
+}
+
 typedef enum {
     PENDING_NONE = 0,
     PENDING_WRITE,
@@ -437,6 +528,13 @@ struct GDBusWorker
   GUnixFDList                        *read_fd_list;
   GSocketControlMessage             **read_ancillary_messages;
   gint                                read_num_ancillary_messages;
+  /* used instead of read_buffer when socket is not NULL; the bytes
+   * between read_slab_offset and read_slab_len are the start of a
+   * message that has not been completely received yet
+   */
+  ReadSlab                           *read_slab;
+  gsize                               read_slab_offset;
+  gsize                               read_slab_len;
 
   /* Whether an async write, flush or close, or none of those, is pending.
    * Only the worker thread may change its value, and only with the write_lock.
@@ -450,6 +548,11 @@ struct GDBusWorker
   GQueue                             *write_queue;
   /* protected by write_lock */
   guint64                             write_num_messages_written;
+  /* number of messages handed to the stream but not yet counted as
+   * written, i.e. the size of the write batch currently in flight;
+   * protected by write_lock
+   */
+  guint                               write_num_messages_in_flight;
   /* number of messages we'd written out last time we flushed;
    * protected by write_lock
    */
@@ -484,11 +587,20 @@ typedef struct _MessageToWriteData MessageToWriteData;
 
 static void message_to_write_data_free (MessageToWriteData *data);
 
-static void read_message_print_transport_debug (gssize bytes_read,
+static void read_message_print_transport_debug (gssize       bytes_read,
+                                                const gchar *buffer,
+                                                gsize        cur_size,
                                                 GDBusWorker *worker);
 
 static void write_message_print_transport_debug (gssize bytes_written,
                                                  MessageToWriteData *data);
+#ifdef G_OS_UNIX
+struct _WriteBatchData;
+typedef struct _WriteBatchData WriteBatchData;
+
+static void write_batch_print_transport_debug (gssize          bytes_written,
+                                               WriteBatchData *batch);
+#endif
 
 typedef struct {
     GDBusWorker *worker;
@@ -534,6 +646,8 @@ _g_dbus_worker_unref (GDBusWorker *worker)
       g_mutex_clear (&worker->write_lock);
       g_queue_free_full (worker->write_queue, (GDestroyNotify) message_to_write_data_free);
       g_free (worker->read_buffer);
+      if (worker->read_slab != NULL)
+        read_slab_unref (worker->read_slab);
 
       g_free (worker);
 
@@ -644,6 +758,228 @@ _g_dbus_worker_unfreeze (GDBusWorker *worker)
 
 static void _g_dbus_worker_do_read_unlocked (GDBusWorker *worker);
 
+#ifdef G_OS_UNIX
+/* Takes the received file descriptors belonging to @message. Descriptors
+ * arrive along with the first byte of their message, so when several
+ * messages are read at once any surplus belongs to a later message.
+ */
+static GUnixFDList *
+_g_dbus_worker_take_fds_for_message (GDBusWorker  *worker,
+                                     GDBusMessage *message)
+{
+  GUnixFDList *fd_list;
+  guint32 num_wanted;
+  gint num_fds;
+  gint *fds;
+
+  num_wanted = g_dbus_message_get_num_unix_fds (message);
+  num_fds = g_unix_fd_list_get_length (worker->read_fd_list);
+
+  if (num_wanted == 0)
+    return NULL;
+
+  if (num_wanted >= (guint32) num_fds)
+    return g_steal_pointer (&worker->read_fd_list);
+
+  fds = g_unix_fd_list_steal_fds (worker->read_fd_list, NULL);
+  g_object_unref (worker->read_fd_list);
+  fd_list = g_unix_fd_list_new_from_array (fds, num_wanted);
+  worker->read_fd_list = g_unix_fd_list_new_from_array (fds + num_wanted, num_fds - num_wanted);
+  g_free (fds);
+
+  return fd_list;
+}
+#endif
+
+/* called in private thread shared by all GDBusConnection instances (with read-lock held)
+ *
+ * Decodes and delivers the message in @bytes. If @share_bytes is %TRUE the
+ * message may keep referencing @bytes. Returns %FALSE if the message could
+ * not be decoded, in which case the worker has been disconnected.
+ */
+static gboolean
+_g_dbus_worker_handle_received_message (GDBusWorker *worker,
+                                        GBytes      *bytes,
+                                        gboolean     share_bytes)
+{
+  GDBusMessage *message;
+  const gchar *blob;
+  gsize blob_len;
+  GError *error = NULL;
+
+  blob = g_bytes_get_data (bytes, &blob_len);
+
+  /* TODO: use connection->priv->auth to decode the message */
+
+  if (share_bytes)
+    message = _g_dbus_message_new_from_bytes (bytes,
+                                              worker->capabilities,
+                                              &error);
+  else
+    message = g_dbus_message_new_from_blob ((guchar *) blob,
+                                            blob_len,
+                                            worker->capabilities,
+                                            &error);
+  if (message == NULL)
+    {
+      gchar *s;
+      s = _g_dbus_hexdump (blob, blob_len, 2);
+      g_warning ("Error decoding D-Bus message of %" G_GSIZE_FORMAT " bytes\n"
+                 "The error is: %s\n"
+                 "The payload is as follows:\n"
+                 "%s",
+                 blob_len,
+                 error->message,
+                 s);
+      g_free (s);
+      _g_dbus_worker_update_read_state (worker, READ_STOPPED);
+      _g_dbus_worker_emit_disconnected (worker, FALSE, error);
+      g_error_free (error);
+      return FALSE;
+    }
+
+#ifdef G_OS_UNIX
+  if (worker->read_fd_list != NULL)
+    {
+      GUnixFDList *fd_list;
+
+      fd_list = _g_dbus_worker_take_fds_for_message (worker, message);
+      if (fd_list != NULL)
+        {
+          g_dbus_message_set_unix_fd_list (message, fd_list);
+          g_object_unref (fd_list);
+        }
+    }
+#endif
+
+  if (G_UNLIKELY (_g_dbus_debug_message ()))
+    {
+      gchar *s;
+      _g_dbus_debug_print_lock ();
+      g_print ("========================================================================\n"
+               "GDBus-debug:Message:\n"
+               "  <<<< RECEIVED D-Bus message (%" G_GSIZE_FORMAT " bytes)\n",
+               blob_len);
+      s = g_dbus_message_print (message, 2);
+      g_print ("%s", s);
+      g_free (s);
+      if (G_UNLIKELY (_g_dbus_debug_payload ()))
+        {
+          s = _g_dbus_hexdump (blob, blob_len, 2);
+          g_print ("%s\n", s);
+          g_free (s);
+        }
+      _g_dbus_debug_print_unlock ();
+    }
+
+  /* yay, got a message, go deliver it */
+  _g_dbus_worker_queue_or_deliver_received_message (worker, g_steal_pointer (&message));
+
+  return TRUE;
+}
+
+/* called in private thread shared by all GDBusConnection instances (with read-lock held)
+ *
+ * Delivers every complete message in the read slab and records the size of
+ * the incomplete one following them, if known, in read_buffer_bytes_wanted.
+ * Returns %FALSE if the worker has been disconnected.
+ */
+static gboolean
+_g_dbus_worker_consume_read_slab (GDBusWorker *worker)
+{
+  ReadSlab *slab = worker->read_slab;
+
+  worker->read_buffer_bytes_wanted = 0;
+
+  while (worker->read_slab_len - worker->read_slab_offset >= 16)
+    {
+      const gchar *blob = slab->data + worker->read_slab_offset;
+      guint32 header[4];
+      gssize message_len;
+      GBytes *bytes;
+      gboolean ok;
+      GError *error = NULL;
+
+      /* messages aren't padded to 8 bytes, so the header may be unaligned */
+      memcpy (header, blob, sizeof (header));
+      message_len = g_dbus_message_bytes_needed ((guchar *) header, 16, &error);
+      if (message_len == -1)
+        {
+          g_warning ("_g_dbus_worker_do_read_cb: error determining bytes needed: %s", error->message);
+          _g_dbus_worker_update_read_state (worker, READ_STOPPED);
+          _g_dbus_worker_emit_disconnected (worker, FALSE, error);
+          g_error_free (error);
+          return FALSE;
+        }
+
+      if (worker->read_slab_len - worker->read_slab_offset < (gsize) message_len)
+        {
+          worker->read_buffer_bytes_wanted = message_len;
+          break;
+        }
+
+      if (message_len >= READ_SLAB_SHARE_MIN_SIZE)
+        bytes = g_bytes_new_with_free_func (blob, message_len,
+                                            read_slab_unref, read_slab_ref (slab));
+      else
+        bytes = g_bytes_new (blob, message_len);
+      worker->read_slab_offset += message_len;
+
+      ok = _g_dbus_worker_handle_received_message (worker, bytes, TRUE);
+      g_bytes_unref (bytes);
+      if (!ok)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* called in private thread shared by all GDBusConnection instances (with read-lock held)
+ *
+ * Makes sure the read slab has room for the rest of the message being
+ * received and then some, moving the partial message to the start of the
+ * slab, or into a fresh one if the current one is still referenced.
+ */
+static void
+_g_dbus_worker_prepare_read_slab (GDBusWorker *worker)
+{
+  ReadSlab *slab = worker->read_slab;
+  gsize pending;
+  gsize wanted;
+  ReadSlab *new_slab;
+
+  pending = worker->read_slab_len - worker->read_slab_offset;
+  wanted = MAX (worker->read_buffer_bytes_wanted, 16) - pending;
+  wanted = MAX (wanted, READ_SLAB_MIN_READ_SIZE);
+
+  if (slab != NULL && pending == 0 && g_atomic_int_get (&slab->ref_count) == 1)
+    {
+      worker->read_slab_offset = 0;
+      worker->read_slab_len = 0;
+    }
+
+  if (slab != NULL && slab->size - worker->read_slab_len >= wanted)
+    return;
+
+  if (slab != NULL && slab->size >= pending + wanted && g_atomic_int_get (&slab->ref_count) == 1)
+    {
+      memmove (slab->data, slab->data + worker->read_slab_offset, pending);
+    }
+  else
+    {
+      new_slab = read_slab_new (MAX (READ_SLAB_SIZE, pending + wanted));
+      if (slab != NULL)
+        {
+          memcpy (new_slab->data, slab->data + worker->read_slab_offset, pending);
+          read_slab_unref (slab);
+        }
+      worker->read_slab = new_slab;
+    }
+
+  worker->read_slab_offset = 0;
+  worker->read_slab_len = pending;
+}
+
 /* called in private thread shared by all GDBusConnection instances (without read-lock held) */
 static void
 _g_dbus_worker_do_read_cb (GInputStream  *input_stream,
@@ -814,7 +1150,23 @@ _g_dbus_worker_do_read_cb (GInputStream  *input_stream,
       goto out;
     }
 
-  read_message_print_transport_debug (bytes_read, worker);
+  if (worker->socket != NULL)
+    {
+      read_message_print_transport_debug (bytes_read,
+                                          worker->read_slab->data + worker->read_slab_offset,
+                                          worker->read_slab_len - worker->read_slab_offset,
+                                          worker);
+
+      worker->read_slab_len += bytes_read;
+      if (_g_dbus_worker_consume_read_slab (worker))
+        _g_dbus_worker_do_read_unlocked (worker);
+      goto out;
+    }
+
+  read_message_print_transport_debug (bytes_read,
+                                      worker->read_buffer,
+                                      worker->read_buffer_cur_size,
+                                      worker);
 
   worker->read_buffer_cur_size += bytes_read;
   if (worker->read_buffer_bytes_wanted == worker->read_buffer_cur_size)
@@ -842,64 +1194,14 @@ _g_dbus_worker_do_read_cb (GInputStream  *input_stream,
         }
       else
         {
-          GDBusMessage *message;
-          error = NULL;
-
-          /* TODO: use connection->priv->auth to decode the message */
-
-          message = g_dbus_message_new_from_blob ((guchar *) worker->read_buffer,
-                                                  worker->read_buffer_cur_size,
-                                                  worker->capabilities,
-                                                  &error);
-          if (message == NULL)
-            {
-              gchar *s;
-              s = _g_dbus_hexdump (worker->read_buffer, worker->read_buffer_cur_size, 2);
-              g_warning ("Error decoding D-Bus message of %" G_GSIZE_FORMAT " bytes\n"
-                         "The error is: %s\n"
-                         "The payload is as follows:\n"
-                         "%s",
-                         worker->read_buffer_cur_size,
-                         error->message,
-                         s);
-              g_free (s);
-              _g_dbus_worker_update_read_state (worker, READ_STOPPED);
-              _g_dbus_worker_emit_disconnected (worker, FALSE, error);
-              g_error_free (error);
-              goto out;
-            }
-
-#ifdef G_OS_UNIX
-          if (worker->read_fd_list != NULL)
-            {
-              g_dbus_message_set_unix_fd_list (message, worker->read_fd_list);
-              g_object_unref (worker->read_fd_list);
-              worker->read_fd_list = NULL;
-            }
-#endif
+          GBytes *bytes;
+          gboolean ok;
 
-          if (G_UNLIKELY (_g_dbus_debug_message ()))
-            {
-              gchar *s;
-              _g_dbus_debug_print_lock ();
-              g_print ("========================================================================\n"
-                       "GDBus-debug:Message:\n"
-                       "  <<<< RECEIVED D-Bus message (%" G_GSIZE_FORMAT " bytes)\n",
-                       worker->read_buffer_cur_size);
-              s = g_dbus_message_print (message, 2);
-              g_print ("%s", s);
-              g_free (s);
-              if (G_UNLIKELY (_g_dbus_debug_payload ()))
-                {
-                  s = _g_dbus_hexdump (worker->read_buffer, worker->read_buffer_cur_size, 2);
-                  g_print ("%s\n", s);
-                  g_free (s);
-                }
-              _g_dbus_debug_print_unlock ();
-            }
-
-          /* yay, got a message, go deliver it */
-          _g_dbus_worker_queue_or_deliver_received_message (worker, g_steal_pointer (&message));
+          bytes = g_bytes_new_static (worker->read_buffer, worker->read_buffer_cur_size);
+          ok = _g_dbus_worker_handle_received_message (worker, bytes, FALSE);
+          g_bytes_unref (bytes);
+          if (!ok)
+            goto out;
 
           /* start reading another message! */
           worker->read_buffer_bytes_wanted = 0;
@@ -931,36 +1233,43 @@ _g_dbus_worker_do_read_unlocked (GDBusWorker *worker)
    * true, because only failing a read causes us to signal 'closed'.
    */
 
-  /* if bytes_wanted is zero, it means start reading a message */
-  if (worker->read_buffer_bytes_wanted == 0)
+  if (worker->socket == NULL)
     {
-      worker->read_buffer_cur_size = 0;
-      worker->read_buffer_bytes_wanted = 16;
-    }
+      /* if bytes_wanted is zero, it means start reading a message */
+      if (worker->read_buffer_bytes_wanted == 0)
+        {
+          worker->read_buffer_cur_size = 0;
+          worker->read_buffer_bytes_wanted = 16;
+        }
 
-  /* ensure we have a (big enough) buffer */
-  if (worker->read_buffer == NULL || worker->read_buffer_bytes_wanted > worker->read_buffer_allocated_size)
-    {
-      /* TODO: 4096 is randomly chosen; might want a better chosen default minimum */
-      worker->read_buffer_allocated_size = MAX (worker->read_buffer_bytes_wanted, 4096);
-      worker->read_buffer = g_realloc (worker->read_buffer, worker->read_buffer_allocated_size);
-    }
+      /* ensure we have a (big enough) buffer */
+      if (worker->read_buffer == NULL || worker->read_buffer_bytes_wanted > worker->read_buffer_allocated_size)
+        {
+          /* TODO: 4096 is randomly chosen; might want a better chosen default minimum */
+          worker->read_buffer_allocated_size = MAX (worker->read_buffer_bytes_wanted, 4096);
+          worker->read_buffer = g_realloc (worker->read_buffer, worker->read_buffer_allocated_size);
+        }
 
-  if (worker->socket == NULL)
-    g_input_stream_read_async (g_io_stream_get_input_stream (worker->stream),
-                               worker->read_buffer + worker->read_buffer_cur_size,
-                               worker->read_buffer_bytes_wanted - worker->read_buffer_cur_size,
-                               G_PRIORITY_DEFAULT,
-                               worker->rx_cancellable,
-                               (GAsyncReadyCallback) _g_dbus_worker_do_read_cb,
-                               _g_dbus_worker_ref (worker));
+      g_input_stream_read_async (g_io_stream_get_input_stream (worker->stream),
+                                 worker->read_buffer + worker->read_buffer_cur_size,
+                                 worker->read_buffer_bytes_wanted - worker->read_buffer_cur_size,
+                                 G_PRIORITY_DEFAULT,
+                                 worker->rx_cancellable,
+                                 (GAsyncReadyCallback) _g_dbus_worker_do_read_cb,
+                                 _g_dbus_worker_ref (worker));
+    }
   else
     {
+      /* read as much as is available; the socket is a byte stream, so
+       * this may well cover several messages
+       */
+      _g_dbus_worker_prepare_read_slab (worker);
+
       worker->read_ancillary_messages = NULL;
       worker->read_num_ancillary_messages = 0;
       _g_socket_read_with_control_messages (worker->socket,
-                                            worker->read_buffer + worker->read_buffer_cur_size,
-                                            worker->read_buffer_bytes_wanted - worker->read_buffer_cur_size,
+                                            worker->read_slab->data + worker->read_slab_len,
+                                            worker->read_slab->size - worker->read_slab_len,
                                             &worker->read_ancillary_messages,
                                             &worker->read_num_ancillary_messages,
                                             G_PRIORITY_DEFAULT,
@@ -1008,6 +1317,9 @@ struct _MessageToWriteData
 
   gsize         total_written;
   GTask        *task;
+
+  /* whether the about-to-be-sent filters have already been run */
+  gboolean      filtered;
 };
 
 static void
@@ -1406,7 +1718,10 @@ prepare_flush_unlocked (GDBusWorker *worker)
       FlushData *f = l->data;
       ll = l->next;
 
-      if (f->number_to_wait_for == worker->write_num_messages_written)
+      /* batches end at the nearest flush target, but complete any
+       * flush that a write has gone past all the same
+       */
+      if (f->number_to_wait_for <= worker->write_num_messages_written)
         {
           flushers = g_list_append (flushers, f);
           worker->write_pending_flushes = g_list_delete_link (worker->write_pending_flushes, l);
@@ -1447,6 +1762,7 @@ write_message_cb (GObject       *source_object,
   g_mutex_lock (&data->worker->write_lock);
   g_assert (data->worker->output_pending == PENDING_WRITE);
   data->worker->output_pending = PENDING_NONE;
+  data->worker->write_num_messages_in_flight = 0;
 
   error = NULL;
   if (!write_message_finish (res, &error))
@@ -1469,6 +1785,393 @@ write_message_cb (GObject       *source_object,
   message_to_write_data_free (data);
 }
 
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* called in private thread shared by all GDBusConnection instances
+ *
+ * write-lock is not held on entry
+ *
+ * Runs the filter functions on @data, re-encoding the blob if they altered
+ * the message. Returns %FALSE if the filters dropped the message.
+ */
+static gboolean
+filter_message_to_write (GDBusWorker        *worker,
+                         MessageToWriteData *data)
+{
+  GDBusMessage *old_message;
+  guchar *new_blob;
+  gsize new_blob_size;
+  GError *error;
+
+  if (data->filtered)
+    return TRUE;
+  data->filtered = TRUE;
+
+  old_message = data->message;
+  data->message = _g_dbus_worker_emit_message_about_to_be_sent (worker, data->message);
+  if (data->message == old_message)
+    {
+      /* filters had no effect - do nothing */
+    }
+  else if (data->message == NULL)
+    {
+      /* filters dropped message */
+      return FALSE;
+    }
+  else
+    {
+      /* filters altered the message -> re-encode */
+      error = NULL;
+      new_blob = g_dbus_message_to_blob (data->message,
+                                         &new_blob_size,
+                                         worker->capabilities,
+                                         &error);
+      if (new_blob == NULL)
+        {
+          /* if filter make the GDBusMessage unencodeable, just complain on stderr and send
+           * the old message instead
+           */
+          g_warning ("Error encoding GDBusMessage with serial %d altered by filter function: %s",
+                     g_dbus_message_get_serial (data->message),
+                     error->message);
+          g_error_free (error);
+        }
+      else
+        {
+          g_free (data->blob);
+          data->blob = (gchar *) new_blob;
+          data->blob_size = new_blob_size;
+        }
+    }
+
+  return TRUE;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+#ifdef G_OS_UNIX
+
+/* Upper bounds for coalescing queued messages into a single sendmsg() */
+#define WRITE_BATCH_MAX_MESSAGES 64
+#define WRITE_BATCH_MAX_BYTES    (256 * 1024)
+
+/* A run of queued messages written out with one scatter-gather send.
+ *
+ * The kernel delivers SCM_RIGHTS with the first byte of the send it was
+ * attached to, and the peer assigns received fds to the message it is
+ * currently reading. So only the first message of a batch may carry file
+ * descriptors; a message with fds always starts a new batch.
+ */
+struct _WriteBatchData
+{
+  GDBusWorker   *worker;
+  /* of MessageToWriteData, in queue order */
+  GPtrArray     *messages;
+  /* one per message, consumed from the front as bytes are written */
+  GOutputVector *vectors;
+  guint          cur_vector;
+  gsize          total_size;
+  gsize          total_written;
+};
+
+static void
+write_batch_data_free (WriteBatchData *batch)
+{
+  g_ptr_array_unref (batch->messages);
+  g_free (batch->vectors);
+  _g_dbus_worker_unref (batch->worker);
+  g_slice_free (WriteBatchData, batch);
+}
+
+static gboolean
+message_to_write_data_has_fds (MessageToWriteData *data)
+{
+  GUnixFDList *fd_list;
+
+  fd_list = g_dbus_message_get_unix_fd_list (data->message);
+
+  return fd_list != NULL && g_unix_fd_list_get_length (fd_list) > 0;
+}
+
+/* called in private thread shared by all GDBusConnection instances
+ *
+ * write-lock is held on entry
+ *
+ * Returns: the number of messages that can be written before the nearest
+ *   pending flush has to be started, or %G_MAXUINT64 if none is pending
+ */
+static guint64
+write_batch_get_limit_unlocked (GDBusWorker *worker)
+{
+  guint64 limit = G_MAXUINT64;
+  GList *l;
+
+  for (l = worker->write_pending_flushes; l != NULL; l = l->next)
+    {
+      FlushData *f = l->data;
+
+      if (f->number_to_wait_for > worker->write_num_messages_written)
+        limit = MIN (limit, f->number_to_wait_for - worker->write_num_messages_written);
+      else
+        limit = 0;
+    }
+
+  return limit;
+}
+
+/* called in private thread shared by all GDBusConnection instances
+ *
+ * write-lock is not held on entry
+ * output_pending is PENDING_WRITE on entry, with @head in flight
+ *
+ * Returns: (nullable): a batch starting with @head, or %NULL if no other
+ *   message could be sent along with it
+ */
+static WriteBatchData *
+write_batch_collect (GDBusWorker        *worker,
+                     MessageToWriteData *head)
+{
+  WriteBatchData *batch;
+  gsize total_size;
+  guint n;
+
+  batch = NULL;
+  total_size = head->blob_size;
+
+  while (batch == NULL || batch->messages->len < WRITE_BATCH_MAX_MESSAGES)
+    {
+      MessageToWriteData *data, *next;
+
+      data = NULL;
+
+      g_mutex_lock (&worker->write_lock);
+      /* if we want to close the connection, that takes precedence; and a
+       * batch must not carry messages queued after a pending flush past it
+       */
+      next = g_queue_peek_head (worker->write_queue);
+      if (worker->pending_close_attempts == NULL &&
+          next != NULL &&
+          (batch != NULL ? batch->messages->len : 1) < write_batch_get_limit_unlocked (worker) &&
+          total_size + next->blob_size <= WRITE_BATCH_MAX_BYTES &&
+          !message_to_write_data_has_fds (next))
+        {
+          data = g_queue_pop_head (worker->write_queue);
+          worker->write_num_messages_in_flight++;
+        }
+      g_mutex_unlock (&worker->write_lock);
+
+      if (data == NULL)
+        break;
+
+      if (!filter_message_to_write (worker, data))
+        {
+          g_mutex_lock (&worker->write_lock);
+          worker->write_num_messages_in_flight--;
+          g_mutex_unlock (&worker->write_lock);
+          message_to_write_data_free (data);
+          continue;
+        }
+
+      if (total_size + data->blob_size > WRITE_BATCH_MAX_BYTES ||
+          message_to_write_data_has_fds (data))
+        {
+          /* the filters made it unfit for this batch, so it goes first in the next one */
+          g_mutex_lock (&worker->write_lock);
+          g_queue_push_head (worker->write_queue, data);
+          worker->write_num_messages_in_flight--;
+          g_mutex_unlock (&worker->write_lock);
+          break;
+        }
+
+      if (batch == NULL)
+        {
+          batch = g_slice_new0 (WriteBatchData);
+          batch->worker = _g_dbus_worker_ref (worker);
+          batch->messages = g_ptr_array_new_full (WRITE_BATCH_MAX_MESSAGES,
+                                                  (GDestroyNotify) message_to_write_data_free);
+          g_ptr_array_add (batch->messages, head);
+        }
+      g_ptr_array_add (batch->messages, data);
+      total_size += data->blob_size;
+    }
+
+  if (batch == NULL)
+    return NULL;
+
+  batch->vectors = g_new (GOutputVector, batch->messages->len);
+  for (n = 0; n != batch->messages->len; n++)
+    {
+      MessageToWriteData *data = g_ptr_array_index (batch->messages, n);
+
+      batch->vectors[n].buffer = data->blob;
+      batch->vectors[n].size = data->blob_size;
+    }
+  batch->total_size = total_size;
+
+  return batch;
+}
+
+/* called in private thread shared by all GDBusConnection instances
+ *
+ * write-lock is not held on entry
+ * output_pending is PENDING_WRITE on entry
+ */
+static void
+write_batch_complete (WriteBatchData *batch,
+                      GError         *error)
+{
+  GDBusWorker *worker = batch->worker;
+  guint n;
+
+  g_mutex_lock (&worker->write_lock);
+  g_assert (worker->output_pending == PENDING_WRITE);
+  worker->output_pending = PENDING_NONE;
+  worker->write_num_messages_in_flight = 0;
+
+  if (error != NULL)
+    {
+      g_mutex_unlock (&worker->write_lock);
+
+      /* TODO: handle */
+      _g_dbus_worker_emit_disconnected (worker, TRUE, error);
+      g_error_free (error);
+
+      g_mutex_lock (&worker->write_lock);
+    }
+
+  for (n = 0; n != batch->messages->len; n++)
+    message_written_unlocked (worker, g_ptr_array_index (batch->messages, n));
+
+  g_mutex_unlock (&worker->write_lock);
+
+  continue_writing (worker);
+
+  write_batch_data_free (batch);
+}
+
+static void
+write_batch_advance (WriteBatchData *batch,
+                     gsize           bytes_written)
+{
+  batch->total_written += bytes_written;
+  g_assert (batch->total_written <= batch->total_size);
+
+  while (bytes_written > 0)
+    {
+      GOutputVector *vector = &batch->vectors[batch->cur_vector];
+
+      if (bytes_written < vector->size)
+        {
+          vector->buffer = (const guint8 *) vector->buffer + bytes_written;
+          vector->size -= bytes_written;
+          break;
+        }
+
+      bytes_written -= vector->size;
+      batch->cur_vector++;
+    }
+}
+
+static gboolean on_write_batch_socket_ready (GSocket      *socket,
+                                             GIOCondition  condition,
+                                             gpointer      user_data);
+
+/* called in private thread shared by all GDBusConnection instances
+ *
+ * write-lock is not held on entry
+ * output_pending is PENDING_WRITE on entry
+ */
+static void
+write_batch_continue_writing (WriteBatchData *batch)
+{
+  GDBusWorker *worker = batch->worker;
+  GError *error = NULL;
+
+  while (batch->total_written < batch->total_size)
+    {
+      GSocketControlMessage *control_message;
+      gssize bytes_written;
+
+      control_message = NULL;
+      if (batch->total_written == 0)
+        {
+          MessageToWriteData *head = g_ptr_array_index (batch->messages, 0);
+
+          if (message_to_write_data_has_fds (head))
+            {
+              if (!(worker->capabilities & G_DBUS_CAPABILITY_FLAGS_UNIX_FD_PASSING))
+                {
+                  g_set_error_literal (&error,
+                                       G_IO_ERROR,
+                                       G_IO_ERROR_FAILED,
+                                       "Tried sending a file descriptor but remote peer does not support this capability");
+                  break;
+                }
+              control_message = g_unix_fd_message_new_with_fd_list (g_dbus_message_get_unix_fd_list (head->message));
+            }
+        }
+
+      bytes_written = g_socket_send_message (worker->socket,
+                                             NULL, /* address */
+                                             batch->vectors + batch->cur_vector,
+                                             batch->messages->len - batch->cur_vector,
+                                             control_message != NULL ? &control_message : NULL,
+                                             control_message != NULL ? 1 : 0,
+                                             G_SOCKET_MSG_NONE,
+                                             worker->tx_cancellable,
+                                             &error);
+      if (control_message != NULL)
+        g_object_unref (control_message);
+
+      if (bytes_written == -1)
+        {
+          /* Handle WOULD_BLOCK by waiting until there's room in the buffer */
+          if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+            {
+              GSource *source;
+              source = g_socket_create_source (worker->socket,
+                                               G_IO_OUT | G_IO_HUP | G_IO_ERR,
+                                               worker->tx_cancellable);
+              g_source_set_callback (source,
+                                     (GSourceFunc) on_write_batch_socket_ready,
+                                     batch,
+                                     NULL); /* GDestroyNotify */
+              g_source_attach (source, g_main_context_get_thread_default ());
+              g_source_unref (source);
+              g_error_free (error);
+              return;
+            }
+          break;
+        }
+      g_assert (bytes_written > 0); /* zero is never returned */
+
+      write_batch_print_transport_debug (bytes_written, batch);
+
+      write_batch_advance (batch, bytes_written);
+    }
+
+  write_batch_complete (batch, error);
+}
+
+/* called in private thread shared by all GDBusConnection instances
+ *
+ * write-lock is not held on entry
+ * output_pending is PENDING_WRITE on entry
+ */
+static gboolean
+on_write_batch_socket_ready (GSocket      *socket,
+                             GIOCondition  condition,
+                             gpointer      user_data)
+{
+  WriteBatchData *batch = user_data;
+  write_batch_continue_writing (batch);
+  return FALSE; /* remove source */
+}
+
+#endif /* G_OS_UNIX */
+
+/* ---------------------------------------------------------------------------------------------------- */
+
 /* called in private thread shared by all GDBusConnection instances
  *
  * write-lock is not held on entry
@@ -1582,7 +2285,10 @@ continue_writing (GDBusWorker *worker)
           data = g_queue_pop_head (worker->write_queue);
 
           if (data != NULL)
-            worker->output_pending = PENDING_WRITE;
+            {
+              worker->output_pending = PENDING_WRITE;
+              worker->write_num_messages_in_flight = 1;
+            }
         }
     }
 
@@ -1604,51 +2310,31 @@ continue_writing (GDBusWorker *worker)
     }
   else if (data != NULL)
     {
-      GDBusMessage *old_message;
-      guchar *new_blob;
-      gsize new_blob_size;
-      GError *error;
-
-      old_message = data->message;
-      data->message = _g_dbus_worker_emit_message_about_to_be_sent (worker, data->message);
-      if (data->message == old_message)
-        {
-          /* filters had no effect - do nothing */
-        }
-      else if (data->message == NULL)
+      if (!filter_message_to_write (worker, data))
         {
           /* filters dropped message */
           g_mutex_lock (&worker->write_lock);
           worker->output_pending = PENDING_NONE;
+          worker->write_num_messages_in_flight = 0;
           g_mutex_unlock (&worker->write_lock);
           message_to_write_data_free (data);
           goto write_next;
         }
-      else
+
+#ifdef G_OS_UNIX
+      if (worker->socket != NULL &&
+          G_IS_SOCKET_OUTPUT_STREAM (g_io_stream_get_output_stream (worker->stream)))
         {
-          /* filters altered the message -> re-encode */
-          error = NULL;
-          new_blob = g_dbus_message_to_blob (data->message,
-                                             &new_blob_size,
-                                             worker->capabilities,
-                                             &error);
-          if (new_blob == NULL)
-            {
-              /* if filter make the GDBusMessage unencodeable, just complain on stderr and send
-               * the old message instead
-               */
-              g_warning ("Error encoding GDBusMessage with serial %d altered by filter function: %s",
-                         g_dbus_message_get_serial (data->message),
-                         error->message);
-              g_error_free (error);
-            }
-          else
+          WriteBatchData *batch;
+
+          batch = write_batch_collect (worker, data);
+          if (batch != NULL)
             {
-              g_free (data->blob);
-              data->blob = (gchar *) new_blob;
-              data->blob_size = new_blob_size;
+              write_batch_continue_writing (batch);
+              return;
             }
         }
+#endif
 
       write_message_async (worker,
                            data,
@@ -1769,6 +2455,7 @@ GDBusWorker *
 _g_dbus_worker_new (GIOStream                              *stream,
                     GDBusCapabilityFlags                    capabilities,
                     gboolean                                initially_frozen,
+                    gboolean                                sharded,
                     GDBusWorkerMessageReceivedCallback      message_received_callback,
                     GDBusWorkerMessageAboutToBeSentCallback message_about_to_be_sent_callback,
                     GDBusWorkerDisconnectedCallback         disconnected_callback,
@@ -1806,7 +2493,7 @@ _g_dbus_worker_new (GIOStream                              *stream,
   if (G_IS_SOCKET_CONNECTION (worker->stream))
     worker->socket = g_socket_connection_get_socket (G_SOCKET_CONNECTION (worker->stream));
 
-  worker->shared_thread_data = _g_dbus_shared_thread_ref ();
+  worker->shared_thread_data = _g_dbus_shared_thread_ref (sharded);
 
   _g_dbus_worker_begin_reading (worker);
 
@@ -1898,10 +2585,11 @@ _g_dbus_worker_flush_sync (GDBusWorker    *worker,
   pending_writes = g_queue_get_length (worker->write_queue);
 
   /* if a write is in-flight, we shouldn't be satisfied until the first
-   * flush operation that follows it
+   * flush operation that follows it; a batched write carries several
+   * messages at once
    */
   if (worker->output_pending == PENDING_WRITE)
-    pending_writes += 1;
+    pending_writes += worker->write_num_messages_in_flight;
 
   if (pending_writes > 0 ||
       worker->write_num_messages_written != worker->write_num_messages_flushed)
@@ -2098,6 +2786,8 @@ _g_dbus_initialize (void)
 void
 _g_dbus_shutdown (void)
 {
+  guint i;
+
   G_LOCK (gdbus_workers);
   while (gdbus_workers != NULL)
     g_cond_wait (&gdbus_workers_cond, &G_LOCK_NAME (gdbus_workers));
@@ -2108,6 +2798,17 @@ _g_dbus_shutdown (void)
       g_assert_cmpint (gdbus_shared_thread_data->refcount, ==, 1); /* if not, there's a leak */
       _g_dbus_shared_thread_unref (gdbus_shared_thread_data);
     }
+
+  for (i = 0; i != G_N_ELEMENTS (gdbus_sharded_thread_data); i++)
+    {
+      SharedThreadData *data = gdbus_sharded_thread_data[i];
+
+      if (data != NULL)
+        {
+          g_assert_cmpint (data->refcount, ==, 1); /* if not, there's a leak */
+          _g_dbus_shared_thread_unref (data);
+        }
+    }
 }
 
 void
@@ -2120,6 +2821,7 @@ void
 _g_dbus_prepare_to_fork (void)
 {
   GSList *workers, *l;
+  guint i;
 
   G_LOCK (gdbus_workers);
   workers = g_slist_copy_deep (gdbus_workers,
@@ -2164,6 +2866,11 @@ _g_dbus_prepare_to_fork (void)
   G_LOCK (gdbus_shared_thread_data);
   if (gdbus_shared_thread_data != NULL)
     gdbus_shared_thread_stop (gdbus_shared_thread_data);
+  for (i = 0; i != G_N_ELEMENTS (gdbus_sharded_thread_data); i++)
+    {
+      if (gdbus_sharded_thread_data[i] != NULL)
+        gdbus_shared_thread_stop (gdbus_sharded_thread_data[i]);
+    }
   G_UNLOCK (gdbus_shared_thread_data);
 }
 
@@ -2171,10 +2878,16 @@ void
 _g_dbus_recover_from_fork_in_parent (void)
 {
   GSList *workers, *l;
+  guint i;
 
   G_LOCK (gdbus_shared_thread_data);
   if (gdbus_shared_thread_data != NULL)
     gdbus_shared_thread_start (gdbus_shared_thread_data);
+  for (i = 0; i != G_N_ELEMENTS (gdbus_sharded_thread_data); i++)
+    {
+      if (gdbus_sharded_thread_data[i] != NULL)
+        gdbus_shared_thread_start (gdbus_sharded_thread_data[i]);
+    }
   G_UNLOCK (gdbus_shared_thread_data);
 
   G_LOCK (gdbus_workers);
@@ -2204,6 +2917,7 @@ void
 _g_dbus_recover_from_fork_in_child (void)
 {
   GSList *workers, *l;
+  guint i;
 
   G_LOCK (gdbus_workers);
   workers = g_slist_copy_deep (gdbus_workers,
@@ -2223,6 +2937,11 @@ _g_dbus_recover_from_fork_in_child (void)
   G_LOCK (gdbus_shared_thread_data);
   if (gdbus_shared_thread_data != NULL)
     gdbus_shared_thread_start (gdbus_shared_thread_data);
+  for (i = 0; i != G_N_ELEMENTS (gdbus_sharded_thread_data); i++)
+    {
+      if (gdbus_sharded_thread_data[i] != NULL)
+        gdbus_shared_thread_start (gdbus_sharded_thread_data[i]);
+    }
   G_UNLOCK (gdbus_shared_thread_data);
 }
 
@@ -2771,33 +3490,64 @@ write_message_print_transport_debug (gssize bytes_written,
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+#ifdef G_OS_UNIX
+static void
+write_batch_print_transport_debug (gssize          bytes_written,
+                                   WriteBatchData *batch)
+{
+  if (G_LIKELY (!_g_dbus_debug_transport ()))
+    goto out;
+
+  _g_dbus_debug_print_lock ();
+  g_print ("========================================================================\n"
+           "GDBus-debug:Transport:\n"
+           "  >>>> WROTE %" G_GSSIZE_FORMAT " bytes of batch of %u messages and\n"
+           "       size %" G_GSIZE_FORMAT " from offset %" G_GSIZE_FORMAT " on a %s\n",
+           bytes_written,
+           batch->messages->len,
+           batch->total_size,
+           batch->total_written,
+           g_type_name (G_TYPE_FROM_INSTANCE (g_io_stream_get_output_stream (batch->worker->stream))));
+  _g_dbus_debug_print_unlock ();
+ out:
+  ;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+#endif
+
 static void
-read_message_print_transport_debug (gssize bytes_read,
+read_message_print_transport_debug (gssize       bytes_read,
+                                    const gchar *buffer,
+                                    gsize        cur_size,
                                     GDBusWorker *worker)
 {
   gsize size;
+  guint32 header[4];
   gint32 serial;
   gint32 message_length;
 
   if (G_LIKELY (!_g_dbus_debug_transport ()))
     goto out;
 
-  size = bytes_read + worker->read_buffer_cur_size;
+  /* the buffer is not necessarily aligned when reading into a slab */
+  size = bytes_read + cur_size;
+  memcpy (header, buffer, MIN (size, sizeof (header)));
   serial = 0;
   message_length = 0;
   if (size >= 16)
-    message_length = g_dbus_message_bytes_needed ((guchar *) worker->read_buffer, size, NULL);
+    message_length = g_dbus_message_bytes_needed ((guchar *) header, 16, NULL);
   if (size >= 1)
     {
-      switch (worker->read_buffer[0])
+      switch (buffer[0])
         {
         case 'l':
           if (size >= 12)
-            serial = GUINT32_FROM_LE (((guint32 *) worker->read_buffer)[2]);
+            serial = GUINT32_FROM_LE (header[2]);
           break;
         case 'B':
           if (size >= 12)
-            serial = GUINT32_FROM_BE (((guint32 *) worker->read_buffer)[2]);
+            serial = GUINT32_FROM_BE (header[2]);
           break;
         default:
           /* an error will be set elsewhere if this happens */
@@ -2813,7 +3563,7 @@ read_message_print_transport_debug (gssize bytes_read,
            bytes_read,
            serial,
            message_length,
-           worker->read_buffer_cur_size,
+           cur_size,
            g_type_name (G_TYPE_FROM_INSTANCE (g_io_stream_get_input_stream (worker->stream))));
   _g_dbus_debug_print_unlock ();
  out:
@@ -44,12 +44,13 @@ typedef void (*GDBusWorkerDisconnectedCallback)    (GDBusWorker   *worker,
                                                     GError        *error,
                                                     gpointer       user_data);
 
-/* This function may be called from any thread - callbacks will be in the shared private message thread
- * and must not block.
+/* This function may be called from any thread - callbacks will be in the shared private message thread,
+ * or one of the sharded ones if @sharded is TRUE, and must not block.
  */
 GDBusWorker *_g_dbus_worker_new          (GIOStream                          *stream,
                                           GDBusCapabilityFlags                capabilities,
                                           gboolean                            initially_frozen,
+                                          gboolean                            sharded,
                                           GDBusWorkerMessageReceivedCallback  message_received_callback,
                                           GDBusWorkerMessageAboutToBeSentCallback message_about_to_be_sent_callback,
                                           GDBusWorkerDisconnectedCallback     disconnected_callback,
@@ -158,6 +159,11 @@ gchar *_g_dbus_hexencode (const gchar *str,
 GDBusConnection *_g_bus_get_singleton_if_exists (GBusType bus_type);
 void             _g_bus_forget_singleton        (GBusType bus_type);
 
+/* Implemented in gdbusmessage.c */
+GDBusMessage *_g_dbus_message_new_from_bytes (GBytes                *bytes,
+                                              GDBusCapabilityFlags   capabilities,
+                                              GError               **error);
+
 G_END_DECLS
 
 #endif /* __G_DBUS_PRIVATE_H__ */
@@ -31,6 +31,9 @@
 #include "gasyncresult.h"
 #include "gioerror.h"
 #include "gpollableinputstream.h"
+#ifdef HAVE_IO_URING
+#include "giouring-private.h"
+#endif
 
 /**
  * SECTION:ginputstream
@@ -1400,6 +1403,18 @@ read_async_pollable (GPollableInputStream *stream,
 }
 
 
+/* Starts a read_async() without io_uring */
+static void
+read_async_fallback (GTask *task)
+{
+  GInputStream *stream = g_task_get_source_object (task);
+
+  if (!g_input_stream_async_read_is_via_threads (stream))
+    read_async_pollable (G_POLLABLE_INPUT_STREAM (stream), task);
+  else
+    g_task_run_in_thread (task, read_async_thread);
+}
+
 static void
 g_input_stream_real_read_async (GInputStream        *stream,
 				void                *buffer,
@@ -1420,10 +1435,15 @@ g_input_stream_real_read_async (GInputStream        *stream,
   op->buffer = buffer;
   op->count = count;
 
-  if (!g_input_stream_async_read_is_via_threads (stream))
-    read_async_pollable (G_POLLABLE_INPUT_STREAM (stream), task);
-  else
-    g_task_run_in_thread (task, read_async_thread);
+#ifdef HAVE_IO_URING
+  if (_g_io_uring_read_async (stream, task, buffer, count, read_async_fallback))
+    {
+      g_object_unref (task);
+      return;
+    }
+#endif
+
+  read_async_fallback (task);
   g_object_unref (task);
 }
 
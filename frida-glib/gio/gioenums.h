@@ -1223,6 +1223,10 @@ typedef enum
  *  affects client-side `EXTERNAL` authentication, for which this flag makes
  *  connections to a server in another user namespace succeed, but causes
  *  a deadlock when connecting to a GDBus server older than 2.73.3. Since: 2.74
+ * @G_DBUS_CONNECTION_FLAGS_SHARDED_WORKER_THREAD: Do the connection's I/O on
+ *  one of a pool of worker threads, one per processor, instead of the single
+ *  worker thread shared by all other connections. Useful for processes that
+ *  talk to many peers at once. Since: 2.76
  *
  * Flags used when creating a new #GDBusConnection.
  *
@@ -1236,7 +1240,8 @@ typedef enum {
   G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION = (1<<3),
   G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING = (1<<4),
   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_REQUIRE_SAME_USER GIO_AVAILABLE_ENUMERATOR_IN_2_68 = (1<<5),
-  G_DBUS_CONNECTION_FLAGS_CROSS_NAMESPACE GIO_AVAILABLE_ENUMERATOR_IN_2_74 = (1<<6)
+  G_DBUS_CONNECTION_FLAGS_CROSS_NAMESPACE GIO_AVAILABLE_ENUMERATOR_IN_2_74 = (1<<6),
+  G_DBUS_CONNECTION_FLAGS_SHARDED_WORKER_THREAD GIO_AVAILABLE_ENUMERATOR_IN_2_76 = (1<<7)
 } GDBusConnectionFlags;
 
 /**
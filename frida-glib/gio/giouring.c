@@ -0,0 +1,1043 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "giouring-private.h"
+
+#include "gcancellable.h"
+#include "gfiledescriptorbased.h"
+#include "gioerror.h"
+#include "gpollableoutputstream.h"
+#include "glocalfileinputstream.h"
+#include "glocalfileoutputstream.h"
+#include "gsocket.h"
+#include "gsocketinputstream.h"
+#include "gsocketoutputstream.h"
+#include "gunixinputstream.h"
+#include "gunixoutputstream.h"
+#include "glibintl.h"
+
+/*
+ * Completion-based backend for the default read_async() and write_async()
+ * implementations, used for streams whose reads and writes map directly onto
+ * a file descriptor or a #GSocket.
+ *
+ * Every #GMainContext that runs such operations gets its own io_uring,
+ * wrapped in a #GSource.  Starting an operation only fills in a submission
+ * queue entry; the queued entries are handed to the kernel with a single
+ * io_uring_enter() from the source's prepare function, so an iteration costs
+ * one syscall however many operations it starts.  Completions are reaped
+ * straight from the shared completion ring.
+ *
+ * The backend is opt-in, through the `GIO_USE_IO_URING` environment variable,
+ * and anything it cannot handle (unknown stream types, sockets with timeouts,
+ * kernels lacking the opcodes we need, a full ring) falls back to the
+ * pollable or thread-based paths.
+ *
+ * Every submission entry posts exactly one completion.  Each operation
+ * reserves room in the completion ring for its own entries and for the two
+ * cancellations it may need later, so the completion ring never overflows
+ * and a cancellation always fits.
+ */
+
+#define RING_ENTRIES 256
+
+/* Completions reserved for cancelling an operation: one for the operation
+ * itself and one for the poll that may be linked in front of it.
+ */
+#define CANCEL_ENTRIES 2
+
+#ifndef IORING_SQ_CQ_OVERFLOW
+#define IORING_SQ_CQ_OVERFLOW (1U << 1)
+#endif
+
+/* Marks the user_data of a POLL_ADD linked in front of an operation, which
+ * then waits for the descriptor to become ready.
+ */
+#define OP_ID_POLL_FLAG (G_GUINT64_CONSTANT (1) << 63)
+
+typedef struct _GIOURing GIOURing;
+typedef struct _GIOURingOp GIOURingOp;
+
+struct _GIOURing
+{
+  GSource source;
+
+  GMainContext *context;
+  gint fd;
+
+  gpointer sq_ring;
+  gsize sq_ring_size;
+  gpointer cq_ring;
+  gsize cq_ring_size;
+  struct io_uring_sqe *sqes;
+  gsize sqes_size;
+
+  /* Protects the submission ring and @ops, which are also touched from
+   * cancellation handlers and from threads other than the context owner.
+   * The completion ring is only ever consumed from the owner.
+   */
+  GMutex lock;
+
+  guint32 *sq_head;
+  guint32 *sq_tail;
+  guint32 *sq_flags;
+  guint32 *sq_array;
+  guint32 sq_mask;
+  guint32 sq_entries;
+  guint32 sq_queued;
+
+  guint32 *cq_head;
+  guint32 *cq_tail;
+  struct io_uring_cqe *cqes;
+  guint32 cq_mask;
+  guint32 cq_entries;
+  guint32 cq_reserved;  /* completions the kernel may still post */
+
+  guint64 next_id;
+  GHashTable *ops;  /* (element-type guint64 GIOURingOp) */
+  guint n_cancels_pending;
+};
+
+struct _GIOURingOp
+{
+  guint64 id;
+  GIOURing *ring;
+  GTask *task;
+
+  guint8 opcode;
+  gint fd;
+  gpointer buffer;
+  guint32 len;
+
+  GIOURingFallbackFunc fallback;
+
+  GCancellable *cancellable;
+  gulong cancelled_id;
+  gboolean cancelled;
+  gboolean cancel_queued;
+  gboolean cancel_pending;
+
+  gint result;
+  GIOURingOp *next;
+};
+
+G_LOCK_DEFINE_STATIC (rings);
+static GHashTable *rings = NULL;  /* (element-type GMainContext GIOURing) */
+
+static gint
+sys_io_uring_setup (guint                   entries,
+                    struct io_uring_params *params)
+{
+  return syscall (__NR_io_uring_setup, entries, params);
+}
+
+static gint
+sys_io_uring_enter (gint  fd,
+                    guint to_submit,
+                    guint min_complete,
+                    guint flags)
+{
+  return syscall (__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static gint
+sys_io_uring_register (gint     fd,
+                       guint    opcode,
+                       gpointer arg,
+                       guint    n_args)
+{
+  return syscall (__NR_io_uring_register, fd, opcode, arg, n_args);
+}
+
+static gboolean
+probe_kernel_support (void)
+{
+  static const guint8 required_ops[] = {
+    IORING_OP_READ,
+    IORING_OP_WRITE,
+    IORING_OP_RECV,
+    IORING_OP_SEND,
+    IORING_OP_POLL_ADD,
+    IORING_OP_ASYNC_CANCEL,
+  };
+  struct io_uring_params params;
+  struct io_uring_probe *probe;
+  gsize probe_size;
+  gboolean supported;
+  gint fd;
+  gsize i;
+
+  memset (&params, 0, sizeof (params));
+  fd = sys_io_uring_setup (2, &params);
+  if (fd < 0)
+    return FALSE;
+
+  /* Reads and writes are issued at the current file position, and we rely
+   * on the kernel never dropping completions.
+   */
+  supported = (params.features & IORING_FEAT_RW_CUR_POS) != 0 &&
+              (params.features & IORING_FEAT_NODROP) != 0;
+
+  probe_size = sizeof (struct io_uring_probe) + 256 * sizeof (struct io_uring_probe_op);
+  probe = g_malloc0 (probe_size);
+  if (supported && sys_io_uring_register (fd, IORING_REGISTER_PROBE, probe, 256) == 0)
+    {
+      for (i = 0; i != G_N_ELEMENTS (required_ops); i++)
+        {
+          guint8 op = required_ops[i];
+
+          if (op > probe->last_op || (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0)
+            supported = FALSE;
+        }
+    }
+  else
+    supported = FALSE;
+  g_free (probe);
+
+  close (fd);
+
+  return supported;
+}
+
+static gboolean
+g_io_uring_is_enabled (void)
+{
+  static gsize enabled = 0;
+
+  if (g_once_init_enter (&enabled))
+    {
+      const gchar *env = g_getenv ("GIO_USE_IO_URING");
+      gsize value = 1;
+
+      if (env != NULL && *env != '\0' && strcmp (env, "0") != 0 && probe_kernel_support ())
+        value = 2;
+
+      g_once_init_leave (&enabled, value);
+    }
+
+  return enabled == 2;
+}
+
+static guint
+g_io_uring_enter_flags (GIOURing *ring)
+{
+  /* Completions that did not fit are held back by the kernel until we ask
+   * for events; our budget should prevent that, but never leave them stuck.
+   */
+  if ((g_atomic_int_get (ring->sq_flags) & IORING_SQ_CQ_OVERFLOW) != 0)
+    return IORING_ENTER_GETEVENTS;
+
+  return 0;
+}
+
+static void
+g_io_uring_submit_locked (GIOURing *ring)
+{
+  if (ring->sq_queued == 0 && g_io_uring_enter_flags (ring) != 0)
+    sys_io_uring_enter (ring->fd, 0, 0, IORING_ENTER_GETEVENTS);
+
+  while (ring->sq_queued != 0)
+    {
+      gint ret;
+
+      ret = sys_io_uring_enter (ring->fd, ring->sq_queued, 0,
+                                g_io_uring_enter_flags (ring));
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          /* EAGAIN or EBUSY: the kernel is short on resources or has
+           * completions it could not post yet.  Leave the entries queued and
+           * retry once we have reaped what is there.
+           */
+          break;
+        }
+      if (ret == 0)
+        break;
+
+      ring->sq_queued -= ret;
+    }
+}
+
+static gboolean
+g_io_uring_reserve_locked (GIOURing *ring,
+                           guint     n_entries)
+{
+  guint32 head;
+
+  head = g_atomic_int_get (ring->sq_head);
+  if (ring->sq_entries - (*ring->sq_tail - head) >= n_entries)
+    return TRUE;
+
+  g_io_uring_submit_locked (ring);
+
+  head = g_atomic_int_get (ring->sq_head);
+  return ring->sq_entries - (*ring->sq_tail - head) >= n_entries;
+}
+
+/* Callers must have reserved the entry, and must fill it in before the next
+ * call, which publishes it.
+ */
+static struct io_uring_sqe *
+g_io_uring_next_sqe_locked (GIOURing *ring)
+{
+  guint32 tail = *ring->sq_tail;
+  guint32 index = tail & ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[index];
+
+  memset (sqe, 0, sizeof (*sqe));
+  ring->sq_array[index] = index;
+
+  return sqe;
+}
+
+static void
+g_io_uring_publish_sqe_locked (GIOURing *ring)
+{
+  g_atomic_int_set (ring->sq_tail, *ring->sq_tail + 1);
+  ring->sq_queued++;
+}
+
+static gboolean
+g_io_uring_queue_op_locked (GIOURing   *ring,
+                            GIOURingOp *op,
+                            gboolean    wait_until_ready)
+{
+  struct io_uring_sqe *sqe;
+  guint n_entries = wait_until_ready ? 2 : 1;
+
+  if (ring->cq_entries - ring->cq_reserved < n_entries + CANCEL_ENTRIES)
+    return FALSE;
+
+  if (!g_io_uring_reserve_locked (ring, n_entries))
+    return FALSE;
+
+  ring->cq_reserved += n_entries + CANCEL_ENTRIES;
+  op->cancel_queued = FALSE;
+
+  if (wait_until_ready)
+    {
+      guint32 events;
+
+      events = (op->opcode == IORING_OP_READ || op->opcode == IORING_OP_RECV) ? POLLIN : POLLOUT;
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+      events = (events << 16) | (events >> 16);
+#endif
+
+      sqe = g_io_uring_next_sqe_locked (ring);
+      sqe->opcode = IORING_OP_POLL_ADD;
+      sqe->flags = IOSQE_IO_LINK;
+      sqe->fd = op->fd;
+      sqe->poll32_events = events;
+      sqe->user_data = op->id | OP_ID_POLL_FLAG;
+      g_io_uring_publish_sqe_locked (ring);
+    }
+
+  sqe = g_io_uring_next_sqe_locked (ring);
+  sqe->opcode = op->opcode;
+  sqe->fd = op->fd;
+  sqe->addr = (guint64) (gsize) op->buffer;
+  sqe->len = op->len;
+  if (op->opcode == IORING_OP_READ || op->opcode == IORING_OP_WRITE)
+    sqe->off = (guint64) -1;
+  else if (op->opcode == IORING_OP_SEND)
+    sqe->msg_flags = MSG_NOSIGNAL;
+  sqe->user_data = op->id;
+  g_io_uring_publish_sqe_locked (ring);
+
+  g_hash_table_insert (ring->ops, &op->id, op);
+
+  return TRUE;
+}
+
+static void
+g_io_uring_wakeup (GIOURing *ring)
+{
+  /* The owner submits from prepare on its next iteration anyway. */
+  if (!g_main_context_is_owner (ring->context))
+    g_main_context_wakeup (ring->context);
+}
+
+/* Cancels @op, which must be in flight, using the completions it reserved.
+ * If the submission ring is full the cancellation is retried from prepare.
+ */
+static void
+g_io_uring_queue_cancel_locked (GIOURing   *ring,
+                                GIOURingOp *op)
+{
+  struct io_uring_sqe *sqe;
+
+  if (op->cancel_queued)
+    return;
+
+  if (!g_io_uring_reserve_locked (ring, CANCEL_ENTRIES))
+    {
+      if (!op->cancel_pending)
+        {
+          op->cancel_pending = TRUE;
+          ring->n_cancels_pending++;
+        }
+      return;
+    }
+
+  if (op->cancel_pending)
+    {
+      op->cancel_pending = FALSE;
+      ring->n_cancels_pending--;
+    }
+  op->cancel_queued = TRUE;
+
+  /* The operation might be waiting behind a linked poll, in which case
+   * cancelling the poll fails the operation with -ECANCELED too.
+   */
+  sqe = g_io_uring_next_sqe_locked (ring);
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = op->id;
+  g_io_uring_publish_sqe_locked (ring);
+
+  sqe = g_io_uring_next_sqe_locked (ring);
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = op->id | OP_ID_POLL_FLAG;
+  g_io_uring_publish_sqe_locked (ring);
+}
+
+static void
+g_io_uring_queue_pending_cancels_locked (GIOURing *ring)
+{
+  GHashTableIter iter;
+  gpointer op;
+
+  g_hash_table_iter_init (&iter, ring->ops);
+  while (ring->n_cancels_pending != 0 && g_hash_table_iter_next (&iter, NULL, &op))
+    {
+      if (((GIOURingOp *) op)->cancel_pending)
+        g_io_uring_queue_cancel_locked (ring, op);
+    }
+}
+
+static void
+g_io_uring_op_cancelled (GCancellable *cancellable,
+                         gpointer      user_data)
+{
+  GIOURingOp *op = user_data;
+  GIOURing *ring = op->ring;
+
+  g_mutex_lock (&ring->lock);
+
+  op->cancelled = TRUE;
+
+  /* Nothing to do if it is not in flight; whoever queues or completes it
+   * next notices.
+   */
+  if (g_hash_table_contains (ring->ops, &op->id))
+    g_io_uring_queue_cancel_locked (ring, op);
+
+  g_mutex_unlock (&ring->lock);
+
+  g_io_uring_wakeup (ring);
+}
+
+/* Takes the in-flight operation @id off @ring once its completion arrived,
+ * releasing the completions it reserved for a cancellation it never used.
+ */
+static GIOURingOp *
+g_io_uring_steal_op_locked (GIOURing *ring,
+                            guint64   id)
+{
+  gpointer op;
+
+  if (!g_hash_table_steal_extended (ring->ops, &id, NULL, &op))
+    return NULL;
+
+  if (((GIOURingOp *) op)->cancel_pending)
+    {
+      ((GIOURingOp *) op)->cancel_pending = FALSE;
+      ring->n_cancels_pending--;
+    }
+  if (!((GIOURingOp *) op)->cancel_queued)
+    ring->cq_reserved -= CANCEL_ENTRIES;
+
+  return op;
+}
+
+static void
+g_io_uring_op_disconnect (GIOURingOp *op)
+{
+  if (op->cancellable != NULL)
+    g_cancellable_disconnect (op->cancellable, op->cancelled_id);
+  op->cancellable = NULL;
+}
+
+static void
+g_io_uring_op_free (GIOURingOp *op)
+{
+  g_io_uring_op_disconnect (op);
+  g_object_unref (op->task);
+  g_slice_free (GIOURingOp, op);
+}
+
+static void
+g_io_uring_op_complete (GIOURingOp *op)
+{
+  GTask *task = op->task;
+  gint result = op->result;
+
+  if (result == -EAGAIN)
+    {
+      GIOURing *ring = op->ring;
+      gboolean requeued = FALSE;
+
+      /* The descriptor is non-blocking; try again once it is ready. */
+      g_mutex_lock (&ring->lock);
+      if (!op->cancelled)
+        requeued = g_io_uring_queue_op_locked (ring, op, TRUE);
+      else
+        result = -ECANCELED;
+      g_mutex_unlock (&ring->lock);
+
+      if (requeued)
+        return;
+
+      /* The ring is full; wait for the descriptor the way the stream
+       * would have without us, rather than reporting EAGAIN.
+       */
+      if (result == -EAGAIN)
+        {
+          g_io_uring_op_disconnect (op);
+          op->fallback (task);
+          g_io_uring_op_free (op);
+          return;
+        }
+    }
+
+  if (result >= 0)
+    {
+      g_task_return_int (task, result);
+    }
+  else if (result == -ECANCELED && g_task_return_error_if_cancelled (task))
+    {
+    }
+  else
+    {
+      gboolean is_socket = op->opcode == IORING_OP_RECV || op->opcode == IORING_OP_SEND;
+      gboolean is_read = op->opcode == IORING_OP_READ || op->opcode == IORING_OP_RECV;
+      int errsv = -result;
+      const gchar *message;
+
+      if (is_socket)
+        message = is_read ? _("Error receiving data: %s") : _("Error sending data: %s");
+      else
+        message = is_read ? _("Error reading from file descriptor: %s")
+                          : _("Error writing to file descriptor: %s");
+
+      g_task_return_new_error (task, G_IO_ERROR,
+                               g_io_error_from_errno (errsv),
+                               message, g_strerror (errsv));
+    }
+
+  g_io_uring_op_free (op);
+}
+
+static gboolean
+g_io_uring_has_completions (GIOURing *ring)
+{
+  return *ring->cq_head != (guint32) g_atomic_int_get (ring->cq_tail);
+}
+
+static gboolean
+g_io_uring_source_prepare (GSource *source,
+                           gint    *timeout)
+{
+  GIOURing *ring = (GIOURing *) source;
+
+  *timeout = -1;
+
+  g_mutex_lock (&ring->lock);
+  if (ring->n_cancels_pending != 0)
+    g_io_uring_queue_pending_cancels_locked (ring);
+  g_io_uring_submit_locked (ring);
+
+  /* The kernel pushed back; don't sleep on entries it hasn't seen. */
+  if (ring->sq_queued != 0 || ring->n_cancels_pending != 0)
+    *timeout = 1;
+  g_mutex_unlock (&ring->lock);
+
+  return g_io_uring_has_completions (ring);
+}
+
+static gboolean
+g_io_uring_source_check (GSource *source)
+{
+  return g_io_uring_has_completions ((GIOURing *) source);
+}
+
+static gboolean
+g_io_uring_source_dispatch (GSource     *source,
+                            GSourceFunc  callback,
+                            gpointer     user_data)
+{
+  GIOURing *ring = (GIOURing *) source;
+  GIOURingOp *completed = NULL;
+  GIOURingOp **link = &completed;
+  guint32 head, tail;
+
+  g_mutex_lock (&ring->lock);
+
+  head = *ring->cq_head;
+  tail = g_atomic_int_get (ring->cq_tail);
+
+  for (; head != tail; head++)
+    {
+      const struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+      guint64 id = cqe->user_data;
+      GIOURingOp *op;
+
+      ring->cq_reserved--;
+
+      /* Cancellations and the polls we link in front of operations */
+      if (id == 0 || (id & OP_ID_POLL_FLAG) != 0)
+        continue;
+
+      op = g_io_uring_steal_op_locked (ring, id);
+      if (op == NULL)
+        continue;
+
+      op->result = cqe->res;
+      *link = op;
+      link = &op->next;
+    }
+  *link = NULL;
+
+  g_atomic_int_set (ring->cq_head, head);
+
+  if (g_io_uring_enter_flags (ring) != 0)
+    sys_io_uring_enter (ring->fd, 0, 0, IORING_ENTER_GETEVENTS);
+
+  g_mutex_unlock (&ring->lock);
+
+  while (completed != NULL)
+    {
+      GIOURingOp *next = completed->next;
+
+      g_io_uring_op_complete (completed);
+      completed = next;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+g_io_uring_source_finalize (GSource *source)
+{
+  GIOURing *ring = (GIOURing *) source;
+  GIOURingOp *completed = NULL;
+  GHashTableIter iter;
+  gpointer op;
+
+  G_LOCK (rings);
+  if (g_hash_table_lookup (rings, ring->context) == ring)
+    g_hash_table_remove (rings, ring->context);
+  G_UNLOCK (rings);
+
+  /* The cancellation handlers take the lock, so let any running ones
+   * finish before holding it.
+   */
+  g_hash_table_iter_init (&iter, ring->ops);
+  while (g_hash_table_iter_next (&iter, NULL, &op))
+    g_io_uring_op_disconnect (op);
+
+  /* The kernel tears rings down asynchronously, and may still write into
+   * the operations' buffers after close().  Cancel whatever is in flight
+   * and wait for it to complete, so the buffers are the callers' again.
+   * The tasks are then dropped without returning, like any other source
+   * attached to a dying context.
+   */
+  g_mutex_lock (&ring->lock);
+
+  g_hash_table_iter_init (&iter, ring->ops);
+  while (g_hash_table_iter_next (&iter, NULL, &op))
+    g_io_uring_queue_cancel_locked (ring, op);
+
+  while (g_hash_table_size (ring->ops) != 0)
+    {
+      guint32 head, tail;
+      gint ret;
+
+      if (ring->n_cancels_pending != 0)
+        g_io_uring_queue_pending_cancels_locked (ring);
+
+      ret = sys_io_uring_enter (ring->fd, ring->sq_queued, 1, IORING_ENTER_GETEVENTS);
+      if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        break;
+      if (ret > 0)
+        ring->sq_queued -= ret;
+
+      head = *ring->cq_head;
+      tail = g_atomic_int_get (ring->cq_tail);
+      for (; head != tail; head++)
+        {
+          guint64 id = ring->cqes[head & ring->cq_mask].user_data;
+
+          ring->cq_reserved--;
+
+          if (id == 0 || (id & OP_ID_POLL_FLAG) != 0)
+            continue;
+
+          op = g_io_uring_steal_op_locked (ring, id);
+          if (op != NULL)
+            {
+              ((GIOURingOp *) op)->next = completed;
+              completed = op;
+            }
+        }
+      g_atomic_int_set (ring->cq_head, head);
+    }
+
+  g_mutex_unlock (&ring->lock);
+
+  close (ring->fd);
+
+  while (completed != NULL)
+    {
+      GIOURingOp *next = completed->next;
+
+      g_io_uring_op_free (completed);
+      completed = next;
+    }
+
+  g_hash_table_iter_init (&iter, ring->ops);
+  while (g_hash_table_iter_next (&iter, NULL, &op))
+    {
+      g_hash_table_iter_steal (&iter);
+      g_io_uring_op_free (op);
+    }
+  g_hash_table_unref (ring->ops);
+
+  munmap (ring->sqes, ring->sqes_size);
+  if (ring->cq_ring != ring->sq_ring)
+    munmap (ring->cq_ring, ring->cq_ring_size);
+  munmap (ring->sq_ring, ring->sq_ring_size);
+
+  g_mutex_clear (&ring->lock);
+}
+
+static GSourceFuncs g_io_uring_source_funcs = {
+  g_io_uring_source_prepare,
+  g_io_uring_source_check,
+  g_io_uring_source_dispatch,
+  g_io_uring_source_finalize,
+  NULL,
+  NULL
+};
+
+static GIOURing *
+g_io_uring_new (GMainContext *context)
+{
+  struct io_uring_params params;
+  gpointer sq_ring, cq_ring, sqes;
+  gsize sq_ring_size, cq_ring_size, sqes_size;
+  GSource *source;
+  GIOURing *ring;
+  gint fd;
+
+  memset (&params, 0, sizeof (params));
+  params.flags = IORING_SETUP_CLAMP;
+
+  fd = sys_io_uring_setup (RING_ENTRIES, &params);
+  if (fd < 0)
+    return NULL;
+
+  sq_ring_size = params.sq_off.array + params.sq_entries * sizeof (guint32);
+  cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+    sq_ring_size = cq_ring_size = MAX (sq_ring_size, cq_ring_size);
+  sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+
+  sq_ring = mmap (NULL, sq_ring_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED)
+    goto failed_sq_ring;
+
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+    cq_ring = sq_ring;
+  else
+    {
+      cq_ring = mmap (NULL, cq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+      if (cq_ring == MAP_FAILED)
+        goto failed_cq_ring;
+    }
+
+  sqes = mmap (NULL, sqes_size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+    goto failed_sqes;
+
+  source = g_source_new (&g_io_uring_source_funcs, sizeof (GIOURing));
+  g_source_set_static_name (source, "GIOURing");
+  ring = (GIOURing *) source;
+
+  ring->context = context;
+  ring->fd = fd;
+
+  ring->sq_ring = sq_ring;
+  ring->sq_ring_size = sq_ring_size;
+  ring->cq_ring = cq_ring;
+  ring->cq_ring_size = cq_ring_size;
+  ring->sqes = sqes;
+  ring->sqes_size = sqes_size;
+
+  g_mutex_init (&ring->lock);
+
+  ring->sq_head = (guint32 *) ((guint8 *) sq_ring + params.sq_off.head);
+  ring->sq_tail = (guint32 *) ((guint8 *) sq_ring + params.sq_off.tail);
+  ring->sq_flags = (guint32 *) ((guint8 *) sq_ring + params.sq_off.flags);
+  ring->sq_array = (guint32 *) ((guint8 *) sq_ring + params.sq_off.array);
+  ring->sq_mask = *(guint32 *) ((guint8 *) sq_ring + params.sq_off.ring_mask);
+  ring->sq_entries = params.sq_entries;
+
+  ring->cq_head = (guint32 *) ((guint8 *) cq_ring + params.cq_off.head);
+  ring->cq_tail = (guint32 *) ((guint8 *) cq_ring + params.cq_off.tail);
+  ring->cqes = (struct io_uring_cqe *) ((guint8 *) cq_ring + params.cq_off.cqes);
+  ring->cq_mask = *(guint32 *) ((guint8 *) cq_ring + params.cq_off.ring_mask);
+  ring->cq_entries = params.cq_entries;
+
+  ring->next_id = 1;
+  ring->ops = g_hash_table_new (g_int64_hash, g_int64_equal);
+
+  /* Dispatch only touches completions it has already taken off the ring,
+   * so recursing is fine; and it saves blocking the source, which would
+   * remove and re-add the ring's fd (and wake up the context) every time.
+   */
+  g_source_set_can_recurse (source, TRUE);
+  g_source_add_unix_fd (source, fd, G_IO_IN);
+  g_source_attach (source, context);
+  g_source_unref (source);
+
+  return ring;
+
+failed_sqes:
+  if (cq_ring != sq_ring)
+    munmap (cq_ring, cq_ring_size);
+failed_cq_ring:
+  munmap (sq_ring, sq_ring_size);
+failed_sq_ring:
+  close (fd);
+
+  return NULL;
+}
+
+static GIOURing *
+g_io_uring_get_for_context (GMainContext *context)
+{
+  GIOURing *ring;
+
+  G_LOCK (rings);
+
+  if (rings == NULL)
+    rings = g_hash_table_new (NULL, NULL);
+
+  ring = g_hash_table_lookup (rings, context);
+  if (ring == NULL)
+    {
+      ring = g_io_uring_new (context);
+      if (ring != NULL)
+        g_hash_table_insert (rings, context, ring);
+    }
+
+  G_UNLOCK (rings);
+
+  return ring;
+}
+
+static gboolean
+g_io_uring_start (GTask                *task,
+                  guint8                opcode,
+                  gint                  fd,
+                  gpointer              buffer,
+                  gsize                 count,
+                  gboolean              wait_until_ready,
+                  GIOURingFallbackFunc  fallback)
+{
+  GIOURing *ring;
+  GIOURingOp *op;
+  gboolean queued = FALSE;
+
+  ring = g_io_uring_get_for_context (g_task_get_context (task));
+  if (ring == NULL)
+    return FALSE;
+
+  op = g_slice_new0 (GIOURingOp);
+  op->ring = ring;
+  op->task = g_object_ref (task);
+  op->opcode = opcode;
+  op->fd = fd;
+  op->buffer = buffer;
+  op->len = MIN (count, G_MAXINT32);
+  op->fallback = fallback;
+
+  op->cancellable = g_task_get_cancellable (task);
+  if (op->cancellable != NULL)
+    op->cancelled_id = g_cancellable_connect (op->cancellable,
+                                              G_CALLBACK (g_io_uring_op_cancelled),
+                                              op, NULL);
+
+  g_mutex_lock (&ring->lock);
+  /* Already-cancelled operations are left to the fallback, which reports
+   * them right away.
+   */
+  if (!op->cancelled)
+    {
+      op->id = ring->next_id++;
+      queued = g_io_uring_queue_op_locked (ring, op, wait_until_ready);
+    }
+  g_mutex_unlock (&ring->lock);
+
+  if (!queued)
+    {
+      g_io_uring_op_free (op);
+      return FALSE;
+    }
+
+  g_io_uring_wakeup (ring);
+
+  return TRUE;
+}
+
+static gboolean
+g_io_uring_socket_is_usable (GSocket *socket)
+{
+  /* Timeouts are enforced by the pollable path. */
+  return !g_socket_is_closed (socket) && g_socket_get_timeout (socket) == 0;
+}
+
+/*
+ * _g_io_uring_read_async:
+ * @stream: the stream @task reads from
+ * @task: a #GTask set up by g_input_stream_real_read_async()
+ * @buffer: the buffer to read into
+ * @count: the number of bytes to read
+ * @fallback: starts the read the way @stream would without io_uring
+ *
+ * Starts reading from @stream through the io_uring of @task's context, if
+ * the backend is enabled and knows how to read from @stream directly.  The
+ * task is completed with the number of bytes read, like the fallback paths
+ * do.  If the descriptor turns out not to be ready and the ring has no room
+ * to wait for it, @task is handed over to @fallback.
+ *
+ * Returns: %TRUE if the read was started, %FALSE if the caller should fall
+ *   back to another implementation
+ */
+gboolean
+_g_io_uring_read_async (GInputStream         *stream,
+                        GTask                *task,
+                        void                 *buffer,
+                        gsize                 count,
+                        GIOURingFallbackFunc  fallback)
+{
+  GType type;
+
+  if (!g_io_uring_is_enabled ())
+    return FALSE;
+
+  /* Only the exact types, as subclasses may override read_fn. */
+  type = G_TYPE_FROM_INSTANCE (stream);
+  if (type == G_TYPE_UNIX_INPUT_STREAM || type == G_TYPE_LOCAL_FILE_INPUT_STREAM)
+    {
+      gint fd = g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (stream));
+
+      return g_io_uring_start (task, IORING_OP_READ, fd, buffer, count, FALSE, fallback);
+    }
+  else if (type == G_TYPE_SOCKET_INPUT_STREAM)
+    {
+      GSocket *socket = _g_socket_input_stream_get_socket (G_SOCKET_INPUT_STREAM (stream));
+
+      if (!g_io_uring_socket_is_usable (socket))
+        return FALSE;
+
+      return g_io_uring_start (task, IORING_OP_RECV, g_socket_get_fd (socket), buffer, count, FALSE, fallback);
+    }
+
+  return FALSE;
+}
+
+/*
+ * _g_io_uring_write_async:
+ * @stream: the stream @task writes to
+ * @task: a #GTask set up by g_output_stream_real_write_async()
+ * @buffer: the data to write
+ * @count: the number of bytes to write
+ * @fallback: starts the write the way @stream would without io_uring
+ *
+ * The write counterpart of _g_io_uring_read_async().
+ *
+ * Returns: %TRUE if the write was started, %FALSE if the caller should fall
+ *   back to another implementation
+ */
+gboolean
+_g_io_uring_write_async (GOutputStream        *stream,
+                         GTask                *task,
+                         const void           *buffer,
+                         gsize                 count,
+                         GIOURingFallbackFunc  fallback)
+{
+  GType type;
+
+  if (!g_io_uring_is_enabled ())
+    return FALSE;
+
+  type = G_TYPE_FROM_INSTANCE (stream);
+  if (type == G_TYPE_UNIX_OUTPUT_STREAM || type == G_TYPE_LOCAL_FILE_OUTPUT_STREAM)
+    {
+      gint fd = g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (stream));
+      gboolean can_poll;
+
+      /* Like the pollable path, only write once poll() says so; a write
+       * to a socket or pipe may otherwise go through well before that.
+       */
+      can_poll = type == G_TYPE_UNIX_OUTPUT_STREAM &&
+                 g_pollable_output_stream_can_poll (G_POLLABLE_OUTPUT_STREAM (stream));
+
+      return g_io_uring_start (task, IORING_OP_WRITE, fd, (gpointer) buffer, count, can_poll, fallback);
+    }
+  else if (type == G_TYPE_SOCKET_OUTPUT_STREAM)
+    {
+      GSocket *socket = _g_socket_output_stream_get_socket (G_SOCKET_OUTPUT_STREAM (stream));
+
+      if (!g_io_uring_socket_is_usable (socket))
+        return FALSE;
+
+      return g_io_uring_start (task, IORING_OP_SEND, g_socket_get_fd (socket), (gpointer) buffer, count, FALSE, fallback);
+    }
+
+  return FALSE;
+}
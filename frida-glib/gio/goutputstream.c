@@ -31,6 +31,9 @@
 #include "gioprivate.h"
 #include "glibintl.h"
 #include "gpollableoutputstream.h"
+#ifdef HAVE_IO_URING
+#include "giouring-private.h"
+#endif
 
 /**
  * SECTION:goutputstream
@@ -2440,6 +2443,18 @@ write_async_pollable (GPollableOutputStream *stream,
     g_task_return_int (task, count_written);
 }
 
+/* Starts a write_async() without io_uring */
+static void
+write_async_fallback (GTask *task)
+{
+  GOutputStream *stream = g_task_get_source_object (task);
+
+  if (!g_output_stream_async_write_is_via_threads (stream))
+    write_async_pollable (G_POLLABLE_OUTPUT_STREAM (stream), task);
+  else
+    g_task_run_in_thread (task, write_async_thread);
+}
+
 static void
 g_output_stream_real_write_async (GOutputStream       *stream,
                                   const void          *buffer,
@@ -2459,10 +2474,15 @@ g_output_stream_real_write_async (GOutputStream       *stream,
   op->buffer = buffer;
   op->count_requested = count;
 
-  if (!g_output_stream_async_write_is_via_threads (stream))
-    write_async_pollable (G_POLLABLE_OUTPUT_STREAM (stream), task);
-  else
-    g_task_run_in_thread (task, write_async_thread);
+#ifdef HAVE_IO_URING
+  if (_g_io_uring_write_async (stream, task, buffer, count, write_async_fallback))
+    {
+      g_object_unref (task);
+      return;
+    }
+#endif
+
+  write_async_fallback (task);
   g_object_unref (task);
 }
 
@@ -225,3 +225,9 @@ _g_socket_input_stream_new (GSocket *socket)
 {
   return g_object_new (G_TYPE_SOCKET_INPUT_STREAM, "socket", socket, NULL);
 }
+
+GSocket *
+_g_socket_input_stream_get_socket (GSocketInputStream *stream)
+{
+  return stream->priv->socket;
+}
@@ -54,6 +54,7 @@ struct _GSocketInputStream
 
 GType                   _g_socket_input_stream_get_type                  (void) G_GNUC_CONST;
 GSocketInputStream *    _g_socket_input_stream_new                      (GSocket *socket);
+GSocket *               _g_socket_input_stream_get_socket               (GSocketInputStream *stream);
 
 G_END_DECLS
 
@@ -282,3 +282,9 @@ _g_socket_output_stream_new (GSocket *socket)
 {
   return g_object_new (G_TYPE_SOCKET_OUTPUT_STREAM, "socket", socket, NULL);
 }
+
+GSocket *
+_g_socket_output_stream_get_socket (GSocketOutputStream *stream)
+{
+  return stream->priv->socket;
+}
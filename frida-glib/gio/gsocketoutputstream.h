@@ -54,6 +54,7 @@ struct _GSocketOutputStream
 
 GType                   _g_socket_output_stream_get_type                 (void) G_GNUC_CONST;
 GSocketOutputStream *   _g_socket_output_stream_new                     (GSocket *socket);
+GSocket *               _g_socket_output_stream_get_socket              (GSocketOutputStream *stream);
 
 G_END_DECLS
 
@@ -25,6 +25,7 @@
 
 #include <unistd.h>
 #include <string.h>
+#include <sys/socket.h>
 
 #include <gio/gio.h>
 
@@ -342,6 +343,102 @@ test_flush_idle (Fixture       *f,
                    >=, finished);
 }
 
+static void
+emit_signals (GDBusConnection *connection,
+              guint            n_signals)
+{
+  guint i;
+
+  for (i = 0; i < n_signals; i++)
+    {
+      GError *error = NULL;
+
+      g_dbus_connection_emit_signal (connection, NULL, "/",
+                                     "com.example.Foo", "SomeSignal",
+                                     g_variant_new ("(us)", i,
+                                                    "padding to fill up the socket buffer sooner"),
+                                     &error);
+      g_assert_no_error (error);
+    }
+}
+
+static void
+flush_batched_cb (GObject      *source,
+                  GAsyncResult *res,
+                  gpointer      user_data)
+{
+  gboolean *flushed = user_data;
+  GError *error = NULL;
+
+  g_dbus_connection_flush_finish (G_DBUS_CONNECTION (source), res, &error);
+  g_assert_no_error (error);
+
+  *flushed = TRUE;
+}
+
+/* Over a socket the worker writes queued messages in batches.  Messages
+ * queued after a flush was requested must not carry the write counter
+ * past the flush without completing it.
+ */
+static void
+test_flush_batched (void)
+{
+  GSocketConnection *stream;
+  GDBusConnection *connection;
+  GSocket *sockets[2];
+  GError *error = NULL;
+  gboolean flushed = FALSE;
+  gint64 deadline;
+  gint fds[2];
+  guint i;
+
+  g_assert_cmpint (socketpair (AF_UNIX, SOCK_STREAM, 0, fds), ==, 0);
+
+  for (i = 0; i < 2; i++)
+    {
+      sockets[i] = g_socket_new_from_fd (fds[i], &error);
+      g_assert_no_error (error);
+    }
+
+  stream = g_socket_connection_factory_create_connection (sockets[0]);
+  connection = g_dbus_connection_new_sync (G_IO_STREAM (stream), NULL,
+                                           G_DBUS_CONNECTION_FLAGS_NONE,
+                                           NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  /* nobody reads from the other end yet, so the writes back up */
+  emit_signals (connection, 2000);
+  g_dbus_connection_flush (connection, NULL, flush_batched_cb, &flushed);
+  emit_signals (connection, 2000);
+
+  g_socket_set_blocking (sockets[1], FALSE);
+  deadline = g_get_monotonic_time () + 30 * G_USEC_PER_SEC;
+
+  while (!flushed && g_get_monotonic_time () < deadline)
+    {
+      gchar buffer[4096];
+
+      if (g_socket_receive (sockets[1], buffer, sizeof buffer, NULL, &error) <= 0)
+        {
+          g_assert_error (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK);
+          g_clear_error (&error);
+          g_usleep (1000);
+        }
+
+      while (g_main_context_iteration (NULL, FALSE));
+    }
+
+  g_assert_true (flushed);
+
+  g_dbus_connection_close_sync (connection, NULL, &error);
+  g_assert_no_error (error);
+
+  g_object_unref (connection);
+  g_object_unref (stream);
+  g_object_unref (sockets[1]);
+  g_object_unref (sockets[0]);
+}
+
 static void
 teardown (Fixture       *f,
           gconstpointer  test_data G_GNUC_UNUSED)
@@ -376,6 +473,7 @@ main (int   argc,
               setup, test_flush_busy, teardown);
   g_test_add ("/gdbus/connection/flush/idle", Fixture, NULL,
               setup, test_flush_idle, teardown);
+  g_test_add_func ("/gdbus/connection/flush/batched", test_flush_batched);
 
   ret = g_test_run();
 
@@ -0,0 +1,763 @@
+/* GLib testing framework examples and tests
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gio/gio.h>
+
+#include <stdlib.h>
+#include <sys/socket.h>
+
+/* Throughput benchmarks for peer-to-peer GDBusConnections over a
+ * socketpair. Run with `-m perf` for meaningful numbers; in the default
+ * mode the workloads are kept small so the test doubles as a smoke test.
+ */
+
+#define PERF_INTERFACE "org.gtk.GDBus.PerformanceTest"
+
+/* g_malloc() calls made while counting_allocations is set; GSlice
+ * allocations are only included when running with G_SLICE=always-malloc */
+static gboolean counting_allocations;
+static guint n_allocations;
+
+static gpointer
+counting_malloc (gsize n_bytes)
+{
+  if (counting_allocations)
+    g_atomic_int_inc (&n_allocations);
+  return malloc (n_bytes);
+}
+
+static gpointer
+counting_realloc (gpointer mem,
+                  gsize    n_bytes)
+{
+  if (counting_allocations && mem == NULL)
+    g_atomic_int_inc (&n_allocations);
+  return realloc (mem, n_bytes);
+}
+
+static gpointer
+counting_calloc (gsize n_blocks,
+                 gsize n_block_bytes)
+{
+  if (counting_allocations)
+    g_atomic_int_inc (&n_allocations);
+  return calloc (n_blocks, n_block_bytes);
+}
+
+static gpointer
+passthrough_memalign (gsize alignment,
+                      gsize size)
+{
+  gpointer mem = NULL;
+
+  if (posix_memalign (&mem, alignment, size) != 0)
+    return NULL;
+  return mem;
+}
+
+static GMemVTable counting_vtable = {
+  counting_malloc,
+  counting_realloc,
+  passthrough_memalign,
+  free,
+  counting_calloc,
+  NULL,
+  NULL,
+};
+
+static guint
+get_n_iterations (guint quick,
+                  guint perf)
+{
+  return g_test_perf () ? perf : quick;
+}
+
+static GDBusConnection *
+connection_new_for_fd (gint                 fd,
+                       GDBusConnectionFlags flags)
+{
+  GSocket *socket;
+  GSocketConnection *socket_connection;
+  GDBusConnection *connection;
+  GError *error = NULL;
+
+  socket = g_socket_new_from_fd (fd, &error);
+  g_assert_no_error (error);
+  socket_connection = g_socket_connection_factory_create_connection (socket);
+  g_assert_nonnull (socket_connection);
+  g_object_unref (socket);
+
+  connection = g_dbus_connection_new_sync (G_IO_STREAM (socket_connection),
+                                           NULL, /* guid */
+                                           flags,
+                                           NULL, /* GDBusAuthObserver */
+                                           NULL, /* GCancellable */
+                                           &error);
+  g_assert_no_error (error);
+  g_object_unref (socket_connection);
+
+  return connection;
+}
+
+static void
+create_peer_pair_with_flags (GDBusConnection      **producer,
+                             GDBusConnection      **consumer,
+                             GDBusConnectionFlags   flags)
+{
+  gint sv[2];
+
+  g_assert_cmpint (socketpair (AF_UNIX, SOCK_STREAM, 0, sv), ==, 0);
+
+  *producer = connection_new_for_fd (sv[0], flags);
+  *consumer = connection_new_for_fd (sv[1], flags);
+}
+
+static void
+create_peer_pair (GDBusConnection **producer,
+                  GDBusConnection **consumer)
+{
+  create_peer_pair_with_flags (producer, consumer, G_DBUS_CONNECTION_FLAGS_NONE);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+typedef struct
+{
+  guint n_expected;
+  guint n_received;
+  GMainLoop *loop;
+} SignalCounter;
+
+static void
+on_ping (GDBusConnection *connection,
+         const gchar     *sender_name,
+         const gchar     *object_path,
+         const gchar     *interface_name,
+         const gchar     *signal_name,
+         GVariant        *parameters,
+         gpointer         user_data)
+{
+  SignalCounter *counter = user_data;
+  guint32 seq;
+
+  g_variant_get (parameters, "(u)", &seq);
+  g_assert_cmpuint (seq, ==, counter->n_received);
+
+  if (++counter->n_received == counter->n_expected)
+    g_main_loop_quit (counter->loop);
+}
+
+static void
+test_signal_throughput (void)
+{
+  GDBusConnection *producer, *consumer;
+  SignalCounter counter;
+  guint subscription_id;
+  GTimer *timer;
+  gdouble elapsed;
+  guint i;
+
+  create_peer_pair (&producer, &consumer);
+
+  counter.n_expected = get_n_iterations (1000, 200000);
+  counter.n_received = 0;
+  counter.loop = g_main_loop_new (NULL, FALSE);
+
+  subscription_id = g_dbus_connection_signal_subscribe (consumer,
+                                                        NULL, /* sender */
+                                                        PERF_INTERFACE,
+                                                        "Ping",
+                                                        NULL, /* object path */
+                                                        NULL, /* arg0 */
+                                                        G_DBUS_SIGNAL_FLAGS_NONE,
+                                                        on_ping,
+                                                        &counter,
+                                                        NULL);
+
+  timer = g_timer_new ();
+
+  for (i = 0; i != counter.n_expected; i++)
+    {
+      GError *error = NULL;
+
+      g_dbus_connection_emit_signal (producer,
+                                     NULL, /* destination */
+                                     "/org/gtk/GDBus/PerformanceTest",
+                                     PERF_INTERFACE,
+                                     "Ping",
+                                     g_variant_new ("(u)", i),
+                                     &error);
+      g_assert_no_error (error);
+    }
+
+  g_main_loop_run (counter.loop);
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_test_maximized_result (counter.n_expected / elapsed,
+                           "%u signals in %.3f s: %.0f signals/s",
+                           counter.n_expected, elapsed, counter.n_expected / elapsed);
+
+  g_timer_destroy (timer);
+  g_dbus_connection_signal_unsubscribe (consumer, subscription_id);
+  g_main_loop_unref (counter.loop);
+  g_object_unref (consumer);
+  g_object_unref (producer);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+typedef struct
+{
+  guint n_expected;
+  guint n_received;
+  gsize payload_size;
+  GMainLoop *loop;
+} PayloadCounter;
+
+static void
+on_payload (GDBusConnection *connection,
+            const gchar     *sender_name,
+            const gchar     *object_path,
+            const gchar     *interface_name,
+            const gchar     *signal_name,
+            GVariant        *parameters,
+            gpointer         user_data)
+{
+  PayloadCounter *counter = user_data;
+  GVariant *payload;
+  gsize size;
+
+  payload = g_variant_get_child_value (parameters, 0);
+  if (g_variant_is_of_type (payload, G_VARIANT_TYPE_STRING))
+    g_variant_get_string (payload, &size);
+  else
+    g_variant_get_fixed_array (payload, &size, 1);
+  g_assert_cmpuint (size, ==, counter->payload_size);
+  g_variant_unref (payload);
+
+  if (++counter->n_received == counter->n_expected)
+    g_main_loop_quit (counter->loop);
+}
+
+static void
+test_payload_throughput (gconstpointer test_data)
+{
+  const gchar *type_string = test_data;
+  GDBusConnection *producer, *consumer;
+  PayloadCounter counter;
+  GVariant *payload;
+  guint subscription_id;
+  GTimer *timer;
+  gdouble elapsed;
+  guint i;
+
+  create_peer_pair (&producer, &consumer);
+
+  counter.n_expected = get_n_iterations (100, 20000);
+  counter.n_received = 0;
+  counter.payload_size = 16 * 1024;
+  counter.loop = g_main_loop_new (NULL, FALSE);
+
+  if (g_str_equal (type_string, "s"))
+    {
+      gchar *str = g_strnfill (counter.payload_size, 'x');
+      payload = g_variant_new_take_string (str);
+    }
+  else
+    {
+      guint8 *data = g_malloc0 (counter.payload_size);
+      payload = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, data, counter.payload_size, 1);
+      g_free (data);
+    }
+  payload = g_variant_ref_sink (g_variant_new_tuple (&payload, 1));
+
+  subscription_id = g_dbus_connection_signal_subscribe (consumer,
+                                                        NULL, /* sender */
+                                                        PERF_INTERFACE,
+                                                        "Payload",
+                                                        NULL, /* object path */
+                                                        NULL, /* arg0 */
+                                                        G_DBUS_SIGNAL_FLAGS_NONE,
+                                                        on_payload,
+                                                        &counter,
+                                                        NULL);
+
+  timer = g_timer_new ();
+
+  for (i = 0; i != counter.n_expected; i++)
+    {
+      GError *error = NULL;
+
+      g_dbus_connection_emit_signal (producer,
+                                     NULL, /* destination */
+                                     "/org/gtk/GDBus/PerformanceTest",
+                                     PERF_INTERFACE,
+                                     "Payload",
+                                     payload,
+                                     &error);
+      g_assert_no_error (error);
+    }
+
+  g_main_loop_run (counter.loop);
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_test_maximized_result (counter.n_expected * counter.payload_size / elapsed / (1024 * 1024),
+                           "%u (%s) signals of %" G_GSIZE_FORMAT " bytes in %.3f s: %.1f MiB/s",
+                           counter.n_expected, type_string, counter.payload_size, elapsed,
+                           counter.n_expected * counter.payload_size / elapsed / (1024 * 1024));
+
+  g_timer_destroy (timer);
+  g_dbus_connection_signal_unsubscribe (consumer, subscription_id);
+  g_variant_unref (payload);
+  g_main_loop_unref (counter.loop);
+  g_object_unref (consumer);
+  g_object_unref (producer);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Frida-style RPC: a batch of agent messages, each a JSON payload with
+ * optional binary data. */
+static guchar *
+create_rpc_blob (gsize *out_size)
+{
+  GDBusMessage *message;
+  GVariantBuilder builder;
+  guchar *blob;
+  GError *error = NULL;
+  guint i;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(iusbay)"));
+  for (i = 0; i != 4; i++)
+    {
+      gchar *text = g_strdup_printf ("{\"type\":\"send\",\"payload\":{\"seq\":%u,"
+                                     "\"event\":\"instruction\",\"address\":\"0x7fff5fbff%03x\","
+                                     "\"thread\":1234,\"data\":[1,2,3,4,5,6,7,8,9,10]}}", i, i);
+      g_variant_builder_add (&builder, "(iusb@ay)",
+                             1, 42, text, i == 0,
+                             g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, "0123456789abcdef", (i == 0) ? 16 : 0, 1));
+      g_free (text);
+    }
+
+  message = g_dbus_message_new_method_call (NULL,
+                                            "/re/frida/AgentSession/1",
+                                            "re.frida.AgentSession16",
+                                            "PostMessages");
+  g_dbus_message_set_flags (message, G_DBUS_MESSAGE_FLAGS_NO_REPLY_EXPECTED);
+  g_dbus_message_set_serial (message, 1);
+  g_dbus_message_set_body (message, g_variant_new ("(a(iusbay)u)", &builder, 7));
+
+  blob = g_dbus_message_to_blob (message, out_size, G_DBUS_CAPABILITY_FLAGS_NONE, &error);
+  g_assert_no_error (error);
+  g_object_unref (message);
+
+  return blob;
+}
+
+static void
+test_message_decode (gconstpointer test_data)
+{
+  gboolean use_body = GPOINTER_TO_INT (test_data);
+  guchar *blob;
+  gsize blob_size;
+  guint n_iterations, i;
+  GTimer *timer;
+  gdouble elapsed;
+
+  blob = create_rpc_blob (&blob_size);
+  n_iterations = get_n_iterations (1000, 500000);
+
+  timer = g_timer_new ();
+
+  for (i = 0; i != n_iterations; i++)
+    {
+      GDBusMessage *message;
+      GError *error = NULL;
+
+      message = g_dbus_message_new_from_blob (blob, blob_size, G_DBUS_CAPABILITY_FLAGS_NONE, &error);
+      g_assert_no_error (error);
+
+      /* routing only looks at the headers */
+      g_assert_cmpstr (g_dbus_message_get_member (message), ==, "PostMessages");
+      g_assert_cmpstr (g_dbus_message_get_path (message), ==, "/re/frida/AgentSession/1");
+
+      if (use_body)
+        {
+          GVariant *body = g_dbus_message_get_body (message);
+          g_assert_cmpuint (g_variant_n_children (body), ==, 2);
+        }
+
+      g_object_unref (message);
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_test_maximized_result (n_iterations / elapsed,
+                           "%u %s messages of %" G_GSIZE_FORMAT " bytes in %.3f s: %.0f messages/s",
+                           n_iterations, use_body ? "consumed" : "routed", blob_size,
+                           elapsed, n_iterations / elapsed);
+
+  g_timer_destroy (timer);
+  g_free (blob);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* A property dump of roughly @body_size bytes: an a{sv} mixing strings,
+ * numbers, small byte arrays and string arrays. */
+static GDBusMessage *
+create_dict_message (gsize body_size)
+{
+  GDBusMessage *message;
+  GVariantBuilder builder;
+  gsize size;
+  guint i;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+  for (i = 0, size = 0; size < body_size; i++)
+    {
+      gchar *key = g_strdup_printf ("property-%u", i);
+      GVariant *value;
+
+      switch (i % 4)
+        {
+        case 0:
+          value = g_variant_new_take_string (g_strdup_printf ("/org/gtk/GDBus/PerformanceTest/%u", i));
+          break;
+        case 1:
+          value = g_variant_new_uint32 (i);
+          break;
+        case 2:
+          value = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, "0123456789abcdef", 16, 1);
+          break;
+        default:
+          {
+            const gchar *strv[] = { "read", "write", "execute", NULL };
+            value = g_variant_new_strv (strv, -1);
+          }
+          break;
+        }
+
+      /* key, signature and value, plus the entry's alignment */
+      size += 4 + strlen (key) + 1 + 3 + g_variant_get_size (value) + 8;
+      g_variant_builder_add (&builder, "{sv}", key, value);
+      g_free (key);
+    }
+
+  message = g_dbus_message_new_signal ("/org/gtk/GDBus/PerformanceTest",
+                                       PERF_INTERFACE,
+                                       "PropertiesChanged");
+  g_dbus_message_set_serial (message, 1);
+  g_dbus_message_set_body (message, g_variant_new ("(a{sv})", &builder));
+
+  return message;
+}
+
+static void
+test_body_transcode (gconstpointer test_data)
+{
+  gsize body_size = GPOINTER_TO_SIZE (test_data);
+  GDBusMessage *message;
+  GVariant *received_body = NULL;
+  guchar *blob;
+  gsize blob_size;
+  guint n_iterations, i;
+  GTimer *timer;
+  gdouble decode_elapsed, encode_elapsed;
+  GError *error = NULL;
+
+  message = create_dict_message (body_size);
+  blob = g_dbus_message_to_blob (message, &blob_size, G_DBUS_CAPABILITY_FLAGS_NONE, &error);
+  g_assert_no_error (error);
+  g_object_unref (message);
+
+  /* about 4 MiB in total by default, 256 MiB with -m perf */
+  n_iterations = MAX (get_n_iterations (4, 256) * 1024 * 1024 / blob_size, 1);
+
+  timer = g_timer_new ();
+
+  for (i = 0; i != n_iterations; i++)
+    {
+      GDBusMessage *parsed;
+
+      parsed = g_dbus_message_new_from_blob (blob, blob_size, G_DBUS_CAPABILITY_FLAGS_NONE, &error);
+      g_assert_no_error (error);
+
+      g_clear_pointer (&received_body, g_variant_unref);
+      received_body = g_variant_ref (g_dbus_message_get_body (parsed));
+      g_assert_cmpuint (g_variant_n_children (received_body), ==, 1);
+
+      g_object_unref (parsed);
+    }
+
+  decode_elapsed = g_timer_elapsed (timer, NULL);
+
+  /* forward the received body, as a proxy would */
+  message = g_dbus_message_new_signal ("/org/gtk/GDBus/PerformanceTest",
+                                       PERF_INTERFACE,
+                                       "PropertiesChanged");
+  g_dbus_message_set_serial (message, 1);
+  g_dbus_message_set_body (message, received_body);
+
+  g_timer_start (timer);
+
+  for (i = 0; i != n_iterations; i++)
+    {
+      guchar *forwarded;
+      gsize forwarded_size;
+
+      forwarded = g_dbus_message_to_blob (message, &forwarded_size, G_DBUS_CAPABILITY_FLAGS_NONE, &error);
+      g_assert_no_error (error);
+      g_assert_cmpmem (forwarded, forwarded_size, blob, blob_size);
+      g_free (forwarded);
+    }
+
+  encode_elapsed = g_timer_elapsed (timer, NULL);
+
+  g_test_maximized_result (n_iterations * blob_size / decode_elapsed / (1024 * 1024),
+                           "decoded %u messages of %" G_GSIZE_FORMAT " bytes in %.3f s: %.1f MiB/s",
+                           n_iterations, blob_size, decode_elapsed,
+                           n_iterations * blob_size / decode_elapsed / (1024 * 1024));
+  g_test_maximized_result (n_iterations * blob_size / encode_elapsed / (1024 * 1024),
+                           "encoded %u messages of %" G_GSIZE_FORMAT " bytes in %.3f s: %.1f MiB/s",
+                           n_iterations, blob_size, encode_elapsed,
+                           n_iterations * blob_size / encode_elapsed / (1024 * 1024));
+
+  g_timer_destroy (timer);
+  g_variant_unref (received_body);
+  g_object_unref (message);
+  g_free (blob);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Many agents talking to one host at once: N_PEERS independent peer-to-peer
+ * connections, each flooded with signals from its own thread. The consumer
+ * counts them in a filter, i.e. on the connection's worker thread, so the
+ * result reflects how well the I/O side scales rather than main-loop
+ * dispatch. */
+#define N_PEERS 32
+
+typedef struct
+{
+  GDBusConnection *producer;
+  GDBusConnection *consumer;
+  guint filter_id;
+  guint n_signals;
+  GThread *thread;
+} Peer;
+
+typedef struct
+{
+  GMutex mutex;
+  GCond cond;
+  guint n_remaining;
+} PeerCounter;
+
+static GDBusMessage *
+count_peer_message (GDBusConnection *connection,
+                    GDBusMessage    *message,
+                    gboolean         incoming,
+                    gpointer         user_data)
+{
+  PeerCounter *counter = user_data;
+
+  if (incoming && g_dbus_message_get_message_type (message) == G_DBUS_MESSAGE_TYPE_SIGNAL)
+    {
+      g_mutex_lock (&counter->mutex);
+      if (--counter->n_remaining == 0)
+        g_cond_signal (&counter->cond);
+      g_mutex_unlock (&counter->mutex);
+    }
+
+  g_object_unref (message);
+  return NULL;
+}
+
+static gpointer
+flood_peer (gpointer user_data)
+{
+  Peer *peer = user_data;
+  guint i;
+
+  for (i = 0; i != peer->n_signals; i++)
+    {
+      GError *error = NULL;
+
+      g_dbus_connection_emit_signal (peer->producer,
+                                     NULL, /* destination */
+                                     "/org/gtk/GDBus/PerformanceTest",
+                                     PERF_INTERFACE,
+                                     "Ping",
+                                     g_variant_new ("(u)", i),
+                                     &error);
+      g_assert_no_error (error);
+    }
+
+  return NULL;
+}
+
+static void
+test_concurrent_peers (gconstpointer test_data)
+{
+  GDBusConnectionFlags flags = GPOINTER_TO_UINT (test_data);
+  Peer peers[N_PEERS];
+  PeerCounter counter;
+  guint n_signals, i;
+  GTimer *timer;
+  gdouble elapsed;
+
+  n_signals = get_n_iterations (100, 20000);
+
+  g_mutex_init (&counter.mutex);
+  g_cond_init (&counter.cond);
+  counter.n_remaining = N_PEERS * n_signals;
+
+  for (i = 0; i != N_PEERS; i++)
+    {
+      Peer *peer = &peers[i];
+
+      create_peer_pair_with_flags (&peer->producer, &peer->consumer, flags);
+      peer->filter_id = g_dbus_connection_add_filter (peer->consumer, count_peer_message, &counter, NULL);
+      peer->n_signals = n_signals;
+    }
+
+  timer = g_timer_new ();
+
+  for (i = 0; i != N_PEERS; i++)
+    peers[i].thread = g_thread_new ("flood-peer", flood_peer, &peers[i]);
+
+  g_mutex_lock (&counter.mutex);
+  while (counter.n_remaining != 0)
+    g_cond_wait (&counter.cond, &counter.mutex);
+  g_mutex_unlock (&counter.mutex);
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_test_maximized_result (N_PEERS * n_signals / elapsed,
+                           "%u signals over %u %s connections in %.3f s: %.0f signals/s",
+                           N_PEERS * n_signals, N_PEERS,
+                           (flags & G_DBUS_CONNECTION_FLAGS_SHARDED_WORKER_THREAD) ? "sharded" : "shared",
+                           elapsed, N_PEERS * n_signals / elapsed);
+
+  for (i = 0; i != N_PEERS; i++)
+    {
+      Peer *peer = &peers[i];
+
+      g_thread_join (peer->thread);
+      g_dbus_connection_remove_filter (peer->consumer, peer->filter_id);
+      g_object_unref (peer->consumer);
+      g_object_unref (peer->producer);
+    }
+
+  g_timer_destroy (timer);
+  g_cond_clear (&counter.cond);
+  g_mutex_clear (&counter.mutex);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* The gdbus-message workload: build a method call carrying the usual
+ * routing headers, serialize it, parse it back and read the headers the
+ * way GDBusConnection does when routing a message. */
+static void
+test_message_roundtrip (void)
+{
+  guint n_iterations, i;
+  GTimer *timer;
+  gdouble elapsed;
+  guint allocations;
+
+  n_iterations = get_n_iterations (1000, 500000);
+
+  g_atomic_int_set (&n_allocations, 0);
+  counting_allocations = TRUE;
+  timer = g_timer_new ();
+
+  for (i = 0; i != n_iterations; i++)
+    {
+      GDBusMessage *message, *parsed;
+      guchar *blob;
+      gsize blob_size;
+      GError *error = NULL;
+
+      message = g_dbus_message_new_method_call ("org.gtk.GDBus.PerformanceTest.Service",
+                                                "/org/gtk/GDBus/PerformanceTest",
+                                                PERF_INTERFACE,
+                                                "Ping");
+      g_dbus_message_set_sender (message, ":1.42");
+      g_dbus_message_set_serial (message, i + 1);
+      g_dbus_message_set_body (message, g_variant_new ("(u)", i));
+
+      blob = g_dbus_message_to_blob (message, &blob_size, G_DBUS_CAPABILITY_FLAGS_NONE, &error);
+      g_assert_no_error (error);
+
+      parsed = g_dbus_message_new_from_blob (blob, blob_size, G_DBUS_CAPABILITY_FLAGS_NONE, &error);
+      g_assert_no_error (error);
+
+      g_assert_cmpuint (g_dbus_message_get_serial (parsed), ==, i + 1);
+      g_assert_cmpstr (g_dbus_message_get_destination (parsed), ==, "org.gtk.GDBus.PerformanceTest.Service");
+      g_assert_cmpstr (g_dbus_message_get_sender (parsed), ==, ":1.42");
+      g_assert_cmpstr (g_dbus_message_get_path (parsed), ==, "/org/gtk/GDBus/PerformanceTest");
+      g_assert_cmpstr (g_dbus_message_get_interface (parsed), ==, PERF_INTERFACE);
+      g_assert_cmpstr (g_dbus_message_get_member (parsed), ==, "Ping");
+      g_assert_cmpstr (g_dbus_message_get_signature (parsed), ==, "u");
+
+      g_object_unref (parsed);
+      g_free (blob);
+      g_object_unref (message);
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  counting_allocations = FALSE;
+  allocations = g_atomic_int_get (&n_allocations);
+
+  g_test_minimized_result (elapsed * 1e9 / n_iterations,
+                           "%u message round-trips in %.3f s: %.0f ns/message, %.1f allocations/message",
+                           n_iterations, elapsed, elapsed * 1e9 / n_iterations,
+                           (gdouble) allocations / n_iterations);
+
+  g_timer_destroy (timer);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_mem_set_vtable (&counting_vtable);
+
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/gdbus/performance/signal-throughput", test_signal_throughput);
+  g_test_add_data_func ("/gdbus/performance/payload-throughput/string", "s", test_payload_throughput);
+  g_test_add_data_func ("/gdbus/performance/payload-throughput/bytes", "ay", test_payload_throughput);
+  g_test_add_data_func ("/gdbus/performance/message-decode/routed", GINT_TO_POINTER (FALSE), test_message_decode);
+  g_test_add_data_func ("/gdbus/performance/message-decode/consumed", GINT_TO_POINTER (TRUE), test_message_decode);
+  g_test_add_data_func ("/gdbus/performance/body-transcode/1k", GSIZE_TO_POINTER (1024), test_body_transcode);
+  g_test_add_data_func ("/gdbus/performance/body-transcode/64k", GSIZE_TO_POINTER (64 * 1024), test_body_transcode);
+  g_test_add_data_func ("/gdbus/performance/body-transcode/16m", GSIZE_TO_POINTER (16 * 1024 * 1024), test_body_transcode);
+  g_test_add_data_func ("/gdbus/performance/concurrent-peers/shared",
+                        GUINT_TO_POINTER (G_DBUS_CONNECTION_FLAGS_NONE),
+                        test_concurrent_peers);
+  g_test_add_data_func ("/gdbus/performance/concurrent-peers/sharded",
+                        GUINT_TO_POINTER (G_DBUS_CONNECTION_FLAGS_SHARDED_WORKER_THREAD),
+                        test_concurrent_peers);
+  g_test_add_func ("/gdbus/performance/message-roundtrip", test_message_roundtrip);
+
+  return g_test_run ();
+}
@@ -1584,6 +1584,143 @@ test_message_parse_empty_structure (void)
   g_clear_error (&local_error);
 }
 
+static void
+test_message_parse_forward_unparsed_body (void)
+{
+  /* small bodies are parsed right away, large ones on first use */
+  const gsize payload_sizes[] = { 0, 8192 };
+  gsize i;
+
+  g_test_summary ("Test that a message whose body has not been used yet can "
+                  "be copied and serialized again, in either byte order.");
+
+  for (i = 0; i < G_N_ELEMENTS (payload_sizes); i++)
+    {
+      GDBusMessage *message, *copy;
+      GVariant *body;
+      guchar *payload;
+      guchar *blob, *forwarded_blob;
+      gsize blob_size, forwarded_size;
+      GError *local_error = NULL;
+
+      g_test_message ("Payload size %" G_GSIZE_FORMAT, payload_sizes[i]);
+
+      payload = g_malloc0 (payload_sizes[i]);
+      message = g_dbus_message_new_signal ("/org/gtk/GDBus/Test", "org.gtk.GDBus.Test", "Signal");
+      g_dbus_message_set_body (message, g_variant_new ("(sa{sv}@ay)",
+                                                       "hello",
+                                                       NULL,
+                                                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+                                                                                  payload,
+                                                                                  payload_sizes[i],
+                                                                                  1)));
+      g_free (payload);
+      blob = g_dbus_message_to_blob (message, &blob_size, G_DBUS_CAPABILITY_FLAGS_NONE, &local_error);
+      g_assert_no_error (local_error);
+      g_object_unref (message);
+
+      message = g_dbus_message_new_from_blob (blob, blob_size, G_DBUS_CAPABILITY_FLAGS_NONE, &local_error);
+      g_assert_no_error (local_error);
+      g_assert_nonnull (message);
+
+      /* copying must not lose the body */
+      copy = g_dbus_message_copy (message, &local_error);
+      g_assert_no_error (local_error);
+
+      forwarded_blob = g_dbus_message_to_blob (copy, &forwarded_size, G_DBUS_CAPABILITY_FLAGS_NONE, &local_error);
+      g_assert_no_error (local_error);
+      g_assert_cmpmem (forwarded_blob, forwarded_size, blob, blob_size);
+      g_free (forwarded_blob);
+
+      g_dbus_message_set_byte_order (copy,
+                                     (g_dbus_message_get_byte_order (copy) == G_DBUS_MESSAGE_BYTE_ORDER_BIG_ENDIAN) ?
+                                     G_DBUS_MESSAGE_BYTE_ORDER_LITTLE_ENDIAN :
+                                     G_DBUS_MESSAGE_BYTE_ORDER_BIG_ENDIAN);
+      forwarded_blob = g_dbus_message_to_blob (copy, &forwarded_size, G_DBUS_CAPABILITY_FLAGS_NONE, &local_error);
+      g_assert_no_error (local_error);
+      g_object_unref (copy);
+
+      copy = g_dbus_message_new_from_blob (forwarded_blob, forwarded_size, G_DBUS_CAPABILITY_FLAGS_NONE, &local_error);
+      g_assert_no_error (local_error);
+      g_free (forwarded_blob);
+
+      body = g_dbus_message_get_body (message);
+      g_assert_nonnull (body);
+      g_assert_cmpvariant (g_dbus_message_get_body (copy), body);
+      g_assert_cmpstr (g_dbus_message_get_arg0 (copy), ==, "hello");
+
+      /* once parsed, the body is serialized from the parsed value */
+      forwarded_blob = g_dbus_message_to_blob (message, &forwarded_size, G_DBUS_CAPABILITY_FLAGS_NONE, &local_error);
+      g_assert_no_error (local_error);
+      g_assert_cmpmem (forwarded_blob, forwarded_size, blob, blob_size);
+      g_free (forwarded_blob);
+
+      g_object_unref (copy);
+      g_object_unref (message);
+      g_free (blob);
+    }
+}
+
+static void
+test_message_parse_transcoded_containers (void)
+{
+  const GDBusMessageByteOrder byte_orders[] = {
+    G_DBUS_MESSAGE_BYTE_ORDER_LITTLE_ENDIAN,
+    G_DBUS_MESSAGE_BYTE_ORDER_BIG_ENDIAN,
+  };
+  GVariant *body;
+  GError *local_error = NULL;
+  gsize i;
+
+  g_test_summary ("Test that arrays read straight into their serialized form "
+                  "match the values sent, and are written back unchanged, in "
+                  "either byte order.");
+
+  body = g_variant_parse (G_VARIANT_TYPE ("(a{sv}a(sav)aasabaa{ot}a(ybnqiuxtdhg))"),
+                          "({'name': <'value'>, 'count': <uint32 42>, 'empty': <@as []>,"
+                          "  'nested': <{'deeper': <(byte 1, 'two', [int64 3, 4], <true>)>}>,"
+                          "  'bytes': <b'\\x01\\x02\\x03'>, 'unit': <(uint16 7,)>},"
+                          " [('a', [<1>, <'b'>, <@a{sv} {}>]), ('', @av [])],"
+                          " [['x', 'yy', ''], [], ['zzz']],"
+                          " [true, false, true],"
+                          " [{'/org/gtk/GDBus/Test': 18446744073709551615}, {}],"
+                          " [(255, true, -2, 65535, -7, 9, -11, 12, 13.5, handle 1, 'a{sv}')])",
+                          NULL, NULL, &local_error);
+  g_assert_no_error (local_error);
+  g_variant_ref_sink (body);
+
+  for (i = 0; i < G_N_ELEMENTS (byte_orders); i++)
+    {
+      GDBusMessage *message, *parsed;
+      guchar *blob, *forwarded_blob;
+      gsize blob_size, forwarded_size;
+      GVariant *parsed_body;
+
+      message = g_dbus_message_new_signal ("/org/gtk/GDBus/Test", "org.gtk.GDBus.Test", "Signal");
+      g_dbus_message_set_byte_order (message, byte_orders[i]);
+      g_dbus_message_set_body (message, body);
+      blob = g_dbus_message_to_blob (message, &blob_size, G_DBUS_CAPABILITY_FLAGS_NONE, &local_error);
+      g_assert_no_error (local_error);
+
+      parsed = g_dbus_message_new_from_blob (blob, blob_size, G_DBUS_CAPABILITY_FLAGS_NONE, &local_error);
+      g_assert_no_error (local_error);
+      parsed_body = g_dbus_message_get_body (parsed);
+      g_assert_cmpvariant (parsed_body, body);
+      g_assert_true (g_variant_is_normal_form (parsed_body));
+
+      forwarded_blob = g_dbus_message_to_blob (parsed, &forwarded_size, G_DBUS_CAPABILITY_FLAGS_NONE, &local_error);
+      g_assert_no_error (local_error);
+      g_assert_cmpmem (forwarded_blob, forwarded_size, blob, blob_size);
+
+      g_free (forwarded_blob);
+      g_object_unref (parsed);
+      g_free (blob);
+      g_object_unref (message);
+    }
+
+  g_variant_unref (body);
+}
+
 static void
 test_message_serialize_empty_structure (void)
 {
@@ -1657,6 +1794,10 @@ main (int   argc,
                    test_message_parse_truncated);
   g_test_add_func ("/gdbus/message-parse/empty-structure",
                    test_message_parse_empty_structure);
+  g_test_add_func ("/gdbus/message-parse/forward-unparsed-body",
+                   test_message_parse_forward_unparsed_body);
+  g_test_add_func ("/gdbus/message-parse/transcoded-containers",
+                   test_message_parse_transcoded_containers);
 
   return g_test_run();
 }
@@ -0,0 +1,177 @@
+/* GLib testing framework examples and tests
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gio/gio.h>
+#include <gio/gunixinputstream.h>
+#include <glib-unix.h>
+
+#include <unistd.h>
+
+/* Asynchronous reads with GIO_USE_IO_URING=1.  Where the kernel lacks
+ * io_uring the same reads go through the pollable path, and the tests
+ * must pass either way.
+ */
+
+/* More operations than the completion ring has room for */
+#define N_PIPES 200
+
+typedef struct
+{
+  gint fds[2];
+  GInputStream *in;
+  gchar buffer[4];
+  gssize n_read;
+  GError *error;
+} PipeRead;
+
+static guint n_pending;
+
+static void
+read_cb (GObject      *source,
+         GAsyncResult *result,
+         gpointer      user_data)
+{
+  PipeRead *read = user_data;
+
+  read->n_read = g_input_stream_read_finish (G_INPUT_STREAM (source), result, &read->error);
+  n_pending--;
+}
+
+static PipeRead *
+start_reads (gboolean      nonblocking,
+             GCancellable *cancellable)
+{
+  PipeRead *reads = g_new0 (PipeRead, N_PIPES);
+  guint i;
+
+  for (i = 0; i < N_PIPES; i++)
+    {
+      GError *error = NULL;
+
+      g_unix_open_pipe (reads[i].fds, FD_CLOEXEC, &error);
+      g_assert_no_error (error);
+      if (nonblocking)
+        {
+          g_unix_set_fd_nonblocking (reads[i].fds[0], TRUE, &error);
+          g_assert_no_error (error);
+        }
+
+      reads[i].in = g_unix_input_stream_new (reads[i].fds[0], TRUE);
+      g_input_stream_read_async (reads[i].in, reads[i].buffer, sizeof (reads[i].buffer),
+                                 G_PRIORITY_DEFAULT, cancellable, read_cb, &reads[i]);
+      n_pending++;
+    }
+
+  /* let every read reach the kernel and find its pipe empty */
+  for (i = 0; i < 10; i++)
+    g_main_context_iteration (NULL, FALSE);
+
+  return reads;
+}
+
+static void
+free_reads (PipeRead *reads)
+{
+  guint i;
+
+  for (i = 0; i < N_PIPES; i++)
+    {
+      g_clear_error (&reads[i].error);
+      g_object_unref (reads[i].in);
+      close (reads[i].fds[1]);
+    }
+  g_free (reads);
+}
+
+static void
+test_many_reads (gconstpointer data)
+{
+  gboolean nonblocking = GPOINTER_TO_INT (data);
+  PipeRead *reads;
+  guint i;
+
+  g_test_summary ("Test that reads beyond what the ring has room for, and "
+                  "reads from non-blocking descriptors that are not ready "
+                  "yet, complete with their data");
+
+  reads = start_reads (nonblocking, NULL);
+  g_assert_cmpuint (n_pending, ==, N_PIPES);
+
+  for (i = 0; i < N_PIPES; i++)
+    g_assert_cmpint (write (reads[i].fds[1], "ok", 2), ==, 2);
+
+  while (n_pending != 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  for (i = 0; i < N_PIPES; i++)
+    {
+      g_assert_no_error (reads[i].error);
+      g_assert_cmpint (reads[i].n_read, ==, 2);
+      g_assert_cmpmem (reads[i].buffer, 2, "ok", 2);
+    }
+
+  free_reads (reads);
+}
+
+static void
+test_cancel (void)
+{
+  GCancellable *cancellable;
+  PipeRead *reads;
+  guint i;
+
+  g_test_summary ("Test that cancelling many pending reads at once cancels "
+                  "every one of them in the kernel");
+
+  cancellable = g_cancellable_new ();
+  reads = start_reads (FALSE, cancellable);
+
+  g_cancellable_cancel (cancellable);
+  while (n_pending != 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  for (i = 0; i < N_PIPES; i++)
+    {
+      gchar c;
+
+      g_assert_error (reads[i].error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+
+      /* nothing is left reading from the pipe */
+      g_assert_cmpint (write (reads[i].fds[1], "x", 1), ==, 1);
+      g_assert_cmpint (read (reads[i].fds[0], &c, 1), ==, 1);
+      g_assert_cmpint (c, ==, 'x');
+    }
+
+  free_reads (reads);
+  g_object_unref (cancellable);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_setenv ("GIO_USE_IO_URING", "1", TRUE);
+
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_data_func ("/io-uring/many-reads/blocking", GINT_TO_POINTER (FALSE), test_many_reads);
+  g_test_add_data_func ("/io-uring/many-reads/nonblocking", GINT_TO_POINTER (TRUE), test_many_reads);
+  g_test_add_func ("/io-uring/cancel", test_cancel);
+
+  return g_test_run ();
+}
@@ -0,0 +1,357 @@
+/* GLib testing framework examples and tests
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include <string.h>
+#include <sys/socket.h>
+
+/* Throughput benchmarks for the default asynchronous read and write paths
+ * of file and socket streams. Run with `-m perf` for meaningful numbers,
+ * with and without GIO_USE_IO_URING=1 to compare the completion backend
+ * against the pollable and thread-based paths; in the default mode the
+ * workloads are kept small so the test doubles as a smoke test.
+ *
+ * Syscall counts are the read and write syscalls reported by
+ * /proc/self/io, which is what the completion backend saves; its own
+ * io_uring_enter() calls are not included.
+ */
+
+typedef struct
+{
+  guint64 syscr;
+  guint64 syscw;
+} IOCounters;
+
+static void
+read_io_counters (IOCounters *counters)
+{
+  gchar *contents = NULL;
+  gchar **lines;
+  guint i;
+
+  memset (counters, 0, sizeof (*counters));
+
+  if (!g_file_get_contents ("/proc/self/io", &contents, NULL, NULL))
+    return;
+
+  lines = g_strsplit (contents, "\n", -1);
+  for (i = 0; lines[i] != NULL; i++)
+    {
+      if (g_str_has_prefix (lines[i], "syscr: "))
+        counters->syscr = g_ascii_strtoull (lines[i] + 7, NULL, 10);
+      else if (g_str_has_prefix (lines[i], "syscw: "))
+        counters->syscw = g_ascii_strtoull (lines[i] + 7, NULL, 10);
+    }
+
+  g_strfreev (lines);
+  g_free (contents);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+#define FILE_CHUNK_SIZE (64 * 1024)
+#define FILE_PATTERN_PERIOD 251
+
+typedef struct
+{
+  GInputStream *stream;
+  guint8 *buffer;
+  guint64 n_bytes;
+  guint n_reads;
+  GMainLoop *loop;
+} FileReader;
+
+static void
+file_read_cb (GObject      *source,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+  FileReader *reader = user_data;
+  GError *error = NULL;
+  gssize n_read;
+
+  n_read = g_input_stream_read_finish (reader->stream, result, &error);
+  g_assert_no_error (error);
+  reader->n_reads++;
+
+  if (n_read == 0)
+    {
+      g_main_loop_quit (reader->loop);
+      return;
+    }
+
+  g_assert_cmpuint (reader->buffer[0], ==, reader->n_bytes % FILE_PATTERN_PERIOD);
+  reader->n_bytes += n_read;
+
+  g_input_stream_read_async (reader->stream, reader->buffer, FILE_CHUNK_SIZE,
+                             G_PRIORITY_DEFAULT, NULL, file_read_cb, reader);
+}
+
+static void
+test_file_streaming (void)
+{
+  gsize file_size = (g_test_perf () ? 256 : 4) * 1024 * 1024;
+  FileReader reader = { 0, };
+  IOCounters before, after;
+  gchar *path = NULL;
+  guint8 *contents;
+  GError *error = NULL;
+  GTimer *timer;
+  gdouble elapsed;
+  GFile *file;
+  gsize i;
+  gint fd;
+
+  fd = g_file_open_tmp ("stream-performance-XXXXXX", &path, &error);
+  g_assert_no_error (error);
+  g_close (fd, NULL);
+
+  contents = g_malloc (file_size);
+  for (i = 0; i != file_size; i++)
+    contents[i] = i % FILE_PATTERN_PERIOD;
+  g_file_set_contents (path, (const gchar *) contents, file_size, &error);
+  g_assert_no_error (error);
+  g_free (contents);
+
+  file = g_file_new_for_path (path);
+  reader.stream = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+  g_assert_no_error (error);
+  reader.buffer = g_malloc (FILE_CHUNK_SIZE);
+  reader.loop = g_main_loop_new (NULL, FALSE);
+
+  read_io_counters (&before);
+  timer = g_timer_new ();
+
+  g_input_stream_read_async (reader.stream, reader.buffer, FILE_CHUNK_SIZE,
+                             G_PRIORITY_DEFAULT, NULL, file_read_cb, &reader);
+  g_main_loop_run (reader.loop);
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  read_io_counters (&after);
+
+  g_assert_cmpuint (reader.n_bytes, ==, file_size);
+
+  g_test_maximized_result (reader.n_bytes / elapsed / (1024 * 1024),
+                           "%" G_GUINT64_FORMAT " bytes in %u reads, %.3f s: %.1f MiB/s, %.2f read syscalls/read",
+                           reader.n_bytes, reader.n_reads, elapsed,
+                           reader.n_bytes / elapsed / (1024 * 1024),
+                           (gdouble) (after.syscr - before.syscr) / reader.n_reads);
+
+  g_timer_destroy (timer);
+  g_main_loop_unref (reader.loop);
+  g_free (reader.buffer);
+  g_object_unref (reader.stream);
+  g_object_unref (file);
+  g_unlink (path);
+  g_free (path);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Small request/reply messages between the two ends of a socketpair, both
+ * driven from the same main loop.
+ */
+
+#define MESSAGE_SIZE 64
+
+typedef struct
+{
+  GIOStream *connection;
+  guint8 buffer[MESSAGE_SIZE];
+} Endpoint;
+
+typedef struct
+{
+  Endpoint client;
+  Endpoint server;
+  guint n_messages;
+  guint n_remaining;
+  GMainLoop *loop;
+} Exchange;
+
+static void client_write_message (Exchange *exchange);
+static void server_read_message (Exchange *exchange);
+
+static GIOStream *
+connection_new_for_fd (gint fd)
+{
+  GSocket *socket;
+  GIOStream *connection;
+  GError *error = NULL;
+
+  socket = g_socket_new_from_fd (fd, &error);
+  g_assert_no_error (error);
+  connection = G_IO_STREAM (g_socket_connection_factory_create_connection (socket));
+  g_object_unref (socket);
+
+  return connection;
+}
+
+static void
+client_read_cb (GObject      *source,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+  Exchange *exchange = user_data;
+  GError *error = NULL;
+  gsize n_read;
+
+  g_input_stream_read_all_finish (G_INPUT_STREAM (source), result, &n_read, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (n_read, ==, MESSAGE_SIZE);
+  g_assert_cmpuint (exchange->client.buffer[0], ==, exchange->n_remaining % 256);
+
+  if (--exchange->n_remaining == 0)
+    g_main_loop_quit (exchange->loop);
+  else
+    client_write_message (exchange);
+}
+
+static void
+client_write_cb (GObject      *source,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+  Exchange *exchange = user_data;
+  GError *error = NULL;
+
+  g_output_stream_write_all_finish (G_OUTPUT_STREAM (source), result, NULL, &error);
+  g_assert_no_error (error);
+
+  g_input_stream_read_all_async (g_io_stream_get_input_stream (exchange->client.connection),
+                                 exchange->client.buffer, MESSAGE_SIZE,
+                                 G_PRIORITY_DEFAULT, NULL, client_read_cb, exchange);
+}
+
+static void
+client_write_message (Exchange *exchange)
+{
+  memset (exchange->client.buffer, exchange->n_remaining % 256, MESSAGE_SIZE);
+
+  g_output_stream_write_all_async (g_io_stream_get_output_stream (exchange->client.connection),
+                                   exchange->client.buffer, MESSAGE_SIZE,
+                                   G_PRIORITY_DEFAULT, NULL, client_write_cb, exchange);
+}
+
+static void
+server_write_cb (GObject      *source,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+  Exchange *exchange = user_data;
+  GError *error = NULL;
+
+  g_output_stream_write_all_finish (G_OUTPUT_STREAM (source), result, NULL, &error);
+  g_assert_no_error (error);
+
+  server_read_message (exchange);
+}
+
+static void
+server_read_cb (GObject      *source,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+  Exchange *exchange = user_data;
+  GError *error = NULL;
+  gsize n_read;
+
+  g_input_stream_read_all_finish (G_INPUT_STREAM (source), result, &n_read, &error);
+  g_assert_no_error (error);
+
+  /* The client closed its end */
+  if (n_read == 0)
+    {
+      g_main_loop_quit (exchange->loop);
+      return;
+    }
+
+  g_assert_cmpuint (n_read, ==, MESSAGE_SIZE);
+
+  g_output_stream_write_all_async (g_io_stream_get_output_stream (exchange->server.connection),
+                                   exchange->server.buffer, MESSAGE_SIZE,
+                                   G_PRIORITY_DEFAULT, NULL, server_write_cb, exchange);
+}
+
+static void
+server_read_message (Exchange *exchange)
+{
+  g_input_stream_read_all_async (g_io_stream_get_input_stream (exchange->server.connection),
+                                 exchange->server.buffer, MESSAGE_SIZE,
+                                 G_PRIORITY_DEFAULT, NULL, server_read_cb, exchange);
+}
+
+static void
+test_socket_messages (void)
+{
+  Exchange exchange = { 0, };
+  IOCounters before, after;
+  guint64 n_syscalls;
+  GTimer *timer;
+  gdouble elapsed;
+  gint fds[2];
+
+  g_assert_cmpint (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds), ==, 0);
+  exchange.client.connection = connection_new_for_fd (fds[0]);
+  exchange.server.connection = connection_new_for_fd (fds[1]);
+  exchange.n_messages = g_test_perf () ? 200000 : 1000;
+  exchange.n_remaining = exchange.n_messages;
+  exchange.loop = g_main_loop_new (NULL, FALSE);
+
+  read_io_counters (&before);
+  timer = g_timer_new ();
+
+  server_read_message (&exchange);
+  client_write_message (&exchange);
+  g_main_loop_run (exchange.loop);
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  read_io_counters (&after);
+  n_syscalls = (after.syscr - before.syscr) + (after.syscw - before.syscw);
+
+  g_test_maximized_result (exchange.n_messages / elapsed,
+                           "%u round-trips of %u bytes in %.3f s: %.0f round-trips/s, %.2f read/write syscalls/round-trip",
+                           exchange.n_messages, MESSAGE_SIZE, elapsed,
+                           exchange.n_messages / elapsed,
+                           (gdouble) n_syscalls / exchange.n_messages);
+
+  g_timer_destroy (timer);
+
+  g_io_stream_close (exchange.client.connection, NULL, NULL);
+  g_main_loop_run (exchange.loop);
+
+  g_main_loop_unref (exchange.loop);
+  g_object_unref (exchange.client.connection);
+  g_object_unref (exchange.server.connection);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/stream/performance/file-streaming", test_file_streaming);
+  g_test_add_func ("/stream/performance/socket-messages", test_socket_messages);
+
+  return g_test_run ();
+}
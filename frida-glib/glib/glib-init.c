@@ -363,6 +363,97 @@ g_debug_init (void)
 #endif
 }
 
+/*
+ * Bookkeeping that lives exactly as long as GLib stays initialised, such as
+ * the quark tables and the strings they intern, is carved out of a few large
+ * chunks instead of being allocated piecemeal. This keeps glib_init() down to
+ * a single allocation in the common case, and lets glib_deinit() release all
+ * of it with a handful of frees no matter how many strings were interned.
+ *
+ * The arena does no locking of its own; its users serialise on their own
+ * locks, or run during glib_init() and glib_deinit().
+ */
+
+#define G_INIT_ARENA_CHUNK_SIZE (64 * 1024)
+#define G_INIT_ARENA_ALIGN(n)   (((n) + 2 * sizeof (gsize) - 1) & ~(2 * sizeof (gsize) - 1))
+
+typedef struct _GInitArenaChunk GInitArenaChunk;
+
+struct _GInitArenaChunk
+{
+  GInitArenaChunk *next;
+  gsize            size;
+  gsize            offset;
+};
+
+static GInitArenaChunk *init_arena = NULL;
+
+static GInitArenaChunk *
+init_arena_chunk_new (gsize size)
+{
+  GInitArenaChunk *chunk;
+
+  chunk = glib_mem_table->malloc (size);
+  if (chunk == NULL)
+    g_error ("%s: failed to allocate %"G_GSIZE_FORMAT" bytes",
+             G_STRLOC, size);
+
+  chunk->size = size;
+  chunk->offset = G_INIT_ARENA_ALIGN (sizeof (GInitArenaChunk));
+
+  return chunk;
+}
+
+/*
+ * Returns @size bytes of uninitialised memory that remain valid until
+ * glib_deinit(). There is no way to free them individually.
+ */
+gpointer
+_glib_init_arena_alloc (gsize size)
+{
+  GInitArenaChunk *chunk = init_arena;
+  gsize header_size = G_INIT_ARENA_ALIGN (sizeof (GInitArenaChunk));
+  gpointer mem;
+
+  size = G_INIT_ARENA_ALIGN (size);
+
+  if (chunk == NULL || chunk->size - chunk->offset < size)
+    {
+      if (size > G_INIT_ARENA_CHUNK_SIZE / 4 && chunk != NULL)
+        {
+          /* Big enough to get a chunk of its own, keep filling the current one */
+          GInitArenaChunk *big = init_arena_chunk_new (header_size + size);
+
+          big->next = chunk->next;
+          chunk->next = big;
+          big->offset = big->size;
+
+          return (guint8 *) big + header_size;
+        }
+
+      chunk = init_arena_chunk_new (MAX (G_INIT_ARENA_CHUNK_SIZE, header_size + size));
+      chunk->next = init_arena;
+      init_arena = chunk;
+    }
+
+  mem = (guint8 *) chunk + chunk->offset;
+  chunk->offset += size;
+
+  return mem;
+}
+
+static void
+init_arena_free (void)
+{
+  while (init_arena != NULL)
+    {
+      GInitArenaChunk *next = init_arena->next;
+
+      glib_mem_table->free (init_arena);
+      init_arena = next;
+    }
+}
+
 static void
 glib_perform_init (void)
 {
@@ -448,6 +539,7 @@ glib_deinit (void)
 
   _g_main_deinit ();
   _g_strfuncs_deinit ();
+  _g_variant_type_info_deinit ();
 
   glib_initialized = FALSE;
 
@@ -460,12 +552,21 @@ glib_deinit (void)
 # endif
 #endif
 
+  _g_quark_deinit ();
   _g_thread_deinit ();
   _g_slice_deinit ();
   _g_messages_deinit ();
 #ifdef GLIB_STATIC_COMPILATION
   _proxy_libintl_deinit ();
 #endif
+
+  init_arena_free ();
+}
+
+gboolean
+_glib_is_initialized (void)
+{
+  return glib_initialized;
 }
 
 void
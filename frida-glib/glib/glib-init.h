@@ -30,6 +30,7 @@ extern GLogLevelFlags g_log_always_fatal;
 extern GLogLevelFlags g_log_msg_prefix;
 
 void g_quark_init (void);
+G_GNUC_INTERNAL void _g_quark_deinit (void);
 
 #ifdef G_OS_WIN32
 #include <windows.h>
@@ -50,13 +51,20 @@ gboolean g_win32_handle_is_socket (void *h);
 #endif
 
 G_GNUC_INTERNAL void _g_slice_deinit (void);
+G_GNUC_INTERNAL gboolean _g_slice_small_malloc_init (gsize max_block_size);
+G_GNUC_INTERNAL gpointer _g_slice_small_alloc (gsize mem_size);
+G_GNUC_INTERNAL void _g_slice_small_free (gsize mem_size, gpointer mem_block);
+G_GNUC_INTERNAL void _g_slice_small_malloc_thread_init (void);
 G_GNUC_INTERNAL void _g_thread_init (void);
 G_GNUC_INTERNAL void _g_thread_deinit (void);
 G_GNUC_INTERNAL void _g_thread_pool_shutdown (void);
 G_GNUC_INTERNAL void _g_strfuncs_deinit (void);
+G_GNUC_INTERNAL void _g_variant_type_info_deinit (void);
 G_GNUC_INTERNAL void _g_main_shutdown (void);
 G_GNUC_INTERNAL void _g_main_deinit (void);
 G_GNUC_INTERNAL void _g_messages_deinit (void);
+G_GNUC_INTERNAL gboolean _glib_is_initialized (void);
+G_GNUC_INTERNAL gpointer _glib_init_arena_alloc (gsize size);
 
 _GLIB_EXTERN void _glib_register_constructor (GXtorFunc constructor);
 _GLIB_EXTERN void _glib_register_destructor (GXtorFunc destructor);
@@ -23,6 +23,7 @@
 
 #include "glib-private.h"
 #include "glib-init.h"
+#include "gvariant-core.h"
 
 #ifdef USE_INVALID_PARAMETER_HANDLER
 #include <crtdbg.h>
@@ -68,6 +69,8 @@ glib__private__ (void)
 
     g_win32_push_empty_invalid_parameter_handler,
     g_win32_pop_invalid_parameter_handler,
+
+    g_variant_is_serialised,
   };
 
   return &table;
@@ -82,6 +85,8 @@ glib_enable_io_features (void)
 
 static GLibPrivateVTable glib_private_table = {
   .glib_init = glib_init,
+
+  .g_variant_is_serialised = g_variant_is_serialised,
 };
 
 GLibPrivateVTable *
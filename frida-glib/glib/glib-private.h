@@ -213,6 +213,9 @@ typedef struct {
 
   void (* g_win32_pop_invalid_parameter_handler)        (GWin32InvalidParameterHandler *items);
 
+  /* See gvariant-core.c */
+  gboolean              (* g_variant_is_serialised)     (GVariant *value);
+
   /* Add other private functions here, initialize them in glib-private.c */
 } GLibPrivateVTable;
 
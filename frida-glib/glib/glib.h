@@ -99,6 +99,7 @@
 #include <glib/gutils.h>
 #include <glib/guuid.h>
 #include <glib/gvariant.h>
+#include <glib/gvarianttable.h>
 #include <glib/gvarianttype.h>
 #include <glib/gversion.h>
 #include <glib/gversionmacros.h>
@@ -88,6 +88,10 @@
 #include <sys/event.h>
 #endif
 
+#ifdef HAVE_EPOLL_CREATE
+#include <sys/epoll.h>
+#endif
+
 #include "glib_trace.h"
 
 #include "gmain.h"
@@ -335,6 +339,14 @@ struct _GMainContext
 #ifdef HAVE_KQUEUE
   gint kq;
 #endif
+
+#ifdef HAVE_EPOLL_CREATE
+  gint epfd;                      /* -1 unless G_MAIN_CONTEXT_FLAGS_EPOLL */
+  guint n_epoll_unsupported;      /* poll records epoll refused, e.g. regular files */
+  GHashTable *epoll_records;      /* fd -> first GPollRec watching it */
+  GList *epoll_sources;           /* sources prepare() and check() must visit */
+  GArray *epoll_reported;         /* fds whose revents the last wait set */
+#endif
 };
 
 struct _GSourceCallback
@@ -395,8 +407,19 @@ struct _GPollRec
   GPollRec *prev;
   GPollRec *next;
   gint priority;
+#ifdef HAVE_EPOLL_CREATE
+  GSource *source;                /* owner, or NULL for g_main_context_add_poll() */
+  gushort epoll_events;           /* fd->events as last registered */
+  gboolean epoll_unsupported;
+#endif
 };
 
+#ifdef HAVE_EPOLL_CREATE
+#define EPOLL_CONDITIONS (G_IO_IN | G_IO_OUT | G_IO_PRI)
+#define EPOLL_EVENTS_UNREGISTERED G_MAXUINT16
+#define EPOLL_MAX_EVENTS 128
+#endif
+
 struct _GSourcePrivate
 {
   GSList *child_sources;
@@ -412,6 +435,10 @@ struct _GSourcePrivate
   GSourceDisposeFunc dispose;
 
   gboolean static_name;
+
+#ifdef HAVE_EPOLL_CREATE
+  GList *epoll_link;              /* in context->epoll_sources */
+#endif
 };
 
 typedef struct _GSourceIter
@@ -420,6 +447,10 @@ typedef struct _GSourceIter
   gboolean may_modify;
   GList *current_list;
   GSource *source;
+#ifdef HAVE_EPOLL_CREATE
+  GPtrArray *tracked;             /* see g_source_iter_init_tracked() */
+  guint tracked_index;
+#endif
 } GSourceIter;
 
 #define LOCK_CONTEXT(context) g_mutex_lock (&context->mutex)
@@ -443,6 +474,14 @@ static void g_source_set_priority_unlocked      (GSource      *source,
 static void g_child_source_remove_internal      (GSource      *child_source,
                                                  GMainContext *context);
 
+static gboolean g_main_context_prepare_internal (GMainContext *context,
+						 gint         *priority,
+						 gboolean      tracked_only);
+static gboolean g_main_context_check_internal   (GMainContext *context,
+						 gint          max_priority,
+						 GPollFD      *fds,
+						 gint          n_fds,
+						 gboolean      tracked_only);
 static void g_main_context_poll                 (GMainContext *context,
 						 gint          timeout,
 						 gint          priority,
@@ -450,9 +489,22 @@ static void g_main_context_poll                 (GMainContext *context,
 						 gint          n_fds);
 static void g_main_context_add_poll_unlocked    (GMainContext *context,
 						 gint          priority,
-						 GPollFD      *fd);
+						 GPollFD      *fd,
+						 GSource      *source);
 static void g_main_context_remove_poll_unlocked (GMainContext *context,
 						 GPollFD      *fd);
+#ifdef HAVE_EPOLL_CREATE
+static void g_main_context_epoll_update         (GMainContext *context,
+						 gint          fd,
+						 GPollRec     *rec);
+static void g_main_context_epoll_reset          (GMainContext *context);
+static void g_main_context_epoll_track_source   (GMainContext *context,
+						 GSource      *source);
+static void g_main_context_epoll_untrack_source (GMainContext *context,
+						 GSource      *source);
+static gboolean g_main_context_iterate_epoll    (GMainContext *context,
+						 gboolean      block);
+#endif
 
 static void     g_source_iter_init  (GSourceIter   *iter,
 				     GMainContext  *context,
@@ -612,6 +664,13 @@ _g_main_recover_from_fork_in_child (void)
       context->kq = -1;
 #endif
 
+#ifdef HAVE_EPOLL_CREATE
+      /* The epoll instance is shared with the parent, so leave it alone and
+       * register everything with a fresh one */
+      if (context->epfd != -1)
+        g_main_context_epoll_reset (context);
+#endif
+
       g_main_context_remove_poll_unlocked (context, &context->wake_up_rec);
 
 #ifdef HAVE_KQUEUE
@@ -622,7 +681,7 @@ _g_main_recover_from_fork_in_child (void)
       context->wakeup = g_wakeup_new ();
 
       g_wakeup_get_pollfd (context->wakeup, &context->wake_up_rec);
-      g_main_context_add_poll_unlocked (context, 0, &context->wake_up_rec);
+      g_main_context_add_poll_unlocked (context, 0, &context->wake_up_rec, NULL);
     }
 
   if (glib_worker_was_running)
@@ -738,6 +797,22 @@ g_main_context_unref (GMainContext *context)
   close (context->kq);
 #endif
 
+#ifdef HAVE_EPOLL_CREATE
+  if (context->epfd != -1)
+    close (context->epfd);
+  if (context->epoll_records != NULL)
+    {
+      GList *l;
+
+      /* The sources are still alive, see remaining_sources */
+      for (l = context->epoll_sources; l != NULL; l = l->next)
+        ((GSource *) l->data)->priv->epoll_link = NULL;
+      g_list_free (context->epoll_sources);
+      g_hash_table_destroy (context->epoll_records);
+      g_array_free (context->epoll_reported, TRUE);
+    }
+#endif
+
   g_wakeup_free (context->wakeup);
   g_cond_clear (&context->cond);
 
@@ -838,10 +913,20 @@ g_main_context_new_with_flags (GMainContextFlags flags)
 #ifdef HAVE_KQUEUE
   context->kq = kqueue ();
 #endif
+
+#ifdef HAVE_EPOLL_CREATE
+  context->epfd = -1;
+  if (flags & G_MAIN_CONTEXT_FLAGS_EPOLL)
+    {
+      context->epfd = epoll_create1 (EPOLL_CLOEXEC);
+      context->epoll_records = g_hash_table_new (NULL, NULL);
+      context->epoll_reported = g_array_new (FALSE, FALSE, sizeof (gint));
+    }
+#endif
   
   context->wakeup = g_wakeup_new ();
   g_wakeup_get_pollfd (context->wakeup, &context->wake_up_rec);
-  g_main_context_add_poll_unlocked (context, 0, &context->wake_up_rec);
+  g_main_context_add_poll_unlocked (context, 0, &context->wake_up_rec, NULL);
 
   G_LOCK (main_context_list);
   main_context_list = g_slist_append (main_context_list, context);
@@ -1160,14 +1245,94 @@ g_source_iter_init (GSourceIter  *iter,
   iter->current_list = NULL;
   iter->source = NULL;
   iter->may_modify = may_modify;
+#ifdef HAVE_EPOLL_CREATE
+  iter->tracked = NULL;
+  iter->tracked_index = 0;
+#endif
+}
+
+#ifdef HAVE_EPOLL_CREATE
+
+static GSource *
+source_get_root (GSource *source,
+                 guint   *depth)
+{
+  *depth = 0;
+  while (source->priv->parent_source != NULL)
+    {
+      source = source->priv->parent_source;
+      (*depth)++;
+    }
+
+  return source;
+}
+
+/* The order of the source lists: by priority, then in the order the
+ * sources were attached, with child sources right before their parents.
+ */
+static gint
+source_compare_list_order (gconstpointer a,
+                           gconstpointer b)
+{
+  GSource *source_a = *(GSource **) a;
+  GSource *source_b = *(GSource **) b;
+  GSource *root_a, *root_b;
+  guint depth_a, depth_b;
+
+  if (source_a->priority != source_b->priority)
+    return (source_a->priority < source_b->priority) ? -1 : 1;
+
+  root_a = source_get_root (source_a, &depth_a);
+  root_b = source_get_root (source_b, &depth_b);
+  if (root_a->source_id != root_b->source_id)
+    return (root_a->source_id < root_b->source_id) ? -1 : 1;
+  if (depth_a != depth_b)
+    return (depth_a > depth_b) ? -1 : 1;
+
+  return (source_a->source_id < source_b->source_id) ? -1 :
+         (source_a->source_id > source_b->source_id) ? 1 : 0;
 }
 
+/* Holds context's lock
+ *
+ * Like g_source_iter_init() with @may_modify set, but only visits the
+ * sources in context->epoll_sources, i.e. those that can become ready
+ * other than through an fd reported by epoll.
+ */
+static void
+g_source_iter_init_tracked (GSourceIter  *iter,
+                            GMainContext *context)
+{
+  GList *l;
+
+  g_source_iter_init (iter, context, TRUE);
+
+  iter->tracked = g_ptr_array_new ();
+  for (l = context->epoll_sources; l != NULL; l = l->next)
+    g_ptr_array_add (iter->tracked, g_source_ref (l->data));
+  g_ptr_array_sort (iter->tracked, source_compare_list_order);
+}
+
+#endif /* HAVE_EPOLL_CREATE */
+
 /* Holds context's lock */
 static gboolean
 g_source_iter_next (GSourceIter *iter, GSource **source)
 {
   GSource *next_source;
 
+#ifdef HAVE_EPOLL_CREATE
+  if (iter->tracked != NULL)
+    {
+      if (iter->tracked_index < iter->tracked->len)
+        *source = g_ptr_array_index (iter->tracked, iter->tracked_index++);
+      else
+        *source = NULL;
+
+      return *source != NULL;
+    }
+#endif
+
   if (iter->source)
     next_source = iter->source->next;
   else
@@ -1214,6 +1379,19 @@ g_source_iter_next (GSourceIter *iter, GSource **source)
 static void
 g_source_iter_clear (GSourceIter *iter)
 {
+#ifdef HAVE_EPOLL_CREATE
+  if (iter->tracked != NULL)
+    {
+      guint i;
+
+      for (i = 0; i < iter->tracked->len; i++)
+        g_source_unref_internal (g_ptr_array_index (iter->tracked, i), iter->context, TRUE);
+      g_ptr_array_free (iter->tracked, TRUE);
+      iter->tracked = NULL;
+      return;
+    }
+#endif
+
   if (iter->source && iter->may_modify)
     {
       g_source_unref_internal (iter->source, iter->context, TRUE);
@@ -1308,6 +1486,10 @@ source_add_to_context (GSource      *source,
     prev->next = source;
   else
     source_list->head = source;
+
+#ifdef HAVE_EPOLL_CREATE
+  g_main_context_epoll_track_source (context, source);
+#endif
 }
 
 /* Holds context's lock
@@ -1334,6 +1516,10 @@ source_remove_from_context (GSource      *source,
   source->prev = NULL;
   source->next = NULL;
 
+#ifdef HAVE_EPOLL_CREATE
+  g_main_context_epoll_untrack_source (context, source);
+#endif
+
   if (source_list->head == NULL)
     {
       context->source_lists = g_list_remove (context->source_lists, source_list);
@@ -1369,12 +1555,12 @@ g_source_attach_unlocked (GSource      *source,
       tmp_list = source->poll_fds;
       while (tmp_list)
         {
-          g_main_context_add_poll_unlocked (context, source->priority, tmp_list->data);
+          g_main_context_add_poll_unlocked (context, source->priority, tmp_list->data, source);
           tmp_list = tmp_list->next;
         }
 
       for (tmp_list = source->priv->fds; tmp_list; tmp_list = tmp_list->next)
-        g_main_context_add_poll_unlocked (context, source->priority, tmp_list->data);
+        g_main_context_add_poll_unlocked (context, source->priority, tmp_list->data, source);
     }
 
   tmp_list = source->priv->child_sources;
@@ -1635,7 +1821,7 @@ g_source_add_poll (GSource *source,
   if (context)
     {
       if (!SOURCE_BLOCKED (source))
-	g_main_context_add_poll_unlocked (context, source->priority, fd);
+	g_main_context_add_poll_unlocked (context, source->priority, fd, source);
       UNLOCK_CONTEXT (context);
     }
 }
@@ -1733,6 +1919,9 @@ g_source_add_child_source (GSource *source,
 
   if (context)
     {
+#ifdef HAVE_EPOLL_CREATE
+      g_main_context_epoll_track_source (context, source);
+#endif
       g_source_attach_unlocked (child_source, context, TRUE);
       UNLOCK_CONTEXT (context);
     }
@@ -1748,6 +1937,11 @@ g_child_source_remove_internal (GSource *child_source,
     g_slist_remove (parent_source->priv->child_sources, child_source);
   child_source->priv->parent_source = NULL;
 
+#ifdef HAVE_EPOLL_CREATE
+  if (context)
+    g_main_context_epoll_track_source (context, parent_source);
+#endif
+
   g_source_destroy_internal (child_source, context, TRUE);
   g_source_unref_internal (child_source, context, TRUE);
 }
@@ -1992,7 +2186,7 @@ g_source_set_priority_unlocked (GSource      *source,
 	  while (tmp_list)
 	    {
 	      g_main_context_remove_poll_unlocked (context, tmp_list->data);
-	      g_main_context_add_poll_unlocked (context, priority, tmp_list->data);
+	      g_main_context_add_poll_unlocked (context, priority, tmp_list->data, source);
 	      
 	      tmp_list = tmp_list->next;
 	    }
@@ -2000,7 +2194,7 @@ g_source_set_priority_unlocked (GSource      *source,
           for (tmp_list = source->priv->fds; tmp_list; tmp_list = tmp_list->next)
             {
               g_main_context_remove_poll_unlocked (context, tmp_list->data);
-              g_main_context_add_poll_unlocked (context, priority, tmp_list->data);
+              g_main_context_add_poll_unlocked (context, priority, tmp_list->data, source);
             }
 	}
     }
@@ -2125,6 +2319,10 @@ g_source_set_ready_time (GSource *source,
 
   if (context)
     {
+#ifdef HAVE_EPOLL_CREATE
+      g_main_context_epoll_track_source (context, source);
+#endif
+
       /* Quite likely that we need to change the timeout on the poll */
       if (!SOURCE_BLOCKED (source))
         g_wakeup_signal (context->wakeup);
@@ -2827,7 +3025,7 @@ g_source_add_unix_fd (GSource      *source,
   if (context)
     {
       if (!SOURCE_BLOCKED (source))
-        g_main_context_add_poll_unlocked (context, source->priority, poll_fd);
+        g_main_context_add_poll_unlocked (context, source->priority, poll_fd, source);
       UNLOCK_CONTEXT (context);
     }
 
@@ -2869,10 +3067,27 @@ g_source_modify_unix_fd (GSource      *source,
   context = source->context;
   poll_fd = tag;
 
+  if (context)
+    LOCK_CONTEXT (context);
+
   poll_fd->events = new_events;
 
+#ifdef HAVE_EPOLL_CREATE
+  if (context && context->epfd != -1 && !SOURCE_BLOCKED (source))
+    {
+      GPollRec *pollrec;
+
+      pollrec = g_hash_table_lookup (context->epoll_records, GINT_TO_POINTER (poll_fd->fd));
+      if (pollrec != NULL)
+        g_main_context_epoll_update (context, poll_fd->fd, pollrec);
+    }
+#endif
+
   if (context)
-    g_main_context_wakeup (context);
+    {
+      UNLOCK_CONTEXT (context);
+      g_main_context_wakeup (context);
+    }
 }
 
 /**
@@ -3479,12 +3694,12 @@ unblock_source (GSource *source)
   tmp_list = source->poll_fds;
   while (tmp_list)
     {
-      g_main_context_add_poll_unlocked (source->context, source->priority, tmp_list->data);
+      g_main_context_add_poll_unlocked (source->context, source->priority, tmp_list->data, source);
       tmp_list = tmp_list->next;
     }
 
   for (tmp_list = source->priv->fds; tmp_list; tmp_list = tmp_list->next)
-    g_main_context_add_poll_unlocked (source->context, source->priority, tmp_list->data);
+    g_main_context_add_poll_unlocked (source->context, source->priority, tmp_list->data, source);
 
   if (source->priv && source->priv->child_sources)
     {
@@ -3512,6 +3727,9 @@ g_main_dispatch (GMainContext *context)
       g_assert (source);
 
       source->flags &= ~G_SOURCE_READY;
+#ifdef HAVE_EPOLL_CREATE
+      g_main_context_epoll_track_source (context, source);
+#endif
 
       if (!SOURCE_DESTROYED (source))
 	{
@@ -3783,6 +4001,23 @@ g_main_context_wait (GMainContext *context,
   return g_main_context_wait_internal (context, cond, mutex);
 }
 
+/* HOLDS: context's lock */
+static void
+g_source_mark_ready (GMainContext *context,
+                     GSource      *source)
+{
+  GSource *ready_source = source;
+
+  while (ready_source)
+    {
+      ready_source->flags |= G_SOURCE_READY;
+#ifdef HAVE_EPOLL_CREATE
+      g_main_context_epoll_track_source (context, ready_source);
+#endif
+      ready_source = ready_source->priv->parent_source;
+    }
+}
+
 /**
  * g_main_context_prepare:
  * @context: a #GMainContext
@@ -3801,6 +4036,14 @@ g_main_context_wait (GMainContext *context,
 gboolean
 g_main_context_prepare (GMainContext *context,
 			gint         *priority)
+{
+  return g_main_context_prepare_internal (context, priority, FALSE);
+}
+
+static gboolean
+g_main_context_prepare_internal (GMainContext *context,
+                                 gint         *priority,
+                                 gboolean      tracked_only)
 {
   guint i;
   gint n_ready = 0;
@@ -3850,6 +4093,11 @@ g_main_context_prepare (GMainContext *context,
 
   context->timeout = -1;
   
+#ifdef HAVE_EPOLL_CREATE
+  if (tracked_only)
+    g_source_iter_init_tracked (&iter, context);
+  else
+#endif
   g_source_iter_init (&iter, context, TRUE);
   while (g_source_iter_next (&iter, &source))
     {
@@ -3921,15 +4169,7 @@ g_main_context_prepare (GMainContext *context,
             }
 
 	  if (result)
-	    {
-	      GSource *ready_source = source;
-
-	      while (ready_source)
-		{
-		  ready_source->flags |= G_SOURCE_READY;
-		  ready_source = ready_source->priv->parent_source;
-		}
-	    }
+	    g_source_mark_ready (context, source);
 	}
 
       if (source->flags & G_SOURCE_READY)
@@ -4088,6 +4328,16 @@ g_main_context_check (GMainContext *context,
 		      gint          max_priority,
 		      GPollFD      *fds,
 		      gint          n_fds)
+{
+  return g_main_context_check_internal (context, max_priority, fds, n_fds, FALSE);
+}
+
+static gboolean
+g_main_context_check_internal (GMainContext *context,
+                               gint          max_priority,
+                               GPollFD      *fds,
+                               gint          n_fds,
+                               gboolean      tracked_only)
 {
   GSource *source;
   GSourceIter iter;
@@ -4161,6 +4411,11 @@ g_main_context_check (GMainContext *context,
       i++;
     }
 
+#ifdef HAVE_EPOLL_CREATE
+  if (tracked_only)
+    g_source_iter_init_tracked (&iter, context);
+  else
+#endif
   g_source_iter_init (&iter, context, TRUE);
   while (g_source_iter_next (&iter, &source))
     {
@@ -4235,15 +4490,7 @@ g_main_context_check (GMainContext *context,
             }
 
 	  if (result)
-	    {
-	      GSource *ready_source = source;
-
-	      while (ready_source)
-		{
-		  ready_source->flags |= G_SOURCE_READY;
-		  ready_source = ready_source->priv->parent_source;
-		}
-	    }
+	    g_source_mark_ready (context, source);
 	}
 
       if (source->flags & G_SOURCE_READY)
@@ -4307,6 +4554,9 @@ g_main_context_iterate (GMainContext *context,
   gint nfds, allocated_nfds;
   GPollFD *fds = NULL;
   gint64 begin_time_nsec G_GNUC_UNUSED;
+#ifdef HAVE_EPOLL_CREATE
+  gboolean use_epoll;
+#endif
 
   UNLOCK_CONTEXT (context);
 
@@ -4339,27 +4589,41 @@ g_main_context_iterate (GMainContext *context,
 
   allocated_nfds = context->cached_poll_array_size;
   fds = context->cached_poll_array;
+
+#ifdef HAVE_EPOLL_CREATE
+  /* Regular files and custom poll functions need the whole GPollFD array */
+  use_epoll = context->epfd != -1 &&
+              context->n_epoll_unsupported == 0 &&
+              context->poll_func == g_poll;
+#endif
   
   UNLOCK_CONTEXT (context);
 
-  g_main_context_prepare (context, &max_priority); 
-  
-  while ((nfds = g_main_context_query (context, max_priority, &timeout, fds, 
-				       allocated_nfds)) > allocated_nfds)
+#ifdef HAVE_EPOLL_CREATE
+  if (use_epoll)
+    some_ready = g_main_context_iterate_epoll (context, block);
+  else
+#endif
     {
-      LOCK_CONTEXT (context);
-      g_free (fds);
-      context->cached_poll_array_size = allocated_nfds = nfds;
-      context->cached_poll_array = fds = g_new (GPollFD, nfds);
-      UNLOCK_CONTEXT (context);
-    }
+      g_main_context_prepare (context, &max_priority);
 
-  if (!block)
-    timeout = 0;
-  
-  g_main_context_poll (context, timeout, max_priority, fds, nfds);
-  
-  some_ready = g_main_context_check (context, max_priority, fds, nfds);
+      while ((nfds = g_main_context_query (context, max_priority, &timeout, fds,
+                                           allocated_nfds)) > allocated_nfds)
+        {
+          LOCK_CONTEXT (context);
+          g_free (fds);
+          context->cached_poll_array_size = allocated_nfds = nfds;
+          context->cached_poll_array = fds = g_new (GPollFD, nfds);
+          UNLOCK_CONTEXT (context);
+        }
+
+      if (!block)
+        timeout = 0;
+
+      g_main_context_poll (context, timeout, max_priority, fds, nfds);
+
+      some_ready = g_main_context_check (context, max_priority, fds, nfds);
+    }
   
   if (dispatch)
     g_main_context_dispatch (context);
@@ -4632,6 +4896,297 @@ g_main_loop_get_context (GMainLoop *loop)
   return loop->context;
 }
 
+#ifdef HAVE_EPOLL_CREATE
+
+static guint32
+epoll_events_from_condition (gushort events)
+{
+  guint32 result = 0;
+
+  if (events & G_IO_IN)
+    result |= EPOLLIN;
+  if (events & G_IO_OUT)
+    result |= EPOLLOUT;
+  if (events & G_IO_PRI)
+    result |= EPOLLPRI;
+
+  return result;
+}
+
+static gushort
+condition_from_epoll_events (guint32 events)
+{
+  gushort result = 0;
+
+  if (events & EPOLLIN)
+    result |= G_IO_IN;
+  if (events & EPOLLOUT)
+    result |= G_IO_OUT;
+  if (events & EPOLLPRI)
+    result |= G_IO_PRI;
+  if (events & EPOLLERR)
+    result |= G_IO_ERR;
+  if (events & EPOLLHUP)
+    result |= G_IO_HUP;
+
+  return result;
+}
+
+/* HOLDS: context's lock
+ *
+ * Brings the epoll registration of @fd in line with the poll records
+ * watching it. @rec is any of those records, or %NULL if there are none
+ * left. Records for the same fd are adjacent since the list is sorted.
+ */
+static void
+g_main_context_epoll_update (GMainContext *context,
+                             gint          fd,
+                             GPollRec     *rec)
+{
+  struct epoll_event ev = { 0, };
+  GPollRec *first, *cur;
+  gboolean registered = FALSE;
+  gushort events = 0;
+  int op, ret;
+
+  if (rec == NULL)
+    {
+      /* May fail harmlessly if the fd was closed before being removed */
+      epoll_ctl (context->epfd, EPOLL_CTL_DEL, fd, &ev);
+      g_hash_table_remove (context->epoll_records, GINT_TO_POINTER (fd));
+      return;
+    }
+
+  first = rec;
+  while (first->prev != NULL && first->prev->fd->fd == fd)
+    first = first->prev;
+  g_hash_table_insert (context->epoll_records, GINT_TO_POINTER (fd), first);
+
+  for (cur = first; cur != NULL && cur->fd->fd == fd; cur = cur->next)
+    {
+      if (cur->epoll_events != EPOLL_EVENTS_UNREGISTERED)
+        registered = TRUE;
+      events |= cur->fd->events & EPOLL_CONDITIONS;
+    }
+
+  ev.events = epoll_events_from_condition (events);
+  ev.data.fd = fd;
+
+  /* The fd may have been closed and reused behind our back */
+  op = registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  ret = epoll_ctl (context->epfd, op, fd, &ev);
+  if (ret != 0 && (errno == ENOENT || errno == EEXIST))
+    {
+      op = (op == EPOLL_CTL_ADD) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+      ret = epoll_ctl (context->epfd, op, fd, &ev);
+    }
+
+  /* epoll can't watch regular files and some devices, which poll(2)
+   * always reports as ready. Fall back to poll(2) while they're around. */
+  if (ret != 0 && errno == EPERM)
+    {
+      for (cur = first; cur != NULL && cur->fd->fd == fd; cur = cur->next)
+        {
+          if (!cur->epoll_unsupported)
+            {
+              cur->epoll_unsupported = TRUE;
+              context->n_epoll_unsupported++;
+            }
+        }
+    }
+
+  for (cur = first; cur != NULL && cur->fd->fd == fd; cur = cur->next)
+    cur->epoll_events = cur->fd->events & EPOLL_CONDITIONS;
+}
+
+/* HOLDS: context's lock */
+static void
+g_main_context_epoll_reset (GMainContext *context)
+{
+  GPollRec *pollrec;
+
+  close (context->epfd);
+  context->epfd = epoll_create1 (EPOLL_CLOEXEC);
+  if (context->epfd == -1)
+    return;
+
+  context->n_epoll_unsupported = 0;
+  g_hash_table_remove_all (context->epoll_records);
+  g_array_set_size (context->epoll_reported, 0);
+  for (pollrec = context->poll_records; pollrec; pollrec = pollrec->next)
+    {
+      pollrec->epoll_events = EPOLL_EVENTS_UNREGISTERED;
+      pollrec->epoll_unsupported = FALSE;
+    }
+
+  /* Once per fd, from the last record of each group */
+  for (pollrec = context->poll_records; pollrec; pollrec = pollrec->next)
+    {
+      if (pollrec->next == NULL || pollrec->next->fd->fd != pollrec->fd->fd)
+        g_main_context_epoll_update (context, pollrec->fd->fd, pollrec);
+    }
+}
+
+/* A source that can only become ready through its fds, so that
+ * g_main_context_iterate_epoll() need not visit it until epoll
+ * reports one of them.
+ */
+static gboolean
+source_is_passive (GSource *source)
+{
+  return source->source_funcs->prepare == NULL &&
+         source->source_funcs->check == NULL &&
+         source->priv->ready_time == -1 &&
+         source->priv->child_sources == NULL;
+}
+
+/* HOLDS: context's lock
+ *
+ * context->epoll_sources holds every attached source that is not
+ * passive, and the passive ones that are ready but not dispatched yet.
+ */
+static void
+g_main_context_epoll_track_source (GMainContext *context,
+                                   GSource      *source)
+{
+  gboolean track;
+
+  if (context->epoll_records == NULL)
+    return;
+
+  track = !source_is_passive (source) || (source->flags & G_SOURCE_READY) != 0;
+
+  if (track && source->priv->epoll_link == NULL)
+    {
+      context->epoll_sources = g_list_prepend (context->epoll_sources, source);
+      source->priv->epoll_link = context->epoll_sources;
+    }
+  else if (!track && source->priv->epoll_link != NULL)
+    g_main_context_epoll_untrack_source (context, source);
+}
+
+/* HOLDS: context's lock */
+static void
+g_main_context_epoll_untrack_source (GMainContext *context,
+                                     GSource      *source)
+{
+  if (source->priv->epoll_link == NULL)
+    return;
+
+  context->epoll_sources = g_list_delete_link (context->epoll_sources,
+                                               source->priv->epoll_link);
+  source->priv->epoll_link = NULL;
+}
+
+/* HOLDS: context's lock
+ *
+ * Passes what epoll_wait() reported on to the poll records, the way
+ * g_main_context_check() does for the results of poll(2), and flags
+ * passive sources with a ready fd as ready.
+ */
+static void
+g_main_context_epoll_apply (GMainContext       *context,
+                            gint                max_priority,
+                            struct epoll_event *events,
+                            gint                n_events)
+{
+  GPollRec *pollrec;
+  guint i;
+
+  /* Records the previous wait reported are now stale */
+  for (i = 0; i < context->epoll_reported->len; i++)
+    {
+      gint fd = g_array_index (context->epoll_reported, gint, i);
+
+      for (pollrec = g_hash_table_lookup (context->epoll_records, GINT_TO_POINTER (fd));
+           pollrec != NULL && pollrec->fd->fd == fd;
+           pollrec = pollrec->next)
+        pollrec->fd->revents = 0;
+    }
+  g_array_set_size (context->epoll_reported, 0);
+
+  for (i = 0; i < (guint) n_events; i++)
+    {
+      gint fd = events[i].data.fd;
+      gushort revents = condition_from_epoll_events (events[i].events);
+
+      if (fd == context->wake_up_rec.fd)
+        {
+          TRACE (GLIB_MAIN_CONTEXT_WAKEUP_ACKNOWLEDGE (context));
+          g_wakeup_acknowledge (context->wakeup);
+          continue;
+        }
+
+      /* As in g_main_context_check(), leave it to the next iteration,
+       * the fd is still ready then as epoll is level-triggered */
+      if (context->poll_changed)
+        continue;
+
+      for (pollrec = g_hash_table_lookup (context->epoll_records, GINT_TO_POINTER (fd));
+           pollrec != NULL && pollrec->fd->fd == fd;
+           pollrec = pollrec->next)
+        {
+          if (pollrec->priority > max_priority)
+            continue;
+
+          pollrec->fd->revents = revents & (pollrec->fd->events | G_IO_ERR | G_IO_HUP);
+
+          if (pollrec->fd->revents != 0 &&
+              pollrec->source != NULL &&
+              source_is_passive (pollrec->source))
+            g_source_mark_ready (context, pollrec->source);
+        }
+
+      g_array_append_val (context->epoll_reported, fd);
+    }
+}
+
+/* Does what g_main_context_prepare(), query(), poll() and check() do
+ * in g_main_context_iterate(), but without visiting every source or
+ * poll record: the fds are registered with epoll already, and only the
+ * sources in context->epoll_sources and those epoll reports ready are
+ * looked at. Returns whether some source is ready to be dispatched.
+ */
+static gboolean
+g_main_context_iterate_epoll (GMainContext *context,
+                              gboolean      block)
+{
+  struct epoll_event events[EPOLL_MAX_EVENTS];
+  gint max_priority = 0;
+  gint timeout, epfd;
+  gint n_events, errsv;
+
+  g_main_context_prepare_internal (context, &max_priority, TRUE);
+
+  LOCK_CONTEXT (context);
+  context->poll_changed = FALSE;
+  timeout = context->timeout;
+  if (timeout != 0)
+    context->time_is_fresh = FALSE;
+  epfd = context->epfd;
+  UNLOCK_CONTEXT (context);
+
+  if (!block)
+    timeout = 0;
+
+  n_events = epoll_wait (epfd, events, G_N_ELEMENTS (events), timeout);
+  errsv = errno;
+  if (n_events < 0)
+    {
+      if (errsv != EINTR)
+        g_warning ("epoll_wait(2) failed due to: %s.", g_strerror (errsv));
+      n_events = 0;
+    }
+
+  LOCK_CONTEXT (context);
+  g_main_context_epoll_apply (context, max_priority, events, n_events);
+  UNLOCK_CONTEXT (context);
+
+  return g_main_context_check_internal (context, max_priority, NULL, 0, TRUE);
+}
+
+#endif /* HAVE_EPOLL_CREATE */
+
 /* HOLDS: context's lock */
 static void
 g_main_context_poll (GMainContext *context,
@@ -4858,7 +5413,7 @@ g_main_context_add_poll (GMainContext *context,
   g_return_if_fail (fd);
 
   LOCK_CONTEXT (context);
-  g_main_context_add_poll_unlocked (context, priority, fd);
+  g_main_context_add_poll_unlocked (context, priority, fd, NULL);
   UNLOCK_CONTEXT (context);
 }
 
@@ -4866,7 +5421,8 @@ g_main_context_add_poll (GMainContext *context,
 static void 
 g_main_context_add_poll_unlocked (GMainContext *context,
 				  gint          priority,
-				  GPollFD      *fd)
+				  GPollFD      *fd,
+				  GSource      *source)
 {
   GPollRec *prevrec, *nextrec;
   GPollRec *newrec = g_slice_new (GPollRec);
@@ -4902,6 +5458,14 @@ g_main_context_add_poll_unlocked (GMainContext *context,
 
   context->poll_changed = TRUE;
 
+#ifdef HAVE_EPOLL_CREATE
+  newrec->source = source;
+  newrec->epoll_events = EPOLL_EVENTS_UNREGISTERED;
+  newrec->epoll_unsupported = FALSE;
+  if (context->epfd != -1)
+    g_main_context_epoll_update (context, fd->fd, newrec);
+#endif
+
 #ifdef HAVE_KQUEUE
   {
     struct kevent events[3], *ev;
@@ -4991,6 +5555,22 @@ g_main_context_remove_poll_unlocked (GMainContext *context,
 	  if (nextrec != NULL)
 	    nextrec->prev = prevrec;
 
+#ifdef HAVE_EPOLL_CREATE
+	  if (pollrec->epoll_unsupported)
+	    context->n_epoll_unsupported--;
+	  if (context->epfd != -1)
+	    {
+	      GPollRec *sibling = NULL;
+
+	      if (prevrec != NULL && prevrec->fd->fd == fd->fd)
+		sibling = prevrec;
+	      else if (nextrec != NULL && nextrec->fd->fd == fd->fd)
+		sibling = nextrec;
+
+	      g_main_context_epoll_update (context, fd->fd, sibling);
+	    }
+#endif
+
 	  g_slice_free (GPollRec, pollrec);
 
 	  context->n_poll_records--;
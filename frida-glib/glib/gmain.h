@@ -47,6 +47,16 @@ typedef enum /*< flags >*/
  * free the thread to process other jobs. That's useful if you're using
  * `g_main_context_{prepare,query,check,dispatch}` to integrate GMainContext in
  * other event loops.
+ * @G_MAIN_CONTEXT_FLAGS_EPOLL: On Linux, wait for events using epoll(7)
+ * instead of poll(2). File descriptors are registered with the kernel as they
+ * are added to the context rather than passed in again on every iteration,
+ * and sources without prepare or check functions or a ready time are only
+ * looked at once one of their file descriptors is reported ready. This makes
+ * an iteration of a context watching many mostly idle file descriptors cost
+ * the same as one watching a few. Changes to the events of a file descriptor
+ * must go through g_source_modify_unix_fd(). Ignored on other platforms, and
+ * while a custom #GPollFunc is set.
+ * Since: 2.76
  *
  * Flags to pass to g_main_context_new_with_flags() which affect the behaviour
  * of a #GMainContext.
@@ -57,7 +67,8 @@ GLIB_AVAILABLE_TYPE_IN_2_72
 typedef enum /*< flags >*/
 {
   G_MAIN_CONTEXT_FLAGS_NONE = 0,
-  G_MAIN_CONTEXT_FLAGS_OWNERLESS_POLLING = 1
+  G_MAIN_CONTEXT_FLAGS_OWNERLESS_POLLING = 1,
+  G_MAIN_CONTEXT_FLAGS_EPOLL GLIB_AVAILABLE_ENUMERATOR_IN_2_76 = 2
 } GMainContextFlags;
 
 
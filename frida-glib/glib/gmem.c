@@ -56,6 +56,7 @@
 #include <signal.h>
 
 #include "gslice.h"
+#include "glib-init.h"
 #include "gbacktrace.h"
 #include "gtestutils.h"
 #include "gthread.h"
@@ -100,6 +101,99 @@ static GMemVTable glib_mem_vtable = {
 };
 GMemVTable *glib_mem_table = &glib_mem_vtable;
 
+/* --- sized blocks --- */
+/* With G_SLICE=small-malloc and a custom vtable, every block starts with a
+ * header holding its size. Small blocks come from the GSlice magazines, the
+ * rest from the vtable, and g_free() tells them apart by that size. The
+ * header is two words so the returned memory keeps malloc()'s alignment,
+ * and is always included in the size handed to GSlice.
+ */
+#define SIZED_HEADER_SIZE       (2 * sizeof (gsize))
+#define SMALL_BLOCK_MAX_SIZE    (256)
+#define SIZED_IS_SMALL(n_bytes) ((n_bytes) <= SMALL_BLOCK_MAX_SIZE - SIZED_HEADER_SIZE)
+
+static gboolean sized_blocks = FALSE;
+
+static gpointer
+sized_malloc (gsize    n_bytes,
+              gboolean zero,
+              gboolean try)
+{
+  gsize *header;
+
+  if (SIZED_IS_SMALL (n_bytes))
+    {
+      header = _g_slice_small_alloc (SIZED_HEADER_SIZE + n_bytes);
+      if (zero)
+        memset ((guint8 *) header + SIZED_HEADER_SIZE, 0, n_bytes);
+    }
+  else if (n_bytes <= G_MAXSIZE - SIZED_HEADER_SIZE)
+    {
+      if (zero)
+        header = glib_mem_vtable.calloc (1, SIZED_HEADER_SIZE + n_bytes);
+      else if (try)
+        header = glib_mem_vtable.try_malloc (SIZED_HEADER_SIZE + n_bytes);
+      else
+        header = glib_mem_vtable.malloc (SIZED_HEADER_SIZE + n_bytes);
+      if (!header)
+        return NULL;
+    }
+  else
+    return NULL;
+
+  header[0] = n_bytes;
+
+  return (guint8 *) header + SIZED_HEADER_SIZE;
+}
+
+static void
+sized_free (gpointer mem)
+{
+  gsize *header = (gsize *) ((guint8 *) mem - SIZED_HEADER_SIZE);
+
+  if (SIZED_IS_SMALL (header[0]))
+    _g_slice_small_free (SIZED_HEADER_SIZE + header[0], header);
+  else
+    glib_mem_vtable.free (header);
+}
+
+static gpointer
+sized_realloc (gpointer mem,
+               gsize    n_bytes,
+               gboolean try)
+{
+  gsize *header;
+  gpointer newmem;
+
+  if (!mem)
+    return sized_malloc (n_bytes, FALSE, try);
+
+  header = (gsize *) ((guint8 *) mem - SIZED_HEADER_SIZE);
+
+  if (!SIZED_IS_SMALL (header[0]) && !SIZED_IS_SMALL (n_bytes))
+    {
+      if (n_bytes > G_MAXSIZE - SIZED_HEADER_SIZE)
+        return NULL;
+      if (try)
+        header = glib_mem_vtable.try_realloc (header, SIZED_HEADER_SIZE + n_bytes);
+      else
+        header = glib_mem_vtable.realloc (header, SIZED_HEADER_SIZE + n_bytes);
+      if (!header)
+        return NULL;
+      header[0] = n_bytes;
+      return (guint8 *) header + SIZED_HEADER_SIZE;
+    }
+
+  /* moving between GSlice and the vtable */
+  newmem = sized_malloc (n_bytes, FALSE, try);
+  if (!newmem)
+    return NULL;
+  memcpy (newmem, mem, MIN (header[0], n_bytes));
+  sized_free (mem);
+
+  return newmem;
+}
+
 /**
  * SECTION:memory
  * @Short_Description: general memory-handling
@@ -147,7 +241,10 @@ g_malloc (gsize n_bytes)
     {
       gpointer mem;
 
-      mem = glib_mem_vtable.malloc (n_bytes);
+      if (sized_blocks)
+        mem = sized_malloc (n_bytes, FALSE, FALSE);
+      else
+        mem = glib_mem_vtable.malloc (n_bytes);
       TRACE (GLIB_MEM_ALLOC((void*) mem, (unsigned int) n_bytes, 0, 0));
       if (mem)
 	return mem;
@@ -180,7 +277,10 @@ g_malloc0 (gsize n_bytes)
     {
       gpointer mem;
 
-      mem = glib_mem_vtable.calloc (1, n_bytes);
+      if (sized_blocks)
+        mem = sized_malloc (n_bytes, TRUE, FALSE);
+      else
+        mem = glib_mem_vtable.calloc (1, n_bytes);
       TRACE (GLIB_MEM_ALLOC((void*) mem, (unsigned int) n_bytes, 1, 0));
       if (mem)
 	return mem;
@@ -218,7 +318,10 @@ g_realloc (gpointer mem,
 
   if (G_LIKELY (n_bytes))
     {
-      newmem = glib_mem_vtable.realloc (mem, n_bytes);
+      if (sized_blocks)
+        newmem = sized_realloc (mem, n_bytes, FALSE);
+      else
+        newmem = glib_mem_vtable.realloc (mem, n_bytes);
       TRACE (GLIB_MEM_REALLOC((void*) newmem, (void*)mem, (unsigned int) n_bytes, 0));
       if (newmem)
 	return newmem;
@@ -228,7 +331,12 @@ g_realloc (gpointer mem,
     }
 
   if (mem)
-    glib_mem_vtable.free (mem);
+    {
+      if (sized_blocks)
+        sized_free (mem);
+      else
+        glib_mem_vtable.free (mem);
+    }
 
   TRACE (GLIB_MEM_REALLOC((void*) NULL, (void*)mem, 0, 0));
 
@@ -248,7 +356,12 @@ void
 g_free (gpointer mem)
 {
   if (G_LIKELY (mem))
-    glib_mem_vtable.free (mem);
+    {
+      if (sized_blocks)
+        sized_free (mem);
+      else
+        glib_mem_vtable.free (mem);
+    }
   TRACE(GLIB_MEM_FREE((void*) mem));
 }
 
@@ -305,7 +418,7 @@ g_try_malloc (gsize n_bytes)
   gpointer mem;
 
   if (G_LIKELY (n_bytes))
-    mem = glib_mem_vtable.try_malloc (n_bytes);
+    mem = sized_blocks ? sized_malloc (n_bytes, FALSE, TRUE) : glib_mem_vtable.try_malloc (n_bytes);
   else
     mem = NULL;
 
@@ -330,7 +443,7 @@ g_try_malloc0 (gsize n_bytes)
   gpointer mem;
 
   if (G_LIKELY (n_bytes))
-    mem = glib_mem_vtable.try_malloc (n_bytes);
+    mem = sized_blocks ? sized_malloc (n_bytes, FALSE, TRUE) : glib_mem_vtable.try_malloc (n_bytes);
   else
     mem = NULL;
 
@@ -360,11 +473,13 @@ g_try_realloc (gpointer mem,
   gpointer newmem;
 
   if (G_LIKELY (n_bytes))
-    newmem = glib_mem_vtable.try_realloc (mem, n_bytes);
+    newmem = sized_blocks ? sized_realloc (mem, n_bytes, TRUE) : glib_mem_vtable.try_realloc (mem, n_bytes);
   else
     {
       newmem = NULL;
-      if (mem)
+      if (mem && sized_blocks)
+	sized_free (mem);
+      else if (mem)
 	glib_mem_vtable.free (mem);
     }
 
@@ -573,6 +688,12 @@ g_mem_is_system_malloc (void)
  *
  * Note that this function must be called before using any other GLib
  * functions.
+ *
+ * If the [`G_SLICE`][G_SLICE] environment variable contains `small-malloc`
+ * and @vtable is installed before glib_init(), small blocks are served from
+ * the slice allocator's per-thread caches and only larger blocks reach
+ * @vtable. Memory returned by g_malloc() must then only be released with
+ * g_free(), never with @vtable's free().
  */
 void
 g_mem_set_vtable (GMemVTable *vtable)
@@ -589,6 +710,10 @@ g_mem_set_vtable (GMemVTable *vtable)
 	  glib_mem_vtable.try_malloc = vtable->try_malloc ? vtable->try_malloc : glib_mem_vtable.malloc;
 	  glib_mem_vtable.try_realloc = vtable->try_realloc ? vtable->try_realloc : glib_mem_vtable.realloc;
 	  vtable_set = TRUE;
+
+	  /* blocks allocated before this point have no size header */
+	  if (!_glib_is_initialized ())
+	    sized_blocks = _g_slice_small_malloc_init (SMALL_BLOCK_MAX_SIZE);
 	}
       else
 	g_warning (G_STRLOC ": memory allocation vtable lacks one of malloc(), realloc() or free()");
@@ -350,6 +350,13 @@ g_vasprintf (gchar      **string,
         else
           *string = NULL;
       }
+    else if (!g_mem_is_system_malloc ())
+      {
+        /* vasprintf() allocated with malloc(), the caller will use g_free() */
+        gchar *string1 = g_memdup2 (*string, len + 1);
+        free (*string);
+        *string = string1;
+      }
   }
 
 #else
@@ -22,14 +22,56 @@
 #include "gptrset.h"
 #include "gmem.h"
 
+#include <string.h>
+
+/*
+ * The items live in a dense array so that iteration is a plain loop, and a
+ * pointer → index map makes add, remove and lookup O(1). The map is an
+ * open-addressing table in the style of SwissTable: next to the entries we
+ * keep one control byte per slot, holding either EMPTY, DELETED, or the low
+ * seven bits of the key's hash. Lookups compare a whole group of control
+ * bytes against the hash byte at once, using SSE2 or NEON where available and
+ * a 64-bit word otherwise, so that usually only one entry is ever touched.
+ *
+ * The control bytes of the first group are mirrored past the end of the
+ * array, which lets a group be loaded at any slot without wrapping.
+ */
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define G_PTR_INDEX_MAP_USE_SSE2 1
+# define G_PTR_INDEX_MAP_GROUP_WIDTH 16
+# define G_PTR_INDEX_MAP_GROUP_SHIFT 0
+#elif (defined (__aarch64__) && defined (__ARM_NEON)) || defined (_M_ARM64)
+# include <arm_neon.h>
+# define G_PTR_INDEX_MAP_USE_NEON 1
+# define G_PTR_INDEX_MAP_GROUP_WIDTH 16
+# define G_PTR_INDEX_MAP_GROUP_SHIFT 2
+#else
+# define G_PTR_INDEX_MAP_GROUP_WIDTH 8
+# define G_PTR_INDEX_MAP_GROUP_SHIFT 3
+#endif
+
 #define G_PTR_SET_INITIAL_CAPACITY 16
-#define G_PTR_INDEX_MAP_TOMBSTONE  ((gpointer) -1)
+
+#define G_PTR_INDEX_MAP_EMPTY   0x80
+#define G_PTR_INDEX_MAP_DELETED 0xfe
+
+#define G_PTR_INDEX_MAP_NOT_FOUND G_MAXSIZE
 
 typedef struct _GPtrIndexMapEntry GPtrIndexMapEntry;
 
+/*
+ * A bit mask with one bit set for each matching slot of a group. Depending on
+ * the implementation each slot occupies 1 << G_PTR_INDEX_MAP_GROUP_SHIFT
+ * bits of it.
+ */
+typedef guint64 GPtrIndexMapMask;
+
 struct _GPtrIndexMap
 {
   GPtrIndexMapEntry *entries;
+  guint8            *ctrl;
   gsize              capacity;
   gsize              size;
   gsize              tombstones;
@@ -41,27 +83,34 @@ struct _GPtrIndexMapEntry
   gsize    val;
 };
 
-static void g_ptr_set_grow (GPtrSet *pset);
+static void g_ptr_set_reserve (GPtrSet *pset,
+                               gsize    n);
 
 static GPtrIndexMap *g_ptr_index_map_new (void);
 static void g_ptr_index_map_free (GPtrIndexMap   *map);
-static void g_ptr_index_map_insert (GPtrIndexMap *map,
-                                    gpointer      key,
-                                    gsize         val);
-static gboolean g_ptr_index_map_lookup (GPtrIndexMap  *map,
-                                        gconstpointer  key,
-                                        gsize         *out_val);
-static void g_ptr_index_map_update (GPtrIndexMap *map,
-                                    gpointer      key,
-                                    gsize         new_val);
-static void g_ptr_index_map_remove (GPtrIndexMap  *map,
-                                    gconstpointer  key);
-static gsize g_ptr_index_map_probe (GPtrIndexMap  *map,
-                                    gconstpointer  key,
-                                    gboolean      *found);
+static void g_ptr_index_map_clear (GPtrIndexMap *map);
+static gboolean g_ptr_index_map_insert (GPtrIndexMap *map,
+                                        gpointer      key,
+                                        gsize         val);
+static gsize g_ptr_index_map_find (GPtrIndexMap  *map,
+                                   gconstpointer  key);
+static gsize g_ptr_index_map_find_with_hash (GPtrIndexMap  *map,
+                                             gconstpointer  key,
+                                             gsize          hashv);
+static void g_ptr_index_map_erase (GPtrIndexMap *map,
+                                   gsize         slot);
+static gsize g_ptr_index_map_find_free_slot (GPtrIndexMap *map,
+                                             gsize         hashv);
+static void g_ptr_index_map_set_ctrl (GPtrIndexMap *map,
+                                      gsize         slot,
+                                      guint8        ctrl);
+static void g_ptr_index_map_reserve (GPtrIndexMap *map,
+                                     gsize         n);
 static void g_ptr_index_map_rehash (GPtrIndexMap *map,
                                     gsize         new_capacity);
-static gsize g_ptr_index_map_adjust_capacity (gsize desired);
+static void g_ptr_index_map_alloc (GPtrIndexMap *map,
+                                   gsize         capacity);
+static gsize g_ptr_index_map_capacity_for (gsize n);
 static gsize g_ptr_index_map_ptr_hash (gconstpointer ptr);
 
 GPtrSet *
@@ -94,44 +143,125 @@ g_ptr_set_add (GPtrSet  *pset,
                gpointer  ptr)
 {
   if (pset->size == pset->capacity)
-    g_ptr_set_grow (pset);
+    g_ptr_set_reserve (pset, pset->size + 1);
+
+  if (g_ptr_index_map_insert (pset->index_map, ptr, pset->size))
+    pset->items[pset->size++] = ptr;
+}
+
+void
+g_ptr_set_add_many (GPtrSet         *pset,
+                    gpointer const  *ptrs,
+                    gsize            n_ptrs)
+{
+  gsize i;
+
+  g_ptr_set_reserve (pset, pset->size + n_ptrs);
+  g_ptr_index_map_reserve (pset->index_map, pset->size + n_ptrs);
 
-  pset->items[pset->size] = ptr;
-  g_ptr_index_map_insert (pset->index_map, ptr, pset->size);
-  pset->size++;
+  for (i = 0; i != n_ptrs; i++)
+    {
+      if (g_ptr_index_map_insert (pset->index_map, ptrs[i], pset->size))
+        pset->items[pset->size++] = ptrs[i];
+    }
 }
 
 void
 g_ptr_set_remove (GPtrSet  *pset,
                   gpointer  ptr)
 {
-  gsize idx, last_idx;
+  GPtrIndexMap *map = pset->index_map;
+  gsize slot, idx, last_idx;
 
   if (pset->size == 0)
     return;
 
-  if (!g_ptr_index_map_lookup (pset->index_map, ptr, &idx))
+  slot = g_ptr_index_map_find (map, ptr);
+  if (slot == G_PTR_INDEX_MAP_NOT_FOUND)
     return;
 
+  idx = map->entries[slot].val;
+  g_ptr_index_map_erase (map, slot);
+
   last_idx = pset->size - 1;
   if (idx != last_idx)
     {
       gpointer last_ptr = pset->items[last_idx];
       pset->items[idx] = last_ptr;
 
-      g_ptr_index_map_update (pset->index_map, last_ptr, idx);
+      map->entries[g_ptr_index_map_find (map, last_ptr)].val = idx;
     }
 
-  g_ptr_index_map_remove (pset->index_map, ptr);
-
   pset->size--;
 }
 
+gboolean
+g_ptr_set_contains (GPtrSet       *pset,
+                    gconstpointer  ptr)
+{
+  return g_ptr_index_map_find (pset->index_map, ptr) != G_PTR_INDEX_MAP_NOT_FOUND;
+}
+
+/*
+ * Empties the set and hands its items over to the caller, who must release
+ * the returned array with glib_mem_table->free().
+ */
+gpointer *
+g_ptr_set_steal_all (GPtrSet *pset,
+                     gsize   *n_items)
+{
+  gpointer *items = pset->items;
+
+  if (n_items != NULL)
+    *n_items = pset->size;
+
+  pset->size = 0;
+  pset->capacity = G_PTR_SET_INITIAL_CAPACITY;
+  pset->items = glib_mem_table->calloc (pset->capacity, sizeof (gpointer));
+  g_ptr_index_map_clear (pset->index_map);
+
+  return items;
+}
+
+/*
+ * Drops the tombstones left behind by removals and shrinks the storage to
+ * what the current items need, e.g. once a burst of threads has come and
+ * gone.
+ */
+void
+g_ptr_set_compact (GPtrSet *pset)
+{
+  GPtrIndexMap *map = pset->index_map;
+  gsize capacity;
+
+  capacity = G_PTR_SET_INITIAL_CAPACITY;
+  while (capacity < pset->size)
+    capacity <<= 1;
+  if (capacity < pset->capacity)
+    {
+      pset->capacity = capacity;
+      pset->items = glib_mem_table->realloc (pset->items, capacity * sizeof (gpointer));
+    }
+
+  capacity = g_ptr_index_map_capacity_for (map->size);
+  if (map->tombstones != 0 || capacity < map->capacity)
+    g_ptr_index_map_rehash (map, capacity);
+}
+
 static void
-g_ptr_set_grow (GPtrSet *pset)
+g_ptr_set_reserve (GPtrSet *pset,
+                   gsize    n)
 {
-  pset->capacity *= 2;
-  pset->items = glib_mem_table->realloc (pset->items, pset->capacity * sizeof (gpointer));
+  gsize capacity = pset->capacity;
+
+  while (capacity < n)
+    capacity *= 2;
+
+  if (capacity != pset->capacity)
+    {
+      pset->capacity = capacity;
+      pset->items = glib_mem_table->realloc (pset->items, capacity * sizeof (gpointer));
+    }
 }
 
 void
@@ -145,17 +275,163 @@ g_ptr_set_foreach (GPtrSet  *pset,
     func (pset->items[i], user_data);
 }
 
+static inline guint
+g_ptr_index_map_mask_first (GPtrIndexMapMask mask)
+{
+#if G_GNUC_CHECK_VERSION (3, 4) || defined (__clang__)
+  return __builtin_ctzll (mask) >> G_PTR_INDEX_MAP_GROUP_SHIFT;
+#else
+  guint bit = 0;
+
+  while ((mask & 1) == 0)
+    {
+      mask >>= 1;
+      bit++;
+    }
+
+  return bit >> G_PTR_INDEX_MAP_GROUP_SHIFT;
+#endif
+}
+
+static inline guint
+g_ptr_index_map_mask_last (GPtrIndexMapMask mask)
+{
+#if G_GNUC_CHECK_VERSION (3, 4) || defined (__clang__)
+  return (63 - __builtin_clzll (mask)) >> G_PTR_INDEX_MAP_GROUP_SHIFT;
+#else
+  guint bit = 63;
+
+  while ((mask & G_GUINT64_CONSTANT (0x8000000000000000)) == 0)
+    {
+      mask <<= 1;
+      bit--;
+    }
+
+  return bit >> G_PTR_INDEX_MAP_GROUP_SHIFT;
+#endif
+}
+
+#if defined (G_PTR_INDEX_MAP_USE_SSE2)
+
+typedef __m128i GPtrIndexMapGroup;
+
+static inline GPtrIndexMapGroup
+g_ptr_index_map_group_load (const guint8 *ctrl)
+{
+  return _mm_loadu_si128 ((const __m128i *) ctrl);
+}
+
+static inline GPtrIndexMapMask
+g_ptr_index_map_group_match (GPtrIndexMapGroup group,
+                             guint8            h2)
+{
+  return (guint16) _mm_movemask_epi8 (_mm_cmpeq_epi8 (group, _mm_set1_epi8 ((gchar) h2)));
+}
+
+static inline GPtrIndexMapMask
+g_ptr_index_map_group_match_empty (GPtrIndexMapGroup group)
+{
+  return g_ptr_index_map_group_match (group, G_PTR_INDEX_MAP_EMPTY);
+}
+
+static inline GPtrIndexMapMask
+g_ptr_index_map_group_match_free (GPtrIndexMapGroup group)
+{
+  return (guint16) _mm_movemask_epi8 (group);
+}
+
+#elif defined (G_PTR_INDEX_MAP_USE_NEON)
+
+typedef uint8x16_t GPtrIndexMapGroup;
+
+static inline GPtrIndexMapGroup
+g_ptr_index_map_group_load (const guint8 *ctrl)
+{
+  return vld1q_u8 (ctrl);
+}
+
+/* Narrows a byte-wise comparison result to one nibble per slot, keeping only
+ * the top bit of each so that clearing the lowest set bit steps to the next
+ * slot.
+ */
+static inline GPtrIndexMapMask
+g_ptr_index_map_group_to_mask (uint8x16_t cmp)
+{
+  uint8x8_t nibbles = vshrn_n_u16 (vreinterpretq_u16_u8 (cmp), 4);
+
+  return vget_lane_u64 (vreinterpret_u64_u8 (nibbles), 0) &
+      G_GUINT64_CONSTANT (0x8888888888888888);
+}
+
+static inline GPtrIndexMapMask
+g_ptr_index_map_group_match (GPtrIndexMapGroup group,
+                             guint8            h2)
+{
+  return g_ptr_index_map_group_to_mask (vceqq_u8 (group, vdupq_n_u8 (h2)));
+}
+
+static inline GPtrIndexMapMask
+g_ptr_index_map_group_match_empty (GPtrIndexMapGroup group)
+{
+  return g_ptr_index_map_group_match (group, G_PTR_INDEX_MAP_EMPTY);
+}
+
+static inline GPtrIndexMapMask
+g_ptr_index_map_group_match_free (GPtrIndexMapGroup group)
+{
+  return g_ptr_index_map_group_to_mask (vtstq_u8 (group, vdupq_n_u8 (0x80)));
+}
+
+#else
+
+typedef guint64 GPtrIndexMapGroup;
+
+#define G_PTR_INDEX_MAP_LSBS G_GUINT64_CONSTANT (0x0101010101010101)
+#define G_PTR_INDEX_MAP_MSBS G_GUINT64_CONSTANT (0x8080808080808080)
+
+static inline GPtrIndexMapGroup
+g_ptr_index_map_group_load (const guint8 *ctrl)
+{
+  guint64 group;
+
+  memcpy (&group, ctrl, sizeof (group));
+
+  return GUINT64_FROM_LE (group);
+}
+
+static inline GPtrIndexMapMask
+g_ptr_index_map_group_match (GPtrIndexMapGroup group,
+                             guint8            h2)
+{
+  guint64 x = group ^ (G_PTR_INDEX_MAP_LSBS * h2);
+  guint64 low7 = ~G_PTR_INDEX_MAP_MSBS;
+
+  /* Exact zero-byte test, which unlike the cheaper borrow-based one never
+   * reports a byte following a match */
+  return ~(((x & low7) + low7) | x | low7);
+}
+
+static inline GPtrIndexMapMask
+g_ptr_index_map_group_match_empty (GPtrIndexMapGroup group)
+{
+  return group & ~(group << 6) & G_PTR_INDEX_MAP_MSBS;
+}
+
+static inline GPtrIndexMapMask
+g_ptr_index_map_group_match_free (GPtrIndexMapGroup group)
+{
+  return group & G_PTR_INDEX_MAP_MSBS;
+}
+
+#endif
+
 static GPtrIndexMap *
 g_ptr_index_map_new (void)
 {
   GPtrIndexMap *map;
 
   map = glib_mem_table->malloc (sizeof (GPtrIndexMap));
-  map->capacity   = G_PTR_SET_INITIAL_CAPACITY;
-  map->entries    = glib_mem_table->calloc (map->capacity,
-                                            sizeof (GPtrIndexMapEntry));
-  map->size       = 0;
-  map->tombstones = 0;
+  g_ptr_index_map_alloc (map, G_PTR_SET_INITIAL_CAPACITY);
 
   return map;
 }
@@ -168,165 +444,227 @@ g_ptr_index_map_free (GPtrIndexMap *map)
 }
 
 static void
+g_ptr_index_map_clear (GPtrIndexMap *map)
+{
+  glib_mem_table->free (map->entries);
+  g_ptr_index_map_alloc (map, G_PTR_SET_INITIAL_CAPACITY);
+}
+
+static gboolean
 g_ptr_index_map_insert (GPtrIndexMap *map,
                         gpointer      key,
                         gsize         val)
 {
-  gsize idx;
-  gboolean found;
+  gsize hashv, slot;
+
+  hashv = g_ptr_index_map_ptr_hash (key);
+  if (g_ptr_index_map_find_with_hash (map, key, hashv) != G_PTR_INDEX_MAP_NOT_FOUND)
+    return FALSE;
 
-  if ((map->size + map->tombstones) * 10 >= map->capacity * 7)
+  slot = g_ptr_index_map_find_free_slot (map, hashv);
+
+  if (map->ctrl[slot] == G_PTR_INDEX_MAP_DELETED)
     {
-      gsize new_cap = g_ptr_index_map_adjust_capacity (map->capacity * 2);
-      g_ptr_index_map_rehash (map, new_cap);
+      map->tombstones--;
     }
-
-  idx = g_ptr_index_map_probe (map, key, &found);
-  if (found)
+  else if ((map->size + map->tombstones + 1) * 8 > map->capacity * 7)
     {
-      map->entries[idx].val = val;
-      return;
+      /* Mostly tombstones: reclaim them without growing */
+      if (map->size * 16 < map->capacity * 7)
+        g_ptr_index_map_rehash (map, map->capacity);
+      else
+        g_ptr_index_map_rehash (map, map->capacity * 2);
+      slot = g_ptr_index_map_find_free_slot (map, hashv);
     }
 
-  if (map->entries[idx].key == G_PTR_INDEX_MAP_TOMBSTONE)
-    map->tombstones--;
-
-  map->entries[idx].key = key;
-  map->entries[idx].val = val;
+  g_ptr_index_map_set_ctrl (map, slot, hashv & 0x7f);
+  map->entries[slot].key = key;
+  map->entries[slot].val = val;
   map->size++;
+
+  return TRUE;
 }
 
-static gboolean
-g_ptr_index_map_lookup (GPtrIndexMap  *map,
-                        gconstpointer  key,
-                        gsize         *out_val)
+static gsize
+g_ptr_index_map_find (GPtrIndexMap  *map,
+                      gconstpointer  key)
 {
-  gsize idx;
-  gboolean found;
+  return g_ptr_index_map_find_with_hash (map, key, g_ptr_index_map_ptr_hash (key));
+}
 
-  if (map->capacity == 0)
-    return FALSE;
+static gsize
+g_ptr_index_map_find_with_hash (GPtrIndexMap  *map,
+                                gconstpointer  key,
+                                gsize          hashv)
+{
+  gsize mask, pos, stride;
+  guint8 h2;
 
-  idx = g_ptr_index_map_probe (map, key, &found);
-  if (!found)
-    return FALSE;
+  mask = map->capacity - 1;
+  h2 = hashv & 0x7f;
+  pos = (hashv >> 7) & mask;
+  stride = 0;
 
-  if (out_val != NULL)
-    *out_val = map->entries[idx].val;
+  while (TRUE)
+    {
+      GPtrIndexMapGroup group = g_ptr_index_map_group_load (map->ctrl + pos);
+      GPtrIndexMapMask match;
 
-  return TRUE;
-}
+      for (match = g_ptr_index_map_group_match (group, h2);
+           match != 0;
+           match &= match - 1)
+        {
+          gsize slot = (pos + g_ptr_index_map_mask_first (match)) & mask;
 
-static void
-g_ptr_index_map_update (GPtrIndexMap *map,
-                        gpointer      key,
-                        gsize         new_val)
-{
-  gsize idx;
-  gboolean found;
+          if (map->entries[slot].key == key)
+            return slot;
+        }
 
-  idx = g_ptr_index_map_probe (map, key, &found);
+      if (g_ptr_index_map_group_match_empty (group) != 0)
+        return G_PTR_INDEX_MAP_NOT_FOUND;
 
-  if (found)
-    map->entries[idx].val = new_val;
+      stride += G_PTR_INDEX_MAP_GROUP_WIDTH;
+      pos = (pos + stride) & mask;
+    }
 }
 
 static void
-g_ptr_index_map_remove (GPtrIndexMap  *map,
-                        gconstpointer  key)
+g_ptr_index_map_erase (GPtrIndexMap *map,
+                       gsize         slot)
 {
-  gsize idx;
-  gboolean found;
-
-  if (map->size == 0)
-    return;
+  gsize mask = map->capacity - 1;
+  GPtrIndexMapMask empty_before, empty_after;
+  guint n_full;
+
+  /*
+   * If every group-sized window covering this slot still has an empty slot,
+   * no probe sequence ever continued past it and we can skip the tombstone.
+   */
+  empty_before = g_ptr_index_map_group_match_empty (
+      g_ptr_index_map_group_load (map->ctrl + ((slot - G_PTR_INDEX_MAP_GROUP_WIDTH) & mask)));
+  empty_after = g_ptr_index_map_group_match_empty (
+      g_ptr_index_map_group_load (map->ctrl + slot));
+
+  if (empty_before != 0 && empty_after != 0)
+    {
+      n_full = g_ptr_index_map_mask_first (empty_after) +
+          (G_PTR_INDEX_MAP_GROUP_WIDTH - 1 - g_ptr_index_map_mask_last (empty_before));
+    }
+  else
+    {
+      n_full = G_PTR_INDEX_MAP_GROUP_WIDTH;
+    }
 
-  idx = g_ptr_index_map_probe (map, key, &found);
-  if (!found)
-    return;
+  if (n_full < G_PTR_INDEX_MAP_GROUP_WIDTH)
+    {
+      g_ptr_index_map_set_ctrl (map, slot, G_PTR_INDEX_MAP_EMPTY);
+    }
+  else
+    {
+      g_ptr_index_map_set_ctrl (map, slot, G_PTR_INDEX_MAP_DELETED);
+      map->tombstones++;
+    }
 
-  map->entries[idx].key = G_PTR_INDEX_MAP_TOMBSTONE;
   map->size--;
-  map->tombstones++;
 }
 
 static gsize
-g_ptr_index_map_probe (GPtrIndexMap  *map,
-                       gconstpointer  key,
-                       gboolean      *found)
+g_ptr_index_map_find_free_slot (GPtrIndexMap *map,
+                                gsize         hashv)
 {
-  gsize mask, hashv, idx;
-  gssize first_tombstone;
-
-  *found = FALSE;
+  gsize mask, pos, stride;
 
   mask = map->capacity - 1;
-  hashv = g_ptr_index_map_ptr_hash (key);
-  idx = hashv & mask;
-  first_tombstone = -1;
+  pos = (hashv >> 7) & mask;
+  stride = 0;
 
   while (TRUE)
     {
-      gpointer slot_key = map->entries[idx].key;
+      GPtrIndexMapMask free_slots = g_ptr_index_map_group_match_free (
+          g_ptr_index_map_group_load (map->ctrl + pos));
 
-      if (slot_key == NULL)
-        {
-          if (first_tombstone != -1)
-            return (gsize) first_tombstone;
-          return idx;
-        }
-      else if (slot_key == G_PTR_INDEX_MAP_TOMBSTONE)
-        {
-          if (first_tombstone == -1)
-            first_tombstone = idx;
-        }
-      else if (slot_key == key)
-        {
-          *found = TRUE;
-          return idx;
-        }
+      if (free_slots != 0)
+        return (pos + g_ptr_index_map_mask_first (free_slots)) & mask;
 
-      idx = (idx + 1) & mask;
+      stride += G_PTR_INDEX_MAP_GROUP_WIDTH;
+      pos = (pos + stride) & mask;
     }
 }
 
+static void
+g_ptr_index_map_set_ctrl (GPtrIndexMap *map,
+                          gsize         slot,
+                          guint8        ctrl)
+{
+  map->ctrl[slot] = ctrl;
+  if (slot < G_PTR_INDEX_MAP_GROUP_WIDTH)
+    map->ctrl[map->capacity + slot] = ctrl;
+}
+
+static void
+g_ptr_index_map_reserve (GPtrIndexMap *map,
+                         gsize         n)
+{
+  gsize capacity = g_ptr_index_map_capacity_for (n);
+
+  if (capacity > map->capacity)
+    g_ptr_index_map_rehash (map, capacity);
+}
+
 static void
 g_ptr_index_map_rehash (GPtrIndexMap *map,
                         gsize         new_capacity)
 {
   GPtrIndexMapEntry *old_entries = map->entries;
+  guint8            *old_ctrl = map->ctrl;
   gsize              old_capacity = map->capacity;
-  GPtrIndexMapEntry *new_entries;
   gsize i;
 
-  new_entries = glib_mem_table->calloc (new_capacity,
-                                        sizeof (GPtrIndexMapEntry));
-
-  map->entries    = new_entries;
-  map->capacity   = new_capacity;
-  map->size       = 0;
-  map->tombstones = 0;
+  g_ptr_index_map_alloc (map, new_capacity);
 
   for (i = 0; i != old_capacity; i++)
     {
-      gpointer old_key = old_entries[i].key;
-      if (old_key != NULL && old_key != G_PTR_INDEX_MAP_TOMBSTONE)
-        g_ptr_index_map_insert (map, old_key, old_entries[i].val);
+      GPtrIndexMapEntry *entry;
+      gsize slot;
+
+      if ((old_ctrl[i] & 0x80) != 0)
+        continue;
+
+      entry = &old_entries[i];
+      slot = g_ptr_index_map_find_free_slot (map, g_ptr_index_map_ptr_hash (entry->key));
+      g_ptr_index_map_set_ctrl (map, slot, old_ctrl[i]);
+      map->entries[slot] = *entry;
+      map->size++;
     }
 
   glib_mem_table->free (old_entries);
 }
 
-static gsize
-g_ptr_index_map_adjust_capacity (gsize desired)
+/*
+ * Entries and control bytes share one allocation, the control bytes
+ * followed by a mirror of the first group.
+ */
+static void
+g_ptr_index_map_alloc (GPtrIndexMap *map,
+                       gsize         capacity)
 {
-  gsize cap;
+  gsize n_ctrl = capacity + G_PTR_INDEX_MAP_GROUP_WIDTH;
 
-  if (desired < 8)
-    return 8;
+  map->entries = glib_mem_table->malloc (capacity * sizeof (GPtrIndexMapEntry) + n_ctrl);
+  map->ctrl = (guint8 *) (map->entries + capacity);
+  memset (map->ctrl, G_PTR_INDEX_MAP_EMPTY, n_ctrl);
+  map->capacity = capacity;
+  map->size = 0;
+  map->tombstones = 0;
+}
+
+/* Smallest capacity holding n keys within the 7/8 load factor */
+static gsize
+g_ptr_index_map_capacity_for (gsize n)
+{
+  gsize cap = G_PTR_SET_INITIAL_CAPACITY;
 
-  cap = 8;
-  while (cap < desired)
+  while (n * 8 > cap * 7)
     cap <<= 1;
 
   return cap;
@@ -36,19 +36,31 @@ struct _GPtrSet
 };
 
 G_GNUC_INTERNAL
-GPtrSet *   g_ptr_set_new      (void);
+GPtrSet *   g_ptr_set_new       (void);
 G_GNUC_INTERNAL
-void        g_ptr_set_free     (GPtrSet  *pset);
+void        g_ptr_set_free      (GPtrSet         *pset);
 G_GNUC_INTERNAL
-void        g_ptr_set_add      (GPtrSet  *pset,
-                                gpointer  ptr);
+void        g_ptr_set_add       (GPtrSet         *pset,
+                                 gpointer         ptr);
 G_GNUC_INTERNAL
-void        g_ptr_set_remove   (GPtrSet  *pset,
-                                gpointer  ptr);
+void        g_ptr_set_add_many  (GPtrSet         *pset,
+                                 gpointer const  *ptrs,
+                                 gsize            n_ptrs);
 G_GNUC_INTERNAL
-void        g_ptr_set_foreach  (GPtrSet  *pset,
-                                GFunc     func,
-                                gpointer  user_data);
+void        g_ptr_set_remove    (GPtrSet         *pset,
+                                 gpointer         ptr);
+G_GNUC_INTERNAL
+gboolean    g_ptr_set_contains  (GPtrSet         *pset,
+                                 gconstpointer    ptr);
+G_GNUC_INTERNAL
+gpointer *  g_ptr_set_steal_all (GPtrSet         *pset,
+                                 gsize           *n_items);
+G_GNUC_INTERNAL
+void        g_ptr_set_compact   (GPtrSet         *pset);
+G_GNUC_INTERNAL
+void        g_ptr_set_foreach   (GPtrSet         *pset,
+                                 GFunc            func,
+                                 gpointer         user_data);
 
 G_END_DECLS
 
@@ -46,25 +46,69 @@
 
 #define QUARK_BLOCK_SIZE         2048
 #define QUARK_STRING_BLOCK_SIZE (4096 - sizeof (gsize))
+#define QUARK_TABLE_INITIAL_SIZE 1024
+
+/* The string to quark mapping is an open-addressing hash table with linear
+ * probing, so that lookups can run without quark_global. Slots are only ever
+ * filled, never cleared, and a slot's hash is written before its quark is
+ * published. Growing the table builds a new one and publishes it whole; the
+ * old one stays valid for readers still probing it until glib_deinit()
+ * releases the init arena, like the old quarks arrays.
+ */
+typedef struct {
+  guint  hash;
+  GQuark quark; /* (atomic), 0 if the slot is empty */
+} QuarkSlot;
+
+typedef struct {
+  guint     mask;
+  QuarkSlot slots[1]; /* flexible array */
+} QuarkTable;
 
-static inline GQuark  quark_new (gchar *string);
+static inline GQuark  quark_new (gchar *string,
+                                 guint  hash);
 
 G_LOCK_DEFINE_STATIC (quark_global);
-static GHashTable    *quark_ht = NULL;
+static QuarkTable    *quark_table = NULL; /* (atomic) */
 static gchar        **quarks = NULL;
 static gint           quark_seq_id = 0;
 static gchar         *quark_block = NULL;
 static gint           quark_block_offset = 0;
 
+static QuarkTable *
+quark_table_new (guint size)
+{
+  gsize table_size = G_STRUCT_OFFSET (QuarkTable, slots) + sizeof (QuarkSlot) * size;
+  QuarkTable *table;
+
+  table = _glib_init_arena_alloc (table_size);
+  memset (table, 0, table_size);
+  table->mask = size - 1;
+
+  return table;
+}
+
 void
 g_quark_init (void)
 {
   g_assert (quark_seq_id == 0);
-  quarks = g_new (gchar*, QUARK_BLOCK_SIZE);
+  quarks = _glib_init_arena_alloc (sizeof (gchar *) * QUARK_BLOCK_SIZE);
   quarks[0] = NULL;
+  quark_table = quark_table_new (QUARK_TABLE_INITIAL_SIZE);
   quark_seq_id = 1;
 }
 
+void
+_g_quark_deinit (void)
+{
+  /* The table, arrays and string blocks live in the init arena */
+  quark_table = NULL;
+  quarks = NULL;
+  quark_seq_id = 0;
+  quark_block = NULL;
+  quark_block_offset = 0;
+}
+
 /**
  * SECTION:quarks
  * @title: Quarks
@@ -117,6 +161,35 @@ g_quark_init (void)
  * Since: 2.34
  */
 
+/* Safe to call without quark_global. A quark being added concurrently may
+ * or may not be found, as if the lookup happened before or after it. */
+static GQuark
+quark_lookup (const gchar *string,
+              guint        hash)
+{
+  QuarkTable *table;
+  guint i;
+
+  table = g_atomic_pointer_get (&quark_table);
+  if (table == NULL)
+    return 0;
+
+  for (i = hash & table->mask; ; i = (i + 1) & table->mask)
+    {
+      QuarkSlot *slot = &table->slots[i];
+      GQuark quark;
+
+      quark = (GQuark) g_atomic_int_get ((gint *) &slot->quark);
+      if (quark == 0)
+        return 0;
+
+      /* The quarks array is loaded after the slot, so it covers the quark */
+      if (slot->hash == hash &&
+          strcmp (((gchar **) g_atomic_pointer_get (&quarks))[quark], string) == 0)
+        return quark;
+    }
+}
+
 /**
  * g_quark_try_string:
  * @string: (nullable): a string
@@ -136,17 +209,10 @@ g_quark_init (void)
 GQuark
 g_quark_try_string (const gchar *string)
 {
-  GQuark quark = 0;
-
   if (string == NULL)
     return 0;
 
-  G_LOCK (quark_global);
-  if (quark_ht != NULL)
-    quark = GPOINTER_TO_UINT (g_hash_table_lookup (quark_ht, string));
-  G_UNLOCK (quark_global);
-
-  return quark;
+  return quark_lookup (string, g_str_hash (string));
 }
 
 /* HOLDS: quark_global_lock */
@@ -159,14 +225,14 @@ quark_strdup (const gchar *string)
   len = strlen (string) + 1;
 
   /* For strings longer than half the block size, fall back
-     to strdup so that we fill our blocks at least 50%. */
+     to a separate allocation so that we fill our blocks at least 50%. */
   if (len > QUARK_STRING_BLOCK_SIZE / 2)
-    return g_strdup (string);
+    return memcpy (_glib_init_arena_alloc (len), string, len);
 
   if (quark_block == NULL ||
       QUARK_STRING_BLOCK_SIZE - quark_block_offset < len)
     {
-      quark_block = g_malloc (QUARK_STRING_BLOCK_SIZE);
+      quark_block = _glib_init_arena_alloc (QUARK_STRING_BLOCK_SIZE);
       quark_block_offset = 0;
     }
 
@@ -180,16 +246,16 @@ quark_strdup (const gchar *string)
 /* HOLDS: quark_global_lock */
 static inline GQuark
 quark_from_string (const gchar *string,
+                   guint        hash,
                    gboolean     duplicate)
 {
-  GQuark quark = 0;
+  GQuark quark;
 
-  if (quark_ht != NULL)
-    quark = GPOINTER_TO_UINT (g_hash_table_lookup (quark_ht, string));
+  quark = quark_lookup (string, hash);
 
   if (!quark)
     {
-      quark = quark_new (duplicate ? quark_strdup (string) : (gchar *)string);
+      quark = quark_new (duplicate ? quark_strdup (string) : (gchar *)string, hash);
       TRACE(GLIB_QUARK_NEW(string, quark));
     }
 
@@ -200,13 +266,19 @@ static inline GQuark
 quark_from_string_locked (const gchar   *string,
                           gboolean       duplicate)
 {
-  GQuark quark = 0;
+  GQuark quark;
+  guint hash;
 
   if (!string)
     return 0;
 
+  hash = g_str_hash (string);
+  quark = quark_lookup (string, hash);
+  if (quark)
+    return quark;
+
   G_LOCK (quark_global);
-  quark = quark_from_string (string, duplicate);
+  quark = quark_from_string (string, hash, duplicate);
   G_UNLOCK (quark_global);
 
   return quark;
@@ -285,32 +357,67 @@ g_quark_to_string (GQuark quark)
   return result;
 }
 
-/* HOLDS: g_quark_global_lock */
+/* HOLDS: quark_global_lock */
+static void
+quark_table_insert (QuarkTable *table,
+                    guint       hash,
+                    GQuark      quark)
+{
+  guint i;
+
+  for (i = hash & table->mask; table->slots[i].quark != 0; i = (i + 1) & table->mask)
+    ;
+
+  table->slots[i].hash = hash;
+  g_atomic_int_set ((gint *) &table->slots[i].quark, (gint) quark);
+}
+
+/* HOLDS: quark_global_lock */
+static void
+quark_table_grow (void)
+{
+  QuarkTable *old_table = quark_table;
+  QuarkTable *new_table;
+  guint i;
+
+  new_table = quark_table_new ((old_table->mask + 1) * 2);
+  for (i = 0; i <= old_table->mask; i++)
+    if (old_table->slots[i].quark != 0)
+      quark_table_insert (new_table, old_table->slots[i].hash, old_table->slots[i].quark);
+
+  g_atomic_pointer_set (&quark_table, new_table);
+}
+
+/* HOLDS: quark_global_lock */
 static inline GQuark
-quark_new (gchar *string)
+quark_new (gchar *string,
+           guint  hash)
 {
   GQuark quark;
   gchar **quarks_new;
 
   if (quark_seq_id % QUARK_BLOCK_SIZE == 0)
     {
-      quarks_new = g_new (gchar*, quark_seq_id + QUARK_BLOCK_SIZE);
+      quarks_new = _glib_init_arena_alloc (sizeof (gchar *) * (quark_seq_id + QUARK_BLOCK_SIZE));
       if (quark_seq_id != 0)
         memcpy (quarks_new, quarks, sizeof (char *) * quark_seq_id);
       memset (quarks_new + quark_seq_id, 0, sizeof (char *) * QUARK_BLOCK_SIZE);
-      /* This leaks the old quarks array. Its unfortunate, but it allows
-       * us to do lockless lookup of the arrays, and there shouldn't be that
-       * many quarks in an app
+      /* The old quarks array stays around until glib_deinit() releases the
+       * init arena. Its unfortunate, but it allows us to do lockless lookup
+       * of the arrays, and there shouldn't be that many quarks in an app
        */
       g_atomic_pointer_set (&quarks, quarks_new);
     }
 
+  /* Keep the table at most half full, so probe sequences stay short */
+  if ((guint) quark_seq_id * 2 > quark_table->mask)
+    quark_table_grow ();
+
+  /* Make the quark valid for g_quark_to_string() before it can be found */
   quark = quark_seq_id;
   g_atomic_pointer_set (&quarks[quark], string);
-  if (quark_ht == NULL)
-    quark_ht = g_hash_table_new (g_str_hash, g_str_equal);
-  g_hash_table_insert (quark_ht, string, GUINT_TO_POINTER (quark));
   g_atomic_int_inc (&quark_seq_id);
+  quark_table_insert (quark_table, hash, quark);
 
   return quark;
 }
@@ -321,12 +428,18 @@ quark_intern_string_locked (const gchar   *string,
 {
   const gchar *result;
   GQuark quark;
+  guint hash;
 
   if (!string)
     return NULL;
 
+  hash = g_str_hash (string);
+  quark = quark_lookup (string, hash);
+  if (quark)
+    return ((gchar **) g_atomic_pointer_get (&quarks))[quark];
+
   G_LOCK (quark_global);
-  quark = quark_from_string (string, duplicate);
+  quark = quark_from_string (string, hash, duplicate);
   result = quarks[quark];
   G_UNLOCK (quark_global);
 
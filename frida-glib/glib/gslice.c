@@ -27,6 +27,9 @@
 #ifdef G_OS_UNIX
 #include <unistd.h>             /* sysconf() */
 #endif
+#ifdef HAVE_SCHED_GETCPU
+#include <sched.h>              /* sched_getcpu() */
+#endif
 #ifdef G_OS_WIN32
 #include <windows.h>
 #include <process.h>
@@ -163,6 +166,9 @@
  *   with the same chunk size are kept in a partially sorted ring to allow O(1)
  *   freeing and allocation of chunks (as long as the allocation of an entirely
  *   new slab can be avoided).
+ *   slabs are kept in per-CPU slab caches, each with its own lock and rings.
+ *   new chunks come from the cache of the CPU the caller runs on, freed chunks
+ *   go back to the cache that owns their slab, see [5].
  * - the page allocator. on most modern systems, posix_memalign(3) or
  *   memalign(3) should be available, so this is used to allocate blocks with
  *   system page size based alignments and sizes or multiples thereof.
@@ -187,6 +193,10 @@
  *     16KB.
  * [4] allocating ca. 8 chunks per block/page keeps a good balance between
  *     external and internal fragmentation (<= 12.5%). [Bonwick94]
+ * [5] a chunk may be freed on another CPU than the one it was allocated on, so
+ *     each slab records the index of its cache. the index is immutable while
+ *     the slab has allocated chunks, which is what allows reading it before
+ *     taking the owning cache's lock.
  */
 
 #ifndef G_NO_SLICE
@@ -205,6 +215,9 @@
 #define SLAB_INDEX(al, asize)   ((asize) / P2ALIGNMENT - 1)                     /* asize must be P2ALIGNMENT aligned */
 #define SLAB_CHUNK_SIZE(al, ix) (((ix) + 1) * P2ALIGNMENT)
 #define SLAB_BPAGE_SIZE(al,csz) (8 * (csz) + SLAB_INFO_SIZE)
+#define MAX_SLAB_CACHES         (64)
+#define SLAB_CACHE_STRIDE       ALIGN (sizeof (SlabCache), 64)                 /* keep caches on separate cache lines */
+#define SLAB_CACHE(al, i)       ((SlabCache*) ((guint8*) (al)->slab_caches + (i) * SLAB_CACHE_STRIDE))
 
 /* optimized version of ALIGN (size, P2ALIGNMENT) */
 #if     GLIB_SIZEOF_SIZE_T * 2 == 8  /* P2ALIGNMENT */
@@ -230,6 +243,7 @@ struct _ChunkLink {
 struct _SlabInfo {
   ChunkLink *chunks;
   guint n_allocated;
+  guint cache_index;                    /* owning SlabCache, see [5] */
   SlabInfo *next, *prev;
 };
 typedef struct {
@@ -246,7 +260,13 @@ typedef struct {
   gboolean debug_blocks;
   gsize    working_set_msecs;
   guint    color_increment;
+  gboolean small_malloc;
 } SliceConfig;
+typedef struct {
+  GMutex        mutex;
+  SlabInfo    **slab_stack;               /* array of MAX_SLAB_INDEX (allocator) */
+  guint         color_accu;
+} SlabCache;
 typedef struct {
   /* const after initialization */
   gsize         min_page_size, max_page_size;
@@ -260,17 +280,20 @@ typedef struct {
   guint         stamp_counter;
   guint         last_stamp;
   /* slab allocator */
-  GMutex        slab_mutex;
-  SlabInfo    **slab_stack;                /* array of MAX_SLAB_INDEX (allocator) */
-  guint        color_accu;
+  SlabCache    *slab_caches;              /* n_slab_caches, SLAB_CACHE_STRIDE apart */
+  guint         n_slab_caches;
 } Allocator;
 
 /* --- g-slice prototypes --- */
-static gpointer     slab_allocator_alloc_chunk       (gsize      chunk_size);
+static gpointer     slab_allocator_alloc_chunk       (SlabCache *cache,
+                                                      gsize      chunk_size);
 static void         slab_allocator_free_chunk        (gsize      chunk_size,
-                                                      gpointer   mem);
+                                                      gpointer   mem,
+                                                      SlabCache **locked);
 static void         private_thread_memory_cleanup    (gpointer   data);
 static void         allocator_cleanup                (void);
+static gsize        allocator_aligned_page_size      (Allocator *allocator,
+                                                      gsize      n_bytes);
 static gpointer     allocator_memalign               (gsize      alignment,
                                                       gsize      memsize);
 static void         allocator_memfree                (gsize      memsize,
@@ -296,7 +319,10 @@ static SliceConfig slice_config = {
   FALSE,        /* debug_blocks */
   15 * 1000,    /* working_set_msecs */
   1,            /* color increment, alt: 0x7fffffff */
+  FALSE,        /* small_malloc */
 };
+static GMutex      init_mutex;
+static gboolean    small_malloc_enabled = FALSE;
 static GMutex      smc_tree_mutex; /* mutex for G_SLICE=debug-blocks */
 
 /* --- auxiliary functions --- */
@@ -421,6 +447,7 @@ slice_config_init (SliceConfig *config)
       const GDebugKey keys[] = {
         { "always-malloc", 1 << 0 },
         { "debug-blocks",  1 << 1 },
+        { "small-malloc",  1 << 2 },
       };
 
       flags = g_parse_debug_string (val, keys, G_N_ELEMENTS (keys));
@@ -428,6 +455,8 @@ slice_config_init (SliceConfig *config)
         config->always_malloc = TRUE;
       if (flags & (1 << 1))
         config->debug_blocks = TRUE;
+      if (flags & (1 << 2))
+        config->small_malloc = TRUE;
     }
   else
     {
@@ -485,23 +514,36 @@ g_slice_init_nomessage (void)
       /* we can only align to system page size */
       allocator->max_page_size = sys_page_size;
     }
+  /* the allocator's own bookkeeping bypasses g_malloc(), which may route
+   * small blocks back into GSlice, see _g_slice_small_alloc()
+   */
   if (allocator->config.always_malloc)
     {
       allocator->contention_counters = NULL;
       allocator->magazines = NULL;
-      allocator->slab_stack = NULL;
+      allocator->slab_caches = NULL;
+      allocator->n_slab_caches = 0;
     }
   else
     {
-      allocator->contention_counters = g_new0 (guint, MAX_SLAB_INDEX (allocator));
-      allocator->magazines = g_new0 (ChunkLink*, MAX_SLAB_INDEX (allocator));
-      allocator->slab_stack = g_new0 (SlabInfo*, MAX_SLAB_INDEX (allocator));
+      guint i;
+
+      allocator->contention_counters = glib_mem_table->calloc (MAX_SLAB_INDEX (allocator), sizeof (guint));
+      allocator->magazines = glib_mem_table->calloc (MAX_SLAB_INDEX (allocator), sizeof (ChunkLink*));
+      allocator->n_slab_caches = CLAMP (g_get_num_processors (), 1, MAX_SLAB_CACHES);
+      allocator->slab_caches = glib_mem_table->calloc (allocator->n_slab_caches, SLAB_CACHE_STRIDE);
+      mem_assert (allocator->contention_counters && allocator->magazines && allocator->slab_caches);
+      for (i = 0; i < allocator->n_slab_caches; i++)
+        {
+          SlabCache *cache = SLAB_CACHE (allocator, i);
+          cache->slab_stack = glib_mem_table->calloc (MAX_SLAB_INDEX (allocator), sizeof (SlabInfo*));
+          mem_assert (cache->slab_stack);
+        }
     }
 
   allocator->mutex_counter = 0;
   allocator->stamp_counter = MAX_STAMP_COUNTER; /* force initial update */
   allocator->last_stamp = 0;
-  allocator->color_accu = 0;
   magazine_cache_update_stamp();
   /* values cached for performance reasons */
   allocator->max_slab_chunk_size_for_magazine_cache = MAX_SLAB_CHUNK_SIZE (allocator);
@@ -509,12 +551,6 @@ g_slice_init_nomessage (void)
     allocator->max_slab_chunk_size_for_magazine_cache = 0;      /* non-optimized cases */
 }
 
-void
-_g_slice_deinit (void)
-{
-  allocator_cleanup ();
-}
-
 static inline guint
 allocator_categorize (gsize aligned_chunk_size)
 {
@@ -570,7 +606,6 @@ thread_memory_from_self (void)
 
   if (G_UNLIKELY (!tmem))
     {
-      static GMutex init_mutex;
       guint n_magazines;
 
       g_mutex_lock (&init_mutex);
@@ -579,7 +614,9 @@ thread_memory_from_self (void)
       g_mutex_unlock (&init_mutex);
 
       n_magazines = MAX_SLAB_INDEX (allocator);
-      tmem = g_private_set_alloc0 (&private_thread_memory, sizeof (ThreadMemory) + sizeof (Magazine) * 2 * n_magazines);
+      tmem = glib_mem_table->calloc (1, sizeof (ThreadMemory) + sizeof (Magazine) * 2 * n_magazines);
+      mem_assert (tmem != NULL);
+      g_private_set (&private_thread_memory, tmem);
     }
 
   if (G_UNLIKELY (!tmem->magazine1))
@@ -591,6 +628,31 @@ thread_memory_from_self (void)
   return tmem;
 }
 
+static inline SlabCache*
+allocator_get_slab_cache (void)
+{
+#ifdef G_OS_WIN32
+  return SLAB_CACHE (allocator, GetCurrentProcessorNumber () % allocator->n_slab_caches);
+#else
+  guint hash;
+#ifdef HAVE_SCHED_GETCPU
+  gint cpu = sched_getcpu ();
+  if (G_LIKELY (cpu >= 0))
+    return SLAB_CACHE (allocator, (guint) cpu % allocator->n_slab_caches);
+#endif
+  /* no CPU number available, spread threads over the caches instead */
+  hash = (guint) (GPOINTER_TO_SIZE (g_private_get (&private_thread_memory)) >> 4) * 0x9e3779b1U;
+  return SLAB_CACHE (allocator, (hash >> 16) % allocator->n_slab_caches);
+#endif
+}
+
+static inline void
+slab_cache_unlock (SlabCache *locked)
+{
+  if (locked)
+    g_mutex_unlock (&locked->mutex);
+}
+
 static inline ChunkLink*
 magazine_chain_pop_head (ChunkLink **magazine_chunks)
 {
@@ -734,7 +796,7 @@ magazine_cache_trim (Allocator *local_allocator,
   if (trash)
     {
       const gsize chunk_size = SLAB_CHUNK_SIZE (local_allocator, ix);
-      g_mutex_lock (&local_allocator->slab_mutex);
+      SlabCache *locked = NULL;
       while (trash)
         {
           current = trash;
@@ -743,10 +805,10 @@ magazine_cache_trim (Allocator *local_allocator,
           while (current)
             {
               ChunkLink *chunk = magazine_chain_pop_head (&current);
-              slab_allocator_free_chunk (chunk_size, chunk);
+              slab_allocator_free_chunk (chunk_size, chunk, &locked);
             }
         }
-      g_mutex_unlock (&local_allocator->slab_mutex);
+      slab_cache_unlock (locked);
     }
 }
 
@@ -787,20 +849,21 @@ magazine_cache_pop_magazine (guint  ix,
     {
       guint magazine_threshold = allocator_get_magazine_threshold (allocator, ix);
       gsize i, chunk_size = SLAB_CHUNK_SIZE (allocator, ix);
+      SlabCache *cache = allocator_get_slab_cache ();
       ChunkLink *chunk, *head;
       g_mutex_unlock (&allocator->magazine_mutex);
-      g_mutex_lock (&allocator->slab_mutex);
-      head = slab_allocator_alloc_chunk (chunk_size);
+      g_mutex_lock (&cache->mutex);
+      head = slab_allocator_alloc_chunk (cache, chunk_size);
       head->data = NULL;
       chunk = head;
       for (i = 1; i < magazine_threshold; i++)
         {
-          chunk->next = slab_allocator_alloc_chunk (chunk_size);
+          chunk->next = slab_allocator_alloc_chunk (cache, chunk_size);
           chunk = chunk->next;
           chunk->data = NULL;
         }
       chunk->next = NULL;
-      g_mutex_unlock (&allocator->slab_mutex);
+      g_mutex_unlock (&cache->mutex);
       *countp = i;
       return head;
     }
@@ -845,17 +908,17 @@ private_thread_memory_cleanup (gpointer data)
           else
             {
               const gsize chunk_size = SLAB_CHUNK_SIZE (allocator, ix);
-              g_mutex_lock (&allocator->slab_mutex);
+              SlabCache *locked = NULL;
               while (mag->chunks)
                 {
                   ChunkLink *chunk = magazine_chain_pop_head (&mag->chunks);
-                  slab_allocator_free_chunk (chunk_size, chunk);
+                  slab_allocator_free_chunk (chunk_size, chunk, &locked);
                 }
-              g_mutex_unlock (&allocator->slab_mutex);
+              slab_cache_unlock (locked);
             }
         }
     }
-  g_free (tmem);
+  glib_mem_table->free (tmem);
 }
 
 static void
@@ -925,6 +988,141 @@ thread_memory_magazine2_free (ThreadMemory *tmem,
   mag->count++;
 }
 
+/* --- teardown --- */
+void
+_g_slice_deinit (void)
+{
+  /* the calling thread's magazines were handed to the magazine cache by
+   * _g_thread_deinit(), so flushing that returns every cached chunk to its
+   * slab. slabs still around after that hold leaked chunks, or chunks in
+   * magazines of threads that are still running, and are freed regardless.
+   * no locking here, the mutex implementations may already be gone.
+   */
+  if (sys_page_size != 0 && !allocator->config.always_malloc)
+    {
+      const guint n_magazines = MAX_SLAB_INDEX (allocator);
+      guint ix, i;
+
+      for (ix = 0; ix < n_magazines; ix++)
+        {
+          const gsize chunk_size = SLAB_CHUNK_SIZE (allocator, ix);
+          ChunkLink *current = allocator->magazines[ix];
+          if (!current)
+            continue;
+          /* open up the ring */
+          magazine_chain_next (magazine_chain_prev (current)) = NULL;
+          while (current)
+            {
+              ChunkLink *next = magazine_chain_next (current);
+              magazine_chain_prev (current) = NULL;
+              magazine_chain_next (current) = NULL;
+              magazine_chain_count (current) = NULL;
+              magazine_chain_stamp (current) = NULL;
+              while (current)
+                {
+                  ChunkLink *chunk = magazine_chain_pop_head (&current);
+                  slab_allocator_free_chunk (chunk_size, chunk, NULL);
+                }
+              current = next;
+            }
+        }
+
+      for (i = 0; i < allocator->n_slab_caches; i++)
+        {
+          SlabCache *cache = SLAB_CACHE (allocator, i);
+          for (ix = 0; ix < n_magazines; ix++)
+            {
+              gsize page_size = allocator_aligned_page_size (allocator, SLAB_BPAGE_SIZE (allocator, SLAB_CHUNK_SIZE (allocator, ix)));
+              SlabInfo *sinfo = cache->slab_stack[ix];
+              if (!sinfo)
+                continue;
+              sinfo->prev->next = NULL;
+              while (sinfo)
+                {
+                  SlabInfo *next = sinfo->next;
+                  allocator_memfree (page_size, (guint8*) sinfo + SLAB_INFO_SIZE - page_size);
+                  sinfo = next;
+                }
+            }
+          glib_mem_table->free (cache->slab_stack);
+        }
+
+      glib_mem_table->free (allocator->slab_caches);
+      glib_mem_table->free (allocator->magazines);
+      glib_mem_table->free (allocator->contention_counters);
+    }
+
+  allocator_cleanup ();
+
+  memset (allocator, 0, sizeof (Allocator));
+  sys_page_size = 0;
+}
+
+gboolean
+_g_slice_small_malloc_init (gsize max_block_size)
+{
+  gboolean enabled;
+
+  g_mutex_lock (&init_mutex);
+  if G_UNLIKELY (sys_page_size == 0)
+    g_slice_init_nomessage ();
+  g_mutex_unlock (&init_mutex);
+
+  /* only take blocks that will stay in the magazine layer, anything else
+   * would come back through g_malloc()
+   */
+  enabled = allocator->config.small_malloc &&
+            !allocator->config.debug_blocks &&
+            allocator_categorize (P2ALIGN (max_block_size)) == 1;
+  small_malloc_enabled = enabled;
+
+  return enabled;
+}
+
+void
+_g_slice_small_malloc_thread_init (void)
+{
+  /* the magazines are set up through g_private_set(), which must not happen
+   * from within g_thread_private_destroy_later()'s hash table update
+   */
+  if (small_malloc_enabled)
+    thread_memory_from_self ();
+}
+
+/* --- g_malloc() small blocks --- */
+/* these serve g_malloc() and g_free() for small blocks, once enabled by
+ * _g_slice_small_malloc_init(). @mem_size includes gmem.c's size header and
+ * is known to map to the magazine layer.
+ */
+gpointer
+_g_slice_small_alloc (gsize mem_size)
+{
+  ThreadMemory *tmem = thread_memory_from_self ();
+  guint ix = SLAB_INDEX (allocator, P2ALIGN (mem_size));
+  if (G_UNLIKELY (thread_memory_magazine1_is_empty (tmem, ix)))
+    {
+      thread_memory_swap_magazines (tmem, ix);
+      if (G_UNLIKELY (thread_memory_magazine1_is_empty (tmem, ix)))
+        thread_memory_magazine1_reload (tmem, ix);
+    }
+  return thread_memory_magazine1_alloc (tmem, ix);
+}
+
+void
+_g_slice_small_free (gsize    mem_size,
+                     gpointer mem_block)
+{
+  ThreadMemory *tmem = thread_memory_from_self ();
+  guint ix = SLAB_INDEX (allocator, P2ALIGN (mem_size));
+  if (G_UNLIKELY (thread_memory_magazine2_is_full (tmem, ix)))
+    {
+      thread_memory_swap_magazines (tmem, ix);
+      if (G_UNLIKELY (thread_memory_magazine2_is_full (tmem, ix)))
+        thread_memory_magazine2_unload (tmem, ix);
+    }
+  thread_memory_magazine2_free (tmem, ix, mem_block);
+}
+
 #else
 
 void
@@ -932,6 +1130,30 @@ _g_slice_deinit (void)
 {
 }
 
+gboolean
+_g_slice_small_malloc_init (gsize max_block_size)
+{
+  return FALSE;
+}
+
+gpointer
+_g_slice_small_alloc (gsize mem_size)
+{
+  g_assert_not_reached ();
+}
+
+void
+_g_slice_small_free (gsize    mem_size,
+                     gpointer mem_block)
+{
+  g_assert_not_reached ();
+}
+
+void
+_g_slice_small_malloc_thread_init (void)
+{
+}
+
 #endif
 
 /* --- API functions --- */
@@ -1097,9 +1319,10 @@ g_slice_alloc (gsize mem_size)
     }
   else if (acat == 2)           /* allocate through slab allocator */
     {
-      g_mutex_lock (&allocator->slab_mutex);
-      mem = slab_allocator_alloc_chunk (chunk_size);
-      g_mutex_unlock (&allocator->slab_mutex);
+      SlabCache *cache = allocator_get_slab_cache ();
+      g_mutex_lock (&cache->mutex);
+      mem = slab_allocator_alloc_chunk (cache, chunk_size);
+      g_mutex_unlock (&cache->mutex);
     }
   else                          /* delegate to system malloc */
     mem = g_malloc (mem_size);
@@ -1207,11 +1430,11 @@ g_slice_free1 (gsize    mem_size,
     }
   else if (acat == 2)                   /* allocate through slab allocator */
     {
+      SlabCache *locked = NULL;
       if (G_UNLIKELY (g_mem_gc_friendly))
         memset (mem_block, 0, chunk_size);
-      g_mutex_lock (&allocator->slab_mutex);
-      slab_allocator_free_chunk (chunk_size, mem_block);
-      g_mutex_unlock (&allocator->slab_mutex);
+      slab_allocator_free_chunk (chunk_size, mem_block, &locked);
+      slab_cache_unlock (locked);
     }
   else                                  /* delegate to system malloc */
     {
@@ -1293,7 +1516,7 @@ g_slice_free_chain_with_offset (gsize    mem_size,
     }
   else if (acat == 2)                   /* allocate through slab allocator */
     {
-      g_mutex_lock (&allocator->slab_mutex);
+      SlabCache *locked = NULL;
       while (slice)
         {
           guint8 *current = slice;
@@ -1303,9 +1526,9 @@ g_slice_free_chain_with_offset (gsize    mem_size,
             abort();
           if (G_UNLIKELY (g_mem_gc_friendly))
             memset (current, 0, chunk_size);
-          slab_allocator_free_chunk (chunk_size, current);
+          slab_allocator_free_chunk (chunk_size, current, &locked);
         }
-      g_mutex_unlock (&allocator->slab_mutex);
+      slab_cache_unlock (locked);
     }
   else                                  /* delegate to system malloc */
     while (slice)
@@ -1333,25 +1556,25 @@ g_slice_free_chain_with_offset (gsize    mem_size,
 
 /* --- single page allocator --- */
 static void
-allocator_slab_stack_push (Allocator *local_allocator,
+allocator_slab_stack_push (SlabCache *cache,
                            guint ix,
                            SlabInfo *sinfo)
 {
   /* insert slab at slab ring head */
-  if (!local_allocator->slab_stack[ix])
+  if (!cache->slab_stack[ix])
     {
       sinfo->next = sinfo;
       sinfo->prev = sinfo;
     }
   else
     {
-      SlabInfo *next = local_allocator->slab_stack[ix], *prev = next->prev;
+      SlabInfo *next = cache->slab_stack[ix], *prev = next->prev;
       next->prev = sinfo;
       prev->next = sinfo;
       sinfo->next = next;
       sinfo->prev = prev;
     }
-  local_allocator->slab_stack[ix] = sinfo;
+  cache->slab_stack[ix] = sinfo;
 }
 
 static gsize
@@ -1365,6 +1588,7 @@ allocator_aligned_page_size (Allocator *local_allocator,
 
 static void
 allocator_add_slab (Allocator *local_allocator,
+                    SlabCache *cache,
                     guint ix,
                     gsize chunk_size)
 {
@@ -1396,14 +1620,15 @@ allocator_add_slab (Allocator *local_allocator,
   /* basic slab info setup */
   sinfo = (SlabInfo*) (mem + page_size - SLAB_INFO_SIZE);
   sinfo->n_allocated = 0;
+  sinfo->cache_index = ((guint8*) cache - (guint8*) local_allocator->slab_caches) / SLAB_CACHE_STRIDE;
   sinfo->chunks = NULL;
   /* figure cache colorization */
   n_chunks = ((guint8*) sinfo - mem) / chunk_size;
   padding = ((guint8*) sinfo - mem) - n_chunks * chunk_size;
   if (padding)
     {
-      color = (local_allocator->color_accu * P2ALIGNMENT) % padding;
-      local_allocator->color_accu += local_allocator->config.color_increment;
+      color = (cache->color_accu * P2ALIGNMENT) % padding;
+      cache->color_accu += local_allocator->config.color_increment;
     }
   /* add chunks to free list */
   chunk = (ChunkLink*) (mem + color);
@@ -1415,32 +1640,41 @@ allocator_add_slab (Allocator *local_allocator,
     }
   chunk->next = NULL;   /* last chunk */
   /* add slab to slab ring */
-  allocator_slab_stack_push (local_allocator, ix, sinfo);
+  allocator_slab_stack_push (cache, ix, sinfo);
 }
 
 static gpointer
-slab_allocator_alloc_chunk (gsize chunk_size)
+slab_allocator_alloc_chunk (SlabCache *cache,
+                            gsize      chunk_size)
 {
+  /* g_mutex_lock (&cache->mutex); done by caller */
   ChunkLink *chunk;
   guint ix = SLAB_INDEX (allocator, chunk_size);
   /* ensure non-empty slab */
-  if (!allocator->slab_stack[ix] || !allocator->slab_stack[ix]->chunks)
-    allocator_add_slab (allocator, ix, chunk_size);
+  if (!cache->slab_stack[ix] || !cache->slab_stack[ix]->chunks)
+    allocator_add_slab (allocator, cache, ix, chunk_size);
   /* allocate chunk */
-  chunk = allocator->slab_stack[ix]->chunks;
-  allocator->slab_stack[ix]->chunks = chunk->next;
-  allocator->slab_stack[ix]->n_allocated++;
+  chunk = cache->slab_stack[ix]->chunks;
+  cache->slab_stack[ix]->chunks = chunk->next;
+  cache->slab_stack[ix]->n_allocated++;
   /* rotate empty slabs */
-  if (!allocator->slab_stack[ix]->chunks)
-    allocator->slab_stack[ix] = allocator->slab_stack[ix]->next;
+  if (!cache->slab_stack[ix]->chunks)
+    cache->slab_stack[ix] = cache->slab_stack[ix]->next;
   return chunk;
 }
 
+/* returns @mem to the cache owning its slab. if @locked is non-%NULL, it
+ * holds the cache currently locked by the caller (or %NULL), and is switched
+ * over to the owning cache if that differs, so runs of chunks from the same
+ * cache only lock once. the caller unlocks *@locked when done.
+ */
 static void
-slab_allocator_free_chunk (gsize    chunk_size,
-                           gpointer mem)
+slab_allocator_free_chunk (gsize       chunk_size,
+                           gpointer    mem,
+                           SlabCache **locked)
 {
   ChunkLink *chunk;
+  SlabCache *cache;
   gboolean was_empty;
   guint ix = SLAB_INDEX (allocator, chunk_size);
   gsize page_size = allocator_aligned_page_size (allocator, SLAB_BPAGE_SIZE (allocator, chunk_size));
@@ -1448,6 +1682,14 @@ slab_allocator_free_chunk (gsize    chunk_size,
   /* mask page address */
   guint8 *page = (guint8*) addr;
   SlabInfo *sinfo = (SlabInfo*) (page + page_size - SLAB_INFO_SIZE);
+  /* lock the owning cache, see [5] */
+  cache = SLAB_CACHE (allocator, sinfo->cache_index);
+  if (locked && *locked != cache)
+    {
+      slab_cache_unlock (*locked);
+      g_mutex_lock (&cache->mutex);
+      *locked = cache;
+    }
   /* assert valid chunk count */
   mem_assert (sinfo->n_allocated > 0);
   /* add chunk to free list */
@@ -1463,10 +1705,10 @@ slab_allocator_free_chunk (gsize    chunk_size,
       SlabInfo *next = sinfo->next, *prev = sinfo->prev;
       next->prev = prev;
       prev->next = next;
-      if (allocator->slab_stack[ix] == sinfo)
-        allocator->slab_stack[ix] = next == sinfo ? NULL : next;
+      if (cache->slab_stack[ix] == sinfo)
+        cache->slab_stack[ix] = next == sinfo ? NULL : next;
       /* insert slab at head */
-      allocator_slab_stack_push (allocator, ix, sinfo);
+      allocator_slab_stack_push (cache, ix, sinfo);
     }
   /* eagerly free complete unused slabs */
   if (!sinfo->n_allocated)
@@ -1475,8 +1717,8 @@ slab_allocator_free_chunk (gsize    chunk_size,
       SlabInfo *next = sinfo->next, *prev = sinfo->prev;
       next->prev = prev;
       prev->next = next;
-      if (allocator->slab_stack[ix] == sinfo)
-        allocator->slab_stack[ix] = next == sinfo ? NULL : next;
+      if (cache->slab_stack[ix] == sinfo)
+        cache->slab_stack[ix] = next == sinfo ? NULL : next;
       /* free slab */
       allocator_memfree (page_size, page);
     }
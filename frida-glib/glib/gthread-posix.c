@@ -98,6 +98,10 @@ static GPtrSet *g_thread_conds;
 static GPtrSet *g_thread_rec_mutexes;
 static GPtrSet *g_thread_rwlocks;
 static GPtrSet *g_thread_privates;
+/* Locks that got their impl on first use, e.g. statically allocated ones.
+ * Their impl pointer is reset on deinit so that they start out fresh if GLib
+ * gets initialised again. */
+static GPtrSet *g_thread_lazy_locks;
 
 static void
 g_thread_state_add (GPtrSet  *pset,
@@ -108,12 +112,25 @@ g_thread_state_add (GPtrSet  *pset,
   pthread_mutex_unlock (&g_thread_state_lock);
 }
 
+static void
+g_thread_state_add_lazy (GPtrSet  *pset,
+                         gpointer  impl,
+                         gpointer  lock)
+{
+  pthread_mutex_lock (&g_thread_state_lock);
+  g_ptr_set_add (pset, impl);
+  g_ptr_set_add (g_thread_lazy_locks, lock);
+  pthread_mutex_unlock (&g_thread_state_lock);
+}
+
 static void
 g_thread_state_remove (GPtrSet  *pset,
-                       gpointer  item)
+                       gpointer  impl,
+                       gpointer  lock)
 {
   pthread_mutex_lock (&g_thread_state_lock);
-  g_ptr_set_remove (pset, item);
+  g_ptr_set_remove (pset, impl);
+  g_ptr_set_remove (g_thread_lazy_locks, lock);
   pthread_mutex_unlock (&g_thread_state_lock);
 }
 
@@ -192,7 +209,7 @@ g_mutex_get_impl (GMutex *mutex)
       if (!g_atomic_pointer_compare_and_exchange (&mutex->p, NULL, impl))
         g_mutex_impl_free (impl);
       else
-        g_thread_state_add (g_thread_mutexes, impl);
+        g_thread_state_add_lazy (g_thread_mutexes, impl, mutex);
       impl = mutex->p;
     }
 
@@ -256,7 +273,7 @@ g_mutex_init (GMutex *mutex)
 void
 g_mutex_clear (GMutex *mutex)
 {
-  g_thread_state_remove (g_thread_mutexes, mutex->p);
+  g_thread_state_remove (g_thread_mutexes, mutex->p, mutex);
 
   g_mutex_impl_free (mutex->p);
 }
@@ -371,7 +388,7 @@ g_rec_mutex_get_impl (GRecMutex *rec_mutex)
       if (!g_atomic_pointer_compare_and_exchange (&rec_mutex->p, NULL, impl))
         g_rec_mutex_impl_free (impl);
       else
-        g_thread_state_add (g_thread_rec_mutexes, impl);
+        g_thread_state_add_lazy (g_thread_rec_mutexes, impl, rec_mutex);
       impl = rec_mutex->p;
     }
 
@@ -437,7 +454,7 @@ g_rec_mutex_init (GRecMutex *rec_mutex)
 void
 g_rec_mutex_clear (GRecMutex *rec_mutex)
 {
-  g_thread_state_remove (g_thread_rec_mutexes, rec_mutex->p);
+  g_thread_state_remove (g_thread_rec_mutexes, rec_mutex->p, rec_mutex);
 
   g_rec_mutex_impl_free (rec_mutex->p);
 }
@@ -537,7 +554,7 @@ g_rw_lock_get_impl (GRWLock *lock)
       if (!g_atomic_pointer_compare_and_exchange (&lock->p, NULL, impl))
         g_rw_lock_impl_free (impl);
       else
-        g_thread_state_add (g_thread_rwlocks, impl);
+        g_thread_state_add_lazy (g_thread_rwlocks, impl, lock);
       impl = lock->p;
     }
 
@@ -600,7 +617,7 @@ g_rw_lock_init (GRWLock *rw_lock)
 void
 g_rw_lock_clear (GRWLock *rw_lock)
 {
-  g_thread_state_remove (g_thread_rwlocks, rw_lock->p);
+  g_thread_state_remove (g_thread_rwlocks, rw_lock->p, rw_lock);
 
   g_rw_lock_impl_free (rw_lock->p);
 }
@@ -784,7 +801,7 @@ g_cond_get_impl (GCond *cond)
       if (!g_atomic_pointer_compare_and_exchange (&cond->p, NULL, impl))
         g_cond_impl_free (impl);
       else
-        g_thread_state_add (g_thread_conds, impl);
+        g_thread_state_add_lazy (g_thread_conds, impl, cond);
       impl = cond->p;
     }
 
@@ -834,7 +851,7 @@ g_cond_init (GCond *cond)
 void
 g_cond_clear (GCond *cond)
 {
-  g_thread_state_remove (g_thread_conds, cond->p);
+  g_thread_state_remove (g_thread_conds, cond->p, cond);
 
   g_cond_impl_free (cond->p);
 }
@@ -1955,6 +1972,7 @@ _g_thread_init (void)
   g_thread_rec_mutexes = g_ptr_set_new ();
   g_thread_rwlocks = g_ptr_set_new ();
   g_thread_privates = g_ptr_set_new ();
+  g_thread_lazy_locks = g_ptr_set_new ();
 }
 
 void
@@ -1971,6 +1989,7 @@ _g_thread_deinit (void)
     {
       GPrivate *key = g_thread_privates->items[i];
       g_private_impl_free (key->p);
+      key->p = NULL;
     }
   g_ptr_set_free (g_thread_privates);
   g_thread_privates = NULL;
@@ -1995,6 +2014,11 @@ _g_thread_deinit (void)
   g_thread_mutexes = NULL;
 #endif
 
+  for (i = 0; i != g_thread_lazy_locks->size; i++)
+    *(gpointer *) g_thread_lazy_locks->items[i] = NULL;
+  g_ptr_set_free (g_thread_lazy_locks);
+  g_thread_lazy_locks = NULL;
+
   if G_UNLIKELY ((status = pthread_key_delete (g_thread_cleanup_key)) != 0)
     g_thread_abort (status, "pthread_key_delete");
 
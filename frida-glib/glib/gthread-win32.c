@@ -175,6 +175,9 @@ g_mutex_unlock (GMutex *mutex)
 
 static CRITICAL_SECTION  g_thread_rec_mutex_lock;
 static GPtrSet          *g_thread_rec_mutexes;
+/* Statically allocated GRecMutexes, reset on deinit so that they start out
+ * fresh if GLib gets initialised again. */
+static GPtrSet          *g_thread_lazy_rec_mutexes;
 
 static CRITICAL_SECTION *
 g_rec_mutex_impl_new (void)
@@ -217,7 +220,15 @@ g_rec_mutex_get_impl (GRecMutex *mutex)
     {
       impl = g_rec_mutex_impl_new ();
       if (InterlockedCompareExchangePointer (&mutex->p, impl, NULL) != NULL)
-        g_rec_mutex_impl_free (impl);
+        {
+          g_rec_mutex_impl_free (impl);
+        }
+      else
+        {
+          EnterCriticalSection (&g_thread_rec_mutex_lock);
+          g_ptr_set_add (g_thread_lazy_rec_mutexes, mutex);
+          LeaveCriticalSection (&g_thread_rec_mutex_lock);
+        }
       impl = mutex->p;
     }
 
@@ -233,6 +244,10 @@ g_rec_mutex_init (GRecMutex *mutex)
 void
 g_rec_mutex_clear (GRecMutex *mutex)
 {
+  EnterCriticalSection (&g_thread_rec_mutex_lock);
+  g_ptr_set_remove (g_thread_lazy_rec_mutexes, mutex);
+  LeaveCriticalSection (&g_thread_rec_mutex_lock);
+
   g_rec_mutex_impl_free (mutex->p);
 }
 
@@ -1309,6 +1324,7 @@ _g_thread_init (void)
 
   InitializeCriticalSection (&g_thread_rec_mutex_lock);
   g_thread_rec_mutexes = g_ptr_set_new ();
+  g_thread_lazy_rec_mutexes = g_ptr_set_new ();
 
   InitializeCriticalSection (&g_private_lock);
   g_thread_privates = g_ptr_set_new ();
@@ -1352,6 +1368,7 @@ _g_thread_deinit (void)
     {
       GPrivate *key = g_thread_privates->items[i];
       TlsFree (GPOINTER_TO_SIZE (key->p));
+      key->p = NULL;
     }
   g_ptr_set_free (g_thread_privates);
   g_thread_privates = NULL;
@@ -1361,6 +1378,14 @@ _g_thread_deinit (void)
   g_ptr_set_free (g_thread_rec_mutexes);
   g_thread_rec_mutexes = NULL;
 
+  for (i = 0; i != g_thread_lazy_rec_mutexes->size; i++)
+    {
+      GRecMutex *mutex = g_thread_lazy_rec_mutexes->items[i];
+      mutex->p = NULL;
+    }
+  g_ptr_set_free (g_thread_lazy_rec_mutexes);
+  g_thread_lazy_rec_mutexes = NULL;
+
   DeleteCriticalSection (&g_thread_rec_mutex_lock);
   DeleteCriticalSection (&g_private_lock);
 
@@ -42,6 +42,7 @@
 
 #include "gthread.h"
 #include "gthreadprivate.h"
+#include "glib-init.h"
 
 #include <string.h>
 
@@ -964,6 +965,11 @@ g_thread_private_destroy_later (GPrivate *key,
   if (key->notify == NULL)
     return;
 
+  /* with G_SLICE=small-malloc, the insertion below may be this thread's
+   * first GSlice allocation, which would recurse into here
+   */
+  _g_slice_small_malloc_thread_init ();
+
   thread = (GRealThread *) g_thread_self ();
 
   if (value != NULL)
@@ -51,6 +51,15 @@
  * Most GVariant API functions are in gvariant.c.
  */
 
+/* The bounds of each child of a large serialised array, decoded from
+ * its framing offsets in one go.  See .ranges below.
+ */
+typedef struct
+{
+  gsize n_children;
+  guint32 bounds[];
+} GVariantChildRanges;
+
 /**
  * GVariant:
  *
@@ -71,6 +80,7 @@ struct _GVariant
     {
       GBytes *bytes;
       gconstpointer data;
+      GVariantChildRanges *ranges;
     } serialised;
 
     struct
@@ -168,6 +178,26 @@ struct _GVariant
  *                if .data pointed to the appropriate number of nul
  *                bytes.
  *
+ *     .ranges: %NULL, %CHILD_RANGES_PENDING, or the start and end of
+ *              each child as decoded by
+ *              g_variant_serialised_get_child_ranges().  This is
+ *              only ever filled in for arrays of variable-sized types
+ *              with at least %CHILD_RANGES_MIN_CHILDREN children.
+ *              Fetching their first child only sets it to
+ *              %CHILD_RANGES_PENDING, so that looking at a single
+ *              child stays O(1) and does not allocate; the next child
+ *              fetched decodes all of the ranges, on the assumption
+ *              that the caller is iterating over them.  Each step is
+ *              done using an atomic compare-and-exchange, and once
+ *              the ranges are set they never change; they are freed
+ *              along with the instance.
+ *
+ *              Unlike the other fields it does not overlap with
+ *              .tree, and it is initialised to %NULL for tree form
+ *              instances too, so it can be read atomically without
+ *              holding the lock regardless of the form of the
+ *              instance.  A non-%NULL value implies serialized form.
+ *
  *   .tree: Only valid when the instance is in tree form.
  *
  *          Note that accesses from other threads could result in
@@ -222,6 +252,11 @@ struct _GVariant
 #define STATE_TRUSTED    4
 #define STATE_FLOATING   8
 
+#define CHILD_RANGES_MIN_CHILDREN 16
+
+static GVariantChildRanges child_ranges_pending;
+#define CHILD_RANGES_PENDING (&child_ranges_pending)
+
 /* -- private -- */
 /* < private >
  * g_variant_lock:
@@ -497,6 +532,7 @@ g_variant_alloc (const GVariantType *type,
   value->size = (gssize) -1;
   g_atomic_ref_count_init (&value->ref_count);
   value->depth = 0;
+  value->contents.serialised.ranges = NULL;
 
   return value;
 }
@@ -676,6 +712,22 @@ g_variant_is_trusted (GVariant *value)
   return (value->state & STATE_TRUSTED) != 0;
 }
 
+/* < internal >
+ * g_variant_is_serialised:
+ * @value: a #GVariant
+ *
+ * Determines if @value is currently in serialized form, in which case
+ * g_variant_get_data() returns its data without having to serialize its
+ * children first.
+ *
+ * Returns: if @value is serialized
+ */
+gboolean
+g_variant_is_serialised (GVariant *value)
+{
+  return (value->state & STATE_SERIALISED) != 0;
+}
+
 /* < internal >
  * g_variant_get_depth:
  * @value: a #GVariant
@@ -722,6 +774,9 @@ g_variant_unref (GVariant *value)
       else
         g_variant_release_children (value);
 
+      if (value->contents.serialised.ranges != CHILD_RANGES_PENDING)
+        g_free (value->contents.serialised.ranges);
+
       memset (value, 0, sizeof (GVariant));
       g_slice_free (GVariant, value);
     }
@@ -1012,8 +1067,13 @@ g_variant_get_data_as_bytes (GVariant *value)
 gsize
 g_variant_n_children (GVariant *value)
 {
+  GVariantChildRanges *ranges;
   gsize n_children;
 
+  ranges = g_atomic_pointer_get (&value->contents.serialised.ranges);
+  if (ranges != NULL && ranges != CHILD_RANGES_PENDING)
+    return ranges->n_children;
+
   g_variant_lock (value);
 
   if (value->state & STATE_SERIALISED)
@@ -1035,6 +1095,80 @@ g_variant_n_children (GVariant *value)
   return n_children;
 }
 
+/* < private >
+ * g_variant_want_child_ranges:
+ * @value: a serialized #GVariant
+ *
+ * Marks .contents.serialised.ranges as %CHILD_RANGES_PENDING if @value
+ * is a large enough array of a variable-sized type, so that the next
+ * child fetched decodes the bounds of all of them.  This only looks at
+ * the type and the last framing offset of @value, so it is O(1).
+ */
+static void
+g_variant_want_child_ranges (GVariant *value)
+{
+  GVariantSerialised serialised = {
+    value->type_info,
+    (gpointer) value->contents.serialised.data,
+    value->size,
+    value->depth,
+  };
+  gsize fixed_size;
+
+  if (g_variant_type_info_get_type_char (value->type_info) !=
+      G_VARIANT_TYPE_INFO_CHAR_ARRAY || value->size > G_MAXUINT32)
+    return;
+
+  g_variant_type_info_query (g_variant_type_info_element (value->type_info),
+                             NULL, &fixed_size);
+  if (fixed_size != 0)
+    return;
+
+  if (g_variant_serialised_n_children (serialised) < CHILD_RANGES_MIN_CHILDREN)
+    return;
+
+  g_atomic_pointer_compare_and_exchange (&value->contents.serialised.ranges,
+                                         NULL, CHILD_RANGES_PENDING);
+}
+
+/* < private >
+ * g_variant_ensure_child_ranges:
+ * @value: a serialized #GVariant marked by g_variant_want_child_ranges()
+ *
+ * Decodes the bounds of all of the children of @value into
+ * .contents.serialised.ranges, so that iterating over it does not have
+ * to decode and check its framing offsets one child at a time.
+ *
+ * Returns: the child ranges of @value
+ */
+static GVariantChildRanges *
+g_variant_ensure_child_ranges (GVariant *value)
+{
+  GVariantSerialised serialised = {
+    value->type_info,
+    (gpointer) value->contents.serialised.data,
+    value->size,
+    value->depth,
+  };
+  GVariantChildRanges *ranges;
+  gsize n_children;
+
+  n_children = g_variant_serialised_n_children (serialised);
+  ranges = g_malloc (sizeof (GVariantChildRanges) +
+                     n_children * 2 * sizeof (guint32));
+  ranges->n_children = n_children;
+  g_variant_serialised_get_child_ranges (serialised, ranges->bounds);
+
+  if (!g_atomic_pointer_compare_and_exchange (&value->contents.serialised.ranges,
+                                              CHILD_RANGES_PENDING, ranges))
+    {
+      g_free (ranges);
+      ranges = g_atomic_pointer_get (&value->contents.serialised.ranges);
+    }
+
+  return ranges;
+}
+
 /**
  * g_variant_get_child_value:
  * @value: a container #GVariant
@@ -1072,10 +1206,24 @@ GVariant *
 g_variant_get_child_value (GVariant *value,
                            gsize     index_)
 {
-  g_return_val_if_fail (index_ < g_variant_n_children (value), NULL);
+  GVariantChildRanges *ranges;
+
+  ranges = g_atomic_pointer_get (&value->contents.serialised.ranges);
+
+  if (ranges == CHILD_RANGES_PENDING)
+    ranges = g_variant_ensure_child_ranges (value);
+  else if (ranges == NULL && index_ == 0 &&
+           g_atomic_int_get (&value->state) & STATE_SERIALISED)
+    g_variant_want_child_ranges (value);
+
+  if (ranges != NULL)
+    g_return_val_if_fail (index_ < ranges->n_children, NULL);
+  else
+    g_return_val_if_fail (index_ < g_variant_n_children (value), NULL);
   g_return_val_if_fail (value->depth < G_MAXSIZE, NULL);
 
-  if (~g_atomic_int_get (&value->state) & STATE_SERIALISED)
+  if (ranges == NULL &&
+      ~g_atomic_int_get (&value->state) & STATE_SERIALISED)
     {
       g_variant_lock (value);
 
@@ -1102,10 +1250,25 @@ g_variant_get_child_value (GVariant *value,
     GVariantSerialised s_child;
     GVariant *child;
 
-    /* get the serializer to extract the serialized data for the child
-     * from the serialized data for the container
-     */
-    s_child = g_variant_serialised_get_child (serialised, index_);
+    if (ranges != NULL)
+      {
+        guint32 start = ranges->bounds[2 * index_];
+        guint32 end = ranges->bounds[2 * index_ + 1];
+
+        /* the same as g_variant_serialised_get_child() would find */
+        s_child.type_info = g_variant_type_info_element (value->type_info);
+        g_variant_type_info_ref (s_child.type_info);
+        s_child.data = start < end ? serialised.data + start : NULL;
+        s_child.size = end - start;
+        s_child.depth = value->depth + 1;
+      }
+    else
+      {
+        /* get the serializer to extract the serialized data for the
+         * child from the serialized data for the container
+         */
+        s_child = g_variant_serialised_get_child (serialised, index_);
+      }
 
     /* Check whether this would cause nesting too deep. If so, return a fake
      * child. The only situation we expect this to happen in is with a variant,
@@ -1132,6 +1295,7 @@ g_variant_get_child_value (GVariant *value,
     child->contents.serialised.bytes =
       g_bytes_ref (value->contents.serialised.bytes);
     child->contents.serialised.data = s_child.data;
+    child->contents.serialised.ranges = NULL;
 
     return child;
   }
@@ -34,6 +34,8 @@ GVariant *              g_variant_new_from_children                     (const G
 
 gboolean                g_variant_is_trusted                            (GVariant            *value);
 
+gboolean                g_variant_is_serialised                         (GVariant            *value);
+
 GVariantTypeInfo *      g_variant_get_type_info                         (GVariant            *value);
 
 gsize                   g_variant_get_depth                             (GVariant            *value);
@@ -639,6 +639,43 @@ gvs_calculate_total_size (gsize body_size,
   return body_size + 8 * offsets;
 }
 
+/* < private >
+ * g_variant_serialiser_offset_size:
+ * @body_size: the size of the children of a variable-sized container,
+ *   including the padding between them
+ * @n_offsets: the number of framing offsets that follow the children
+ *
+ * Determines the size of each framing offset at the end of a container
+ * in normal form.  This is for writers that produce a container
+ * piecewise and only know the size of its body once all of the children
+ * have been written.
+ *
+ * Returns: the size of each framing offset, in bytes
+ */
+guint
+g_variant_serialiser_offset_size (gsize body_size,
+                                  gsize n_offsets)
+{
+  return gvs_get_offset_size (gvs_calculate_total_size (body_size, n_offsets));
+}
+
+/* < private >
+ * g_variant_serialiser_write_offset:
+ * @data: where to write the framing offset
+ * @offset: the framing offset
+ * @offset_size: the size of the offset, from
+ *   g_variant_serialiser_offset_size()
+ *
+ * Writes a single framing offset in little endian, unaligned.
+ */
+void
+g_variant_serialiser_write_offset (guchar *data,
+                                   gsize   offset,
+                                   guint   offset_size)
+{
+  gvs_write_unaligned_le (data, offset, offset_size);
+}
+
 static gsize
 gvs_variable_sized_array_n_children (GVariantSerialised value)
 {
@@ -711,6 +748,103 @@ gvs_variable_sized_array_get_child (GVariantSerialised value,
   return child;
 }
 
+/* Always inlined so that each caller below gets a copy specialised for
+ * a constant @offset_size, turning the reads into plain loads that the
+ * compiler is free to vectorise.
+ */
+G_ALWAYS_INLINE
+static inline void
+gvs_variable_sized_array_decode_offsets (guchar  *offsets,
+                                         guint    offset_size,
+                                         gsize    n_children,
+                                         guint    alignment,
+                                         gsize    last_end,
+                                         guint32 *ranges)
+{
+  gsize prev_end = 0;
+  gsize i;
+
+  for (i = 0; i < n_children; i++)
+    {
+      gsize start = prev_end + ((-prev_end) & alignment);
+      gsize end = gvs_read_unaligned_le (offsets + offset_size * i,
+                                         offset_size);
+      gboolean valid = start < end && end <= last_end;
+
+      ranges[2 * i] = valid ? start : 0;
+      ranges[2 * i + 1] = valid ? end : 0;
+      prev_end = end;
+    }
+}
+
+/* < private >
+ * g_variant_serialised_get_child_ranges:
+ * @serialised: a #GVariantSerialised for an array of a variable-sized
+ *   type, at most %G_MAXUINT32 bytes in size
+ * @ranges: room for two #guint32 per child of @serialised
+ *
+ * Decodes all of the framing offsets of @serialised in one pass,
+ * storing the start and end of child `i` at `ranges[2 * i]` and
+ * `ranges[2 * i + 1]`.  These are exactly the bounds that
+ * g_variant_serialised_get_child() would find for the child; for
+ * children that it would return as empty (including those with invalid
+ * framing offsets) both are 0.
+ *
+ * This is for callers that are going to visit most of the children of a
+ * large array and want to avoid decoding and checking the offsets one
+ * child at a time.
+ */
+void
+g_variant_serialised_get_child_ranges (GVariantSerialised  serialised,
+                                       guint32            *ranges)
+{
+  GVariantTypeInfo *element;
+  guint alignment;
+  gsize fixed_size;
+  gsize n_children;
+  guint offset_size;
+  gsize last_end;
+  guchar *offsets;
+
+  g_assert (g_variant_serialised_check (serialised));
+  g_assert (g_variant_type_info_get_type_char (serialised.type_info) ==
+            G_VARIANT_TYPE_INFO_CHAR_ARRAY);
+  g_assert (serialised.size <= G_MAXUINT32);
+
+  element = g_variant_type_info_element (serialised.type_info);
+  g_variant_type_info_query (element, &alignment, &fixed_size);
+  g_assert (fixed_size == 0);
+
+  n_children = gvs_variable_sized_array_n_children (serialised);
+  if (n_children == 0)
+    return;
+
+  offset_size = gvs_get_offset_size (serialised.size);
+  last_end = serialised.size - offset_size * n_children;
+  offsets = serialised.data + last_end;
+
+  switch (offset_size)
+    {
+    case 1:
+      gvs_variable_sized_array_decode_offsets (offsets, 1, n_children,
+                                               alignment, last_end, ranges);
+      break;
+
+    case 2:
+      gvs_variable_sized_array_decode_offsets (offsets, 2, n_children,
+                                               alignment, last_end, ranges);
+      break;
+
+    case 4:
+      gvs_variable_sized_array_decode_offsets (offsets, 4, n_children,
+                                               alignment, last_end, ranges);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+}
+
 static gsize
 gvs_variable_sized_array_needed_size (GVariantTypeInfo         *type_info,
                                       GVariantSerialisedFiller  gvs_filler,
@@ -39,6 +39,9 @@ gsize                           g_variant_serialised_n_children         (GVarian
 GLIB_AVAILABLE_IN_ALL
 GVariantSerialised              g_variant_serialised_get_child          (GVariantSerialised        container,
                                                                          gsize                     index);
+GLIB_AVAILABLE_IN_ALL
+void                            g_variant_serialised_get_child_ranges   (GVariantSerialised        container,
+                                                                         guint32                  *ranges);
 
 /* serialization */
 typedef void                  (*GVariantSerialisedFiller)               (GVariantSerialised       *serialised,
@@ -56,6 +59,14 @@ void                            g_variant_serialiser_serialise          (GVarian
                                                                          const gpointer           *children,
                                                                          gsize                     n_children);
 
+GLIB_AVAILABLE_IN_ALL
+guint                           g_variant_serialiser_offset_size        (gsize                     body_size,
+                                                                         gsize                     n_offsets);
+GLIB_AVAILABLE_IN_ALL
+void                            g_variant_serialiser_write_offset       (guchar                   *data,
+                                                                         gsize                     offset,
+                                                                         guint                     offset_size);
+
 /* misc */
 GLIB_AVAILABLE_IN_2_60
 gboolean                        g_variant_serialised_check              (GVariantSerialised        serialised);
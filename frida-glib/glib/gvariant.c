@@ -3151,6 +3151,22 @@ g_variant_iter_next_value (GVariantIter *iter)
  * access it from more than one thread.
  **/
 
+/* The buffer that a serialising builder and the subcontainers opened in
+ * it write their children to.  The end offsets of the variable-sized
+ * children of each open container are kept on a stack next to it until
+ * the container is closed and they are written out as framing offsets.
+ */
+struct serialised_buffer
+{
+  guchar *data;
+  gsize size;
+  gsize allocated;
+
+  gsize *offsets;
+  gsize n_offsets;
+  gsize allocated_offsets;
+};
+
 struct stack_builder
 {
   GVariantBuilder *parent;
@@ -3184,6 +3200,16 @@ struct stack_builder
    */
   guint trusted : 1;
 
+  /* for serialising builders, the buffer that children are written to
+   * as they are added (shared with the subcontainers opened inside this
+   * one), where this container starts in it and where its framing
+   * offsets start on the buffer's offset stack.  'children' is unused.
+   */
+  struct serialised_buffer *buffer;
+  GVariantTypeInfo *type_info;
+  gsize start;
+  gsize offsets_start;
+
   gsize magic;
 };
 
@@ -3249,6 +3275,122 @@ ensure_valid_builder (GVariantBuilder *builder)
   g_return_val_if_fail (valid_builder, val);                       \
 } G_STMT_END
 
+static guchar *
+serialised_buffer_grow (struct serialised_buffer *buffer,
+                        gsize                     size)
+{
+  guchar *data;
+
+  if (buffer->allocated - buffer->size < size)
+    {
+      buffer->allocated = MAX (MAX (buffer->allocated * 2, buffer->size + size), 64);
+      buffer->data = g_realloc (buffer->data, buffer->allocated);
+    }
+
+  data = buffer->data + buffer->size;
+  buffer->size += size;
+
+  return data;
+}
+
+/* @alignment is one less than the alignment, as from
+ * g_variant_type_info_query().  Containers are aligned in the buffer
+ * as a whole, so aligning within the buffer is the same as aligning
+ * within the container.
+ */
+static void
+serialised_buffer_align (struct serialised_buffer *buffer,
+                         guint                     alignment)
+{
+  gsize padding = -buffer->size & alignment;
+
+  if (padding)
+    memset (serialised_buffer_grow (buffer, padding), 0, padding);
+}
+
+static void
+serialised_buffer_push_offset (struct serialised_buffer *buffer,
+                               gsize                     offset)
+{
+  if (buffer->n_offsets == buffer->allocated_offsets)
+    {
+      buffer->allocated_offsets = MAX (buffer->allocated_offsets * 2, 16);
+      buffer->offsets = g_renew (gsize, buffer->offsets, buffer->allocated_offsets);
+    }
+
+  buffer->offsets[buffer->n_offsets++] = offset;
+}
+
+/* Follows the child of a variant with its type string. */
+static void
+serialised_buffer_end_variant (struct serialised_buffer *buffer,
+                               GVariantTypeInfo         *child_info)
+{
+  const gchar *type_string;
+  gsize length;
+  guchar *data;
+
+  type_string = g_variant_type_info_get_type_string (child_info);
+  length = strlen (type_string);
+
+  data = serialised_buffer_grow (buffer, length + 1);
+  data[0] = '\0';
+  memcpy (data + 1, type_string, length);
+}
+
+/* Finishes the container of type @type_info that starts at @start by
+ * padding it to its fixed size or by writing out (and popping) the
+ * framing offsets that were pushed since @offsets_start.
+ */
+static void
+serialised_buffer_end_container (struct serialised_buffer *buffer,
+                                 GVariantTypeInfo         *type_info,
+                                 gsize                     start,
+                                 gsize                     offsets_start)
+{
+  gsize n_offsets = buffer->n_offsets - offsets_start;
+  gsize fixed_size;
+
+  g_variant_type_info_query (type_info, NULL, &fixed_size);
+
+  if (fixed_size)
+    {
+      gsize size = buffer->size - start;
+
+      g_assert (n_offsets == 0);
+
+      if (size < fixed_size)
+        memset (serialised_buffer_grow (buffer, fixed_size - size), 0, fixed_size - size);
+    }
+  else if (n_offsets)
+    {
+      gboolean is_array;
+      guint offset_size;
+      guchar *data;
+      gsize i;
+
+      is_array = g_variant_type_info_get_type_char (type_info) == G_VARIANT_CLASS_ARRAY;
+      offset_size = g_variant_serialiser_offset_size (buffer->size - start, n_offsets);
+      data = serialised_buffer_grow (buffer, n_offsets * offset_size);
+
+      /* arrays list the offsets in order, tuples backwards */
+      for (i = 0; i < n_offsets; i++)
+        g_variant_serialiser_write_offset (data + i * offset_size,
+                                           buffer->offsets[offsets_start + (is_array ? i : n_offsets - 1 - i)],
+                                           offset_size);
+    }
+
+  buffer->n_offsets = offsets_start;
+}
+
+static void
+serialised_buffer_free (struct serialised_buffer *buffer)
+{
+  g_free (buffer->data);
+  g_free (buffer->offsets);
+  g_free (buffer);
+}
+
 /**
  * g_variant_builder_new:
  * @type: a container type
@@ -3365,10 +3507,21 @@ g_variant_builder_clear (GVariantBuilder *builder)
 
   g_variant_type_free (GVSB(builder)->type);
 
-  for (i = 0; i < GVSB(builder)->offset; i++)
-    g_variant_unref (GVSB(builder)->children[i]);
+  if (GVSB(builder)->buffer == NULL)
+    {
+      for (i = 0; i < GVSB(builder)->offset; i++)
+        g_variant_unref (GVSB(builder)->children[i]);
 
-  g_free (GVSB(builder)->children);
+      g_free (GVSB(builder)->children);
+    }
+  else
+    {
+      g_variant_type_info_unref (GVSB(builder)->type_info);
+
+      /* the outermost builder owns the buffer */
+      if (GVSB(builder)->parent == NULL)
+        serialised_buffer_free (GVSB(builder)->buffer);
+    }
 
   if (GVSB(builder)->parent)
     {
@@ -3379,50 +3532,10 @@ g_variant_builder_clear (GVariantBuilder *builder)
   memset (builder, 0, sizeof (GVariantBuilder));
 }
 
-/**
- * g_variant_builder_init: (skip)
- * @builder: a #GVariantBuilder
- * @type: a container type
- *
- * Initialises a #GVariantBuilder structure.
- *
- * @type must be non-%NULL.  It specifies the type of container to
- * construct.  It can be an indefinite type such as
- * %G_VARIANT_TYPE_ARRAY or a definite type such as "as" or "(ii)".
- * Maybe, array, tuple, dictionary entry and variant-typed values may be
- * constructed.
- *
- * After the builder is initialised, values are added using
- * g_variant_builder_add_value() or g_variant_builder_add().
- *
- * After all the child values are added, g_variant_builder_end() frees
- * the memory associated with the builder and returns the #GVariant that
- * was created.
- *
- * This function completely ignores the previous contents of @builder.
- * On one hand this means that it is valid to pass in completely
- * uninitialised memory.  On the other hand, this means that if you are
- * initialising over top of an existing #GVariantBuilder you need to
- * first call g_variant_builder_clear() in order to avoid leaking
- * memory.
- *
- * You must not call g_variant_builder_ref() or
- * g_variant_builder_unref() on a #GVariantBuilder that was initialised
- * with this function.  If you ever pass a reference to a
- * #GVariantBuilder outside of the control of your own code then you
- * should assume that the person receiving that reference may try to use
- * reference counting; you should use g_variant_builder_new() instead of
- * this function.
- *
- * Since: 2.24
- **/
-void
-g_variant_builder_init (GVariantBuilder    *builder,
-                        const GVariantType *type)
+static void
+g_variant_builder_setup (GVariantBuilder    *builder,
+                         const GVariantType *type)
 {
-  g_return_if_fail (type != NULL);
-  g_return_if_fail (g_variant_type_is_container (type));
-
   memset (builder, 0, sizeof (GVariantBuilder));
 
   GVSB(builder)->type = g_variant_type_copy (type);
@@ -3486,6 +3599,53 @@ g_variant_builder_init (GVariantBuilder    *builder,
     default:
       g_assert_not_reached ();
    }
+}
+
+/**
+ * g_variant_builder_init: (skip)
+ * @builder: a #GVariantBuilder
+ * @type: a container type
+ *
+ * Initialises a #GVariantBuilder structure.
+ *
+ * @type must be non-%NULL.  It specifies the type of container to
+ * construct.  It can be an indefinite type such as
+ * %G_VARIANT_TYPE_ARRAY or a definite type such as "as" or "(ii)".
+ * Maybe, array, tuple, dictionary entry and variant-typed values may be
+ * constructed.
+ *
+ * After the builder is initialised, values are added using
+ * g_variant_builder_add_value() or g_variant_builder_add().
+ *
+ * After all the child values are added, g_variant_builder_end() frees
+ * the memory associated with the builder and returns the #GVariant that
+ * was created.
+ *
+ * This function completely ignores the previous contents of @builder.
+ * On one hand this means that it is valid to pass in completely
+ * uninitialised memory.  On the other hand, this means that if you are
+ * initialising over top of an existing #GVariantBuilder you need to
+ * first call g_variant_builder_clear() in order to avoid leaking
+ * memory.
+ *
+ * You must not call g_variant_builder_ref() or
+ * g_variant_builder_unref() on a #GVariantBuilder that was initialised
+ * with this function.  If you ever pass a reference to a
+ * #GVariantBuilder outside of the control of your own code then you
+ * should assume that the person receiving that reference may try to use
+ * reference counting; you should use g_variant_builder_new() instead of
+ * this function.
+ *
+ * Since: 2.24
+ **/
+void
+g_variant_builder_init (GVariantBuilder    *builder,
+                        const GVariantType *type)
+{
+  g_return_if_fail (type != NULL);
+  g_return_if_fail (g_variant_type_is_container (type));
+
+  g_variant_builder_setup (builder, type);
 
 #ifdef G_ANALYZER_ANALYZING
   /* Static analysers can’t couple the code in g_variant_builder_init() to the
@@ -3502,6 +3662,67 @@ g_variant_builder_init (GVariantBuilder    *builder,
 #endif
 }
 
+/* Makes @builder write its children to @buffer, starting at the end. */
+static void
+g_variant_builder_start_serialised (GVariantBuilder          *builder,
+                                    struct serialised_buffer *buffer)
+{
+  guint alignment;
+
+  GVSB(builder)->allocated_children = 0;
+  GVSB(builder)->buffer = buffer;
+  GVSB(builder)->type_info = g_variant_type_info_get (GVSB(builder)->type);
+
+  g_variant_type_info_query (GVSB(builder)->type_info, &alignment, NULL);
+  serialised_buffer_align (buffer, alignment);
+
+  GVSB(builder)->start = buffer->size;
+  GVSB(builder)->offsets_start = buffer->n_offsets;
+}
+
+/**
+ * g_variant_builder_init_serialised: (skip)
+ * @builder: a #GVariantBuilder
+ * @type: a definite container type
+ *
+ * Initialises a #GVariantBuilder structure, like g_variant_builder_init(),
+ * that serialises the container as it is being built.
+ *
+ * A regular builder holds on to a #GVariant instance for every child
+ * that is added until g_variant_builder_end() puts them all in a new
+ * container, and the serialised form is only created later if it is
+ * needed.  A serialising builder instead writes each child straight into
+ * a single growing buffer as it is added, and g_variant_builder_end()
+ * returns a value in serialised form that uses that buffer.  This needs
+ * far less memory and far fewer allocations when building large
+ * containers, and is the better choice when the result is going to be
+ * serialised anyway, for example to be sent over D-Bus or written to a
+ * file.
+ *
+ * Containers opened with g_variant_builder_open() are written into the
+ * same buffer.  The exception are containers of an indefinite type, which
+ * may be opened inside a variant: they are built as with
+ * g_variant_builder_init() and written out when they are closed.  Values added with g_variant_builder_add() using a format
+ * string that only contains basic types, `v`, tuples and dictionary
+ * entries (such as `{sv}`) are written without creating any intermediate
+ * #GVariant instances.
+ *
+ * Unlike g_variant_builder_init(), @type must be a definite type.
+ *
+ * Since: 2.76
+ **/
+void
+g_variant_builder_init_serialised (GVariantBuilder    *builder,
+                                   const GVariantType *type)
+{
+  g_return_if_fail (type != NULL);
+  g_return_if_fail (g_variant_type_is_container (type));
+  g_return_if_fail (g_variant_type_is_definite (type));
+
+  g_variant_builder_setup (builder, type);
+  g_variant_builder_start_serialised (builder, g_new0 (struct serialised_buffer, 1));
+}
+
 static void
 g_variant_builder_make_room (struct stack_builder *builder)
 {
@@ -3513,6 +3734,48 @@ g_variant_builder_make_room (struct stack_builder *builder)
     }
 }
 
+/* Called after the next child of the serialising @builder, of type
+ * @child_info, was written to its buffer.
+ */
+static void
+g_variant_builder_child_written (GVariantBuilder  *builder,
+                                 GVariantTypeInfo *child_info)
+{
+  struct serialised_buffer *buffer = GVSB(builder)->buffer;
+  gsize child_fixed_size;
+
+  g_variant_type_info_query (child_info, NULL, &child_fixed_size);
+
+  switch (g_variant_type_info_get_type_char (GVSB(builder)->type_info))
+    {
+    case G_VARIANT_CLASS_ARRAY:
+      if (!child_fixed_size)
+        serialised_buffer_push_offset (buffer, buffer->size - GVSB(builder)->start);
+      break;
+
+    case G_VARIANT_CLASS_MAYBE:
+      if (!child_fixed_size)
+        *serialised_buffer_grow (buffer, 1) = '\0';
+      break;
+
+    case G_VARIANT_CLASS_VARIANT:
+      serialised_buffer_end_variant (buffer, child_info);
+      break;
+
+    default: /* tuples and dict entries */
+      if (g_variant_type_info_member_info (GVSB(builder)->type_info,
+                                           GVSB(builder)->offset)->ending_type ==
+          G_VARIANT_MEMBER_ENDING_OFFSET)
+        serialised_buffer_push_offset (buffer, buffer->size - GVSB(builder)->start);
+
+      GVSB(builder)->expected_type =
+        g_variant_type_next (GVSB(builder)->expected_type);
+      break;
+    }
+
+  GVSB(builder)->offset++;
+}
+
 /**
  * g_variant_builder_add_value:
  * @builder: a #GVariantBuilder
@@ -3546,6 +3809,27 @@ g_variant_builder_add_value (GVariantBuilder *builder,
 
   GVSB(builder)->trusted &= g_variant_is_trusted (value);
 
+  if (GVSB(builder)->buffer != NULL)
+    {
+      struct serialised_buffer *buffer = GVSB(builder)->buffer;
+      GVariantTypeInfo *type_info;
+      guint alignment;
+      gsize size;
+
+      g_variant_ref_sink (value);
+
+      type_info = g_variant_get_type_info (value);
+      g_variant_type_info_query (type_info, &alignment, NULL);
+      serialised_buffer_align (buffer, alignment);
+
+      size = g_variant_get_size (value);
+      g_variant_store (value, serialised_buffer_grow (buffer, size));
+      g_variant_builder_child_written (builder, type_info);
+
+      g_variant_unref (value);
+      return;
+    }
+
   if (!GVSB(builder)->uniform_item_types)
     {
       /* advance our expected type pointers */
@@ -3626,7 +3910,18 @@ g_variant_builder_open (GVariantBuilder    *builder,
                                                   type));
 
   parent = g_slice_dup (GVariantBuilder, builder);
-  g_variant_builder_init (builder, type);
+
+  /* an indefinite type can only be opened inside a variant; its layout
+   * is not known until it is complete, so build it like a regular
+   * container and write it to the buffer when it is closed */
+  if (GVSB(parent)->buffer != NULL && g_variant_type_is_definite (type))
+    {
+      g_variant_builder_setup (builder, type);
+      g_variant_builder_start_serialised (builder, GVSB(parent)->buffer);
+    }
+  else
+    g_variant_builder_init (builder, type);
+
   GVSB(builder)->parent = parent;
 
   /* push the prev_item_type down into the subcontainer */
@@ -3664,11 +3959,28 @@ g_variant_builder_close (GVariantBuilder *builder)
 
   return_if_invalid_builder (builder);
   g_return_if_fail (GVSB(builder)->parent != NULL);
+  g_return_if_fail (GVSB(builder)->buffer == NULL ||
+                    GVSB(builder)->offset >= GVSB(builder)->min_items);
 
   parent = GVSB(builder)->parent;
   GVSB(builder)->parent = NULL;
 
-  g_variant_builder_add_value (parent, g_variant_builder_end (builder));
+  if (GVSB(builder)->buffer != NULL)
+    {
+      /* the subcontainer is already in place in the buffer */
+      serialised_buffer_end_container (GVSB(builder)->buffer,
+                                       GVSB(builder)->type_info,
+                                       GVSB(builder)->start,
+                                       GVSB(builder)->offsets_start);
+      GVSB(parent)->trusted &= GVSB(builder)->trusted;
+      g_variant_builder_child_written (parent, GVSB(builder)->type_info);
+
+      g_variant_type_info_unref (GVSB(builder)->type_info);
+      g_variant_type_free (GVSB(builder)->type);
+    }
+  else
+    g_variant_builder_add_value (parent, g_variant_builder_end (builder));
+
   *builder = *parent;
 
   g_slice_free (GVariantBuilder, parent);
@@ -3698,6 +4010,39 @@ g_variant_make_array_type (GVariant *element)
   return g_variant_type_new_array (g_variant_get_type (element));
 }
 
+static GVariant *
+g_variant_builder_end_serialised (GVariantBuilder *builder)
+{
+  struct serialised_buffer *buffer = GVSB(builder)->buffer;
+  GVariant *value;
+  GBytes *bytes;
+
+  serialised_buffer_end_container (buffer,
+                                   GVSB(builder)->type_info,
+                                   GVSB(builder)->start,
+                                   GVSB(builder)->offsets_start);
+
+  if (GVSB(builder)->parent == NULL)
+    {
+      /* the outermost container starts at the beginning of the buffer,
+       * so the value can take it over */
+      bytes = g_bytes_new_take (g_realloc (buffer->data, buffer->size),
+                                buffer->size);
+      buffer->data = NULL;
+    }
+  else
+    bytes = g_bytes_new (buffer->data + GVSB(builder)->start,
+                         buffer->size - GVSB(builder)->start);
+
+  value = g_variant_new_from_bytes (GVSB(builder)->type, bytes,
+                                    GVSB(builder)->trusted);
+  g_bytes_unref (bytes);
+
+  g_variant_builder_clear (builder);
+
+  return value;
+}
+
 /**
  * g_variant_builder_end:
  * @builder: a #GVariantBuilder
@@ -3720,6 +4065,9 @@ g_variant_make_array_type (GVariant *element)
  * have been added; in this case it is impossible to infer the type of
  * the empty array.
  *
+ * If @builder was initialised with g_variant_builder_init_serialised(),
+ * the returned value is in serialised form.
+ *
  * Returns: (transfer none): a new, floating, #GVariant
  *
  * Since: 2.24
@@ -3738,6 +4086,9 @@ g_variant_builder_end (GVariantBuilder *builder)
                         g_variant_type_is_definite (GVSB(builder)->type),
                         NULL);
 
+  if (GVSB(builder)->buffer != NULL)
+    return g_variant_builder_end_serialised (builder);
+
   if (g_variant_type_is_definite (GVSB(builder)->type))
     my_type = g_variant_type_copy (GVSB(builder)->type);
 
@@ -5568,6 +5919,165 @@ g_variant_get_va (GVariant     *value,
 
 /* Varargs-enabled Utility Functions {{{1 */
 
+/* Serialising builders write values given with a format string that is
+ * a plain type string of basic types, variants, tuples and dict entries
+ * straight into their buffer, without a GVariant for each of them.
+ */
+static gboolean
+g_variant_builder_can_write_valist (GVariantBuilder *builder,
+                                    const gchar     *format_string)
+{
+  const gchar *c;
+
+  /* anything else is for g_variant_builder_add_value() to complain about */
+  if (!ensure_valid_builder (builder) ||
+      GVSB(builder)->buffer == NULL ||
+      GVSB(builder)->offset >= GVSB(builder)->max_items)
+    return FALSE;
+
+  for (c = format_string; *c != '\0'; c++)
+    if (strchr ("bynqiuxthdsogv(){}", *c) == NULL)
+      return FALSE;
+
+  if (!g_variant_type_string_is_valid (format_string))
+    return FALSE;
+
+  /* only variants have no expected type */
+  return GVSB(builder)->expected_type == NULL ||
+         g_variant_type_equal ((const GVariantType *) format_string,
+                               GVSB(builder)->expected_type);
+}
+
+/* The serialising counterpart of g_variant_valist_new(), for the format
+ * strings accepted by g_variant_builder_can_write_valist().  Returns
+ * %FALSE if an argument was not acceptable, after having consumed any
+ * #GVariant given before it.
+ */
+static gboolean
+serialised_buffer_write_valist (struct serialised_buffer  *buffer,
+                                GVariantTypeInfo          *type_info,
+                                const gchar              **str,
+                                va_list                   *app,
+                                gboolean                  *trusted)
+{
+  guint alignment;
+
+  g_variant_type_info_query (type_info, &alignment, NULL);
+  serialised_buffer_align (buffer, alignment);
+
+  switch (*(*str)++)
+    {
+    case 'b':
+      *serialised_buffer_grow (buffer, 1) = va_arg (*app, gboolean) != FALSE;
+      break;
+
+    case 'y':
+      *serialised_buffer_grow (buffer, 1) = va_arg (*app, guint);
+      break;
+
+    case 'n':
+    case 'q':
+      {
+        guint16 value = va_arg (*app, guint);
+
+        memcpy (serialised_buffer_grow (buffer, sizeof value), &value, sizeof value);
+      }
+      break;
+
+    case 'i':
+    case 'u':
+    case 'h':
+      {
+        guint32 value = va_arg (*app, guint);
+
+        memcpy (serialised_buffer_grow (buffer, sizeof value), &value, sizeof value);
+      }
+      break;
+
+    case 'x':
+    case 't':
+      {
+        guint64 value = va_arg (*app, guint64);
+
+        memcpy (serialised_buffer_grow (buffer, sizeof value), &value, sizeof value);
+      }
+      break;
+
+    case 'd':
+      {
+        gdouble value = va_arg (*app, gdouble);
+
+        memcpy (serialised_buffer_grow (buffer, sizeof value), &value, sizeof value);
+      }
+      break;
+
+    case 's':
+    case 'o':
+    case 'g':
+      {
+        const gchar *string = va_arg (*app, const gchar *);
+        gsize size;
+
+        g_return_val_if_fail (string != NULL, FALSE);
+        g_return_val_if_fail ((*str)[-1] != 's' || g_utf8_validate (string, -1, NULL), FALSE);
+        g_return_val_if_fail ((*str)[-1] != 'o' || g_variant_is_object_path (string), FALSE);
+        g_return_val_if_fail ((*str)[-1] != 'g' || g_variant_is_signature (string), FALSE);
+
+        size = strlen (string) + 1;
+        memcpy (serialised_buffer_grow (buffer, size), string, size);
+      }
+      break;
+
+    case 'v':
+      {
+        GVariant *value = va_arg (*app, GVariant *);
+        gsize size;
+
+        g_return_val_if_fail (value != NULL, FALSE);
+
+        g_variant_ref_sink (value);
+        *trusted &= g_variant_is_trusted (value);
+
+        size = g_variant_get_size (value);
+        g_variant_store (value, serialised_buffer_grow (buffer, size));
+        serialised_buffer_end_variant (buffer, g_variant_get_type_info (value));
+
+        g_variant_unref (value);
+      }
+      break;
+
+    case '(':
+    case '{':
+      {
+        gsize start = buffer->size;
+        gsize offsets_start = buffer->n_offsets;
+        gsize i;
+
+        for (i = 0; **str != ')' && **str != '}'; i++)
+          {
+            const GVariantMemberInfo *member_info;
+
+            member_info = g_variant_type_info_member_info (type_info, i);
+            if (!serialised_buffer_write_valist (buffer, member_info->type_info,
+                                                 str, app, trusted))
+              return FALSE;
+
+            if (member_info->ending_type == G_VARIANT_MEMBER_ENDING_OFFSET)
+              serialised_buffer_push_offset (buffer, buffer->size - start);
+          }
+
+        (*str)++;
+        serialised_buffer_end_container (buffer, type_info, start, offsets_start);
+      }
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  return TRUE;
+}
+
 /**
  * g_variant_builder_add: (skip)
  * @builder: a #GVariantBuilder
@@ -5607,6 +6117,7 @@ g_variant_get_va (GVariant     *value,
  *
  * Since: 2.24
  */
+
 void
 g_variant_builder_add (GVariantBuilder *builder,
                        const gchar     *format_string,
@@ -5615,6 +6126,41 @@ g_variant_builder_add (GVariantBuilder *builder,
   GVariant *variant;
   va_list ap;
 
+  if (g_variant_builder_can_write_valist (builder, format_string))
+    {
+      struct serialised_buffer *buffer = GVSB(builder)->buffer;
+      gsize size = buffer->size;
+      gsize n_offsets = buffer->n_offsets;
+      GVariantTypeInfo *type_info;
+      const gchar *str = format_string;
+      gboolean trusted = TRUE;
+
+      type_info = g_variant_type_info_get ((const GVariantType *) format_string);
+
+      va_start (ap, format_string);
+      if (serialised_buffer_write_valist (buffer, type_info, &str, &ap, &trusted))
+        {
+          GVSB(builder)->trusted &= trusted;
+          g_variant_builder_child_written (builder, type_info);
+        }
+      else
+        {
+          /* The offending argument was already complained about, but say
+           * what became of the value as a whole too.
+           */
+          buffer->size = size;
+          buffer->n_offsets = n_offsets;
+          g_critical ("g_variant_builder_add: a value of type '%s' was "
+                      "not added, as one of its arguments was invalid",
+                      format_string);
+        }
+      va_end (ap);
+
+      g_variant_type_info_unref (type_info);
+
+      return;
+    }
+
   va_start (ap, format_string);
   variant = g_variant_new_va (format_string, NULL, &ap);
   va_end (ap);
@@ -0,0 +1,625 @@
+/*
+ * Copyright © 2026 Ole André Vadla Ravnås <oleavr@frida.re>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gvarianttable.h"
+
+#include <glib/gvariant-internal.h>
+#include <glib/gfileutils.h>
+#include <glib/ghash.h>
+#include <glib/gmappedfile.h>
+#include <glib/grefcount.h>
+#include <glib/gtestutils.h>
+
+#include <string.h>
+
+#include "glibintl.h"
+
+/**
+ * SECTION:gvarianttable
+ * @title: GVariantTable
+ * @short_description: read-only indexed dictionaries of GVariant values
+ * @see_also: #GVariant, #GMappedFile
+ *
+ * A #GVariantTable is a read-only dictionary from strings to values of a
+ * single #GVariant type, kept in a serialized form that is used in
+ * place.  It is meant for large dictionaries that are written once and
+ * then loaded from a file, such as caches: the file is mapped with
+ * #GMappedFile, opening it only reads the few pages that hold its
+ * framing, and looking up a key takes constant time regardless of the
+ * size of the table.
+ *
+ * The data for a table is written by g_variant_table_build() from a
+ * dictionary #GVariant of a type like `a{sv}` or `a{st}`, and can then
+ * be saved to a file with g_file_set_contents().  Tables are loaded with
+ * g_variant_table_new_from_file() or g_variant_table_new_from_bytes().
+ *
+ * Looking up a key with g_variant_table_lookup_data() returns the
+ * serialized data of the value in place, without allocating anything;
+ * g_variant_table_lookup_value() returns it as a #GVariant that shares
+ * the memory of the table.
+ *
+ * The data is itself a serialized #GVariant of type `(tauauv)`.  It holds
+ * a magic number, a hash index of n + 1 bucket boundaries, the hash of
+ * each entry, and the entries themselves as an `a{s*}` dictionary in a
+ * variant, sorted by bucket.  The entries of bucket `b` are those from
+ * index `buckets[b]` up to `buckets[b + 1]`.  Keys are hashed with the
+ * djb2 hash of their bytes, and there is one bucket per entry.
+ *
+ * Like all serialized #GVariant data, tables are stored in the byte
+ * order of the machine that wrote them.  Loading a table written with
+ * the other byte order fails with %G_FILE_ERROR_INVAL.
+ *
+ * Since: 2.76
+ */
+
+/**
+ * GVariantTable:
+ *
+ * An opaque structure representing a loaded table.  It can only be
+ * accessed using the following functions, and is safe to use from
+ * multiple threads at once.
+ *
+ * Since: 2.76
+ */
+
+/* "GVTABLE1" when read in little endian */
+#define G_VARIANT_TABLE_MAGIC G_GUINT64_CONSTANT (0x31454c4241545647)
+
+#define G_VARIANT_TABLE_TYPE ((const GVariantType *) "(tauauv)")
+
+struct _GVariantTable
+{
+  gatomicrefcount ref_count;
+
+  GVariant *buckets_value;
+  GVariant *hashes_value;
+  GVariant *entries;
+  GBytes *entries_bytes;
+
+  const guint32 *buckets;
+  gsize n_buckets;
+  const guint32 *hashes;
+  gsize n_entries;
+
+  GVariantSerialised entries_serialised;
+};
+
+static guint32
+g_variant_table_hash_key (const gchar *key,
+                          gsize       *key_size)
+{
+  const guchar *p = (const guchar *) key;
+  guint32 hash = 5381;
+
+  for (; *p != '\0'; p++)
+    hash = (hash << 5) + hash + *p;
+
+  *key_size = (const gchar *) p - key + 1;
+
+  return hash;
+}
+
+static gboolean
+g_variant_type_is_string_dictionary (const GVariantType *type)
+{
+  const GVariantType *element;
+
+  if (!g_variant_type_is_array (type))
+    return FALSE;
+
+  element = g_variant_type_element (type);
+
+  return g_variant_type_is_dict_entry (element) &&
+         g_variant_type_equal (g_variant_type_key (element),
+                               G_VARIANT_TYPE_STRING);
+}
+
+/**
+ * g_variant_table_build:
+ * @dictionary: a dictionary #GVariant with string keys, such as an
+ *   `a{sv}`
+ *
+ * Writes the data for a #GVariantTable holding the entries of
+ * @dictionary, which can be saved to a file and loaded with
+ * g_variant_table_new_from_file().
+ *
+ * If @dictionary contains the same key more than once, only the first
+ * entry for it is kept, matching g_variant_lookup_value().
+ *
+ * If @dictionary is floating, it is consumed.
+ *
+ * Returns: (transfer full): the data for the table
+ *
+ * Since: 2.76
+ */
+GBytes *
+g_variant_table_build (GVariant *dictionary)
+{
+  GVariantBuilder builder;
+  GVariant **entries;
+  GHashTable *seen;
+  guint32 *hashes;
+  guint32 *sorted_hashes;
+  guint32 *buckets;
+  guint32 *order;
+  gsize n_children;
+  gsize n_entries;
+  gsize n_buckets;
+  GVariant *children[4];
+  GVariant *table;
+  GBytes *bytes;
+  gsize i;
+
+  g_return_val_if_fail (dictionary != NULL, NULL);
+  g_return_val_if_fail (g_variant_type_is_string_dictionary (g_variant_get_type (dictionary)), NULL);
+
+  n_children = g_variant_n_children (dictionary);
+  g_return_val_if_fail (n_children <= G_MAXUINT32, NULL);
+
+  g_variant_ref_sink (dictionary);
+
+  /* drop any repeated keys, keeping the first */
+  entries = g_new (GVariant *, n_children);
+  hashes = g_new (guint32, n_children);
+  seen = g_hash_table_new (g_str_hash, g_str_equal);
+  n_entries = 0;
+
+  for (i = 0; i < n_children; i++)
+    {
+      GVariant *entry;
+      const gchar *key;
+      gsize key_size;
+
+      entry = g_variant_get_child_value (dictionary, i);
+      g_variant_get_child (entry, 0, "&s", &key);
+
+      if (!g_hash_table_add (seen, (gpointer) key))
+        {
+          g_variant_unref (entry);
+          continue;
+        }
+
+      hashes[n_entries] = g_variant_table_hash_key (key, &key_size);
+      entries[n_entries++] = entry;
+    }
+
+  g_hash_table_unref (seen);
+
+  /* sort the entries into their buckets, keeping their order within
+   * each bucket
+   */
+  n_buckets = MAX (n_entries, 1);
+  buckets = g_new0 (guint32, n_buckets + 1);
+
+  for (i = 0; i < n_entries; i++)
+    buckets[hashes[i] % n_buckets + 1]++;
+
+  for (i = 0; i < n_buckets; i++)
+    buckets[i + 1] += buckets[i];
+
+  order = g_new (guint32, n_entries);
+  sorted_hashes = g_new (guint32, n_entries);
+
+  for (i = 0; i < n_entries; i++)
+    {
+      gsize bucket = hashes[i] % n_buckets;
+      gsize position = buckets[bucket]++;
+
+      order[position] = i;
+      sorted_hashes[position] = hashes[i];
+    }
+
+  /* the loop above moved each boundary up to the next one */
+  memmove (buckets + 1, buckets, n_buckets * sizeof (guint32));
+  buckets[0] = 0;
+
+  g_variant_builder_init_serialised (&builder, g_variant_get_type (dictionary));
+  for (i = 0; i < n_entries; i++)
+    g_variant_builder_add_value (&builder, entries[order[i]]);
+
+  children[0] = g_variant_new_uint64 (G_VARIANT_TABLE_MAGIC);
+  children[1] = g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32, buckets,
+                                           n_buckets + 1, sizeof (guint32));
+  children[2] = g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32, sorted_hashes,
+                                           n_entries, sizeof (guint32));
+  children[3] = g_variant_new_variant (g_variant_builder_end (&builder));
+  table = g_variant_ref_sink (g_variant_new_tuple (children, G_N_ELEMENTS (children)));
+  bytes = g_variant_get_data_as_bytes (table);
+
+  g_variant_unref (table);
+  for (i = 0; i < n_entries; i++)
+    g_variant_unref (entries[i]);
+  g_free (sorted_hashes);
+  g_free (order);
+  g_free (buckets);
+  g_free (hashes);
+  g_free (entries);
+  g_variant_unref (dictionary);
+
+  return bytes;
+}
+
+/**
+ * g_variant_table_new_from_bytes:
+ * @bytes: the data for the table, as written by g_variant_table_build()
+ * @error: return location for a #GError, or %NULL
+ *
+ * Loads a #GVariantTable from @bytes, without copying them.
+ *
+ * Only the outer framing of the table is checked here.  The data may
+ * come from an untrusted source: looking up a key in a corrupted table
+ * can give wrong results but is otherwise safe, in the same way as
+ * reading a #GVariant that is not in normal form.
+ *
+ * If @bytes is not a table, or was written on a machine of the other
+ * byte order, %G_FILE_ERROR_INVAL is returned.
+ *
+ * Returns: (transfer full): a new #GVariantTable, or %NULL on error
+ *
+ * Since: 2.76
+ */
+GVariantTable *
+g_variant_table_new_from_bytes (GBytes  *bytes,
+                                GError **error)
+{
+  GVariantTable *table;
+  GVariant *value;
+  GVariant *child;
+  guint64 magic;
+
+  g_return_val_if_fail (bytes != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  value = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TABLE_TYPE, bytes, FALSE));
+
+  child = g_variant_get_child_value (value, 0);
+  magic = g_variant_get_uint64 (child);
+  g_variant_unref (child);
+
+  if (magic != G_VARIANT_TABLE_MAGIC)
+    {
+      if (magic == GUINT64_SWAP_LE_BE (G_VARIANT_TABLE_MAGIC))
+        g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                             _("The table was written with a different byte order"));
+      else
+        g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                             _("The data is not a GVariant table"));
+      g_variant_unref (value);
+      return NULL;
+    }
+
+  table = g_new0 (GVariantTable, 1);
+  g_atomic_ref_count_init (&table->ref_count);
+
+  table->buckets_value = g_variant_get_child_value (value, 1);
+  table->buckets = g_variant_get_fixed_array (table->buckets_value, &table->n_buckets,
+                                              sizeof (guint32));
+  table->hashes_value = g_variant_get_child_value (value, 2);
+  table->hashes = g_variant_get_fixed_array (table->hashes_value, &table->n_entries,
+                                             sizeof (guint32));
+
+  child = g_variant_get_child_value (value, 3);
+  table->entries = g_variant_get_variant (child);
+  g_variant_unref (child);
+  g_variant_unref (value);
+
+  if (table->n_buckets == 0 ||
+      !g_variant_type_is_string_dictionary (g_variant_get_type (table->entries)))
+    {
+      g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                           _("The GVariant table is corrupt"));
+      g_variant_table_unref (table);
+      return NULL;
+    }
+
+  /* one more boundary than there are buckets */
+  table->n_buckets--;
+
+  table->entries_bytes = g_variant_get_data_as_bytes (table->entries);
+  table->entries_serialised.type_info =
+    g_variant_type_info_get (g_variant_get_type (table->entries));
+  table->entries_serialised.data =
+    (guchar *) g_bytes_get_data (table->entries_bytes, &table->entries_serialised.size);
+  table->entries_serialised.depth = 0;
+
+  /* a bucket can never refer past the entries that have hashes */
+  table->n_entries = MIN (table->n_entries,
+                          g_variant_serialised_n_children (table->entries_serialised));
+
+  return table;
+}
+
+/**
+ * g_variant_table_new_from_file:
+ * @filename: (type filename): the path of a file holding a table
+ * @error: return location for a #GError, or %NULL
+ *
+ * Maps @filename into memory with #GMappedFile and loads the table in
+ * it, as g_variant_table_new_from_bytes() does.
+ *
+ * The file must not be modified while the table is in use.  See
+ * g_mapped_file_new().
+ *
+ * Returns: (transfer full): a new #GVariantTable, or %NULL on error
+ *
+ * Since: 2.76
+ */
+GVariantTable *
+g_variant_table_new_from_file (const gchar  *filename,
+                               GError      **error)
+{
+  GVariantTable *table;
+  GMappedFile *file;
+  GBytes *bytes;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  file = g_mapped_file_new (filename, FALSE, error);
+  if (file == NULL)
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (file);
+  table = g_variant_table_new_from_bytes (bytes, error);
+
+  g_bytes_unref (bytes);
+  g_mapped_file_unref (file);
+
+  return table;
+}
+
+/**
+ * g_variant_table_ref:
+ * @table: a #GVariantTable
+ *
+ * Increases the reference count of @table.
+ *
+ * Returns: (transfer full): @table
+ *
+ * Since: 2.76
+ */
+GVariantTable *
+g_variant_table_ref (GVariantTable *table)
+{
+  g_return_val_if_fail (table != NULL, NULL);
+
+  g_atomic_ref_count_inc (&table->ref_count);
+
+  return table;
+}
+
+/**
+ * g_variant_table_unref:
+ * @table: (transfer full): a #GVariantTable
+ *
+ * Decreases the reference count of @table.  When it drops to 0, the
+ * table is freed, along with the mapping of its file.
+ *
+ * Since: 2.76
+ */
+void
+g_variant_table_unref (GVariantTable *table)
+{
+  g_return_if_fail (table != NULL);
+
+  if (!g_atomic_ref_count_dec (&table->ref_count))
+    return;
+
+  if (table->entries_serialised.type_info != NULL)
+    g_variant_type_info_unref (table->entries_serialised.type_info);
+  g_clear_pointer (&table->entries_bytes, g_bytes_unref);
+  g_variant_unref (table->entries);
+  g_variant_unref (table->hashes_value);
+  g_variant_unref (table->buckets_value);
+  g_free (table);
+}
+
+/**
+ * g_variant_table_get_value_type:
+ * @table: a #GVariantTable
+ *
+ * Gets the type of the values in @table.
+ *
+ * Returns: (transfer none): the type of the values
+ *
+ * Since: 2.76
+ */
+const GVariantType *
+g_variant_table_get_value_type (GVariantTable *table)
+{
+  g_return_val_if_fail (table != NULL, NULL);
+
+  return g_variant_type_value (g_variant_type_element (g_variant_get_type (table->entries)));
+}
+
+/**
+ * g_variant_table_get_n_entries:
+ * @table: a #GVariantTable
+ *
+ * Gets the number of entries in @table.
+ *
+ * Returns: the number of entries
+ *
+ * Since: 2.76
+ */
+gsize
+g_variant_table_get_n_entries (GVariantTable *table)
+{
+  g_return_val_if_fail (table != NULL, 0);
+
+  return table->n_entries;
+}
+
+/* Finds the value for @key in the serialized entries.  The caller must
+ * release the type info of @value if this returns %TRUE.
+ */
+static gboolean
+g_variant_table_find (GVariantTable      *table,
+                      const gchar        *key,
+                      GVariantSerialised *value)
+{
+  guint32 hash;
+  gsize key_size;
+  gsize bucket;
+  gsize start;
+  gsize end;
+  gsize i;
+
+  if (table->n_buckets == 0)
+    return FALSE;
+
+  hash = g_variant_table_hash_key (key, &key_size);
+  bucket = hash % table->n_buckets;
+  start = table->buckets[bucket];
+  end = MIN (table->buckets[bucket + 1], table->n_entries);
+
+  for (i = start; i < end; i++)
+    {
+      GVariantSerialised entry;
+      GVariantSerialised entry_key;
+      gboolean found;
+
+      if (table->hashes[i] != hash)
+        continue;
+
+      entry = g_variant_serialised_get_child (table->entries_serialised, i);
+      entry_key = g_variant_serialised_get_child (entry, 0);
+      found = entry_key.size == key_size &&
+              memcmp (entry_key.data, key, key_size) == 0;
+      g_variant_type_info_unref (entry_key.type_info);
+
+      if (found)
+        *value = g_variant_serialised_get_child (entry, 1);
+
+      g_variant_type_info_unref (entry.type_info);
+
+      if (found)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/**
+ * g_variant_table_contains:
+ * @table: a #GVariantTable
+ * @key: the key to look up
+ *
+ * Checks whether @table has an entry for @key.
+ *
+ * Returns: %TRUE if @key is in @table
+ *
+ * Since: 2.76
+ */
+gboolean
+g_variant_table_contains (GVariantTable *table,
+                          const gchar   *key)
+{
+  return g_variant_table_lookup_data (table, key, NULL, NULL);
+}
+
+/**
+ * g_variant_table_lookup_data:
+ * @table: a #GVariantTable
+ * @key: the key to look up
+ * @data: (out) (optional) (transfer none): return location for the
+ *   serialized data of the value
+ * @size: (out) (optional): return location for the size of the value
+ *
+ * Looks up the value for @key in @table, returning its serialized data
+ * in place within the table.  Nothing is copied or allocated, so this is
+ * the cheapest way to read values, for example with
+ * g_variant_new_from_data() or by reading fixed-sized values directly.
+ *
+ * The data remains valid for as long as @table is alive.  As with
+ * g_variant_get_data(), it may be %NULL if @size is 0, or if the value
+ * is of a fixed-sized type and the table is corrupt, in which case
+ * @size zero bytes should be assumed.
+ *
+ * Returns: %TRUE if @key is in @table
+ *
+ * Since: 2.76
+ */
+gboolean
+g_variant_table_lookup_data (GVariantTable  *table,
+                             const gchar    *key,
+                             gconstpointer  *data,
+                             gsize          *size)
+{
+  GVariantSerialised value;
+
+  g_return_val_if_fail (table != NULL, FALSE);
+  g_return_val_if_fail (key != NULL, FALSE);
+
+  if (!g_variant_table_find (table, key, &value))
+    return FALSE;
+
+  g_variant_type_info_unref (value.type_info);
+
+  if (data != NULL)
+    *data = value.data;
+  if (size != NULL)
+    *size = value.size;
+
+  return TRUE;
+}
+
+/**
+ * g_variant_table_lookup_value:
+ * @table: a #GVariantTable
+ * @key: the key to look up
+ *
+ * Looks up the value for @key in @table.  The returned #GVariant shares
+ * its memory with @table and keeps it alive.
+ *
+ * Returns: (transfer full) (nullable): the value, or %NULL if @key is
+ *   not in @table
+ *
+ * Since: 2.76
+ */
+GVariant *
+g_variant_table_lookup_value (GVariantTable *table,
+                              const gchar   *key)
+{
+  GVariantSerialised value;
+  GVariant *result;
+  GBytes *bytes;
+
+  g_return_val_if_fail (table != NULL, NULL);
+  g_return_val_if_fail (key != NULL, NULL);
+
+  if (!g_variant_table_find (table, key, &value))
+    return NULL;
+
+  if (value.data != NULL)
+    bytes = g_bytes_new_from_bytes (table->entries_bytes,
+                                    value.data - table->entries_serialised.data,
+                                    value.size);
+  else
+    bytes = g_bytes_new (NULL, 0);
+
+  result = g_variant_new_from_bytes (g_variant_table_get_value_type (table), bytes, FALSE);
+
+  g_bytes_unref (bytes);
+  g_variant_type_info_unref (value.type_info);
+
+  return g_variant_ref_sink (result);
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2026 Ole André Vadla Ravnås <oleavr@frida.re>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __G_VARIANT_TABLE_H__
+#define __G_VARIANT_TABLE_H__
+
+#if !defined (__GLIB_H_INSIDE__) && !defined (GLIB_COMPILATION)
+#error "Only <glib.h> can be included directly."
+#endif
+
+#include <glib/gbytes.h>
+#include <glib/gerror.h>
+#include <glib/gvariant.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GVariantTable GVariantTable;
+
+GLIB_AVAILABLE_IN_2_76
+GBytes *             g_variant_table_build          (GVariant       *dictionary);
+
+GLIB_AVAILABLE_IN_2_76
+GVariantTable *      g_variant_table_new_from_bytes (GBytes         *bytes,
+                                                     GError        **error);
+GLIB_AVAILABLE_IN_2_76
+GVariantTable *      g_variant_table_new_from_file  (const gchar    *filename,
+                                                     GError        **error);
+GLIB_AVAILABLE_IN_2_76
+GVariantTable *      g_variant_table_ref            (GVariantTable  *table);
+GLIB_AVAILABLE_IN_2_76
+void                 g_variant_table_unref          (GVariantTable  *table);
+
+GLIB_AVAILABLE_IN_2_76
+const GVariantType * g_variant_table_get_value_type (GVariantTable  *table);
+GLIB_AVAILABLE_IN_2_76
+gsize                g_variant_table_get_n_entries  (GVariantTable  *table);
+
+GLIB_AVAILABLE_IN_2_76
+gboolean             g_variant_table_contains       (GVariantTable  *table,
+                                                     const gchar    *key);
+GLIB_AVAILABLE_IN_2_76
+gboolean             g_variant_table_lookup_data    (GVariantTable  *table,
+                                                     const gchar    *key,
+                                                     gconstpointer  *data,
+                                                     gsize          *size);
+GLIB_AVAILABLE_IN_2_76
+GVariant *           g_variant_table_lookup_value   (GVariantTable  *table,
+                                                     const gchar    *key);
+
+G_END_DECLS
+
+#endif /* __G_VARIANT_TABLE_H__ */
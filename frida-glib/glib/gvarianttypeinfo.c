@@ -23,13 +23,17 @@
 #include "config.h"
 
 #include "gvarianttypeinfo.h"
+#include "glib-init.h"
 
 #include <glib/gtestutils.h>
 #include <glib/gthread.h>
 #include <glib/gslice.h>
 #include <glib/ghash.h>
+#include <glib/gstrfuncs.h>
 #include <glib/grefcount.h>
 
+#include <string.h>
+
 /* < private >
  * GVariantTypeInfo:
  *
@@ -73,13 +77,18 @@ struct _GVariantTypeInfo
 
 /* Container types are reference counted.  They also need to have their
  * type string stored explicitly since it is not merely a single letter.
+ *
+ * Pinned containers (see g_variant_type_info_pinned_types) ignore their
+ * reference count and are only freed by glib_deinit().
  */
 typedef struct
 {
   GVariantTypeInfo info;
 
   gchar *type_string;
+  guint hash;
   gatomicrefcount ref_count;
+  gboolean pinned;
 } ContainerInfo;
 
 /* For 'array' and 'maybe' types, we store some extra information on the
@@ -737,8 +746,221 @@ g_variant_type_info_member_info (GVariantTypeInfo *info,
 }
 
 /* == new/ref/unref == */
-static GRecMutex g_variant_type_info_lock;
-static GHashTable *g_variant_type_info_table;
+
+/* Container types that nearly every GVariant user (and all of GDBus)
+ * creates over and over.  Once created they stay around for the lifetime
+ * of the process in a small table that is searched without locking, and
+ * taking and dropping references on them is free.  Element and member
+ * types come before the containers holding them, so that those are
+ * pinned too.
+ */
+static const gchar * const g_variant_type_info_pinned_types[] = {
+  "as", "ay", "av", "ao", "au",
+  "{sv}", "a{sv}", "{ss}", "a{ss}",
+  "(s)", "(u)", "(b)", "(v)", "(o)", "(as)", "(a{sv})", "(sa{sv}as)",
+};
+
+/* Open addressing with linear probing; slots are filled once and only
+ * cleared by glib_deinit(), so readers can probe them without the lock. */
+#define G_VARIANT_TYPE_INFO_N_PINNED_SLOTS 64
+static ContainerInfo *g_variant_type_info_pinned[G_VARIANT_TYPE_INFO_N_PINNED_SLOTS];
+
+G_STATIC_ASSERT (G_N_ELEMENTS (g_variant_type_info_pinned_types) < G_VARIANT_TYPE_INFO_N_PINNED_SLOTS);
+
+/* Other container types live in hash tables spread over a number of
+ * shards, each behind its own lock, so that threads working with
+ * different types do not contend.  Dropping a reference only takes the
+ * lock when it is the last one.
+ */
+#define G_VARIANT_TYPE_INFO_N_SHARDS 16
+
+typedef struct
+{
+  GMutex lock;
+  GHashTable *table;
+} TypeInfoShard;
+
+static TypeInfoShard g_variant_type_info_shards[G_VARIANT_TYPE_INFO_N_SHARDS];
+
+/* The type strings handled here were validated when the GVariantType was
+ * made, and they are not necessarily nul-terminated, so they are measured
+ * and hashed directly rather than through the (checked) GVariantType API.
+ */
+static gsize
+type_string_get_length (const gchar *type_string)
+{
+  gsize index = 0;
+  gint brackets = 0;
+
+  do
+    {
+      while (type_string[index] == 'a' || type_string[index] == 'm')
+        index++;
+
+      if (type_string[index] == '(' || type_string[index] == '{')
+        brackets++;
+
+      else if (type_string[index] == ')' || type_string[index] == '}')
+        brackets--;
+
+      index++;
+    }
+  while (brackets);
+
+  return index;
+}
+
+/* same as g_variant_type_hash() */
+static guint
+type_string_hash (const gchar *type_string,
+                  gsize        length)
+{
+  guint value = 0;
+  gsize i;
+
+  for (i = 0; i < length; i++)
+    value = (value << 5) - value + type_string[i];
+
+  return value;
+}
+
+static gboolean
+container_info_has_type_string (const ContainerInfo *container,
+                                const gchar         *type_string,
+                                gsize                length)
+{
+  return memcmp (container->type_string, type_string, length) == 0 &&
+         container->type_string[length] == '\0';
+}
+
+static guint
+container_info_hash (gconstpointer key)
+{
+  return ((const ContainerInfo *) key)->hash;
+}
+
+static gboolean
+container_info_equal (gconstpointer key1,
+                      gconstpointer key2)
+{
+  const ContainerInfo *container1 = key1;
+  const ContainerInfo *container2 = key2;
+
+  return container_info_has_type_string (container1, container2->type_string,
+                                         type_string_get_length (container2->type_string));
+}
+
+static gboolean
+type_string_is_pinned (const gchar *type_string,
+                       gsize        length)
+{
+  gsize i;
+
+  for (i = 0; i < G_N_ELEMENTS (g_variant_type_info_pinned_types); i++)
+    {
+      const gchar *pinned = g_variant_type_info_pinned_types[i];
+
+      if (strncmp (pinned, type_string, length) == 0 && pinned[length] == '\0')
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static ContainerInfo *
+g_variant_type_info_lookup_pinned (const gchar *type_string,
+                                   gsize        length,
+                                   guint        hash)
+{
+  guint i;
+
+  for (i = 0; i < G_VARIANT_TYPE_INFO_N_PINNED_SLOTS; i++)
+    {
+      ContainerInfo *container;
+
+      container = g_atomic_pointer_get (&g_variant_type_info_pinned[(hash + i) % G_VARIANT_TYPE_INFO_N_PINNED_SLOTS]);
+      if (container == NULL)
+        break;
+
+      if (container->hash == hash && container_info_has_type_string (container, type_string, length))
+        return container;
+    }
+
+  return NULL;
+}
+
+/* Returns @container, or the pinned info another thread made for the
+ * same type first. */
+static ContainerInfo *
+g_variant_type_info_insert_pinned (ContainerInfo *container)
+{
+  gsize length;
+  guint i;
+
+  length = strlen (container->type_string);
+
+  for (i = 0; i < G_VARIANT_TYPE_INFO_N_PINNED_SLOTS; i++)
+    {
+      ContainerInfo **slot;
+      ContainerInfo *other;
+
+      slot = &g_variant_type_info_pinned[(container->hash + i) % G_VARIANT_TYPE_INFO_N_PINNED_SLOTS];
+      if (g_atomic_pointer_compare_and_exchange (slot, NULL, container))
+        return container;
+
+      other = g_atomic_pointer_get (slot);
+      if (other->hash == container->hash &&
+          container_info_has_type_string (other, container->type_string, length))
+        return other;
+    }
+
+  g_assert_not_reached ();
+}
+
+static ContainerInfo *
+container_info_new (const GVariantType *type,
+                    gsize               length,
+                    guint               hash)
+{
+  ContainerInfo *container;
+  char type_char;
+
+  type_char = g_variant_type_peek_string (type)[0];
+
+  if (type_char == G_VARIANT_TYPE_INFO_CHAR_MAYBE ||
+      type_char == G_VARIANT_TYPE_INFO_CHAR_ARRAY)
+    {
+      container = array_info_new (type);
+    }
+  else /* tuple or dict entry */
+    {
+      container = tuple_info_new (type);
+    }
+
+  container->type_string = g_strndup ((const gchar *) type, length);
+  container->hash = hash;
+  g_atomic_ref_count_init (&container->ref_count);
+  container->pinned = type_string_is_pinned (container->type_string, length);
+
+  return container;
+}
+
+static void
+container_info_free (ContainerInfo *container)
+{
+  GVariantTypeInfo *info = (GVariantTypeInfo *) container;
+
+  g_free (container->type_string);
+
+  if (info->container_class == GV_ARRAY_INFO_CLASS)
+    array_info_free (info);
+
+  else if (info->container_class == GV_TUPLE_INFO_CLASS)
+    tuple_info_free (info);
+
+  else
+    g_assert_not_reached ();
+}
 
 /* < private >
  * g_variant_type_info_get:
@@ -765,47 +987,76 @@ g_variant_type_info_get (const GVariantType *type)
       type_char == G_VARIANT_TYPE_INFO_CHAR_TUPLE ||
       type_char == G_VARIANT_TYPE_INFO_CHAR_DICT_ENTRY)
     {
-      GVariantTypeInfo *info;
-      gchar *type_string;
+      const gchar *type_string = (const gchar *) type;
+      ContainerInfo *container, *other;
+      ContainerInfo key;
+      TypeInfoShard *shard;
+      gsize length;
+      guint hash;
+
+      length = type_string_get_length (type_string);
+      hash = type_string_hash (type_string, length);
+
+      container = g_variant_type_info_lookup_pinned (type_string, length, hash);
+      if (container != NULL)
+        return (GVariantTypeInfo *) container;
+
+      shard = &g_variant_type_info_shards[hash % G_VARIANT_TYPE_INFO_N_SHARDS];
+      key.type_string = (gchar *) type_string;
+      key.hash = hash;
+
+      g_mutex_lock (&shard->lock);
+      container = (shard->table != NULL) ? g_hash_table_lookup (shard->table, &key) : NULL;
+      if (container != NULL)
+        g_atomic_ref_count_inc (&container->ref_count);
+      g_mutex_unlock (&shard->lock);
+
+      if (container != NULL)
+        {
+          g_variant_type_info_check ((GVariantTypeInfo *) container, 0);
+          return (GVariantTypeInfo *) container;
+        }
+
+      /* Build the new info without holding the lock, as doing so looks up
+       * the info for each element or member type.
+       */
+      container = container_info_new (type, length, hash);
 
-      type_string = g_variant_type_dup_string (type);
+      if (container->pinned)
+        {
+          ContainerInfo *pinned;
 
-      g_rec_mutex_lock (&g_variant_type_info_lock);
+          pinned = g_variant_type_info_insert_pinned (container);
+          if (pinned != container)
+            container_info_free (container);
 
-      if (g_variant_type_info_table == NULL)
-        g_variant_type_info_table = g_hash_table_new (g_str_hash,
-                                                      g_str_equal);
-      info = g_hash_table_lookup (g_variant_type_info_table, type_string);
+          return (GVariantTypeInfo *) pinned;
+        }
 
-      if (info == NULL)
-        {
-          ContainerInfo *container;
+      g_mutex_lock (&shard->lock);
 
-          if (type_char == G_VARIANT_TYPE_INFO_CHAR_MAYBE ||
-              type_char == G_VARIANT_TYPE_INFO_CHAR_ARRAY)
-            {
-              container = array_info_new (type);
-            }
-          else /* tuple or dict entry */
-            {
-              container = tuple_info_new (type);
-            }
+      if (shard->table == NULL)
+        shard->table = g_hash_table_new (container_info_hash, container_info_equal);
 
-          info = (GVariantTypeInfo *) container;
-          container->type_string = type_string;
-          g_atomic_ref_count_init (&container->ref_count);
+      other = g_hash_table_lookup (shard->table, container);
+      if (other != NULL)
+        {
+          /* another thread got there first */
+          g_atomic_ref_count_inc (&other->ref_count);
+          g_mutex_unlock (&shard->lock);
 
-          g_hash_table_insert (g_variant_type_info_table, type_string, info);
-          type_string = NULL;
+          container_info_free (container);
+          container = other;
         }
       else
-        g_variant_type_info_ref (info);
+        {
+          g_hash_table_add (shard->table, container);
+          g_mutex_unlock (&shard->lock);
+        }
 
-      g_rec_mutex_unlock (&g_variant_type_info_lock);
-      g_variant_type_info_check (info, 0);
-      g_free (type_string);
+      g_variant_type_info_check ((GVariantTypeInfo *) container, 0);
 
-      return info;
+      return (GVariantTypeInfo *) container;
     }
   else
     {
@@ -839,7 +1090,8 @@ g_variant_type_info_ref (GVariantTypeInfo *info)
     {
       ContainerInfo *container = (ContainerInfo *) info;
 
-      g_atomic_ref_count_inc (&container->ref_count);
+      if (!container->pinned)
+        g_atomic_ref_count_inc (&container->ref_count);
     }
 
   return info;
@@ -860,37 +1112,103 @@ g_variant_type_info_unref (GVariantTypeInfo *info)
   if (info->container_class)
     {
       ContainerInfo *container = (ContainerInfo *) info;
+      TypeInfoShard *shard;
+      gint old_ref;
+
+      if (container->pinned)
+        return;
+
+      /* Dropping any but the last reference leaves the entry in the table,
+       * so it can be done without the lock.
+       */
+      old_ref = g_atomic_int_get ((gint *) &container->ref_count);
+      while (old_ref > 1)
+        {
+          if (g_atomic_int_compare_and_exchange_full ((gint *) &container->ref_count,
+                                                      old_ref, old_ref - 1, &old_ref))
+            return;
+        }
 
-      g_rec_mutex_lock (&g_variant_type_info_lock);
+      shard = &g_variant_type_info_shards[container->hash % G_VARIANT_TYPE_INFO_N_SHARDS];
+
+      g_mutex_lock (&shard->lock);
       if (g_atomic_ref_count_dec (&container->ref_count))
         {
-          g_hash_table_remove (g_variant_type_info_table,
-                               container->type_string);
-          if (g_hash_table_size (g_variant_type_info_table) == 0)
+          g_hash_table_remove (shard->table, container);
+          if (g_hash_table_size (shard->table) == 0)
             {
-              g_hash_table_unref (g_variant_type_info_table);
-              g_variant_type_info_table = NULL;
+              g_hash_table_unref (shard->table);
+              shard->table = NULL;
             }
-          g_rec_mutex_unlock (&g_variant_type_info_lock);
-
-          g_free (container->type_string);
+          g_mutex_unlock (&shard->lock);
 
-          if (info->container_class == GV_ARRAY_INFO_CLASS)
-            array_info_free (info);
-
-          else if (info->container_class == GV_TUPLE_INFO_CLASS)
-            tuple_info_free (info);
-
-          else
-            g_assert_not_reached ();
+          container_info_free (container);
         }
       else
-        g_rec_mutex_unlock (&g_variant_type_info_lock);
+        g_mutex_unlock (&shard->lock);
     }
 }
 
+/* Pinned infos are expected to outlive any test, so they are checked
+ * for being what the pinned table should hold rather than for being gone.
+ */
 void
 g_variant_type_info_assert_no_infos (void)
 {
-  g_assert (g_variant_type_info_table == NULL);
+  gsize n_pinned = 0;
+  gsize i;
+
+  for (i = 0; i < G_N_ELEMENTS (g_variant_type_info_shards); i++)
+    g_assert (g_variant_type_info_shards[i].table == NULL);
+
+  for (i = 0; i < G_VARIANT_TYPE_INFO_N_PINNED_SLOTS; i++)
+    {
+      ContainerInfo *container = g_variant_type_info_pinned[i];
+
+      if (container == NULL)
+        continue;
+
+      g_assert (container->pinned);
+      g_assert (type_string_is_pinned (container->type_string,
+                                       strlen (container->type_string)));
+      g_assert (g_atomic_ref_count_compare (&container->ref_count, 1));
+      n_pinned++;
+    }
+
+  g_assert_cmpuint (n_pinned, <=, G_N_ELEMENTS (g_variant_type_info_pinned_types));
+}
+
+void
+_g_variant_type_info_deinit (void)
+{
+  gsize i;
+
+  /* Containers are freed before the element and member types they point
+   * at, which come earlier in g_variant_type_info_pinned_types, as freeing
+   * a container drops (no-op) references on those.
+   */
+  for (i = G_N_ELEMENTS (g_variant_type_info_pinned_types); i-- > 0;)
+    {
+      const gchar *type_string = g_variant_type_info_pinned_types[i];
+      gsize length = strlen (type_string);
+      guint hash = type_string_hash (type_string, length);
+      guint j;
+
+      for (j = 0; j < G_VARIANT_TYPE_INFO_N_PINNED_SLOTS; j++)
+        {
+          ContainerInfo **slot;
+
+          slot = &g_variant_type_info_pinned[(hash + j) % G_VARIANT_TYPE_INFO_N_PINNED_SLOTS];
+          if (*slot != NULL && (*slot)->hash == hash &&
+              container_info_has_type_string (*slot, type_string, length))
+            {
+              container_info_free (*slot);
+              *slot = NULL;
+              break;
+            }
+        }
+    }
+
+  for (i = 0; i < G_VARIANT_TYPE_INFO_N_PINNED_SLOTS; i++)
+    g_assert (g_variant_type_info_pinned[i] == NULL);
 }
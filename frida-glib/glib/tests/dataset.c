@@ -43,6 +43,149 @@ test_quark_string (void)
   g_free (copy);
 }
 
+#define N_QUARK_THREADS 8
+#define N_THREADED_QUARKS 5000
+
+static gint quark_threads_go;
+
+static gpointer
+quark_thread (gpointer data)
+{
+  GQuark *quarks = data;
+  guint i;
+
+  while (!g_atomic_int_get (&quark_threads_go))
+    g_thread_yield ();
+
+  for (i = 0; i < N_THREADED_QUARKS; i++)
+    {
+      gchar name[32];
+
+      g_snprintf (name, sizeof (name), "threaded-quark-%u", i);
+      quarks[i] = g_quark_from_string (name);
+      g_assert_cmpuint (g_quark_try_string (name), ==, quarks[i]);
+    }
+
+  return NULL;
+}
+
+/* Creating the same quarks from several threads at once, enough of them to
+ * grow the table while other threads are looking them up */
+static void
+test_quark_threaded (void)
+{
+  GThread *threads[N_QUARK_THREADS];
+  GQuark *quarks[N_QUARK_THREADS];
+  guint i, j;
+
+  g_atomic_int_set (&quark_threads_go, 0);
+
+  for (i = 0; i < N_QUARK_THREADS; i++)
+    {
+      quarks[i] = g_new0 (GQuark, N_THREADED_QUARKS);
+      threads[i] = g_thread_new ("quark", quark_thread, quarks[i]);
+    }
+
+  g_atomic_int_set (&quark_threads_go, 1);
+
+  for (i = 0; i < N_QUARK_THREADS; i++)
+    g_thread_join (threads[i]);
+
+  for (j = 0; j < N_THREADED_QUARKS; j++)
+    {
+      gchar name[32];
+
+      g_snprintf (name, sizeof (name), "threaded-quark-%u", j);
+      g_assert_cmpstr (g_quark_to_string (quarks[0][j]), ==, name);
+
+      for (i = 1; i < N_QUARK_THREADS; i++)
+        g_assert_cmpuint (quarks[i][j], ==, quarks[0][j]);
+    }
+
+  for (i = 0; i < N_QUARK_THREADS; i++)
+    g_free (quarks[i]);
+}
+
+static const gchar *perf_quark_names[] = {
+  "notify", "destroy", "changed", "activate", "clicked", "g-properties-changed",
+  "g-signal", "closed", "GLib-GIO", "g-dbus-error-quark", "g-io-error-quark",
+  "g-file-error-quark", "gobject-signal-handlers", "GObject-toggle-references",
+  "GObject-weak-references", "GObject-closure-array",
+};
+
+static guint perf_quark_count_to;
+
+static gpointer
+quark_perf_thread (gpointer data)
+{
+  gboolean try_string = GPOINTER_TO_INT (data);
+  guint i, j;
+
+  while (!g_atomic_int_get (&quark_threads_go))
+    g_thread_yield ();
+
+  for (i = 0; i < perf_quark_count_to; i++)
+    for (j = 0; j < G_N_ELEMENTS (perf_quark_names); j++)
+      {
+        GQuark quark;
+
+        if (try_string)
+          quark = g_quark_try_string (perf_quark_names[j]);
+        else
+          quark = g_quark_from_static_string (perf_quark_names[j]);
+        g_assert (quark != 0);
+      }
+
+  return NULL;
+}
+
+static void
+test_quark_perf (guint    n_threads,
+                 gboolean try_string)
+{
+  GThread **threads;
+  gint64 start_time;
+  gdouble rate;
+  guint i;
+
+  perf_quark_count_to = g_test_perf () ? 1000000 : 1;
+
+  for (i = 0; i < G_N_ELEMENTS (perf_quark_names); i++)
+    g_quark_from_static_string (perf_quark_names[i]);
+
+  g_atomic_int_set (&quark_threads_go, 0);
+
+  threads = g_new (GThread *, n_threads);
+  for (i = 0; i < n_threads; i++)
+    threads[i] = g_thread_new ("quark-perf", quark_perf_thread, GINT_TO_POINTER (try_string));
+
+  /* avoid measuring thread setup time */
+  start_time = g_get_monotonic_time ();
+  g_atomic_int_set (&quark_threads_go, 1);
+
+  for (i = 0; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  rate = g_get_monotonic_time () - start_time;
+  rate = (gdouble) n_threads * perf_quark_count_to * G_N_ELEMENTS (perf_quark_names) / MAX (rate, 1);
+
+  g_test_maximized_result (rate, "%f million lookups per second with %u threads", rate, n_threads);
+
+  g_free (threads);
+}
+
+static void
+test_quark_perf_from_static_string (gconstpointer data)
+{
+  test_quark_perf (GPOINTER_TO_UINT (data), FALSE);
+}
+
+static void
+test_quark_perf_try_string (gconstpointer data)
+{
+  test_quark_perf (GPOINTER_TO_UINT (data), TRUE);
+}
+
 static void
 test_dataset_basic (void)
 {
@@ -326,6 +469,22 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/quark/basic", test_quark_basic);
   g_test_add_func ("/quark/string", test_quark_string);
+  g_test_add_func ("/quark/threaded", test_quark_threaded);
+
+    {
+      guint n_threads;
+
+      for (n_threads = 1; n_threads <= 32; n_threads *= 2)
+        {
+          gchar name[80];
+
+          g_snprintf (name, sizeof (name), "/quark/perf/from-static-string/%u", n_threads);
+          g_test_add_data_func (name, GUINT_TO_POINTER (n_threads), test_quark_perf_from_static_string);
+          g_snprintf (name, sizeof (name), "/quark/perf/try-string/%u", n_threads);
+          g_test_add_data_func (name, GUINT_TO_POINTER (n_threads), test_quark_perf_try_string);
+        }
+    }
+
   g_test_add_func ("/dataset/basic", test_dataset_basic);
   g_test_add_func ("/dataset/id", test_dataset_id);
   g_test_add_func ("/dataset/full", test_dataset_full);
@@ -0,0 +1,292 @@
+/* GLib testing framework examples and tests
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#endif
+
+/* Cost of repeatedly initialising and tearing down GLib in the same process,
+ * the way an agent gets injected into and unloaded from a long-lived host.
+ * Each cycle calls glib_init(), spins up a worker thread with its own main
+ * context, and measures the latency until the first request round-trips
+ * through it, then measures glib_deinit(). Run with `-m perf` for meaningful
+ * numbers; in the default mode only a few cycles are run so the test
+ * doubles as a smoke test for in-process reinitialisation.
+ *
+ * The cycles run in a subprocess, as all memory GLib holds is released on
+ * deinit, including what the test framework itself allocated. Results are
+ * printed as TAP comments from there.
+ */
+
+static gint n_mallocs;
+static gint n_frees;
+
+static gpointer
+counting_malloc (gsize n_bytes)
+{
+  g_atomic_int_inc (&n_mallocs);
+  return malloc (n_bytes);
+}
+
+static gpointer
+counting_realloc (gpointer mem,
+                  gsize    n_bytes)
+{
+  if (mem == NULL)
+    g_atomic_int_inc (&n_mallocs);
+  return realloc (mem, n_bytes);
+}
+
+static gpointer
+counting_calloc (gsize n_blocks,
+                 gsize n_block_bytes)
+{
+  g_atomic_int_inc (&n_mallocs);
+  return calloc (n_blocks, n_block_bytes);
+}
+
+static void
+counting_free (gpointer mem)
+{
+  if (mem != NULL)
+    g_atomic_int_inc (&n_frees);
+  free (mem);
+}
+
+static GMemVTable counting_vtable = {
+  counting_malloc,
+  counting_realloc,
+  NULL,
+  counting_free,
+  counting_calloc,
+  NULL,
+  NULL,
+};
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+#define N_REQUEST_NAMES 100
+
+typedef struct
+{
+  GMainContext *context;
+  GMainLoop *loop;
+  GThread *thread;
+} Agent;
+
+typedef struct
+{
+  GMainContext *caller;
+  GQuark last_name;
+  gsize n_properties;
+  gboolean replied;
+} Request;
+
+static void
+invoke_in_context (GMainContext *context,
+                   GSourceFunc   func,
+                   gpointer      data)
+{
+  GSource *source;
+
+  /* Not g_main_context_invoke(), as that runs @func right away whenever
+   * the calling thread manages to acquire @context. */
+  source = g_idle_source_new ();
+  g_source_set_callback (source, func, data, NULL);
+  g_source_attach (source, context);
+  g_source_unref (source);
+}
+
+static gpointer
+agent_thread (gpointer data)
+{
+  Agent *agent = data;
+
+  g_main_context_push_thread_default (agent->context);
+  g_main_loop_run (agent->loop);
+  g_main_context_pop_thread_default (agent->context);
+
+  return NULL;
+}
+
+static gboolean
+deliver_reply (gpointer data)
+{
+  Request *request = data;
+
+  request->replied = TRUE;
+  g_main_context_wakeup (request->caller);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+handle_request (gpointer data)
+{
+  Request *request = data;
+  GVariantBuilder builder;
+  GVariant *args, *properties;
+  gchar name[32];
+  guint i;
+
+  /* Roughly what dispatching the first call does: intern the names of the
+   * interface, its methods and their arguments, and unpack its arguments. */
+  g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+  for (i = 0; i != N_REQUEST_NAMES; i++)
+    {
+      g_snprintf (name, sizeof (name), "rpc-name-%u", i);
+      request->last_name = g_quark_from_string (name);
+      g_variant_builder_add (&builder, "{sv}", name, g_variant_new_uint32 (i));
+    }
+  args = g_variant_ref_sink (g_variant_new ("(a{sv})", &builder));
+  properties = g_variant_get_child_value (args, 0);
+  request->n_properties = g_variant_n_children (properties);
+  g_variant_unref (properties);
+  g_variant_unref (args);
+
+  invoke_in_context (request->caller, deliver_reply, request);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+stop_agent (gpointer data)
+{
+  Agent *agent = data;
+
+  g_main_loop_quit (agent->loop);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+run_cycle (gint64 *first_rpc_usec,
+           gint64 *deinit_usec,
+           gint   *deinit_frees)
+{
+  Agent agent;
+  Request request = { 0, };
+  gint64 start;
+  gint frees_before;
+
+  start = g_get_monotonic_time ();
+
+  glib_init ();
+
+  agent.context = g_main_context_new ();
+  agent.loop = g_main_loop_new (agent.context, FALSE);
+  agent.thread = g_thread_new ("agent", agent_thread, &agent);
+
+  request.caller = g_main_context_default ();
+  invoke_in_context (agent.context, handle_request, &request);
+  while (!request.replied)
+    g_main_context_iteration (request.caller, TRUE);
+
+  *first_rpc_usec = g_get_monotonic_time () - start;
+
+  g_assert_cmpstr (g_quark_to_string (request.last_name), ==, "rpc-name-99");
+  g_assert_cmpuint (request.n_properties, ==, N_REQUEST_NAMES);
+
+  invoke_in_context (agent.context, stop_agent, &agent);
+  g_thread_join (agent.thread);
+  g_main_loop_unref (agent.loop);
+  g_main_context_unref (agent.context);
+
+  frees_before = g_atomic_int_get (&n_frees);
+  start = g_get_monotonic_time ();
+
+  glib_deinit ();
+
+  *deinit_usec = g_get_monotonic_time () - start;
+  *deinit_frees = g_atomic_int_get (&n_frees) - frees_before;
+}
+
+static void
+test_cycles (void)
+{
+  guint n_cycles;
+  gint64 total_first_rpc = 0, max_first_rpc = 0;
+  gint64 total_deinit = 0, max_deinit = 0;
+  gint total_deinit_frees = 0;
+  gint mallocs_before;
+  guint i;
+
+  if (!g_test_subprocess ())
+    {
+      /* The subprocess doesn't get to see `-m perf` */
+      g_setenv ("DEINIT_PERFORMANCE_CYCLES", g_test_perf () ? "1000" : "10", TRUE);
+      g_test_trap_subprocess (NULL, 0, G_TEST_SUBPROCESS_INHERIT_STDOUT);
+      g_test_trap_assert_passed ();
+      return;
+    }
+
+  n_cycles = atoi (g_getenv ("DEINIT_PERFORMANCE_CYCLES"));
+
+  /* Start from a clean slate, like a freshly injected agent would. */
+  glib_deinit ();
+
+  mallocs_before = g_atomic_int_get (&n_mallocs);
+
+  for (i = 0; i != n_cycles; i++)
+    {
+      gint64 first_rpc, deinit;
+      gint deinit_frees;
+
+      run_cycle (&first_rpc, &deinit, &deinit_frees);
+
+      total_first_rpc += first_rpc;
+      max_first_rpc = MAX (max_first_rpc, first_rpc);
+      total_deinit += deinit;
+      max_deinit = MAX (max_deinit, deinit);
+      total_deinit_frees += deinit_frees;
+    }
+
+  printf ("# %u cycles: inject to first RPC %.1f us avg, %" G_GINT64_FORMAT " us max\n",
+          n_cycles, (gdouble) total_first_rpc / n_cycles, max_first_rpc);
+  printf ("# %u cycles: deinit %.1f us avg, %" G_GINT64_FORMAT " us max, %.1f frees\n",
+          n_cycles, (gdouble) total_deinit / n_cycles, max_deinit,
+          (gdouble) total_deinit_frees / n_cycles);
+  printf ("# %u cycles: %.1f allocations per cycle (G_SLICE=%s)\n",
+          n_cycles, (gdouble) (g_atomic_int_get (&n_mallocs) - mallocs_before) / n_cycles,
+          getenv ("G_SLICE") ? getenv ("G_SLICE") : "");
+  fflush (stdout);
+
+  /* The test framework's own state went away with the first deinit, so
+   * neither return into it nor let its atexit() handler run. */
+  _exit (0);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_mem_set_vtable (&counting_vtable);
+  glib_init ();
+
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/deinit/performance/cycles", test_cycles);
+
+  return g_test_run ();
+}
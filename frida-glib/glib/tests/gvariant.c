@@ -1089,6 +1089,65 @@ test_gvarianttypeinfo (void)
   g_variant_type_info_assert_no_infos ();
 }
 
+#define N_TYPEINFO_THREADS 8
+#define N_TYPEINFO_ITERATIONS 2000
+
+static const gchar *threaded_typeinfo_types[] = {
+  "a{sv}", "as", "(s)", "(sa{sv}as)", "aa{sv}", "a(sv)", "(ii)", "a{s(ii)}",
+  "m(sa{sv})", "{ya(ii)}", "((s)(u))", "aay", "a(oa{sa{sv}})",
+};
+
+static gint typeinfo_threads_go;
+
+static gpointer
+typeinfo_thread (gpointer data)
+{
+  guint i, j;
+
+  while (!g_atomic_int_get (&typeinfo_threads_go))
+    g_thread_yield ();
+
+  for (i = 0; i < N_TYPEINFO_ITERATIONS; i++)
+    {
+      GVariantTypeInfo *infos[G_N_ELEMENTS (threaded_typeinfo_types)];
+
+      for (j = 0; j < G_N_ELEMENTS (threaded_typeinfo_types); j++)
+        {
+          infos[j] = g_variant_type_info_get (G_VARIANT_TYPE (threaded_typeinfo_types[j]));
+          g_assert_cmpstr (g_variant_type_info_get_type_string (infos[j]), ==,
+                           threaded_typeinfo_types[j]);
+        }
+
+      /* drop them in a different order than they were taken, so that
+       * last references go away while other threads look the types up */
+      for (j = 0; j < G_N_ELEMENTS (threaded_typeinfo_types); j++)
+        g_variant_type_info_unref (infos[(j + i) % G_N_ELEMENTS (threaded_typeinfo_types)]);
+    }
+
+  return NULL;
+}
+
+/* Taking and dropping the last references to the same container types
+ * from several threads at once */
+static void
+test_gvarianttypeinfo_threaded (void)
+{
+  GThread *threads[N_TYPEINFO_THREADS];
+  guint i;
+
+  g_atomic_int_set (&typeinfo_threads_go, 0);
+
+  for (i = 0; i < N_TYPEINFO_THREADS; i++)
+    threads[i] = g_thread_new ("typeinfo", typeinfo_thread, NULL);
+
+  g_atomic_int_set (&typeinfo_threads_go, 1);
+
+  for (i = 0; i < N_TYPEINFO_THREADS; i++)
+    g_thread_join (threads[i]);
+
+  g_variant_type_info_assert_no_infos ();
+}
+
 #define MAX_FIXED_MULTIPLIER    256
 #define MAX_INSTANCE_SIZE       1024
 #define MAX_ARRAY_CHILDREN      128
@@ -2341,6 +2400,130 @@ test_serialiser_children (void)
   g_variant_type_free (mv_type);
 }
 
+static void
+check_child_ranges (const GVariantType *type,
+                    guchar             *data,
+                    gsize               size)
+{
+  GVariantSerialised serialised = { NULL, data, size, 0 };
+  GVariant *value;
+  const guchar *value_data;
+  guint32 *ranges;
+  gsize n_children;
+  gsize i;
+
+  serialised.type_info = g_variant_type_info_get (type);
+  n_children = g_variant_serialised_n_children (serialised);
+  ranges = g_new (guint32, 2 * n_children);
+  g_variant_serialised_get_child_ranges (serialised, ranges);
+
+  value = g_variant_ref_sink (g_variant_new_from_data (type, data, size, FALSE, NULL, NULL));
+  value_data = g_variant_get_data (value);
+  g_assert_cmpuint (g_variant_n_children (value), ==, n_children);
+
+  for (i = 0; i < n_children; i++)
+    {
+      GVariantSerialised child;
+      GVariant *child_value;
+
+      child = g_variant_serialised_get_child (serialised, i);
+      if (child.data != NULL)
+        {
+          g_assert_cmpuint (ranges[2 * i], ==, child.data - data);
+          g_assert_cmpuint (ranges[2 * i + 1], ==, child.data - data + child.size);
+        }
+      else
+        {
+          g_assert_cmpuint (child.size, ==, 0);
+          g_assert_cmpuint (ranges[2 * i], ==, 0);
+          g_assert_cmpuint (ranges[2 * i + 1], ==, 0);
+        }
+
+      /* the same child, as found through the instance */
+      child_value = g_variant_get_child_value (value, i);
+      g_assert_cmpuint (g_variant_get_size (child_value), ==, child.size);
+      if (child.data != NULL)
+        g_assert_true ((const guchar *) g_variant_get_data (child_value) ==
+                       value_data + (child.data - data));
+      else
+        g_assert_null (g_variant_get_data (child_value));
+      g_variant_unref (child_value);
+
+      /* fetching the first child of a large array only marks it for
+       * decoding; the second one decodes all of the ranges */
+      if (i == 0)
+        g_assert_cmpuint (g_variant_n_children (value), ==, n_children);
+
+      g_variant_type_info_unref (child.type_info);
+    }
+
+  g_assert_cmpuint (g_variant_n_children (value), ==, n_children);
+
+  g_variant_unref (value);
+  g_variant_type_info_unref (serialised.type_info);
+  g_free (ranges);
+}
+
+static void
+test_serialiser_child_ranges (void)
+{
+  const gchar *types[] = { "as", "a(ts)" };
+  const guint lengths[] = { 3, 20, 200, 20000 };
+  gsize i, j;
+
+  g_test_summary ("Test that decoding all of the framing offsets of an "
+                  "array at once finds the same children as decoding "
+                  "them one by one, including for corrupted arrays");
+
+  for (i = 0; i < G_N_ELEMENTS (types); i++)
+    for (j = 0; j < G_N_ELEMENTS (lengths); j++)
+      {
+        const GVariantType *type = G_VARIANT_TYPE (types[i]);
+        GVariantBuilder builder;
+        GVariant *value;
+        guchar *data;
+        gsize size;
+        guint k;
+
+        g_variant_builder_init (&builder, type);
+        for (k = 0; k < lengths[j]; k++)
+          {
+            gchar string[16];
+
+            memset (string, 'x', sizeof string);
+            string[g_test_rand_int_range (0, sizeof string)] = '\0';
+
+            if (i == 0)
+              g_variant_builder_add (&builder, "s", string);
+            else
+              g_variant_builder_add (&builder, "(ts)", (guint64) k, string);
+          }
+        value = g_variant_ref_sink (g_variant_builder_end (&builder));
+        size = g_variant_get_size (value);
+        data = g_memdup2 (g_variant_get_data (value), size);
+        g_variant_unref (value);
+
+        check_child_ranges (type, data, size);
+
+        /* corrupt some of the framing offsets, and then anything */
+        for (k = 0; k < 8; k++)
+          {
+            gsize offset = size - 1 - g_test_rand_int_range (0, MIN (size, 64));
+
+            data[offset] = g_test_rand_int_range (0, 256);
+            check_child_ranges (type, data, size);
+          }
+
+        for (k = 0; k < 8; k++)
+          {
+            data[g_test_rand_int_range (0, size)] = g_test_rand_int_range (0, 256);
+            check_child_ranges (type, data, size);
+          }
+
+        g_free (data);
+      }
+}
+
 static void
 test_fuzz (gdouble *fuzziness)
 {
@@ -2820,6 +3003,227 @@ test_container (void)
   g_free (s1);
 }
 
+static void
+test_serialising_builder_container (void)
+{
+  GVariantBuilder builder;
+  TreeInstance *tree;
+  GVariant *expected;
+  GVariant *value;
+  GVariant *built;
+
+  tree = tree_instance_new (NULL, 3);
+  value = g_variant_ref_sink (tree_instance_get_gvariant (tree));
+
+  /* wrapped in a variant, to also cover non-container values */
+  expected = g_variant_ref_sink (g_variant_new_variant (value));
+
+  g_variant_builder_init_serialised (&builder, G_VARIANT_TYPE_VARIANT);
+  tree_instance_build_gvariant (tree, &builder, FALSE);
+  built = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  g_assert_true (g_variant_equal (built, expected));
+  g_assert_cmpmem (g_variant_get_data (built), g_variant_get_size (built),
+                   g_variant_get_data (expected), g_variant_get_size (expected));
+  g_assert_true (g_variant_is_normal_form (built));
+  g_variant_unref (built);
+
+  if (g_variant_is_container (value))
+    {
+      GVariantIter iter;
+      gsize i;
+
+      g_variant_builder_init_serialised (&builder, g_variant_get_type (value));
+      for (i = 0; i < tree->n_children; i++)
+        tree_instance_build_gvariant (tree->children[i], &builder, FALSE);
+      built = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+      g_assert_cmpmem (g_variant_get_data (built), g_variant_get_size (built),
+                       g_variant_get_data (value), g_variant_get_size (value));
+
+      g_variant_iter_init (&iter, built);
+      for (i = 0; i < tree->n_children; i++)
+        {
+          GVariant *child = g_variant_iter_next_value (&iter);
+
+          g_assert_true (tree_instance_check_gvariant (tree->children[i], child));
+          g_variant_unref (child);
+        }
+      g_assert_null (g_variant_iter_next_value (&iter));
+
+      g_variant_unref (built);
+    }
+
+  tree_instance_free (tree);
+  g_variant_unref (expected);
+  g_variant_unref (value);
+}
+
+static void
+test_serialising_builder_containers (void)
+{
+  gsize i;
+
+  for (i = 0; i < 100; i++)
+    test_serialising_builder_container ();
+
+  g_variant_type_info_assert_no_infos ();
+}
+
+static GVariant *
+build_with_varargs (void (*init) (GVariantBuilder *, const GVariantType *))
+{
+  GVariantBuilder builder;
+  guint i;
+
+  init (&builder, G_VARIANT_TYPE ("(a{sv}a(ybnqiuxthd)(sog){s(iv)}()vms)"));
+
+  /* enough entries for two-byte framing offsets */
+  g_variant_builder_open (&builder, G_VARIANT_TYPE_VARDICT);
+  for (i = 0; i < 300; i++)
+    {
+      gchar key[16];
+
+      g_snprintf (key, sizeof key, "key%u", i);
+      g_variant_builder_add (&builder, "{sv}", key,
+                             (i & 1) ? g_variant_new_int32 (i) : g_variant_new_string (key));
+    }
+  g_variant_builder_close (&builder);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(ybnqiuxthd)"));
+  for (i = 0; i < 3; i++)
+    g_variant_builder_add (&builder, "(ybnqiuxthd)",
+                           (guchar) i, (gboolean) (i & 1), (gint16) -i, (guint16) i,
+                           (gint32) -i, (guint32) i, (gint64) -i, (guint64) i,
+                           (gint32) i, i / 3.0);
+  g_variant_builder_close (&builder);
+
+  g_variant_builder_add (&builder, "(sog)", "hello", "/org/gtk/test", "a{sv}");
+  g_variant_builder_add (&builder, "{s(iv)}", "key", 42,
+                         g_variant_new_parsed ("[1, 2, 3]"));
+  g_variant_builder_add (&builder, "()");
+  g_variant_builder_add_value (&builder,
+                               g_variant_new_variant (g_variant_new_uint64 (7)));
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("ms"));
+  g_variant_builder_add (&builder, "s", "just");
+  g_variant_builder_close (&builder);
+
+  return g_variant_builder_end (&builder);
+}
+
+static GVariant *
+build_with_indefinite_types (void (*init) (GVariantBuilder *, const GVariantType *))
+{
+  GVariantBuilder builder;
+
+  init (&builder, G_VARIANT_TYPE ("(vav)"));
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE_VARIANT);
+  g_variant_builder_open (&builder, G_VARIANT_TYPE_ARRAY);
+  g_variant_builder_open (&builder, G_VARIANT_TYPE_TUPLE);
+  g_variant_builder_add (&builder, "s", "one");
+  g_variant_builder_add (&builder, "u", 1);
+  g_variant_builder_close (&builder);
+  g_variant_builder_add (&builder, "(su)", "two", 2);
+  g_variant_builder_close (&builder);
+  g_variant_builder_close (&builder);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("av"));
+  g_variant_builder_open (&builder, G_VARIANT_TYPE_VARIANT);
+  g_variant_builder_open (&builder, G_VARIANT_TYPE_MAYBE);
+  g_variant_builder_add (&builder, "x", G_GINT64_CONSTANT (-3));
+  g_variant_builder_close (&builder);
+  g_variant_builder_close (&builder);
+  g_variant_builder_open (&builder, G_VARIANT_TYPE_VARIANT);
+  g_variant_builder_open (&builder, G_VARIANT_TYPE_DICT_ENTRY);
+  g_variant_builder_add (&builder, "s", "key");
+  g_variant_builder_add (&builder, "b", TRUE);
+  g_variant_builder_close (&builder);
+  g_variant_builder_close (&builder);
+  g_variant_builder_close (&builder);
+
+  return g_variant_builder_end (&builder);
+}
+
+static void
+test_serialising_builder_varargs (void)
+{
+  GVariantBuilder builder;
+  GVariant *expected;
+  GVariant *value;
+
+  expected = g_variant_ref_sink (build_with_varargs (g_variant_builder_init));
+  value = g_variant_ref_sink (build_with_varargs (g_variant_builder_init_serialised));
+
+  g_assert_true (g_variant_equal (value, expected));
+  g_assert_cmpmem (g_variant_get_data (value), g_variant_get_size (value),
+                   g_variant_get_data (expected), g_variant_get_size (expected));
+  g_assert_true (g_variant_is_normal_form (value));
+
+  g_variant_unref (value);
+  g_variant_unref (expected);
+
+  /* containers of indefinite types can be opened inside a variant */
+  expected = g_variant_ref_sink (build_with_indefinite_types (g_variant_builder_init));
+  value = g_variant_ref_sink (build_with_indefinite_types (g_variant_builder_init_serialised));
+
+  g_assert_true (g_variant_equal (value, expected));
+  g_assert_cmpmem (g_variant_get_data (value), g_variant_get_size (value),
+                   g_variant_get_data (expected), g_variant_get_size (expected));
+  g_assert_true (g_variant_is_normal_form (value));
+
+  g_variant_unref (value);
+  g_variant_unref (expected);
+
+  /* any true gboolean is stored as 1 */
+  g_variant_builder_init_serialised (&builder, G_VARIANT_TYPE ("a(bb)"));
+  g_variant_builder_add (&builder, "(bb)", (gboolean) 2, (gboolean) -1);
+  value = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  expected = g_variant_ref_sink (g_variant_new_parsed ("[(true, true)]"));
+  g_assert_true (g_variant_is_normal_form (value));
+  g_assert_cmpmem (g_variant_get_data (value), g_variant_get_size (value),
+                   g_variant_get_data (expected), g_variant_get_size (expected));
+
+  g_variant_unref (value);
+  g_variant_unref (expected);
+
+  if (g_test_undefined ())
+    {
+      /* a rejected value is reported and leaves nothing behind */
+      g_variant_builder_init_serialised (&builder, G_VARIANT_TYPE ("a(so)"));
+      g_variant_builder_add (&builder, "(so)", "a", "/a");
+      g_test_expect_message ("GLib", G_LOG_LEVEL_CRITICAL, "*g_variant_is_object_path*");
+      g_test_expect_message ("GLib", G_LOG_LEVEL_CRITICAL, "*type '(so)' was not added*");
+      g_variant_builder_add (&builder, "(so)", "b", "not a path");
+      g_test_assert_expected_messages ();
+      g_variant_builder_add (&builder, "(so)", "c", "/c");
+      value = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+      expected = g_variant_ref_sink (g_variant_new_parsed ("[('a', objectpath '/a'), ('c', '/c')]"));
+      g_assert_cmpmem (g_variant_get_data (value), g_variant_get_size (value),
+                       g_variant_get_data (expected), g_variant_get_size (expected));
+
+      g_variant_unref (value);
+      g_variant_unref (expected);
+    }
+
+  /* clearing part-way through */
+  g_variant_builder_init_serialised (&builder, G_VARIANT_TYPE ("aas"));
+  g_variant_builder_open (&builder, G_VARIANT_TYPE_STRING_ARRAY);
+  g_variant_builder_add (&builder, "s", "some value");
+  g_variant_builder_clear (&builder);
+
+  g_variant_builder_init_serialised (&builder, G_VARIANT_TYPE ("av"));
+  g_variant_builder_open (&builder, G_VARIANT_TYPE_VARIANT);
+  g_variant_builder_open (&builder, G_VARIANT_TYPE_ARRAY);
+  g_variant_builder_add (&builder, "s", "some value");
+  g_variant_builder_clear (&builder);
+
+  g_variant_type_info_assert_no_infos ();
+}
+
 static void
 test_string (void)
 {
@@ -5159,6 +5563,195 @@ test_unaligned_construction (void)
     }
 }
 
+static guint perf_containers_count_to;
+static gint perf_containers_go;
+
+static gpointer
+perf_containers_thread (gpointer data)
+{
+  gboolean use_parser = GPOINTER_TO_INT (data);
+  guint i;
+
+  while (!g_atomic_int_get (&perf_containers_go))
+    g_thread_yield ();
+
+  for (i = 0; i < perf_containers_count_to; i++)
+    {
+      GVariant *value;
+
+      if (use_parser)
+        {
+          value = g_variant_new_parsed ("('org.gtk.Test', {'Name': <'test'>, 'Count': <%u>}, @as [])", i);
+        }
+      else
+        {
+          GVariantBuilder builder;
+
+          g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+          g_variant_builder_add (&builder, "{sv}", "Name", g_variant_new_string ("test"));
+          g_variant_builder_add (&builder, "{sv}", "Count", g_variant_new_uint32 (i));
+          value = g_variant_new ("(sa{sv}as)", "org.gtk.Test", &builder, NULL);
+        }
+
+      g_variant_unref (g_variant_ref_sink (value));
+    }
+
+  return NULL;
+}
+
+/* Building a GDBus-style PropertiesChanged body from several threads at
+ * once, which mostly exercises the GVariantTypeInfo lookups */
+static void
+test_perf_containers (gconstpointer data)
+{
+  guint n_threads = GPOINTER_TO_UINT (data) & 0xff;
+  gboolean use_parser = (GPOINTER_TO_UINT (data) & 0x100) != 0;
+  GThread **threads;
+  gint64 start_time;
+  gdouble rate;
+  guint i;
+
+  perf_containers_count_to = g_test_perf () ? 200000 : 100;
+
+  g_atomic_int_set (&perf_containers_go, 0);
+
+  threads = g_new (GThread *, n_threads);
+  for (i = 0; i < n_threads; i++)
+    threads[i] = g_thread_new ("containers-perf", perf_containers_thread, GINT_TO_POINTER (use_parser));
+
+  /* avoid measuring thread setup time */
+  start_time = g_get_monotonic_time ();
+  g_atomic_int_set (&perf_containers_go, 1);
+
+  for (i = 0; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  rate = g_get_monotonic_time () - start_time;
+  rate = (gdouble) n_threads * perf_containers_count_to / MAX (rate, 1);
+
+  g_test_maximized_result (rate, "%f million values per second with %u threads", rate, n_threads);
+
+  g_free (threads);
+  g_variant_type_info_assert_no_infos ();
+}
+
+static GVariant *
+perf_build_dict (void  (*init) (GVariantBuilder *, const GVariantType *),
+                 guint   n_entries)
+{
+  GVariantBuilder builder;
+  guint i;
+
+  init (&builder, G_VARIANT_TYPE_VARDICT);
+  for (i = 0; i < n_entries; i++)
+    {
+      gchar key[16];
+
+      g_snprintf (key, sizeof key, "key%u", i);
+      g_variant_builder_add (&builder, "{sv}", key, g_variant_new_uint32 (i));
+    }
+
+  return g_variant_builder_end (&builder);
+}
+
+static GVariant *
+perf_build_array (void  (*init) (GVariantBuilder *, const GVariantType *),
+                  guint   n_entries)
+{
+  GVariantBuilder builder;
+  guint i;
+
+  init (&builder, G_VARIANT_TYPE ("a(sux)"));
+  for (i = 0; i < n_entries; i++)
+    g_variant_builder_add (&builder, "(sux)", "entry", i, (gint64) i);
+
+  return g_variant_builder_end (&builder);
+}
+
+/* Building a large container and serialising it, with a regular and with
+ * a serialising builder */
+static void
+test_perf_serialising_builder (gconstpointer data)
+{
+  GVariant * (*build) (void (*) (GVariantBuilder *, const GVariantType *), guint) = data;
+  guint n_entries = g_test_perf () ? 1000000 : 1000;
+  GVariant *values[2];
+  gdouble rates[2];
+  guint i;
+
+  for (i = 0; i < 2; i++)
+    {
+      gint64 start_time;
+
+      start_time = g_get_monotonic_time ();
+      values[i] = g_variant_ref_sink (build (i ? g_variant_builder_init_serialised :
+                                                 g_variant_builder_init,
+                                             n_entries));
+      g_variant_get_data (values[i]);
+      rates[i] = (gdouble) n_entries / MAX (g_get_monotonic_time () - start_time, 1);
+    }
+
+  g_assert_true (g_variant_equal (values[0], values[1]));
+
+  g_test_message ("%f million entries per second with a regular builder", rates[0]);
+  g_test_maximized_result (rates[1], "%f million entries per second with a serialising builder", rates[1]);
+
+  g_variant_unref (values[0]);
+  g_variant_unref (values[1]);
+}
+
+/* Iterating over all of the children of a large string array loaded from
+ * untrusted data, as a D-Bus message or a file would be */
+static void
+test_perf_iterate_strv (void)
+{
+  guint n_children = g_test_perf () ? 1000000 : 1000;
+  GVariantBuilder builder;
+  GVariant *value;
+  GVariantIter iter;
+  const gchar *string;
+  const gchar **strv;
+  gchar expected[32];
+  GBytes *bytes;
+  gint64 start_time;
+  gdouble rate;
+  gsize length;
+  guint i;
+
+  g_variant_builder_init_serialised (&builder, G_VARIANT_TYPE_STRING_ARRAY);
+  for (i = 0; i < n_children; i++)
+    {
+      g_snprintf (expected, sizeof expected, "string%u", i);
+      g_variant_builder_add (&builder, "s", expected);
+    }
+  value = g_variant_ref_sink (g_variant_builder_end (&builder));
+  bytes = g_variant_get_data_as_bytes (value);
+  g_variant_unref (value);
+
+  value = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE_STRING_ARRAY, bytes, FALSE));
+  start_time = g_get_monotonic_time ();
+  strv = g_variant_get_strv (value, &length);
+  rate = (gdouble) n_children / MAX (g_get_monotonic_time () - start_time, 1);
+  g_assert_cmpuint (length, ==, n_children);
+  g_assert_cmpstr (strv[n_children - 1], ==, expected);
+  g_free (strv);
+  g_variant_unref (value);
+  g_test_message ("%f million children per second with g_variant_get_strv()", rate);
+
+  value = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE_STRING_ARRAY, bytes, FALSE));
+  start_time = g_get_monotonic_time ();
+  g_variant_iter_init (&iter, value);
+  for (i = 0; g_variant_iter_next (&iter, "&s", &string); i++)
+    ;
+  rate = (gdouble) n_children / MAX (g_get_monotonic_time () - start_time, 1);
+  g_assert_cmpuint (i, ==, n_children);
+  g_variant_unref (value);
+
+  g_test_maximized_result (rate, "%f million children per second with g_variant_iter_next()", rate);
+
+  g_bytes_unref (bytes);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -5172,6 +5765,7 @@ main (int argc, char **argv)
   g_test_add_func ("/gvariant/type/string-scan/recursion/array",
                    test_gvarianttype_string_scan_recursion_array);
   g_test_add_func ("/gvariant/typeinfo", test_gvarianttypeinfo);
+  g_test_add_func ("/gvariant/typeinfo/threaded", test_gvarianttypeinfo_threaded);
   g_test_add_func ("/gvariant/serialiser/maybe", test_maybes);
   g_test_add_func ("/gvariant/serialiser/array", test_arrays);
   g_test_add_func ("/gvariant/serialiser/tuple", test_tuples);
@@ -5179,6 +5773,7 @@ main (int argc, char **argv)
   g_test_add_func ("/gvariant/serialiser/strings", test_strings);
   g_test_add_func ("/gvariant/serialiser/byteswap", test_byteswaps);
   g_test_add_func ("/gvariant/serialiser/children", test_serialiser_children);
+  g_test_add_func ("/gvariant/serialiser/child-ranges", test_serialiser_child_ranges);
 
   for (i = 1; i <= 20; i += 4)
     {
@@ -5199,6 +5794,8 @@ main (int argc, char **argv)
   g_test_add_func ("/gvariant/varargs/subprocess/empty-array", test_varargs_empty_array);
   g_test_add_func ("/gvariant/valist", test_valist);
   g_test_add_func ("/gvariant/builder-memory", test_builder_memory);
+  g_test_add_func ("/gvariant/serialising-builder/containers", test_serialising_builder_containers);
+  g_test_add_func ("/gvariant/serialising-builder/varargs", test_serialising_builder_varargs);
   g_test_add_func ("/gvariant/hashing", test_hashing);
   g_test_add_func ("/gvariant/byteswap", test_gv_byteswap);
   g_test_add_func ("/gvariant/parser", test_parses);
@@ -5246,5 +5843,19 @@ main (int argc, char **argv)
   g_test_add_func ("/gvariant/unaligned-construction",
                    test_unaligned_construction);
 
+  for (i = 1; i <= 32; i *= 2)
+    {
+      gchar name[80];
+
+      g_snprintf (name, sizeof (name), "/gvariant/perf/builder/%u", i);
+      g_test_add_data_func (name, GUINT_TO_POINTER (i), test_perf_containers);
+      g_snprintf (name, sizeof (name), "/gvariant/perf/new-parsed/%u", i);
+      g_test_add_data_func (name, GUINT_TO_POINTER (i | 0x100), test_perf_containers);
+    }
+
+  g_test_add_data_func ("/gvariant/perf/serialising-builder/dict", perf_build_dict, test_perf_serialising_builder);
+  g_test_add_data_func ("/gvariant/perf/serialising-builder/array", perf_build_array, test_perf_serialising_builder);
+  g_test_add_func ("/gvariant/perf/iterate/strv", test_perf_iterate_strv);
+
   return g_test_run ();
 }
@@ -0,0 +1,448 @@
+/*
+ * Copyright © 2026 Ole André Vadla Ravnås <oleavr@frida.re>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+static GVariant *
+make_dictionary (guint n_entries)
+{
+  GVariantBuilder builder;
+  guint i;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{st}"));
+  for (i = 0; i < n_entries; i++)
+    {
+      gchar key[32];
+
+      g_snprintf (key, sizeof key, "symbol%u", i);
+      g_variant_builder_add (&builder, "{st}", key, (guint64) i * 16);
+    }
+
+  return g_variant_builder_end (&builder);
+}
+
+static void
+test_lookup (void)
+{
+  GVariantTable *table;
+  GError *error = NULL;
+  GBytes *bytes;
+  guint i;
+
+  bytes = g_variant_table_build (make_dictionary (1000));
+  table = g_variant_table_new_from_bytes (bytes, &error);
+  g_assert_no_error (error);
+  g_bytes_unref (bytes);
+
+  g_assert_cmpuint (g_variant_table_get_n_entries (table), ==, 1000);
+  g_assert_true (g_variant_type_equal (g_variant_table_get_value_type (table),
+                                       G_VARIANT_TYPE_UINT64));
+
+  for (i = 0; i < 1000; i++)
+    {
+      gchar key[32];
+      gconstpointer data;
+      gsize size;
+      guint64 offset;
+      GVariant *value;
+
+      g_snprintf (key, sizeof key, "symbol%u", i);
+      g_assert_true (g_variant_table_contains (table, key));
+
+      g_assert_true (g_variant_table_lookup_data (table, key, &data, &size));
+      g_assert_cmpuint (size, ==, sizeof offset);
+      memcpy (&offset, data, sizeof offset);
+      g_assert_cmpuint (offset, ==, (guint64) i * 16);
+
+      value = g_variant_table_lookup_value (table, key);
+      g_assert_cmpuint (g_variant_get_uint64 (value), ==, (guint64) i * 16);
+      g_assert_true (g_variant_get_data (value) == data);
+      g_variant_unref (value);
+
+      g_snprintf (key, sizeof key, "symbol%u", i + 1000);
+      g_assert_false (g_variant_table_contains (table, key));
+      g_assert_null (g_variant_table_lookup_value (table, key));
+    }
+
+  g_assert_false (g_variant_table_contains (table, ""));
+  g_assert_false (g_variant_table_contains (table, "symbol"));
+
+  g_variant_table_unref (table);
+}
+
+static void
+test_values (void)
+{
+  GVariantTable *table;
+  GVariantBuilder builder;
+  GVariant *dictionary;
+  GError *error = NULL;
+  GBytes *bytes;
+  GVariantIter iter;
+  const gchar *key;
+  GVariant *expected;
+
+  g_test_summary ("Test values of various types, empty keys and repeated keys");
+
+  dictionary = g_variant_ref_sink (g_variant_new_parsed ("{'': <'empty key'>,"
+                                                         " 'string': <''>,"
+                                                         " 'byte': <byte 0x2a>,"
+                                                         " 'array': <[1, 2, 3]>,"
+                                                         " 'nested': <{'a': <(1, 'b')>}>,"
+                                                         " 'unit': <()>}"));
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+  g_variant_builder_add_parsed (&builder, "{'unit', <'not the first'>}");
+  g_variant_iter_init (&iter, dictionary);
+  while (g_variant_iter_loop (&iter, "@{sv}", &expected))
+    g_variant_builder_add_value (&builder, expected);
+  bytes = g_variant_table_build (g_variant_builder_end (&builder));
+
+  table = g_variant_table_new_from_bytes (bytes, &error);
+  g_assert_no_error (error);
+  g_bytes_unref (bytes);
+
+  /* the first 'unit' wins */
+  g_assert_cmpuint (g_variant_table_get_n_entries (table), ==, 6);
+
+  g_variant_iter_init (&iter, dictionary);
+  while (g_variant_iter_loop (&iter, "{&sv}", &key, &expected))
+    {
+      GVariant *value;
+      GVariant *inner;
+      gconstpointer data;
+      gsize size;
+
+      value = g_variant_table_lookup_value (table, key);
+      inner = g_variant_get_variant (value);
+
+      if (g_str_equal (key, "unit"))
+        g_assert_cmpstr (g_variant_get_string (inner, NULL), ==, "not the first");
+      else
+        g_assert_cmpvariant (inner, expected);
+
+      g_assert_true (g_variant_table_lookup_data (table, key, &data, &size));
+      g_assert_cmpmem (data, size, g_variant_get_data (value), g_variant_get_size (value));
+
+      g_variant_unref (inner);
+      g_variant_unref (value);
+    }
+
+  g_variant_table_unref (table);
+  g_variant_unref (dictionary);
+}
+
+static void
+test_empty (void)
+{
+  GVariantTable *table;
+  GError *error = NULL;
+  GBytes *bytes;
+
+  bytes = g_variant_table_build (g_variant_new_parsed ("@a{sv} {}"));
+  table = g_variant_table_new_from_bytes (bytes, &error);
+  g_assert_no_error (error);
+  g_bytes_unref (bytes);
+
+  g_assert_cmpuint (g_variant_table_get_n_entries (table), ==, 0);
+  g_assert_false (g_variant_table_contains (table, ""));
+  g_assert_false (g_variant_table_contains (table, "key"));
+
+  g_variant_table_unref (table);
+}
+
+static void
+test_file (void)
+{
+  GVariantTable *table;
+  GError *error = NULL;
+  GBytes *bytes;
+  gchar *filename;
+  GVariant *value;
+  gint fd;
+
+  fd = g_file_open_tmp ("gvarianttable-XXXXXX", &filename, &error);
+  g_assert_no_error (error);
+  g_close (fd, NULL);
+
+  bytes = g_variant_table_build (make_dictionary (100));
+  g_file_set_contents (filename, g_bytes_get_data (bytes, NULL),
+                       g_bytes_get_size (bytes), &error);
+  g_assert_no_error (error);
+  g_bytes_unref (bytes);
+
+  table = g_variant_table_new_from_file (filename, &error);
+  g_assert_no_error (error);
+
+  /* the mapping stays alive for as long as the value */
+  value = g_variant_table_lookup_value (table, "symbol42");
+  g_variant_table_unref (table);
+  g_assert_cmpuint (g_variant_get_uint64 (value), ==, 42 * 16);
+  g_variant_unref (value);
+
+  g_unlink (filename);
+
+  table = g_variant_table_new_from_file (filename, &error);
+  g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT);
+  g_assert_null (table);
+  g_clear_error (&error);
+
+  g_free (filename);
+}
+
+static void
+test_invalid (void)
+{
+  GVariantTable *table;
+  GError *error = NULL;
+  GVariant *value;
+  GBytes *bytes;
+
+  bytes = g_bytes_new (NULL, 0);
+  table = g_variant_table_new_from_bytes (bytes, &error);
+  g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL);
+  g_assert_null (table);
+  g_clear_error (&error);
+  g_bytes_unref (bytes);
+
+  /* "GVTABLE1" in the other byte order */
+  value = g_variant_ref_sink (g_variant_new_parsed ("(%t, @au [0], @au [], <@a{sv} {}>)",
+                                                    GUINT64_SWAP_LE_BE (G_GUINT64_CONSTANT (0x31454c4241545647))));
+  bytes = g_variant_get_data_as_bytes (value);
+  table = g_variant_table_new_from_bytes (bytes, &error);
+  g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL);
+  g_assert_null (table);
+  g_clear_error (&error);
+  g_bytes_unref (bytes);
+  g_variant_unref (value);
+
+  /* entries that are not a dictionary with string keys */
+  value = g_variant_ref_sink (g_variant_new_parsed ("(%t, @au [0], @au [], <@a{uv} {}>)",
+                                                    G_GUINT64_CONSTANT (0x31454c4241545647)));
+  bytes = g_variant_get_data_as_bytes (value);
+  table = g_variant_table_new_from_bytes (bytes, &error);
+  g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL);
+  g_assert_null (table);
+  g_clear_error (&error);
+  g_bytes_unref (bytes);
+  g_variant_unref (value);
+
+  /* no bucket boundaries at all */
+  value = g_variant_ref_sink (g_variant_new_parsed ("(%t, @au [], @au [], <@a{sv} {}>)",
+                                                    G_GUINT64_CONSTANT (0x31454c4241545647)));
+  bytes = g_variant_get_data_as_bytes (value);
+  table = g_variant_table_new_from_bytes (bytes, &error);
+  g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL);
+  g_assert_null (table);
+  g_clear_error (&error);
+  g_bytes_unref (bytes);
+  g_variant_unref (value);
+}
+
+static void
+test_corrupt (void)
+{
+  GBytes *bytes;
+  guchar *data;
+  gsize size;
+  guint i;
+
+  g_test_summary ("Test that looking up keys in corrupted tables is safe");
+
+  bytes = g_variant_table_build (make_dictionary (200));
+  data = g_bytes_unref_to_data (bytes, &size);
+
+  for (i = 0; i < 1000; i++)
+    {
+      GVariantTable *table;
+      guchar *copy;
+      guint j;
+
+      copy = g_memdup2 (data, size);
+      for (j = 0; j < 8; j++)
+        copy[g_test_rand_int_range (0, size)] = g_test_rand_int_range (0, 256);
+
+      bytes = g_bytes_new_take (copy, size);
+      table = g_variant_table_new_from_bytes (bytes, NULL);
+      g_bytes_unref (bytes);
+
+      if (table == NULL)
+        continue;
+
+      for (j = 0; j < 200; j++)
+        {
+          gchar key[32];
+          GVariant *value;
+
+          g_snprintf (key, sizeof key, "symbol%u", j);
+          value = g_variant_table_lookup_value (table, key);
+          if (value != NULL)
+            {
+              g_variant_get_uint64 (value);
+              g_variant_unref (value);
+            }
+        }
+
+      g_variant_table_unref (table);
+    }
+
+  g_free (data);
+}
+
+static gsize
+get_rss (void)
+{
+#ifdef __linux__
+  gchar *contents;
+  gsize resident = 0;
+
+  if (g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+    {
+      gchar **fields = g_strsplit (contents, " ", 3);
+
+      if (g_strv_length (fields) >= 2)
+        resident = g_ascii_strtoull (fields[1], NULL, 10) * sysconf (_SC_PAGESIZE);
+
+      g_strfreev (fields);
+      g_free (contents);
+    }
+
+  return resident;
+#else
+  return 0;
+#endif
+}
+
+/* Opening a large table from a file and looking up random keys in it,
+ * compared with looking them up in the same dictionary mapped as a
+ * plain GVariant */
+static void
+test_perf (void)
+{
+  guint n_entries = g_test_perf () ? 1000000 : 1000;
+  guint n_lookups = g_test_perf () ? 1000000 : 1000;
+  guint n_linear_lookups = g_test_perf () ? 10 : 100;
+  GVariantTable *table;
+  GVariant *dictionary;
+  GMappedFile *file;
+  GError *error = NULL;
+  GBytes *bytes;
+  gchar *filename;
+  gint64 start_time;
+  gdouble open_time;
+  gdouble rate;
+  gsize rss_before;
+  gsize rss_opened;
+  gsize rss_after;
+  guint i;
+  gint fd;
+
+  fd = g_file_open_tmp ("gvarianttable-XXXXXX", &filename, &error);
+  g_assert_no_error (error);
+  g_close (fd, NULL);
+
+  dictionary = g_variant_ref_sink (make_dictionary (n_entries));
+  bytes = g_variant_table_build (g_variant_ref (dictionary));
+  g_file_set_contents (filename, g_bytes_get_data (bytes, NULL),
+                       g_bytes_get_size (bytes), &error);
+  g_assert_no_error (error);
+  g_test_message ("%" G_GSIZE_FORMAT " bytes for %u entries",
+                  g_bytes_get_size (bytes), n_entries);
+  g_bytes_unref (bytes);
+
+  rss_before = get_rss ();
+  start_time = g_get_monotonic_time ();
+  table = g_variant_table_new_from_file (filename, &error);
+  open_time = g_get_monotonic_time () - start_time;
+  g_assert_no_error (error);
+  rss_opened = get_rss ();
+  g_test_message ("%f ms and %" G_GSIZE_FORMAT " KiB of RSS growth to open the table",
+                  open_time / 1000.0, (rss_opened - MIN (rss_before, rss_opened)) / 1024);
+
+  start_time = g_get_monotonic_time ();
+  for (i = 0; i < n_lookups; i++)
+    {
+      gchar key[32];
+      gconstpointer data;
+
+      g_snprintf (key, sizeof key, "symbol%u", g_test_rand_int_range (0, n_entries));
+      g_assert_true (g_variant_table_lookup_data (table, key, &data, NULL));
+    }
+  rate = (gdouble) n_lookups / MAX (g_get_monotonic_time () - start_time, 1);
+  rss_after = get_rss ();
+  g_test_message ("%" G_GSIZE_FORMAT " KiB of RSS growth after %u random lookups",
+                  (rss_after - MIN (rss_opened, rss_after)) / 1024, n_lookups);
+  g_variant_table_unref (table);
+
+  /* the same dictionary as a plain GVariant file */
+  g_file_set_contents (filename, g_variant_get_data (dictionary),
+                       g_variant_get_size (dictionary), &error);
+  g_assert_no_error (error);
+
+  file = g_mapped_file_new (filename, FALSE, &error);
+  g_assert_no_error (error);
+  bytes = g_mapped_file_get_bytes (file);
+  g_variant_unref (dictionary);
+  dictionary = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE ("a{st}"), bytes, FALSE));
+
+  start_time = g_get_monotonic_time ();
+  for (i = 0; i < n_linear_lookups; i++)
+    {
+      gchar key[32];
+      GVariant *value;
+
+      g_snprintf (key, sizeof key, "symbol%u", g_test_rand_int_range (0, n_entries));
+      value = g_variant_lookup_value (dictionary, key, NULL);
+      g_assert_nonnull (value);
+      g_variant_unref (value);
+    }
+  g_test_message ("%f million lookups per second with g_variant_lookup_value()",
+                  (gdouble) n_linear_lookups / MAX (g_get_monotonic_time () - start_time, 1));
+
+  g_test_maximized_result (rate, "%f million lookups per second with g_variant_table_lookup_data()", rate);
+
+  g_variant_unref (dictionary);
+  g_bytes_unref (bytes);
+  g_mapped_file_unref (file);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/gvariant-table/lookup", test_lookup);
+  g_test_add_func ("/gvariant-table/values", test_values);
+  g_test_add_func ("/gvariant-table/empty", test_empty);
+  g_test_add_func ("/gvariant-table/file", test_file);
+  g_test_add_func ("/gvariant-table/invalid", test_invalid);
+  g_test_add_func ("/gvariant-table/corrupt", test_corrupt);
+  g_test_add_func ("/gvariant-table/perf", test_perf);
+
+  return g_test_run ();
+}
@@ -1660,6 +1660,291 @@ test_unix_fd_priority (void)
   close (fd2);
 }
 
+static GSource *
+attach_flag_fd_source (GMainContext *context,
+                       gint          fd,
+                       GIOCondition  events,
+                       gboolean     *flag)
+{
+  GSource *source;
+
+  source = g_unix_fd_source_new (fd, events);
+  g_source_set_callback (source, G_SOURCE_FUNC (flag_bool), flag, NULL);
+  g_source_attach (source, context);
+
+  return source;
+}
+
+/* Sources attached to a G_MAIN_CONTEXT_FLAGS_EPOLL context must see the same
+ * events as with poll(2), including fds epoll can't watch. */
+static void
+test_epoll_context (void)
+{
+  GSourceFuncs no_funcs = {
+    NULL, NULL, return_true, NULL, NULL, NULL
+  };
+  GMainContext *context;
+  GSource *in_source, *in_source2, *modify_source, *file_source;
+  gboolean in = FALSE, in2 = FALSE, file = FALSE;
+  gpointer tag;
+  gint fds[2];
+  gint file_fd;
+  gchar c = 'x';
+
+  context = g_main_context_new_with_flags (G_MAIN_CONTEXT_FLAGS_EPOLL);
+  g_assert_cmpint (pipe (fds), ==, 0);
+
+  in_source = attach_flag_fd_source (context, fds[0], G_IO_IN, &in);
+  while (g_main_context_iteration (context, FALSE));
+  g_assert_false (in);
+
+  /* two sources watching the same fd */
+  in_source2 = attach_flag_fd_source (context, fds[0], G_IO_IN, &in2);
+  g_assert_cmpint (write (fds[1], &c, 1), ==, 1);
+  g_assert_true (g_main_context_iteration (context, FALSE));
+  g_assert_true (in && in2);
+
+  /* the fd stays registered for the remaining source */
+  in = in2 = FALSE;
+  g_source_destroy (in_source2);
+  g_source_unref (in_source2);
+  g_assert_true (g_main_context_iteration (context, FALSE));
+  g_assert_true (in && !in2);
+  g_assert_cmpint (read (fds[0], &c, 1), ==, 1);
+
+  in = FALSE;
+  while (g_main_context_iteration (context, FALSE));
+  g_assert_false (in);
+
+  /* events changed after the fd was added */
+  modify_source = g_source_new (&no_funcs, sizeof (FlagSource));
+  tag = g_source_add_unix_fd (modify_source, fds[1], 0);
+  g_source_attach (modify_source, context);
+  while (g_main_context_iteration (context, FALSE));
+  assert_not_flagged (modify_source);
+  g_source_modify_unix_fd (modify_source, tag, G_IO_OUT);
+  g_assert_true (g_main_context_iteration (context, FALSE));
+  assert_flagged (modify_source);
+  g_source_destroy (modify_source);
+  g_source_unref (modify_source);
+
+  /* /dev/null can't be added to an epoll set but is always readable */
+  file_fd = open ("/dev/null", O_RDONLY);
+  g_assert_cmpint (file_fd, >=, 0);
+  file_source = attach_flag_fd_source (context, file_fd, G_IO_IN, &file);
+  g_assert_true (g_main_context_iteration (context, TRUE));
+  g_assert_true (file);
+  g_source_destroy (file_source);
+  g_source_unref (file_source);
+  close (file_fd);
+
+  /* and we're back to epoll, with a blocking wait */
+  g_assert_cmpint (write (fds[1], &c, 1), ==, 1);
+  g_assert_true (g_main_context_iteration (context, TRUE));
+  g_assert_true (in);
+
+  g_source_destroy (in_source);
+  g_source_unref (in_source);
+  g_main_context_unref (context);
+  close (fds[0]);
+  close (fds[1]);
+}
+
+/* On a G_MAIN_CONTEXT_FLAGS_EPOLL context, sources that only wait for fds
+ * are not visited until epoll reports one of them, which must not change
+ * when and which sources get dispatched. */
+static void
+test_epoll_ready_sources (void)
+{
+  GSourceFuncs no_funcs = {
+    NULL, NULL, return_true, NULL, NULL, NULL
+  };
+  GMainContext *context;
+  GSource *high_source, *low_source, *parent, *child, *timed;
+  gboolean high = FALSE, low = FALSE, child_in = FALSE;
+  gint fds[2], fds2[2];
+  gchar c = 'x';
+
+  context = g_main_context_new_with_flags (G_MAIN_CONTEXT_FLAGS_EPOLL);
+  g_assert_cmpint (pipe (fds), ==, 0);
+  g_assert_cmpint (pipe (fds2), ==, 0);
+
+  /* a source found ready but left for a higher priority one stays ready */
+  high_source = attach_flag_fd_source (context, fds[0], G_IO_IN, &high);
+  g_source_set_priority (high_source, G_PRIORITY_HIGH);
+  low_source = attach_flag_fd_source (context, fds2[0], G_IO_IN, &low);
+  g_source_set_priority (low_source, G_PRIORITY_LOW);
+  g_assert_cmpint (write (fds[1], &c, 1), ==, 1);
+  g_assert_cmpint (write (fds2[1], &c, 1), ==, 1);
+  g_assert_true (g_main_context_iteration (context, FALSE));
+  g_assert_true (high && !low);
+
+  g_source_destroy (high_source);
+  g_source_unref (high_source);
+  g_assert_cmpint (read (fds[0], &c, 1), ==, 1);
+  g_assert_cmpint (read (fds2[0], &c, 1), ==, 1);
+  g_assert_true (g_main_context_iteration (context, FALSE));
+  g_assert_true (low);
+
+  low = FALSE;
+  while (g_main_context_iteration (context, FALSE));
+  g_assert_false (low);
+  g_source_destroy (low_source);
+  g_source_unref (low_source);
+
+  /* a child source's fd makes its parent ready */
+  parent = g_source_new (&no_funcs, sizeof (FlagSource));
+  child = g_unix_fd_source_new (fds[0], G_IO_IN);
+  g_source_set_callback (child, G_SOURCE_FUNC (flag_bool), &child_in, NULL);
+  g_source_add_child_source (parent, child);
+  g_source_attach (parent, context);
+  while (g_main_context_iteration (context, FALSE));
+  assert_not_flagged (parent);
+  g_assert_cmpint (write (fds[1], &c, 1), ==, 1);
+  g_assert_true (g_main_context_iteration (context, FALSE));
+  assert_flagged (parent);
+  g_assert_true (child_in);
+  g_assert_cmpint (read (fds[0], &c, 1), ==, 1);
+  g_source_destroy (parent);
+  g_source_unref (child);
+  g_source_unref (parent);
+
+  /* a ready time on a source that otherwise only waits for an fd */
+  timed = g_source_new (&no_funcs, sizeof (FlagSource));
+  g_source_add_unix_fd (timed, fds[0], G_IO_IN);
+  g_source_attach (timed, context);
+  while (g_main_context_iteration (context, FALSE));
+  assert_not_flagged (timed);
+  g_source_set_ready_time (timed, 0);
+  g_assert_true (g_main_context_iteration (context, TRUE));
+  assert_flagged (timed);
+  g_source_destroy (timed);
+  g_source_unref (timed);
+
+  g_main_context_unref (context);
+  close (fds[0]);
+  close (fds[1]);
+  close (fds2[0]);
+  close (fds2[1]);
+}
+
+static gboolean
+idle_fd_ready (gint         fd,
+               GIOCondition condition,
+               gpointer     user_data)
+{
+  g_assert_not_reached ();
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+busy_fd_ready (gint         fd,
+               GIOCondition condition,
+               gpointer     user_data)
+{
+  guint *n_dispatched = user_data;
+  gchar c;
+
+  g_assert_cmpint (read (fd, &c, 1), ==, 1);
+  (*n_dispatched)++;
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Cost of one wakeup on a context watching many idle fds and one busy one */
+static void
+test_idle_fds_scaling (gconstpointer test_data)
+{
+  GMainContextFlags flags = GPOINTER_TO_UINT (test_data);
+  const guint n_idle_fds[] = { 10, 100, 1000, 10000 };
+  guint n_sizes, n_iterations;
+  gsize i;
+
+  n_sizes = g_test_perf () ? G_N_ELEMENTS (n_idle_fds) : 2;
+  n_iterations = g_test_perf () ? 20000 : 100;
+
+  for (i = 0; i != n_sizes; i++)
+    {
+      GMainContext *context;
+      GPtrArray *idle_sources;
+      GArray *idle_fds;
+      gint idle_pipe[2], busy_pipe[2];
+      guint n_dispatched = 0;
+      gint64 start_time;
+      gdouble usec;
+      guint j;
+
+      context = g_main_context_new_with_flags (flags);
+      g_assert_cmpint (pipe (idle_pipe), ==, 0);
+      g_assert_cmpint (pipe (busy_pipe), ==, 0);
+
+      idle_sources = g_ptr_array_new ();
+      idle_fds = g_array_new (FALSE, FALSE, sizeof (gint));
+      for (j = 0; j != n_idle_fds[i]; j++)
+        {
+          gint fd = dup (idle_pipe[0]);
+          GSource *source;
+
+          if (fd == -1)
+            break;
+
+          source = g_unix_fd_source_new (fd, G_IO_IN);
+          g_source_set_callback (source, G_SOURCE_FUNC (idle_fd_ready), NULL, NULL);
+          g_source_attach (source, context);
+          g_ptr_array_add (idle_sources, source);
+          g_array_append_val (idle_fds, fd);
+        }
+
+      if (idle_fds->len == n_idle_fds[i])
+        {
+          GSource *busy_source;
+
+          busy_source = g_unix_fd_source_new (busy_pipe[0], G_IO_IN);
+          g_source_set_callback (busy_source, G_SOURCE_FUNC (busy_fd_ready), &n_dispatched, NULL);
+          g_source_attach (busy_source, context);
+
+          start_time = g_get_monotonic_time ();
+          for (j = 0; j != n_iterations; j++)
+            {
+              gchar c = 'x';
+
+              g_assert_cmpint (write (busy_pipe[1], &c, 1), ==, 1);
+              g_main_context_iteration (context, TRUE);
+            }
+          usec = (gdouble) (g_get_monotonic_time () - start_time) / n_iterations;
+          g_assert_cmpuint (n_dispatched, ==, n_iterations);
+
+          g_test_minimized_result (usec, "%s, %u idle fds: %.2f usec/wakeup",
+                                   (flags & G_MAIN_CONTEXT_FLAGS_EPOLL) ? "epoll" : "poll",
+                                   n_idle_fds[i], usec);
+
+          g_source_destroy (busy_source);
+          g_source_unref (busy_source);
+        }
+      else
+        {
+          g_test_message ("Not enough file descriptors for %u idle fds", n_idle_fds[i]);
+        }
+
+      for (j = 0; j != idle_sources->len; j++)
+        {
+          GSource *source = g_ptr_array_index (idle_sources, j);
+
+          g_source_destroy (source);
+          g_source_unref (source);
+          close (g_array_index (idle_fds, gint, j));
+        }
+      g_ptr_array_free (idle_sources, TRUE);
+      g_array_free (idle_fds, TRUE);
+
+      g_main_context_unref (context);
+      close (idle_pipe[0]);
+      close (idle_pipe[1]);
+      close (busy_pipe[0]);
+      close (busy_pipe[1]);
+    }
+}
+
 #endif
 
 #ifdef G_OS_UNIX
@@ -2460,6 +2745,14 @@ main (int argc, char *argv[])
   g_test_add_func ("/mainloop/wait", test_mainloop_wait);
   g_test_add_func ("/mainloop/unix-file-poll", test_unix_file_poll);
   g_test_add_func ("/mainloop/unix-fd-priority", test_unix_fd_priority);
+  g_test_add_func ("/mainloop/epoll-context", test_epoll_context);
+  g_test_add_func ("/mainloop/epoll-ready-sources", test_epoll_ready_sources);
+  g_test_add_data_func ("/mainloop/idle-fds-scaling/poll",
+                        GUINT_TO_POINTER (G_MAIN_CONTEXT_FLAGS_NONE),
+                        test_idle_fds_scaling);
+  g_test_add_data_func ("/mainloop/idle-fds-scaling/epoll",
+                        GUINT_TO_POINTER (G_MAIN_CONTEXT_FLAGS_EPOLL),
+                        test_idle_fds_scaling);
 #endif
   g_test_add_func ("/mainloop/nfds", test_nfds);
   g_test_add_func ("/mainloop/steal-fd", test_steal_fd);
@@ -0,0 +1,181 @@
+/* GLib testing framework examples and tests
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include <stdlib.h>
+
+/* Throughput of small g_malloc()/g_free() pairs with a custom GMemVTable
+ * installed, the way an embedder bringing its own allocator runs GLib.
+ * Run with `-m perf` for meaningful numbers, with and without
+ * G_SLICE=small-malloc to compare the GSlice magazines against going
+ * through the vtable for every block; in the default mode the workloads are
+ * kept small so the test doubles as a smoke test.
+ */
+
+#ifdef G_OS_UNIX
+static gpointer
+passthrough_memalign (gsize alignment,
+                      gsize size)
+{
+  gpointer mem = NULL;
+
+  if (posix_memalign (&mem, alignment, size) != 0)
+    return NULL;
+
+  return mem;
+}
+#else
+#define passthrough_memalign NULL
+#endif
+
+static GMemVTable passthrough_vtable = {
+  malloc,
+  realloc,
+  passthrough_memalign,
+  free,
+  calloc,
+  NULL,
+  NULL,
+};
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+#define N_LIVE_BLOCKS 64
+
+typedef struct
+{
+  guint n_pairs;
+  guint seed;
+} Worker;
+
+static gpointer
+churn_blocks (gpointer data)
+{
+  Worker *worker = data;
+  GRand *rand = g_rand_new_with_seed (worker->seed);
+  guint8 *blocks[N_LIVE_BLOCKS] = { NULL, };
+  gsize sizes[N_LIVE_BLOCKS] = { 0, };
+  guint i;
+
+  /* mostly small blocks, like strings and list nodes, with the odd larger
+   * buffer and some blocks growing across the small-block limit
+   */
+  for (i = 0; i < worker->n_pairs; i++)
+    {
+      guint slot = i % N_LIVE_BLOCKS;
+      guint32 dice = g_rand_int (rand);
+      gsize size;
+
+      if (blocks[slot] != NULL)
+        {
+          g_assert_cmpuint (blocks[slot][0], ==, (guint8) sizes[slot]);
+          g_assert_cmpuint (blocks[slot][sizes[slot] - 1], ==, (guint8) sizes[slot]);
+          g_free (blocks[slot]);
+        }
+
+      if (dice % 64 == 0)
+        size = 1024 + dice % 4096;
+      else
+        size = 1 + dice % 200;
+
+      if (dice % 16 == 1)
+        {
+          blocks[slot] = g_malloc0 (size);
+          g_assert_cmpuint (blocks[slot][size - 1], ==, 0);
+        }
+      else
+        blocks[slot] = g_malloc (size);
+      blocks[slot][0] = blocks[slot][size - 1] = (guint8) size;
+
+      if (dice % 32 == 2)
+        {
+          gsize new_size = size * 3;
+
+          blocks[slot] = g_realloc (blocks[slot], new_size);
+          g_assert_cmpuint (blocks[slot][0], ==, (guint8) size);
+          blocks[slot][0] = blocks[slot][new_size - 1] = (guint8) new_size;
+          size = new_size;
+        }
+
+      sizes[slot] = size;
+    }
+
+  for (i = 0; i < N_LIVE_BLOCKS; i++)
+    g_free (blocks[i]);
+
+  g_rand_free (rand);
+
+  return NULL;
+}
+
+static void
+test_small_blocks (gconstpointer data)
+{
+  guint n_threads = GPOINTER_TO_UINT (data);
+  guint n_pairs = g_test_perf () ? 2000000 : 20000;
+  GThread **threads;
+  Worker *workers;
+  GTimer *timer;
+  gdouble elapsed;
+  guint i;
+
+  threads = g_new0 (GThread *, n_threads);
+  workers = g_new0 (Worker, n_threads);
+
+  timer = g_timer_new ();
+
+  for (i = 0; i < n_threads; i++)
+    {
+      workers[i].n_pairs = n_pairs;
+      workers[i].seed = i + 1;
+      threads[i] = g_thread_new ("churn", churn_blocks, &workers[i]);
+    }
+  for (i = 0; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  g_test_maximized_result (n_threads * n_pairs / elapsed,
+                           "%u threads, %u alloc/free pairs each in %.3f s: %.0f pairs/s (G_SLICE=%s)",
+                           n_threads, n_pairs, elapsed,
+                           n_threads * n_pairs / elapsed,
+                           g_getenv ("G_SLICE") ? g_getenv ("G_SLICE") : "");
+
+  g_timer_destroy (timer);
+  g_free (workers);
+  g_free (threads);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_mem_set_vtable (&passthrough_vtable);
+  glib_init ();
+
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_data_func ("/mem/performance/small-blocks/1-thread", GUINT_TO_POINTER (1), test_small_blocks);
+  g_test_add_data_func ("/mem/performance/small-blocks/4-threads", GUINT_TO_POINTER (4), test_small_blocks);
+  g_test_add_data_func ("/mem/performance/small-blocks/16-threads", GUINT_TO_POINTER (16), test_small_blocks);
+
+  return g_test_run ();
+}
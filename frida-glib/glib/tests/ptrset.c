@@ -0,0 +1,549 @@
+/* GLib testing framework examples and tests
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+/* GPtrSet is internal to GLib, so build it into the test */
+#include "../gptrset.c"
+
+static gpointer
+fake_ptr (gsize i)
+{
+  /* Aligned like the objects the sets track, and never NULL */
+  return GSIZE_TO_POINTER ((i + 1) * 16);
+}
+
+static gboolean
+ptr_set_equals_table (GPtrSet    *pset,
+                      GHashTable *reference)
+{
+  gsize i;
+
+  if (pset->size != g_hash_table_size (reference))
+    return FALSE;
+
+  for (i = 0; i != pset->size; i++)
+    {
+      if (!g_hash_table_contains (reference, pset->items[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+test_basic (void)
+{
+  GPtrSet *pset;
+  gsize i;
+
+  pset = g_ptr_set_new ();
+
+  for (i = 0; i != 1000; i++)
+    g_ptr_set_add (pset, fake_ptr (i));
+  g_assert_cmpuint (pset->size, ==, 1000);
+
+  /* Adding a member again is a no-op */
+  g_ptr_set_add (pset, fake_ptr (500));
+  g_assert_cmpuint (pset->size, ==, 1000);
+
+  for (i = 0; i != 1000; i++)
+    g_assert_true (g_ptr_set_contains (pset, fake_ptr (i)));
+  g_assert_false (g_ptr_set_contains (pset, fake_ptr (1000)));
+
+  for (i = 0; i != 1000; i += 2)
+    g_ptr_set_remove (pset, fake_ptr (i));
+  g_assert_cmpuint (pset->size, ==, 500);
+
+  /* Removing a non-member is a no-op */
+  g_ptr_set_remove (pset, fake_ptr (0));
+  g_ptr_set_remove (pset, fake_ptr (5000));
+  g_assert_cmpuint (pset->size, ==, 500);
+
+  for (i = 0; i != 1000; i++)
+    g_assert_cmpint (g_ptr_set_contains (pset, fake_ptr (i)), ==, i % 2 == 1);
+
+  g_ptr_set_free (pset);
+}
+
+static void
+count_item (gpointer item,
+            gpointer user_data)
+{
+  gsize *n = user_data;
+
+  g_assert_cmpuint (GPOINTER_TO_SIZE (item) % 16, ==, 0);
+  (*n)++;
+}
+
+static void
+test_add_many (void)
+{
+  gpointer ptrs[300];
+  GPtrSet *pset;
+  gsize i, n = 0;
+
+  for (i = 0; i != G_N_ELEMENTS (ptrs); i++)
+    ptrs[i] = fake_ptr (i % 200);
+
+  pset = g_ptr_set_new ();
+  g_ptr_set_add (pset, fake_ptr (10));
+  g_ptr_set_add_many (pset, ptrs, G_N_ELEMENTS (ptrs));
+  g_assert_cmpuint (pset->size, ==, 200);
+
+  for (i = 0; i != 200; i++)
+    g_assert_true (g_ptr_set_contains (pset, fake_ptr (i)));
+
+  g_ptr_set_foreach (pset, count_item, &n);
+  g_assert_cmpuint (n, ==, 200);
+
+  g_ptr_set_free (pset);
+}
+
+static void
+test_steal_all (void)
+{
+  GPtrSet *pset;
+  gpointer *items;
+  gsize i, n_items;
+  gsize sum = 0;
+
+  pset = g_ptr_set_new ();
+  for (i = 0; i != 100; i++)
+    g_ptr_set_add (pset, fake_ptr (i));
+
+  items = g_ptr_set_steal_all (pset, &n_items);
+  g_assert_cmpuint (n_items, ==, 100);
+  for (i = 0; i != n_items; i++)
+    sum += GPOINTER_TO_SIZE (items[i]) / 16;
+  g_assert_cmpuint (sum, ==, 100 * 101 / 2);
+  glib_mem_table->free (items);
+
+  g_assert_cmpuint (pset->size, ==, 0);
+  g_assert_false (g_ptr_set_contains (pset, fake_ptr (0)));
+
+  /* The set remains usable */
+  g_ptr_set_add (pset, fake_ptr (0));
+  g_assert_true (g_ptr_set_contains (pset, fake_ptr (0)));
+  g_assert_cmpuint (pset->size, ==, 1);
+
+  g_ptr_set_free (pset);
+}
+
+static void
+test_compact (void)
+{
+  GPtrSet *pset;
+  gsize i;
+
+  pset = g_ptr_set_new ();
+  for (i = 0; i != 10000; i++)
+    g_ptr_set_add (pset, fake_ptr (i));
+  for (i = 0; i != 10000; i++)
+    {
+      if (i % 100 != 0)
+        g_ptr_set_remove (pset, fake_ptr (i));
+    }
+
+  g_ptr_set_compact (pset);
+  g_assert_cmpuint (pset->size, ==, 100);
+  g_assert_cmpuint (pset->capacity, ==, 128);
+  g_assert_cmpuint (pset->index_map->tombstones, ==, 0);
+  g_assert_cmpuint (pset->index_map->capacity, ==, 128);
+
+  for (i = 0; i != 10000; i++)
+    g_assert_cmpint (g_ptr_set_contains (pset, fake_ptr (i)), ==, i % 100 == 0);
+
+  g_ptr_set_free (pset);
+}
+
+/* Random operations checked against a GHashTable, keeping the set small
+ * enough that removals leave tombstones behind and inserts have to reuse or
+ * reclaim them.
+ */
+static void
+test_churn (void)
+{
+  GPtrSet *pset;
+  GHashTable *reference;
+  GRand *rand;
+  guint i;
+
+  pset = g_ptr_set_new ();
+  reference = g_hash_table_new (NULL, NULL);
+  rand = g_rand_new_with_seed (42);
+
+  for (i = 0; i != 200000; i++)
+    {
+      gpointer ptr = fake_ptr (g_rand_int_range (rand, 0, 2000));
+
+      switch (g_rand_int_range (rand, 0, 4))
+        {
+        case 0:
+        case 1:
+          g_ptr_set_add (pset, ptr);
+          g_hash_table_add (reference, ptr);
+          break;
+        case 2:
+          g_ptr_set_remove (pset, ptr);
+          g_hash_table_remove (reference, ptr);
+          break;
+        case 3:
+          g_assert_cmpint (g_ptr_set_contains (pset, ptr), ==,
+                           g_hash_table_contains (reference, ptr));
+          break;
+        default:
+          g_assert_not_reached ();
+        }
+
+      if (i % 50000 == 0)
+        g_ptr_set_compact (pset);
+    }
+
+  g_assert_true (ptr_set_equals_table (pset, reference));
+
+  g_rand_free (rand);
+  g_hash_table_unref (reference);
+  g_ptr_set_free (pset);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/*
+ * The linear-probing map GPtrSet used before, kept verbatim apart from
+ * naming so the benchmark can compare against it.
+ */
+
+#define LEGACY_TOMBSTONE ((gpointer) -1)
+
+typedef struct
+{
+  gpointer key;
+  gsize    val;
+} LegacyEntry;
+
+typedef struct
+{
+  gpointer    *items;
+  gsize        size;
+  gsize        capacity;
+  LegacyEntry *entries;
+  gsize        map_capacity;
+  gsize        map_size;
+  gsize        tombstones;
+} LegacyPtrSet;
+
+static LegacyPtrSet *
+legacy_ptr_set_new (void)
+{
+  LegacyPtrSet *pset = g_new0 (LegacyPtrSet, 1);
+
+  pset->capacity = 16;
+  pset->items = g_new0 (gpointer, pset->capacity);
+  pset->map_capacity = 16;
+  pset->entries = g_new0 (LegacyEntry, pset->map_capacity);
+
+  return pset;
+}
+
+static void
+legacy_ptr_set_free (LegacyPtrSet *pset)
+{
+  g_free (pset->entries);
+  g_free (pset->items);
+  g_free (pset);
+}
+
+static gsize
+legacy_probe (LegacyPtrSet  *pset,
+              gconstpointer  key,
+              gboolean      *found)
+{
+  gsize mask, idx;
+  gssize first_tombstone = -1;
+
+  *found = FALSE;
+
+  mask = pset->map_capacity - 1;
+  idx = g_ptr_index_map_ptr_hash (key) & mask;
+
+  while (TRUE)
+    {
+      gpointer slot_key = pset->entries[idx].key;
+
+      if (slot_key == NULL)
+        return (first_tombstone != -1) ? (gsize) first_tombstone : idx;
+      else if (slot_key == LEGACY_TOMBSTONE)
+        {
+          if (first_tombstone == -1)
+            first_tombstone = idx;
+        }
+      else if (slot_key == key)
+        {
+          *found = TRUE;
+          return idx;
+        }
+
+      idx = (idx + 1) & mask;
+    }
+}
+
+static void legacy_map_insert (LegacyPtrSet *pset,
+                               gpointer      key,
+                               gsize         val);
+
+static void
+legacy_map_rehash (LegacyPtrSet *pset,
+                   gsize         new_capacity)
+{
+  LegacyEntry *old_entries = pset->entries;
+  gsize old_capacity = pset->map_capacity;
+  gsize i;
+
+  pset->entries = g_new0 (LegacyEntry, new_capacity);
+  pset->map_capacity = new_capacity;
+  pset->map_size = 0;
+  pset->tombstones = 0;
+
+  for (i = 0; i != old_capacity; i++)
+    {
+      gpointer old_key = old_entries[i].key;
+      if (old_key != NULL && old_key != LEGACY_TOMBSTONE)
+        legacy_map_insert (pset, old_key, old_entries[i].val);
+    }
+
+  g_free (old_entries);
+}
+
+static void
+legacy_map_insert (LegacyPtrSet *pset,
+                   gpointer      key,
+                   gsize         val)
+{
+  gsize idx;
+  gboolean found;
+
+  if ((pset->map_size + pset->tombstones) * 10 >= pset->map_capacity * 7)
+    legacy_map_rehash (pset, pset->map_capacity * 2);
+
+  idx = legacy_probe (pset, key, &found);
+  if (found)
+    {
+      pset->entries[idx].val = val;
+      return;
+    }
+
+  if (pset->entries[idx].key == LEGACY_TOMBSTONE)
+    pset->tombstones--;
+
+  pset->entries[idx].key = key;
+  pset->entries[idx].val = val;
+  pset->map_size++;
+}
+
+static void
+legacy_ptr_set_add (LegacyPtrSet *pset,
+                    gpointer      ptr)
+{
+  if (pset->size == pset->capacity)
+    {
+      pset->capacity *= 2;
+      pset->items = g_renew (gpointer, pset->items, pset->capacity);
+    }
+
+  pset->items[pset->size] = ptr;
+  legacy_map_insert (pset, ptr, pset->size);
+  pset->size++;
+}
+
+static gboolean
+legacy_ptr_set_contains (LegacyPtrSet  *pset,
+                         gconstpointer  ptr)
+{
+  gboolean found;
+
+  legacy_probe (pset, ptr, &found);
+
+  return found;
+}
+
+static void
+legacy_ptr_set_remove (LegacyPtrSet *pset,
+                       gpointer      ptr)
+{
+  gsize idx, last_idx;
+  gboolean found;
+
+  if (pset->size == 0)
+    return;
+
+  idx = legacy_probe (pset, ptr, &found);
+  if (!found)
+    return;
+  pset->entries[idx].key = LEGACY_TOMBSTONE;
+  pset->map_size--;
+  pset->tombstones++;
+  idx = pset->entries[idx].val;
+
+  last_idx = pset->size - 1;
+  if (idx != last_idx)
+    {
+      gpointer last_ptr = pset->items[last_idx];
+      pset->items[idx] = last_ptr;
+      pset->entries[legacy_probe (pset, last_ptr, &found)].val = idx;
+    }
+
+  pset->size--;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/*
+ * Models the thread-state sets: a population of live objects where each
+ * step one is destroyed and another one created, with the odd membership
+ * check. Addresses are recycled like an allocator would.
+ */
+
+#define N_CHURN_ADDRESSES 65536
+
+/* Cheap enough not to drown out the set operations being timed */
+static inline guint32
+xorshift32 (guint32 *state)
+{
+  guint32 x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+
+  return *state = x;
+}
+
+typedef struct
+{
+  gpointer (* new_set) (void);
+  void     (* free_set) (gpointer pset);
+  void     (* add) (gpointer pset, gpointer ptr);
+  void     (* remove) (gpointer pset, gpointer ptr);
+  gboolean (* contains) (gpointer pset, gconstpointer ptr);
+} PtrSetImpl;
+
+static const PtrSetImpl current_impl = {
+  (gpointer (*) (void)) g_ptr_set_new,
+  (void (*) (gpointer)) g_ptr_set_free,
+  (void (*) (gpointer, gpointer)) g_ptr_set_add,
+  (void (*) (gpointer, gpointer)) g_ptr_set_remove,
+  (gboolean (*) (gpointer, gconstpointer)) g_ptr_set_contains,
+};
+
+static const PtrSetImpl legacy_impl = {
+  (gpointer (*) (void)) legacy_ptr_set_new,
+  (void (*) (gpointer)) legacy_ptr_set_free,
+  (void (*) (gpointer, gpointer)) legacy_ptr_set_add,
+  (void (*) (gpointer, gpointer)) legacy_ptr_set_remove,
+  (gboolean (*) (gpointer, gconstpointer)) legacy_ptr_set_contains,
+};
+
+static gdouble
+run_churn (const PtrSetImpl *impl,
+           guint             n_live,
+           guint             n_steps)
+{
+  gpointer pset;
+  gpointer *live;
+  guint8 *addresses;
+  guint32 rand_state = 1;
+  GTimer *timer;
+  gdouble elapsed;
+  guint i, n_hits = 0;
+
+  pset = impl->new_set ();
+  live = g_new (gpointer, n_live);
+  addresses = g_malloc0 (N_CHURN_ADDRESSES * 16);
+
+  for (i = 0; i != n_live; i++)
+    {
+      live[i] = addresses + i * 16;
+      impl->add (pset, live[i]);
+    }
+
+  timer = g_timer_new ();
+
+  for (i = 0; i != n_steps; i++)
+    {
+      guint victim = xorshift32 (&rand_state) % n_live;
+      gpointer candidate;
+
+      impl->remove (pset, live[victim]);
+
+      do
+        candidate = addresses + (xorshift32 (&rand_state) % N_CHURN_ADDRESSES) * 16;
+      while (impl->contains (pset, candidate));
+      live[victim] = candidate;
+      impl->add (pset, candidate);
+
+      n_hits += impl->contains (pset, live[(victim + 1) % n_live]);
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_assert_cmpuint (n_hits, ==, n_steps);
+
+  g_timer_destroy (timer);
+  g_free (addresses);
+  g_free (live);
+  impl->free_set (pset);
+
+  return elapsed;
+}
+
+static void
+test_churn_performance (gconstpointer data)
+{
+  guint n_live = GPOINTER_TO_UINT (data);
+  guint n_steps = g_test_perf () ? 4000000 : 20000;
+  gdouble current, legacy;
+
+  current = run_churn (&current_impl, n_live, n_steps);
+  legacy = run_churn (&legacy_impl, n_live, n_steps);
+
+  g_test_maximized_result (legacy / current,
+                           "%u live pointers, %u steps: %.0f steps/s, %.0f steps/s with linear probing (%.2fx)",
+                           n_live, n_steps, n_steps / current, n_steps / legacy,
+                           legacy / current);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/ptrset/basic", test_basic);
+  g_test_add_func ("/ptrset/add-many", test_add_many);
+  g_test_add_func ("/ptrset/steal-all", test_steal_all);
+  g_test_add_func ("/ptrset/compact", test_compact);
+  g_test_add_func ("/ptrset/churn", test_churn);
+
+  g_test_add_data_func ("/ptrset/performance/churn/64", GUINT_TO_POINTER (64), test_churn_performance);
+  g_test_add_data_func ("/ptrset/performance/churn/1024", GUINT_TO_POINTER (1024), test_churn_performance);
+  g_test_add_data_func ("/ptrset/performance/churn/16384", GUINT_TO_POINTER (16384), test_churn_performance);
+
+  return g_test_run ();
+}
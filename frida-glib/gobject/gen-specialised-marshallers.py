@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: LGPL-2.1-or-later
+
+"""Generate the table of specialised marshallers used by g_signal_newv().
+
+Signals registered without a marshaller fall back to the libffi-based
+g_cclosure_marshal_generic(). For the common signatures, this script lists
+marshallers for glib-genmarshal to generate instead, and emits a lookup
+table indexed the same way as specialised_marshaller_lookup() in gsignal.c:
+return types first, then by number of arguments, then by argument classes
+read as base-N digits.
+"""
+
+import argparse
+import itertools
+from pathlib import Path
+
+RETURN_TYPES = ["VOID", "BOOLEAN"]
+ARG_CLASSES = ["POINTER", "INT", "INT64", "DOUBLE"]
+MAX_ARGS = 4
+PREFIX = "_g_specialised_marshal"
+
+
+def signatures():
+    for ret in RETURN_TYPES:
+        for n_args in range(MAX_ARGS + 1):
+            for args in itertools.product(ARG_CLASSES, repeat=n_args):
+                yield ret, args
+
+
+def gen_list(out_path):
+    with out_path.open("w", encoding="utf-8") as ofile:
+        for ret, args in signatures():
+            ofile.write("{}:{}\n".format(ret, ",".join(args) or "VOID"))
+
+
+def gen_table(out_path):
+    with out_path.open("w", encoding="utf-8") as ofile:
+        ofile.write("/* This file is generated by gen-specialised-marshallers.py, do not modify it. */\n\n")
+        ofile.write("#define SPECIALISED_MARSHALLER_N_ARG_CLASSES {}\n".format(len(ARG_CLASSES)))
+        ofile.write("#define SPECIALISED_MARSHALLER_MAX_ARGS {}\n\n".format(MAX_ARGS))
+        ofile.write("static const SpecialisedMarshaller specialised_marshallers[] = {\n")
+        for ret, args in signatures():
+            name = "{}_{}__{}".format(PREFIX, ret, "_".join(args) or "VOID")
+            ofile.write("  {{ {0}, {0}v }},\n".format(name))
+        ofile.write("};\n")
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("mode", choices=["list", "table"])
+    parser.add_argument("out_path", type=Path)
+    args = parser.parse_args()
+
+    if args.mode == "list":
+        gen_list(args.out_path)
+    else:
+        gen_table(args.out_path)
+
+
+if __name__ == "__main__":
+    main()
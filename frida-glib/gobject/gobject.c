@@ -203,6 +203,18 @@ G_STATIC_ASSERT(sizeof(GObject) == sizeof(GObjectReal));
 G_STATIC_ASSERT(G_STRUCT_OFFSET(GObject, ref_count) == G_STRUCT_OFFSET(GObjectReal, ref_count));
 G_STATIC_ASSERT(G_STRUCT_OFFSET(GObject, qdata) == G_STRUCT_OFFSET(GObjectReal, qdata));
 
+/* Optional data that does not fit in the public struct. It is instance
+ * private data of GObject itself, so it lives right in front of every
+ * object and is reached at a fixed offset, without any lookup.
+ */
+typedef struct
+{
+  gpointer       signal_handlers;  /* (atomic) owned by gsignal.c */
+  gpointer       notify_queue;     /* (atomic) GObjectNotifyQueue, bit 0 is its lock */
+} GObjectPrivate;
+
+static gint GObject_private_offset;
+
 
 /* --- prototypes --- */
 static void	g_object_base_class_init		(GObjectClass	*class);
@@ -247,67 +259,155 @@ static guint               object_floating_flag_handler (GObject        *object,
 
 static void object_interface_check_properties           (gpointer        check_data,
 							 gpointer        g_iface);
-static void                weak_locations_free_unlocked (GSList **weak_locations);
 
 /* --- typedefs --- */
 typedef struct _GObjectNotifyQueue            GObjectNotifyQueue;
+typedef struct _ObjectLocks                   ObjectLocks;
+typedef struct _WeakLocations                 WeakLocations;
+
+/* Most freezes collect only a handful of notifications, which then fit
+ * in the queue itself.
+ */
+#define NOTIFY_QUEUE_N_INLINE_PSPECS 8
+#define NOTIFY_QUEUE_LOCK_BIT        0
 
 struct _GObjectNotifyQueue
 {
-  GSList  *pspecs;
-  guint16  n_pspecs;
-  guint16  freeze_count;
+  GParamSpec **pspecs;
+  guint16      n_pspecs;
+  guint16      n_pspecs_allocated;
+  guint16      freeze_count;
+  GParamSpec  *pspecs_inline[NOTIFY_QUEUE_N_INLINE_PSPECS];
 };
 
+/* The locks guarding weak refs, toggle refs, closure arrays and weak
+ * locations only ever need to exclude other threads working on the same
+ * object, so rather than one global lock each, they are picked from
+ * a fixed set by the address of the object.
+ */
+#define N_OBJECT_LOCKS 64
+
+struct _ObjectLocks
+{
+  GMutex   closure_array_mutex;
+  GMutex   weak_refs_mutex;
+  GMutex   toggle_refs_mutex;
+  GRWLock  weak_locations_lock;
+};
+
+/* qdata for GWeakRef, the list of GWeakRef pointing to the object */
+struct _WeakLocations
+{
+  GObject *object;
+  GSList  *weak_refs;
+};
+
+static void                weak_locations_free_unlocked (WeakLocations *weak_locations);
+
 /* --- variables --- */
-G_LOCK_DEFINE_STATIC (closure_array_mutex);
-G_LOCK_DEFINE_STATIC (weak_refs_mutex);
-G_LOCK_DEFINE_STATIC (toggle_refs_mutex);
+static ObjectLocks          object_locks[N_OBJECT_LOCKS];
 static GQuark	            quark_closure_array = 0;
 static GQuark	            quark_weak_refs = 0;
 static GQuark	            quark_toggle_refs = 0;
-static GQuark               quark_notify_queue;
 #ifndef HAVE_OPTIONAL_FLAGS
 static GQuark               quark_in_construction;
 #endif
 static GParamSpecPool      *pspec_pool = NULL;
 static gulong	            gobject_signals[LAST_SIGNAL] = { 0, };
 static guint (*floating_flag_handler) (GObject*, gint) = object_floating_flag_handler;
-/* qdata pointing to GSList<GWeakRef *>, protected by weak_locations_lock */
+/* qdata pointing to WeakLocations, protected by weak_locations_lock */
 static GQuark	            quark_weak_locations = 0;
-static GRWLock              weak_locations_lock;
-
-G_LOCK_DEFINE_STATIC(notify_lock);
 
 /* --- functions --- */
-static void
-g_object_notify_queue_free (gpointer data)
+static inline ObjectLocks *
+object_get_locks (gconstpointer object)
+{
+  gsize address = GPOINTER_TO_SIZE (object);
+
+  return &object_locks[((address >> 4) ^ (address >> 12)) % N_OBJECT_LOCKS];
+}
+
+/* The notify queue of an object hangs off its GObjectPrivate, and is
+ * guarded by a bit lock in the pointer to it, so that objects being
+ * notified from several threads do not contend on a global lock.
+ */
+static inline gpointer *
+object_get_notify_queue_location (GObject *object)
 {
-  GObjectNotifyQueue *nqueue = data;
+  GObjectPrivate *priv = G_STRUCT_MEMBER_P (object, GObject_private_offset);
 
-  g_slist_free (nqueue->pspecs);
+  return &priv->notify_queue;
+}
+
+static inline GObjectNotifyQueue *
+notify_queue_from_location (gpointer *location)
+{
+  return (GObjectNotifyQueue *) ((guintptr) g_atomic_pointer_get (location) &
+                                 ~((guintptr) 1 << NOTIFY_QUEUE_LOCK_BIT));
+}
+
+static inline GObjectNotifyQueue *
+notify_queue_lock (gpointer *location)
+{
+  g_pointer_bit_lock (location, NOTIFY_QUEUE_LOCK_BIT);
+
+  return notify_queue_from_location (location);
+}
+
+static inline void
+notify_queue_set_and_unlock (gpointer           *location,
+                             GObjectNotifyQueue *nqueue)
+{
+  g_atomic_pointer_set (location,
+                        (gpointer) ((guintptr) nqueue | ((guintptr) 1 << NOTIFY_QUEUE_LOCK_BIT)));
+  g_pointer_bit_unlock (location, NOTIFY_QUEUE_LOCK_BIT);
+}
+
+static inline void
+notify_queue_unlock (gpointer *location)
+{
+  g_pointer_bit_unlock (location, NOTIFY_QUEUE_LOCK_BIT);
+}
+
+static void
+g_object_notify_queue_free (GObjectNotifyQueue *nqueue)
+{
+  if (nqueue->pspecs != nqueue->pspecs_inline)
+    g_free (nqueue->pspecs);
   g_slice_free (GObjectNotifyQueue, nqueue);
 }
 
+static inline GObjectNotifyQueue *
+g_object_notify_queue_peek (GObject *object)
+{
+  return notify_queue_from_location (object_get_notify_queue_location (object));
+}
+
 static GObjectNotifyQueue*
 g_object_notify_queue_freeze (GObject  *object,
                               gboolean  conditional)
 {
+  gpointer *location = object_get_notify_queue_location (object);
   GObjectNotifyQueue *nqueue;
 
-  G_LOCK(notify_lock);
-  nqueue = g_datalist_id_get_data (&object->qdata, quark_notify_queue);
+  /* Whether the object is frozen is racy with respect to other threads
+   * anyway, so the common unfrozen case does not need the lock.
+   */
+  if (conditional && notify_queue_from_location (location) == NULL)
+    return NULL;
+
+  nqueue = notify_queue_lock (location);
   if (!nqueue)
     {
       if (conditional)
         {
-          G_UNLOCK(notify_lock);
+          notify_queue_unlock (location);
           return NULL;
         }
 
       nqueue = g_slice_new0 (GObjectNotifyQueue);
-      g_datalist_id_set_data_full (&object->qdata, quark_notify_queue,
-                                   nqueue, g_object_notify_queue_free);
+      nqueue->pspecs = nqueue->pspecs_inline;
+      nqueue->n_pspecs_allocated = NOTIFY_QUEUE_N_INLINE_PSPECS;
     }
 
   if (nqueue->freeze_count >= 65535)
@@ -318,7 +418,7 @@ g_object_notify_queue_freeze (GObject  *object,
   else
     nqueue->freeze_count++;
 
-  G_UNLOCK(notify_lock);
+  notify_queue_set_and_unlock (location, nqueue);
 
   return nqueue;
 }
@@ -327,16 +427,16 @@ static void
 g_object_notify_queue_thaw (GObject            *object,
                             GObjectNotifyQueue *nqueue)
 {
-  GParamSpec *pspecs_mem[16], **pspecs, **free_me = NULL;
-  GSList *slist;
-  guint n_pspecs = 0;
+  gpointer *location = object_get_notify_queue_location (object);
+  GParamSpec *pspecs_mem[16], **pspecs;
+  guint n_pspecs, i;
 
-  G_LOCK(notify_lock);
+  notify_queue_lock (location);
 
   /* Just make sure we never get into some nasty race condition */
   if (G_UNLIKELY (nqueue->freeze_count == 0))
     {
-      G_UNLOCK (notify_lock);
+      notify_queue_unlock (location);
       g_critical ("%s: property-changed notification for %s(%p) is not frozen",
                   G_STRFUNC, G_OBJECT_TYPE_NAME (object), object);
       return;
@@ -345,23 +445,23 @@ g_object_notify_queue_thaw (GObject            *object,
   nqueue->freeze_count--;
   if (nqueue->freeze_count)
     {
-      G_UNLOCK (notify_lock);
+      notify_queue_unlock (location);
       return;
     }
 
-  pspecs = nqueue->n_pspecs > 16 ? free_me = g_new (GParamSpec*, nqueue->n_pspecs) : pspecs_mem;
-
-  for (slist = nqueue->pspecs; slist; slist = slist->next)
-    {
-      pspecs[n_pspecs++] = slist->data;
-    }
-  g_datalist_id_set_data (&object->qdata, quark_notify_queue, NULL);
+  notify_queue_set_and_unlock (location, NULL);
 
-  G_UNLOCK(notify_lock);
+  /* The queue is ours now. Notifications go out latest first. */
+  n_pspecs = nqueue->n_pspecs;
+  pspecs = n_pspecs > G_N_ELEMENTS (pspecs_mem) ? g_new (GParamSpec *, n_pspecs) : pspecs_mem;
+  for (i = 0; i < n_pspecs; i++)
+    pspecs[i] = nqueue->pspecs[n_pspecs - 1 - i];
+  g_object_notify_queue_free (nqueue);
 
   if (n_pspecs)
     G_OBJECT_GET_CLASS (object)->dispatch_properties_changed (object, n_pspecs, pspecs);
-  g_free (free_me);
+  if (pspecs != pspecs_mem)
+    g_free (pspecs);
 }
 
 static void
@@ -369,17 +469,31 @@ g_object_notify_queue_add (GObject            *object,
                            GObjectNotifyQueue *nqueue,
                            GParamSpec         *pspec)
 {
-  G_LOCK(notify_lock);
+  gpointer *location = object_get_notify_queue_location (object);
+  guint i;
+
+  notify_queue_lock (location);
+
+  for (i = 0; i < nqueue->n_pspecs; i++)
+    if (nqueue->pspecs[i] == pspec)
+      {
+        notify_queue_unlock (location);
+        return;
+      }
 
   g_assert (nqueue->n_pspecs < 65535);
 
-  if (g_slist_find (nqueue->pspecs, pspec) == NULL)
+  if (nqueue->n_pspecs == nqueue->n_pspecs_allocated)
     {
-      nqueue->pspecs = g_slist_prepend (nqueue->pspecs, pspec);
-      nqueue->n_pspecs++;
+      nqueue->n_pspecs_allocated = MIN (nqueue->n_pspecs_allocated * 2, 65535);
+      if (nqueue->pspecs == nqueue->pspecs_inline)
+        nqueue->pspecs = g_memdup2 (nqueue->pspecs_inline,
+                                    sizeof (nqueue->pspecs_inline));
+      nqueue->pspecs = g_renew (GParamSpec *, nqueue->pspecs, nqueue->n_pspecs_allocated);
     }
+  nqueue->pspecs[nqueue->n_pspecs++] = pspec;
 
-  G_UNLOCK(notify_lock);
+  notify_queue_unlock (location);
 }
 
 #ifdef	G_ENABLE_DEBUG
@@ -459,6 +573,7 @@ _g_object_type_init (void)
   info.value_table = &value_table;
   type = g_type_register_fundamental (G_TYPE_OBJECT, g_intern_static_string ("GObject"), &info, &finfo, 0);
   g_assert (type == G_TYPE_OBJECT);
+  GObject_private_offset = g_type_add_instance_private (G_TYPE_OBJECT, sizeof (GObjectPrivate));
   g_value_register_transform_func (G_TYPE_OBJECT, G_TYPE_OBJECT, g_value_object_transform_value);
 
 #if G_ENABLE_DEBUG
@@ -524,13 +639,14 @@ g_object_base_class_finalize (GObjectClass *class)
 static void
 g_object_do_class_init (GObjectClass *class)
 {
+  g_type_class_adjust_private_offset (class, &GObject_private_offset);
+
   /* read the comment about typedef struct CArray; on why not to change this quark */
   quark_closure_array = g_quark_from_static_string ("GObject-closure-array");
 
   quark_weak_refs = g_quark_from_static_string ("GObject-weak-references");
   quark_weak_locations = g_quark_from_static_string ("GObject-weak-locations");
   quark_toggle_refs = g_quark_from_static_string ("GObject-toggle-references");
-  quark_notify_queue = g_quark_from_static_string ("GObject-notify-queue");
 #ifndef HAVE_OPTIONAL_FLAGS
   quark_in_construction = g_quark_from_static_string ("GObject-in-construction");
 #endif
@@ -1243,6 +1359,14 @@ _g_object_has_signal_handler (GObject *object)
 #endif
 }
 
+gpointer *
+_g_object_get_signal_handlers_location (GObject *object)
+{
+  GObjectPrivate *priv = G_STRUCT_MEMBER_P (object, GObject_private_offset);
+
+  return &priv->signal_handlers;
+}
+
 static inline gboolean
 _g_object_has_notify_handler (GObject *object)
 {
@@ -1392,6 +1516,8 @@ floating_check (GObject *object)
 static void
 g_object_finalize (GObject *object)
 {
+  GObjectNotifyQueue *nqueue;
+
 #ifdef G_ENABLE_DEBUG
   if (object_in_construction (object))
     {
@@ -1409,6 +1535,13 @@ g_object_finalize (GObject *object)
    }
 #endif
 
+  /* Objects finalized while frozen still own their queue */
+  nqueue = g_object_notify_queue_peek (object);
+  if (nqueue != NULL)
+    g_object_notify_queue_free (nqueue);
+
+  _g_signal_handlers_finalize (object);
+
   g_datalist_clear (&object->qdata);
   
   GOBJECT_IF_DEBUG (OBJECTS,
@@ -2197,7 +2330,7 @@ g_object_new_with_custom_constructor (GObjectClass          *class,
           /* This may or may not have been setup in g_object_init().
            * If it hasn't, we do it now.
            */
-          nqueue = g_datalist_id_get_data (&object->qdata, quark_notify_queue);
+          nqueue = g_object_notify_queue_peek (object);
           if (!nqueue)
             nqueue = g_object_notify_queue_freeze (object, FALSE);
         }
@@ -2246,7 +2379,7 @@ g_object_new_internal (GObjectClass          *class,
           /* This may or may not have been setup in g_object_init().
            * If it hasn't, we do it now.
            */
-          nqueue = g_datalist_id_get_data (&object->qdata, quark_notify_queue);
+          nqueue = g_object_notify_queue_peek (object);
           if (!nqueue)
             nqueue = g_object_notify_queue_freeze (object, FALSE);
         }
@@ -2598,6 +2731,287 @@ g_object_new_valist (GType        object_type,
   return object;
 }
 
+typedef struct
+{
+  GParamSpec *pspec;
+  GParamSpec *target_pspec;
+  GObjectClass *class;
+  guint param_id;
+  guint value_index;
+  const GValue *default_value;
+  gboolean (*value_is_valid) (GParamSpec   *pspec,
+                              const GValue *value);
+  guint needs_validation : 1;
+  guint notify : 1;
+} PreparedProperty;
+
+#define PREPARED_PROPERTY_DEFAULT G_MAXUINT
+
+struct _GObjectPreparedNew
+{
+  GObjectClass *class;
+  guint n_properties;
+  guint n_construct_steps;
+  guint n_steps;
+  gboolean needs_notify_queue;
+  PreparedProperty steps[];
+};
+
+static void
+prepared_property_init (PreparedProperty *prop,
+                        GParamSpec       *pspec,
+                        guint             value_index)
+{
+  GParamSpec *target = pspec;
+  GParamSpecClass *pclass;
+
+  prop->pspec = pspec;
+  prop->class = g_type_class_peek (pspec->owner_type);
+  g_assert (prop->class != NULL);
+  prop->param_id = PARAM_SPEC_PARAM_ID (pspec);
+
+  param_spec_follow_override (&target);
+  prop->target_pspec = target;
+
+  prop->value_index = value_index;
+  prop->default_value = (value_index == PREPARED_PROPERTY_DEFAULT)
+      ? g_param_spec_get_default_value (pspec)
+      : NULL;
+
+  pclass = G_PARAM_SPEC_GET_CLASS (target);
+  prop->value_is_valid = pclass->value_is_valid;
+  prop->needs_validation = pclass->value_validate != NULL;
+
+  prop->notify = (target->flags & (G_PARAM_EXPLICIT_NOTIFY | G_PARAM_READABLE)) == G_PARAM_READABLE;
+
+  if (value_index != PREPARED_PROPERTY_DEFAULT)
+    consider_issuing_property_deprecation_warning (target);
+}
+
+static inline void
+object_set_prepared_property (GObject                *object,
+                              const PreparedProperty *prop,
+                              const GValue           *values,
+                              GObjectNotifyQueue     *nqueue)
+{
+  const GValue *value;
+
+  value = (prop->value_index != PREPARED_PROPERTY_DEFAULT)
+      ? &values[prop->value_index]
+      : prop->default_value;
+
+  if (G_LIKELY (G_VALUE_TYPE (value) == prop->target_pspec->value_type) &&
+      (!prop->needs_validation ||
+       (prop->value_is_valid != NULL && prop->value_is_valid (prop->target_pspec, value))))
+    {
+      prop->class->set_property (object, prop->param_id, value, prop->target_pspec);
+
+      if (prop->notify && nqueue != NULL)
+        g_object_notify_queue_add (object, nqueue, prop->target_pspec);
+    }
+  else
+    {
+      /* Leave conversion, validation and the error paths to the general
+       * case. */
+      object_set_property (object, prop->pspec, value, prop->notify ? nqueue : NULL, FALSE);
+    }
+}
+
+/**
+ * g_object_prepare_new: (skip)
+ * @object_type: the object type to instantiate
+ * @n_properties: the number of properties
+ * @names: (array length=n_properties): the names of each property to be set
+ *
+ * Resolves a list of property names against @object_type once, so that
+ * many instances can then be created with g_object_new_prepared() without
+ * looking the properties up and checking them each time.
+ *
+ * The returned structure holds a reference on the class of @object_type
+ * and may be used from any thread. Free it with g_object_prepared_new_free().
+ *
+ * Returns: (transfer full): a new #GObjectPreparedNew
+ *
+ * Since: 2.76
+ */
+GObjectPreparedNew *
+g_object_prepare_new (GType       object_type,
+                      guint       n_properties,
+                      const char *names[])
+{
+  GObjectPreparedNew *prepared;
+  GObjectClass *class;
+  GObjectConstructParam *params;
+  guint *indices;
+  guint i, n_params, n_steps;
+  GSList *node;
+
+  g_return_val_if_fail (G_TYPE_IS_OBJECT (object_type), NULL);
+  g_return_val_if_fail (n_properties == 0 || names != NULL, NULL);
+
+  class = g_type_class_ref (object_type);
+
+  params = g_newa (GObjectConstructParam, n_properties + 1);
+  indices = g_newa (guint, n_properties + 1);
+  n_params = 0;
+  for (i = 0; i < n_properties; i++)
+    {
+      GParamSpec *pspec = find_pspec (class, names[i]);
+
+      if (!g_object_new_is_valid_property (object_type, pspec, names[i], params, n_params))
+        continue;
+      params[n_params].pspec = pspec;
+      params[n_params].value = NULL;
+      indices[n_params] = i;
+      n_params++;
+    }
+
+  n_steps = class->n_construct_properties;
+  for (i = 0; i < n_params; i++)
+    if (!(params[i].pspec->flags & (G_PARAM_CONSTRUCT | G_PARAM_CONSTRUCT_ONLY)))
+      n_steps++;
+
+  prepared = g_malloc0 (sizeof (GObjectPreparedNew) + n_steps * sizeof (PreparedProperty));
+  prepared->class = class;
+  prepared->n_properties = n_properties;
+  prepared->n_construct_steps = class->n_construct_properties;
+  prepared->n_steps = n_steps;
+
+  /* Mirror g_object_new_internal(): every construct property is set, in
+   * class order, from either the caller's values or its default; then the
+   * remaining properties follow in the caller's order.
+   */
+  n_steps = 0;
+  for (node = class->construct_properties; node; node = node->next)
+    {
+      GParamSpec *pspec = node->data;
+      guint value_index = PREPARED_PROPERTY_DEFAULT;
+
+      for (i = 0; i < n_params; i++)
+        if (params[i].pspec == pspec)
+          {
+            value_index = indices[i];
+            break;
+          }
+
+      prepared_property_init (&prepared->steps[n_steps++], pspec, value_index);
+    }
+
+  for (i = 0; i < n_params; i++)
+    if (!(params[i].pspec->flags & (G_PARAM_CONSTRUCT | G_PARAM_CONSTRUCT_ONLY)))
+      prepared_property_init (&prepared->steps[n_steps++], params[i].pspec, indices[i]);
+
+  for (i = 0; i < prepared->n_steps; i++)
+    {
+      const PreparedProperty *prop = &prepared->steps[i];
+
+      if (prop->notify || (prop->target_pspec->flags & G_PARAM_EXPLICIT_NOTIFY) != 0)
+        prepared->needs_notify_queue = TRUE;
+    }
+
+  return prepared;
+}
+
+/**
+ * g_object_new_prepared: (skip)
+ * @prepared: a #GObjectPreparedNew
+ * @values: (array): the values of each property to be set, in the order the
+ *   names were passed to g_object_prepare_new()
+ *
+ * Creates a new instance of the type @prepared was created for, and sets
+ * its properties from @values. This is equivalent to calling
+ * g_object_new_with_properties() with the same names, but cheaper.
+ *
+ * Values holding exactly the type of their property take a fast path;
+ * other values are converted as g_object_new_with_properties() would.
+ *
+ * Returns: (type GObject.Object) (transfer full): a new instance
+ *
+ * Since: 2.76
+ */
+GObject *
+g_object_new_prepared (GObjectPreparedNew *prepared,
+                       const GValue        values[])
+{
+  GObjectClass *class;
+  GObjectNotifyQueue *nqueue = NULL;
+  GObject *object;
+  guint i;
+
+  g_return_val_if_fail (prepared != NULL, NULL);
+  g_return_val_if_fail (prepared->n_properties == 0 || values != NULL, NULL);
+
+  class = prepared->class;
+
+  if (G_UNLIKELY (CLASS_HAS_CUSTOM_CONSTRUCTOR (class)))
+    {
+      GObjectConstructParam *params;
+      guint n_params = 0;
+
+      params = g_newa (GObjectConstructParam, prepared->n_steps + 1);
+      for (i = 0; i < prepared->n_steps; i++)
+        {
+          const PreparedProperty *prop = &prepared->steps[i];
+
+          if (prop->value_index == PREPARED_PROPERTY_DEFAULT)
+            continue;
+          params[n_params].pspec = prop->pspec;
+          params[n_params].value = (GValue *) &values[prop->value_index];
+          n_params++;
+        }
+
+      return g_object_new_with_custom_constructor (class, params, n_params);
+    }
+
+  object = (GObject *) g_type_create_instance (class->g_type_class.g_type);
+
+  g_assert (g_object_is_aligned (object));
+
+  unset_object_in_construction (object);
+
+  if (CLASS_HAS_PROPS (class) && _g_object_has_notify_handler_X (object))
+    {
+      /* g_object_init() has already frozen the queue if the class needs
+       * it; otherwise only freeze it if a property can actually notify.
+       */
+      nqueue = g_object_notify_queue_peek (object);
+      if (!nqueue && prepared->needs_notify_queue)
+        nqueue = g_object_notify_queue_freeze (object, FALSE);
+    }
+
+  for (i = 0; i < prepared->n_construct_steps; i++)
+    object_set_prepared_property (object, &prepared->steps[i], values, nqueue);
+
+  if (CLASS_HAS_CUSTOM_CONSTRUCTED (class))
+    class->constructed (object);
+
+  for (; i < prepared->n_steps; i++)
+    object_set_prepared_property (object, &prepared->steps[i], values, nqueue);
+
+  if (nqueue)
+    g_object_notify_queue_thaw (object, nqueue);
+
+  return object;
+}
+
+/**
+ * g_object_prepared_new_free:
+ * @prepared: (transfer full): a #GObjectPreparedNew
+ *
+ * Frees @prepared and drops its reference on the object class. No other
+ * thread may be using @prepared at the same time.
+ *
+ * Since: 2.76
+ */
+void
+g_object_prepared_new_free (GObjectPreparedNew *prepared)
+{
+  g_return_if_fail (prepared != NULL);
+
+  g_type_class_unref (prepared->class);
+  g_free (prepared);
+}
+
 static GObject*
 g_object_constructor (GType                  type,
 		      guint                  n_construct_properties,
@@ -3304,7 +3718,7 @@ g_object_weak_ref (GObject    *object,
   g_return_if_fail (notify != NULL);
   g_return_if_fail (g_atomic_int_get (&object->ref_count) >= 1);
 
-  G_LOCK (weak_refs_mutex);
+  g_mutex_lock (&object_get_locks (object)->weak_refs_mutex);
   wstack = g_datalist_id_remove_no_notify (&object->qdata, quark_weak_refs);
   if (wstack)
     {
@@ -3321,7 +3735,7 @@ g_object_weak_ref (GObject    *object,
   wstack->weak_refs[i].notify = notify;
   wstack->weak_refs[i].data = data;
   g_datalist_id_set_data_full (&object->qdata, quark_weak_refs, wstack, weak_refs_notify);
-  G_UNLOCK (weak_refs_mutex);
+  g_mutex_unlock (&object_get_locks (object)->weak_refs_mutex);
 }
 
 /**
@@ -3343,7 +3757,7 @@ g_object_weak_unref (GObject    *object,
   g_return_if_fail (G_IS_OBJECT (object));
   g_return_if_fail (notify != NULL);
 
-  G_LOCK (weak_refs_mutex);
+  g_mutex_lock (&object_get_locks (object)->weak_refs_mutex);
   wstack = g_datalist_id_get_data (&object->qdata, quark_weak_refs);
   if (wstack)
     {
@@ -3361,7 +3775,7 @@ g_object_weak_unref (GObject    *object,
 	    break;
 	  }
     }
-  G_UNLOCK (weak_refs_mutex);
+  g_mutex_unlock (&object_get_locks (object)->weak_refs_mutex);
   if (!found_one)
     g_critical ("%s: couldn't find weak ref %p(%p)", G_STRFUNC, notify, data);
 }
@@ -3581,22 +3995,23 @@ static void
 toggle_refs_notify (GObject *object,
 		    gboolean is_last_ref)
 {
+  GMutex *toggle_refs_mutex = &object_get_locks (object)->toggle_refs_mutex;
   ToggleRefStack tstack, *tstackptr;
 
-  G_LOCK (toggle_refs_mutex);
+  g_mutex_lock (toggle_refs_mutex);
   /* If another thread removed the toggle reference on the object, while
    * we were waiting here, there's nothing to notify.
    * So let's check again if the object has toggle reference and in case return.
    */
   if (!OBJECT_HAS_TOGGLE_REF (object))
     {
-      G_UNLOCK (toggle_refs_mutex);
+      g_mutex_unlock (toggle_refs_mutex);
       return;
     }
 
   tstackptr = g_datalist_id_get_data (&object->qdata, quark_toggle_refs);
   tstack = *tstackptr;
-  G_UNLOCK (toggle_refs_mutex);
+  g_mutex_unlock (toggle_refs_mutex);
 
   /* Reentrancy here is not as tricky as it seems, because a toggle reference
    * will only be notified when there is exactly one of them.
@@ -3658,7 +4073,7 @@ g_object_add_toggle_ref (GObject       *object,
 
   g_object_ref (object);
 
-  G_LOCK (toggle_refs_mutex);
+  g_mutex_lock (&object_get_locks (object)->toggle_refs_mutex);
   tstack = g_datalist_id_remove_no_notify (&object->qdata, quark_toggle_refs);
   if (tstack)
     {
@@ -3683,7 +4098,7 @@ g_object_add_toggle_ref (GObject       *object,
   tstack->toggle_refs[i].data = data;
   g_datalist_id_set_data_full (&object->qdata, quark_toggle_refs, tstack,
 			       (GDestroyNotify)g_free);
-  G_UNLOCK (toggle_refs_mutex);
+  g_mutex_unlock (&object_get_locks (object)->toggle_refs_mutex);
 }
 
 /**
@@ -3711,7 +4126,7 @@ g_object_remove_toggle_ref (GObject       *object,
   g_return_if_fail (G_IS_OBJECT (object));
   g_return_if_fail (notify != NULL);
 
-  G_LOCK (toggle_refs_mutex);
+  g_mutex_lock (&object_get_locks (object)->toggle_refs_mutex);
   tstack = g_datalist_id_get_data (&object->qdata, quark_toggle_refs);
   if (tstack)
     {
@@ -3732,7 +4147,7 @@ g_object_remove_toggle_ref (GObject       *object,
 	    break;
 	  }
     }
-  G_UNLOCK (toggle_refs_mutex);
+  g_mutex_unlock (&object_get_locks (object)->toggle_refs_mutex);
 
   if (found_one)
     g_object_unref (object);
@@ -3813,7 +4228,7 @@ g_object_unref (gpointer _object)
     }
   else
     {
-      GSList **weak_locations;
+      WeakLocations *weak_locations;
       GObjectNotifyQueue *nqueue;
 
       /* The only way that this object can live at this point is if
@@ -3833,7 +4248,9 @@ g_object_unref (gpointer _object)
 
       if (weak_locations != NULL)
         {
-          g_rw_lock_writer_lock (&weak_locations_lock);
+          GRWLock *weak_locations_lock = &object_get_locks (object)->weak_locations_lock;
+
+          g_rw_lock_writer_lock (weak_locations_lock);
 
           /* It is possible that one of the weak references beat us to
            * the lock. Make sure the refcount is still what we expected
@@ -3842,7 +4259,7 @@ g_object_unref (gpointer _object)
           old_ref = g_atomic_int_get (&object->ref_count);
           if (old_ref != 1)
             {
-              g_rw_lock_writer_unlock (&weak_locations_lock);
+              g_rw_lock_writer_unlock (weak_locations_lock);
               goto retry_atomic_decrement1;
             }
 
@@ -3853,7 +4270,7 @@ g_object_unref (gpointer _object)
                                                            quark_weak_locations);
           g_clear_pointer (&weak_locations, weak_locations_free_unlocked);
 
-          g_rw_lock_writer_unlock (&weak_locations_lock);
+          g_rw_lock_writer_unlock (weak_locations_lock);
         }
 
       /* freeze the notification queue, so we don't accidentally emit
@@ -4657,10 +5074,11 @@ object_remove_closure (gpointer  data,
 		       GClosure *closure)
 {
   GObject *object = data;
+  GMutex *closure_array_mutex = &object_get_locks (object)->closure_array_mutex;
   CArray *carray;
   guint i;
   
-  G_LOCK (closure_array_mutex);
+  g_mutex_lock (closure_array_mutex);
   carray = g_object_get_qdata (object, quark_closure_array);
   for (i = 0; i < carray->n_closures; i++)
     if (carray->closures[i] == closure)
@@ -4668,10 +5086,10 @@ object_remove_closure (gpointer  data,
 	carray->n_closures--;
 	if (i < carray->n_closures)
 	  carray->closures[i] = carray->closures[carray->n_closures];
-	G_UNLOCK (closure_array_mutex);
+	g_mutex_unlock (closure_array_mutex);
 	return;
       }
-  G_UNLOCK (closure_array_mutex);
+  g_mutex_unlock (closure_array_mutex);
   g_assert_not_reached ();
 }
 
@@ -4727,7 +5145,7 @@ g_object_watch_closure (GObject  *object,
   g_closure_add_marshal_guards (closure,
 				object, (GClosureNotify) g_object_ref,
 				object, (GClosureNotify) g_object_unref);
-  G_LOCK (closure_array_mutex);
+  g_mutex_lock (&object_get_locks (object)->closure_array_mutex);
   carray = g_datalist_id_remove_no_notify (&object->qdata, quark_closure_array);
   if (!carray)
     {
@@ -4743,7 +5161,7 @@ g_object_watch_closure (GObject  *object,
     }
   carray->closures[i] = closure;
   g_datalist_id_set_data_full (&object->qdata, quark_closure_array, carray, destroy_closure_array);
-  G_UNLOCK (closure_array_mutex);
+  g_mutex_unlock (&object_get_locks (object)->closure_array_mutex);
 }
 
 /**
@@ -4971,32 +5389,41 @@ g_weak_ref_get (GWeakRef *weak_ref)
 
   g_return_val_if_fail (weak_ref!= NULL, NULL);
 
-  g_rw_lock_reader_lock (&weak_locations_lock);
+  for (;;)
+    {
+      GRWLock *weak_locations_lock;
 
-  object_or_null = weak_ref->priv.p;
+      object_or_null = g_atomic_pointer_get (&weak_ref->priv.p);
+      if (object_or_null == NULL)
+        return NULL;
 
-  if (object_or_null != NULL)
-    g_object_ref (object_or_null);
+      /* The object may be going away, so it can only be relied upon once
+       * we hold its lock and @weak_ref still points to it. */
+      weak_locations_lock = &object_get_locks (object_or_null)->weak_locations_lock;
+      g_rw_lock_reader_lock (weak_locations_lock);
 
-  g_rw_lock_reader_unlock (&weak_locations_lock);
+      if (weak_ref->priv.p == object_or_null)
+        {
+          g_object_ref (object_or_null);
+          g_rw_lock_reader_unlock (weak_locations_lock);
+          return object_or_null;
+        }
 
-  return object_or_null;
+      g_rw_lock_reader_unlock (weak_locations_lock);
+    }
 }
 
 static void
-weak_locations_free_unlocked (GSList **weak_locations)
+weak_locations_free_unlocked (WeakLocations *weak_locations)
 {
-  if (*weak_locations)
-    {
-      GSList *weak_location;
+  GSList *weak_location;
 
-      for (weak_location = *weak_locations; weak_location;)
-        {
-          GWeakRef *weak_ref_location = weak_location->data;
+  for (weak_location = weak_locations->weak_refs; weak_location;)
+    {
+      GWeakRef *weak_ref_location = weak_location->data;
 
-          weak_ref_location->priv.p = NULL;
-          weak_location = g_slist_delete_link (weak_location, weak_location);
-        }
+      g_atomic_pointer_set (&weak_ref_location->priv.p, NULL);
+      weak_location = g_slist_delete_link (weak_location, weak_location);
     }
 
   g_free (weak_locations);
@@ -5005,11 +5432,51 @@ weak_locations_free_unlocked (GSList **weak_locations)
 static void
 weak_locations_free (gpointer data)
 {
-  GSList **weak_locations = data;
+  WeakLocations *weak_locations = data;
+  GRWLock *weak_locations_lock = &object_get_locks (weak_locations->object)->weak_locations_lock;
 
-  g_rw_lock_writer_lock (&weak_locations_lock);
+  g_rw_lock_writer_lock (weak_locations_lock);
   weak_locations_free_unlocked (weak_locations);
-  g_rw_lock_writer_unlock (&weak_locations_lock);
+  g_rw_lock_writer_unlock (weak_locations_lock);
+}
+
+/* Takes the weak locations locks of both objects, either of which may be
+ * %NULL, in a fixed order so that two g_weak_ref_set() can't deadlock. */
+static void
+weak_locations_lock_pair (GObject  *object_a,
+                          GObject  *object_b,
+                          GRWLock **lock_a,
+                          GRWLock **lock_b)
+{
+  GRWLock *a = object_a != NULL ? &object_get_locks (object_a)->weak_locations_lock : NULL;
+  GRWLock *b = object_b != NULL ? &object_get_locks (object_b)->weak_locations_lock : NULL;
+
+  if (a == b)
+    b = NULL;
+  else if (a == NULL || (b != NULL && b < a))
+    {
+      GRWLock *tmp = a;
+      a = b;
+      b = tmp;
+    }
+
+  if (a != NULL)
+    g_rw_lock_writer_lock (a);
+  if (b != NULL)
+    g_rw_lock_writer_lock (b);
+
+  *lock_a = a;
+  *lock_b = b;
+}
+
+static void
+weak_locations_unlock_pair (GRWLock *lock_a,
+                            GRWLock *lock_b)
+{
+  if (lock_b != NULL)
+    g_rw_lock_writer_unlock (lock_b);
+  if (lock_a != NULL)
+    g_rw_lock_writer_unlock (lock_a);
 }
 
 /**
@@ -5029,16 +5496,26 @@ void
 g_weak_ref_set (GWeakRef *weak_ref,
                 gpointer  object)
 {
-  GSList **weak_locations;
+  WeakLocations *weak_locations;
   GObject *new_object;
   GObject *old_object;
+  GRWLock *lock_a, *lock_b;
 
   g_return_if_fail (weak_ref != NULL);
   g_return_if_fail (object == NULL || G_IS_OBJECT (object));
 
   new_object = object;
 
-  g_rw_lock_writer_lock (&weak_locations_lock);
+  /* Both the old and the new object's locks are needed, and which object
+   * is the old one is only known for sure once we hold its lock. */
+  for (;;)
+    {
+      old_object = g_atomic_pointer_get (&weak_ref->priv.p);
+      weak_locations_lock_pair (old_object, new_object, &lock_a, &lock_b);
+      if (weak_ref->priv.p == old_object)
+        break;
+      weak_locations_unlock_pair (lock_a, lock_b);
+    }
 
   /* We use the extra level of indirection here so that if we have ever
    * had a weak pointer installed at any point in time on this object,
@@ -5055,10 +5532,9 @@ g_weak_ref_set (GWeakRef *weak_ref,
    * races.
    */
 
-  old_object = weak_ref->priv.p;
   if (new_object != old_object)
     {
-      weak_ref->priv.p = new_object;
+      g_atomic_pointer_set (&weak_ref->priv.p, new_object);
 
       /* Remove the weak ref from the old object */
       if (old_object != NULL)
@@ -5074,9 +5550,9 @@ g_weak_ref_set (GWeakRef *weak_ref,
             }
           else
             {
-              *weak_locations = g_slist_remove (*weak_locations, weak_ref);
+              weak_locations->weak_refs = g_slist_remove (weak_locations->weak_refs, weak_ref);
 
-              if (!*weak_locations)
+              if (!weak_locations->weak_refs)
                 {
                   weak_locations_free_unlocked (weak_locations);
                   g_datalist_id_remove_no_notify (&old_object->qdata, quark_weak_locations);
@@ -5091,14 +5567,15 @@ g_weak_ref_set (GWeakRef *weak_ref,
 
           if (weak_locations == NULL)
             {
-              weak_locations = g_new0 (GSList *, 1);
+              weak_locations = g_new0 (WeakLocations, 1);
+              weak_locations->object = new_object;
               g_datalist_id_set_data_full (&new_object->qdata, quark_weak_locations,
                                            weak_locations, weak_locations_free);
             }
 
-          *weak_locations = g_slist_prepend (*weak_locations, weak_ref);
+          weak_locations->weak_refs = g_slist_prepend (weak_locations->weak_refs, weak_ref);
         }
     }
 
-  g_rw_lock_writer_unlock (&weak_locations_lock);
+  weak_locations_unlock_pair (lock_a, lock_b);
 }
@@ -194,6 +194,16 @@ typedef struct _GObjectClass             GObjectClass;
 typedef struct _GObject                  GInitiallyUnowned;
 typedef struct _GObjectClass             GInitiallyUnownedClass;
 typedef struct _GObjectConstructParam    GObjectConstructParam;
+
+/**
+ * GObjectPreparedNew:
+ *
+ * An opaque structure holding a property list resolved against an object
+ * type by g_object_prepare_new(), for use with g_object_new_prepared().
+ *
+ * Since: 2.76
+ */
+typedef struct _GObjectPreparedNew       GObjectPreparedNew;
 /**
  * GObjectGetPropertyFunc:
  * @object: a #GObject
@@ -466,6 +476,16 @@ GOBJECT_AVAILABLE_IN_ALL
 GObject*    g_object_new_valist               (GType           object_type,
 					       const gchar    *first_property_name,
 					       va_list         var_args);
+GOBJECT_AVAILABLE_IN_2_76
+GObjectPreparedNew *
+            g_object_prepare_new              (GType           object_type,
+                                               guint           n_properties,
+                                               const char     *names[]);
+GOBJECT_AVAILABLE_IN_2_76
+GObject*    g_object_new_prepared             (GObjectPreparedNew *prepared,
+                                               const GValue    values[]);
+GOBJECT_AVAILABLE_IN_2_76
+void        g_object_prepared_new_free        (GObjectPreparedNew *prepared);
 GOBJECT_AVAILABLE_IN_ALL
 void	    g_object_set                      (gpointer	       object,
 					       const gchar    *first_property_name,
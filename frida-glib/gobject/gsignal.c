@@ -37,6 +37,9 @@
 #include "gobject.h"
 #include "genums.h"
 #include "gobject_trace.h"
+#ifdef HAVE_SPECIALISED_MARSHALLERS
+#include "gmarshal-specialised.h"
+#endif
 
 #ifdef G_DISABLE_CHECKS
 #include "glib-nolog.h"
@@ -145,6 +148,10 @@ typedef struct _Emission     Emission;
 typedef struct _Handler      Handler;
 typedef struct _HandlerList  HandlerList;
 typedef struct _HandlerMatch HandlerMatch;
+typedef struct _HandlerSnapshot HandlerSnapshot;
+typedef struct _InstanceHandlers InstanceHandlers;
+typedef struct _InstanceHandlersTable InstanceHandlersTable;
+typedef struct _SignalThread SignalThread;
 typedef enum
 {
   EMISSION_STOP,
@@ -158,6 +165,7 @@ typedef enum
 static inline guint   signal_id_lookup  (const gchar *name,
                                          GType        itype);
 static	      void		signal_destroy_R	(SignalNode	 *signal_node);
+static inline GBSearchArray*	handler_list_bsa_get	(gpointer	  instance);
 static inline HandlerList*	handler_list_ensure	(guint		  signal_id,
 							 gpointer	  instance);
 static inline HandlerList*	handler_list_lookup	(guint		  signal_id,
@@ -189,13 +197,25 @@ static inline void		handler_ref		(Handler	 *handler);
 static inline void		handler_unref_R		(guint		  signal_id,
 							 gpointer	  instance,
 							 Handler	 *handler);
+static	      void		handler_list_publish_R	(guint		  signal_id,
+							 gpointer	  instance);
+static inline HandlerSnapshot*	handler_snapshot_acquire (SignalThread	 *thread,
+							 gpointer	  instance,
+							 guint		  signal_id);
+static inline void		handler_snapshot_release (HandlerSnapshot *snapshot);
+static inline void		handler_snapshot_unref_R (HandlerSnapshot *snapshot);
+static inline SignalThread*	signal_thread_get	(void);
+static	      void		signal_synchronize	(void);
 static gint			handler_lists_cmp	(gconstpointer	  node1,
 							 gconstpointer	  node2);
-static inline void		emission_push		(Emission	 *emission);
-static inline void		emission_pop		(Emission	 *emission);
+static inline void		emission_push		(SignalThread	 *thread,
+							 Emission	 *emission);
+static inline void		emission_pop		(SignalThread	 *thread,
+							 Emission	 *emission);
 static inline Emission*		emission_find		(guint		  signal_id,
 							 GQuark		  detail,
 							 gpointer	  instance);
+static inline Emission*		emission_find_innermost	(gpointer	  instance);
 static gint			class_closures_cmp	(gconstpointer	  node1,
 							 gconstpointer	  node2);
 static gint			signal_key_cmp		(gconstpointer	  node1,
@@ -214,6 +234,11 @@ static       void               invalid_closure_notify  (gpointer         data,
 static const gchar *            type_debug_name         (GType            type);
 static void                     node_check_deprecated   (const SignalNode *node);
 static void                     node_update_single_va_closure (SignalNode *node);
+static gboolean                 specialised_marshaller_lookup (guint                 n_params,
+                                                               const GType          *param_types,
+                                                               GType                 return_type,
+                                                               GSignalCMarshaller   *c_marshaller,
+                                                               GSignalCVaMarshaller *va_marshaller);
 
 
 /* --- structures --- */
@@ -240,16 +265,18 @@ struct _SignalNode
   /* reinitializable portion */
   guint              flags : 9;
   guint              n_params : 8;
-  guint              single_va_closure_is_valid : 1;
-  guint              single_va_closure_is_after : 1;
+  guint              plain_params : 1; /* see signal_param_is_plain() */
   GType		    *param_types; /* mangled with G_SIGNAL_TYPE_STATIC_SCOPE flag */
   GType		     return_type; /* mangled with G_SIGNAL_TYPE_STATIC_SCOPE flag */
-  GBSearchArray     *class_closure_bsa;
+  GBSearchArray     *class_closure_bsa; /* (atomic), replaced rather than modified */
   SignalAccumulator *accumulator;
   GSignalCMarshaller c_marshaller;
   GSignalCVaMarshaller va_marshaller;
   GHookList         *emission_hooks;
 
+  /* (atomic), kept up to date by node_update_single_va_closure() whenever
+   * anything it depends on changes; when it is a real closure it runs first
+   * or last according to flags */
   GClosure *single_va_closure;
 };
 
@@ -264,10 +291,11 @@ struct _SignalKey
 
 struct _Emission
 {
-  Emission             *next;
+  Emission             *next;            /* the emitting thread's emissions */
+  Emission             *next_no_recurse; /* all G_SIGNAL_NO_RECURSE emissions */
   gpointer              instance;
   GSignalInvocationHint ihint;
-  EmissionState         state;
+  gint                  state;           /* (atomic) EmissionState */
   GType			chain_type;
 };
 
@@ -277,6 +305,7 @@ struct _HandlerList
   Handler *handlers;
   Handler *tail_before;  /* normal signal handlers are appended here  */
   Handler *tail_after;   /* CONNECT_AFTER handlers are appended here  */
+  HandlerSnapshot *snapshot;  /* (atomic) what emissions see, see below */
 };
 
 struct _Handler
@@ -287,7 +316,7 @@ struct _Handler
   GQuark	detail;
   guint         signal_id;
   guint         ref_count;
-  guint         block_count : 16;
+  guint         block_count; /* (atomic) */
 #define HANDLER_MAX_BLOCK_COUNT (1 << 16)
   guint         after : 1;
   guint         has_invalid_closure_notify : 1;
@@ -301,6 +330,66 @@ struct _HandlerMatch
   guint         signal_id;
 };
 
+/* Emission does not take the signal lock. Instead, each handler list
+ * publishes an immutable array of its connected handlers, which emission
+ * looks up without locking and holds a reference on while it runs. The
+ * array holds a reference on each of its handlers, and is replaced whenever
+ * a handler gets connected or disconnected. For this to work, an instance's
+ * handler list array is replaced rather than resized in place.
+ */
+struct _HandlerSnapshot
+{
+  gpointer  instance;
+  guint     signal_id;
+  gint      ref_count;    /* (atomic) */
+  guint     n_handlers;
+  guint     n_before;     /* handlers[n_before] is the first CONNECT_AFTER one */
+  Handler  *handlers[1];  /* (array length=n_handlers) */
+};
+
+/* GObjects keep their handler list array inline, see
+ * _g_object_get_signal_handlers_location(). Any other instance gets one of
+ * these, in an open addressing index keyed by instance. The index is only
+ * ever modified with the signal lock held; readers find entries without
+ * locking, which is why removed entries are replaced by a tombstone and the
+ * index is replaced rather than resized in place.
+ */
+struct _InstanceHandlers
+{
+  gpointer       instance;
+  GBSearchArray *hlbsa;  /* (atomic) */
+};
+
+struct _InstanceHandlersTable
+{
+  gsize             mask;
+  gsize             n_live;
+  gsize             n_used;       /* live entries plus tombstones */
+  InstanceHandlers *entries[1];   /* (atomic) (array length=mask+1) */
+};
+
+/* Per-thread state: the thread's emission stack, and which reader slot it
+ * announces its lock-free reads in. */
+struct _SignalThread
+{
+  Emission *emissions;
+  guint     reader_slot;
+};
+
+/* Lock-free readers bump a counter for the current phase in their slot while
+ * they look something up. Writers unpublish what they are about to free,
+ * then flip the phase and wait for the previous phase's counters to drain,
+ * twice, after which no reader can still be looking at it. Slots are spread
+ * out over cache lines so that readers on different threads do not contend.
+ */
+#define N_SIGNAL_READER_SLOTS 16
+
+typedef struct
+{
+  gint count[2];  /* (atomic) */
+  gint padding[14];
+} SignalReaderSlot;
+
 typedef struct
 {
   GType     instance_type; /* 0 for default closure */
@@ -325,8 +414,13 @@ static GBSearchConfig g_class_closure_bconfig = {
   class_closures_cmp,
   0,
 };
-static GHashTable    *g_handler_list_bsa_ht = NULL;
-static Emission      *g_emissions = NULL;
+static InstanceHandlersTable *g_instance_handlers = NULL; /* (atomic) */
+static InstanceHandlers g_instance_handlers_tombstone = { NULL, NULL };
+#define INSTANCE_HANDLERS_TOMBSTONE (&g_instance_handlers_tombstone)
+static SignalReaderSlot g_signal_readers[N_SIGNAL_READER_SLOTS];
+static gint           g_signal_reader_phase = 0; /* (atomic) */
+static GPrivate       g_signal_thread = G_PRIVATE_INIT (g_free);
+static Emission      *g_no_recurse_emissions = NULL;
 static gulong         g_handler_sequential_number = 1;
 static GHashTable    *g_handlers = NULL;
 
@@ -336,18 +430,42 @@ G_LOCK_DEFINE_STATIC (g_signal_mutex);
 
 
 /* --- signal nodes --- */
-static guint          g_n_signal_nodes = 0;
-static SignalNode   **g_signal_nodes = NULL;
+static guint          g_n_signal_nodes = 0;    /* (atomic) */
+static SignalNode   **g_signal_nodes = NULL;   /* (atomic) */
+static guint          g_signal_nodes_size = 0;
 
+/* Safe to call without holding the signal lock: the nodes array only grows,
+ * by being copied, and old copies are never freed. */
 static inline SignalNode*
 LOOKUP_SIGNAL_NODE (guint signal_id)
 {
-  if (signal_id < g_n_signal_nodes)
-    return g_signal_nodes[signal_id];
+  if (signal_id < (guint) g_atomic_int_get (&g_n_signal_nodes))
+    return ((SignalNode **) g_atomic_pointer_get (&g_signal_nodes))[signal_id];
   else
     return NULL;
 }
 
+static guint
+signal_node_append (SignalNode *node)
+{
+  guint signal_id = g_n_signal_nodes;
+
+  if (signal_id == g_signal_nodes_size)
+    {
+      SignalNode **nodes;
+
+      g_signal_nodes_size = MAX (g_signal_nodes_size * 2, 64);
+      nodes = g_new (SignalNode*, g_signal_nodes_size);
+      if (signal_id > 0)
+        memcpy (nodes, g_signal_nodes, signal_id * sizeof (SignalNode*));
+      g_atomic_pointer_set (&g_signal_nodes, nodes);
+    }
+  g_signal_nodes[signal_id] = node;
+  g_atomic_int_set (&g_n_signal_nodes, signal_id + 1);
+
+  return signal_id;
+}
+
 
 /* --- functions --- */
 /* @key must have already been validated with is_valid()
@@ -478,30 +596,272 @@ handler_lists_cmp (gconstpointer node1,
   return G_BSEARCH_ARRAY_CMP (hlist1->signal_id, hlist2->signal_id);
 }
 
+static inline SignalThread*
+signal_thread_get (void)
+{
+  SignalThread *thread = g_private_get (&g_signal_thread);
+
+  if (G_UNLIKELY (thread == NULL))
+    {
+      static gint next_reader_slot = 0;
+
+      thread = g_new0 (SignalThread, 1);
+      thread->reader_slot = (guint) g_atomic_int_add (&next_reader_slot, 1) % N_SIGNAL_READER_SLOTS;
+      g_private_set (&g_signal_thread, thread);
+    }
+
+  return thread;
+}
+
+static inline guint
+signal_read_begin (SignalThread *thread)
+{
+  guint phase = (guint) g_atomic_int_get (&g_signal_reader_phase);
+
+  g_atomic_int_inc (&g_signal_readers[thread->reader_slot].count[phase]);
+
+  return phase;
+}
+
+static inline void
+signal_read_end (SignalThread *thread,
+                 guint         phase)
+{
+  g_atomic_int_add (&g_signal_readers[thread->reader_slot].count[phase], -1);
+}
+
+/* Must be called with the signal lock held, after unpublishing whatever is
+ * about to be freed. Waits for every read-side section that may have seen
+ * it to end.
+ *
+ * Holding the lock while waiting cannot deadlock: read-side sections only
+ * load and search the published arrays and take references on snapshots.
+ * They never take the signal lock or any other lock (type checks on them
+ * are lock-free ancestry tests), never call out to handlers or closures,
+ * and never call this function, so each of them ends after a bounded
+ * number of steps whatever the writer holds.  The lock is kept rather than
+ * dropped for the wait, because callers go on to use the state they just
+ * published.
+ */
+static void
+signal_synchronize (void)
+{
+  guint round, i;
+
+  for (round = 0; round < 2; round++)
+    {
+      guint phase = (guint) g_atomic_int_get (&g_signal_reader_phase);
+
+      g_atomic_int_set (&g_signal_reader_phase, phase ^ 1);
+
+      for (i = 0; i < N_SIGNAL_READER_SLOTS; i++)
+        while (g_atomic_int_get (&g_signal_readers[i].count[phase]) != 0)
+          g_thread_yield ();
+    }
+}
+
+static inline gsize
+instance_handlers_hash (gconstpointer instance)
+{
+  gsize h = GPOINTER_TO_SIZE (instance);
+
+  h ^= h >> 16;
+  h *= 0x45d9f3b;
+  h ^= h >> 16;
+
+  return h;
+}
+
+static inline InstanceHandlers*
+instance_handlers_table_lookup (InstanceHandlersTable *table,
+                                gconstpointer          instance)
+{
+  gsize i;
+
+  if (table == NULL)
+    return NULL;
+
+  /* the table is never full, so this always hits an empty slot eventually */
+  for (i = instance_handlers_hash (instance) & table->mask;; i = (i + 1) & table->mask)
+    {
+      InstanceHandlers *entry = g_atomic_pointer_get (&table->entries[i]);
+
+      if (entry == NULL)
+        return NULL;
+      if (entry->instance == instance)
+        return entry;
+    }
+}
+
+static gsize
+instance_handlers_table_find_empty (InstanceHandlersTable *table,
+                                    gconstpointer          instance)
+{
+  gsize i;
+
+  for (i = instance_handlers_hash (instance) & table->mask;
+       table->entries[i] != NULL;
+       i = (i + 1) & table->mask)
+    ;
+
+  return i;
+}
+
+/* Replaces the table with one that has room for @n_live entries and
+ * no tombstones. */
+static void
+instance_handlers_table_resize (gsize n_live)
+{
+  InstanceHandlersTable *old_table = g_instance_handlers;
+  InstanceHandlersTable *table;
+  gsize n_slots = 16;
+
+  while (n_slots < n_live * 2)
+    n_slots *= 2;
+
+  table = g_malloc0 (G_STRUCT_OFFSET (InstanceHandlersTable, entries) +
+                     n_slots * sizeof (InstanceHandlers *));
+  table->mask = n_slots - 1;
+
+  if (old_table != NULL)
+    {
+      gsize i;
+
+      for (i = 0; i <= old_table->mask; i++)
+        {
+          InstanceHandlers *entry = old_table->entries[i];
+
+          if (entry != NULL && entry != INSTANCE_HANDLERS_TOMBSTONE)
+            {
+              table->entries[instance_handlers_table_find_empty (table, entry->instance)] = entry;
+              table->n_live++;
+              table->n_used++;
+            }
+        }
+    }
+
+  g_atomic_pointer_set (&g_instance_handlers, table);
+
+  if (old_table != NULL)
+    {
+      signal_synchronize ();
+      g_free (old_table);
+    }
+}
+
+static InstanceHandlers*
+instance_handlers_table_insert (gpointer instance)
+{
+  InstanceHandlersTable *table = g_instance_handlers;
+  InstanceHandlers *entry;
+  gsize i, slot = G_MAXSIZE;
+
+  if (table != NULL)
+    {
+      for (i = instance_handlers_hash (instance) & table->mask;
+           table->entries[i] != NULL;
+           i = (i + 1) & table->mask)
+        {
+          if (table->entries[i] == INSTANCE_HANDLERS_TOMBSTONE)
+            {
+              slot = i;
+              break;
+            }
+        }
+    }
+
+  if (slot == G_MAXSIZE)
+    {
+      if (table == NULL || (table->n_used + 1) * 4 > (table->mask + 1) * 3)
+        {
+          instance_handlers_table_resize ((table != NULL ? table->n_live : 0) + 1);
+          table = g_instance_handlers;
+        }
+      slot = instance_handlers_table_find_empty (table, instance);
+      table->n_used++;
+    }
+
+  entry = g_new0 (InstanceHandlers, 1);
+  entry->instance = instance;
+  table->n_live++;
+  g_atomic_pointer_set (&table->entries[slot], entry);
+
+  return entry;
+}
+
+/* The entry must not be freed before a signal_synchronize(). */
+static void
+instance_handlers_table_remove (InstanceHandlers *entry)
+{
+  InstanceHandlersTable *table = g_instance_handlers;
+  gsize i;
+
+  for (i = instance_handlers_hash (entry->instance) & table->mask;
+       table->entries[i] != entry;
+       i = (i + 1) & table->mask)
+    ;
+
+  g_atomic_pointer_set (&table->entries[i], INSTANCE_HANDLERS_TOMBSTONE);
+  table->n_live--;
+}
+
+/* Where @instance keeps its handler list array, or %NULL if it has none
+ * yet. Does not take the signal lock, but the location is only good until
+ * the end of the read-side section or until the lock is dropped. */
+static inline GBSearchArray**
+handler_list_bsa_location (gpointer instance)
+{
+  InstanceHandlers *entry;
+
+  if (G_TYPE_CHECK_INSTANCE_TYPE (instance, G_TYPE_OBJECT))
+    return (GBSearchArray **) _g_object_get_signal_handlers_location (instance);
+
+  entry = instance_handlers_table_lookup (g_atomic_pointer_get (&g_instance_handlers), instance);
+
+  return entry != NULL ? &entry->hlbsa : NULL;
+}
+
+static inline GBSearchArray*
+handler_list_bsa_get (gpointer instance)
+{
+  GBSearchArray **location = handler_list_bsa_location (instance);
+
+  return location != NULL ? g_atomic_pointer_get (location) : NULL;
+}
+
 static inline HandlerList*
 handler_list_ensure (guint    signal_id,
 		     gpointer instance)
 {
-  GBSearchArray *hlbsa = g_hash_table_lookup (g_handler_list_bsa_ht, instance);
-  HandlerList key;
+  GBSearchArray **location = handler_list_bsa_location (instance);
+  GBSearchArray *hlbsa, *o;
+  HandlerList key, *hlist;
   
   key.signal_id = signal_id;
   key.handlers    = NULL;
   key.tail_before = NULL;
   key.tail_after  = NULL;
-  if (!hlbsa)
-    {
-      hlbsa = g_bsearch_array_create (&g_signal_hlbsa_bconfig);
-      hlbsa = g_bsearch_array_insert (hlbsa, &g_signal_hlbsa_bconfig, &key);
-      g_hash_table_insert (g_handler_list_bsa_ht, instance, hlbsa);
-    }
+  key.snapshot    = NULL;
+  if (!location)
+    location = &instance_handlers_table_insert (instance)->hlbsa;
+  o = *location;
+  if (!o)
+    hlbsa = g_bsearch_array_create (&g_signal_hlbsa_bconfig);
   else
     {
-      GBSearchArray *o = hlbsa;
+      hlist = g_bsearch_array_lookup (o, &g_signal_hlbsa_bconfig, &key);
+      if (hlist)
+        return hlist;
 
-      hlbsa = g_bsearch_array_insert (o, &g_signal_hlbsa_bconfig, &key);
-      if (hlbsa != o)
-	g_hash_table_insert (g_handler_list_bsa_ht, instance, hlbsa);
+      /* emissions look handler lists up without locking, so copy on write */
+      hlbsa = g_memdup2 (o, sizeof (GBSearchArray) + o->n_nodes * g_signal_hlbsa_bconfig.sizeof_node);
+    }
+  hlbsa = g_bsearch_array_insert (hlbsa, &g_signal_hlbsa_bconfig, &key);
+  g_atomic_pointer_set (location, hlbsa);
+  if (o)
+    {
+      signal_synchronize ();
+      g_bsearch_array_free (o, &g_signal_hlbsa_bconfig);
     }
   return g_bsearch_array_lookup (hlbsa, &g_signal_hlbsa_bconfig, &key);
 }
@@ -510,7 +870,7 @@ static inline HandlerList*
 handler_list_lookup (guint    signal_id,
 		     gpointer instance)
 {
-  GBSearchArray *hlbsa = g_hash_table_lookup (g_handler_list_bsa_ht, instance);
+  GBSearchArray *hlbsa = handler_list_bsa_get (instance);
   HandlerList key;
   
   key.signal_id = signal_id;
@@ -518,6 +878,113 @@ handler_list_lookup (guint    signal_id,
   return hlbsa ? g_bsearch_array_lookup (hlbsa, &g_signal_hlbsa_bconfig, &key) : NULL;
 }
 
+static void
+handler_snapshot_free_R (HandlerSnapshot *snapshot)
+{
+  guint i;
+
+  for (i = 0; i < snapshot->n_handlers; i++)
+    {
+      Handler *handler = snapshot->handlers[i];
+
+      /* g_signal_handlers_destroy() unlinks handlers by pointing them at themselves */
+      if (handler->prev == handler)
+        handler_unref_R (0, NULL, handler);
+      else
+        handler_unref_R (snapshot->signal_id, snapshot->instance, handler);
+    }
+  g_free (snapshot);
+}
+
+static inline void
+handler_snapshot_unref_R (HandlerSnapshot *snapshot)
+{
+  if (g_atomic_int_dec_and_test (&snapshot->ref_count))
+    handler_snapshot_free_R (snapshot);
+}
+
+/* Like handler_snapshot_unref_R(), for when the signal lock is not held */
+static inline void
+handler_snapshot_release (HandlerSnapshot *snapshot)
+{
+  if (g_atomic_int_dec_and_test (&snapshot->ref_count))
+    {
+      SIGNAL_LOCK ();
+      handler_snapshot_free_R (snapshot);
+      SIGNAL_UNLOCK ();
+    }
+}
+
+/* Returns a reference on the handlers currently connected to @signal_id on
+ * @instance, or %NULL if there are none. Does not take the signal lock. */
+static inline HandlerSnapshot*
+handler_snapshot_acquire (SignalThread *thread,
+                          gpointer      instance,
+                          guint         signal_id)
+{
+  HandlerSnapshot *snapshot = NULL;
+  HandlerList *hlist;
+  guint phase;
+
+  phase = signal_read_begin (thread);
+  hlist = handler_list_lookup (signal_id, instance);
+  if (hlist != NULL)
+    snapshot = g_atomic_pointer_get (&hlist->snapshot);
+  if (snapshot != NULL)
+    g_atomic_int_inc (&snapshot->ref_count);
+  signal_read_end (thread, phase);
+
+  return snapshot;
+}
+
+/* Must be called whenever a handler in the list gets connected or
+ * disconnected, after it is ready to be invoked or marked as disconnected.
+ */
+static void
+handler_list_publish_R (guint    signal_id,
+                        gpointer instance)
+{
+  HandlerList *hlist = handler_list_lookup (signal_id, instance);
+  HandlerSnapshot *snapshot = NULL, *old;
+  Handler *handler;
+  guint n_handlers = 0;
+
+  if (hlist == NULL)
+    return;
+
+  for (handler = hlist->handlers; handler; handler = handler->next)
+    if (handler->sequential_number)
+      n_handlers++;
+
+  if (n_handlers > 0)
+    {
+      snapshot = g_malloc (G_STRUCT_OFFSET (HandlerSnapshot, handlers) +
+                           n_handlers * sizeof (Handler *));
+      snapshot->instance = instance;
+      snapshot->signal_id = signal_id;
+      snapshot->ref_count = 1;
+      snapshot->n_handlers = 0;
+      snapshot->n_before = 0;
+
+      for (handler = hlist->handlers; handler; handler = handler->next)
+        if (handler->sequential_number)
+          {
+            handler_ref (handler);
+            snapshot->handlers[snapshot->n_handlers++] = handler;
+            if (!handler->after)
+              snapshot->n_before = snapshot->n_handlers;
+          }
+    }
+
+  old = hlist->snapshot;
+  g_atomic_pointer_set (&hlist->snapshot, snapshot);
+  if (old != NULL)
+    {
+      signal_synchronize ();
+      handler_snapshot_unref_R (old);
+    }
+}
+
 static guint
 handler_hash (gconstpointer key)
 {
@@ -550,7 +1017,7 @@ handler_lookup (gpointer  instance,
 
     }
 
-  hlbsa = g_hash_table_lookup (g_handler_list_bsa_ht, instance);
+  hlbsa = handler_list_bsa_get (instance);
   
   if (hlbsa)
     {
@@ -645,7 +1112,7 @@ handlers_find (gpointer         instance,
     }
   else
     {
-      GBSearchArray *hlbsa = g_hash_table_lookup (g_handler_list_bsa_ht, instance);
+      GBSearchArray *hlbsa = handler_list_bsa_get (instance);
       
       mask = ~mask;
       if (hlbsa)
@@ -823,11 +1290,39 @@ handler_insert (guint    signal_id,
     hlist->tail_after = handler;
 }
 
+/* Whether a signal parameter of @param_type is a plain value, one that
+ * neither holds a reference nor points to memory a handler could free,
+ * so that the same collected arguments can be handed to any number of
+ * handlers in turn. */
+static gboolean
+signal_param_is_plain (GType param_type)
+{
+  switch (G_TYPE_FUNDAMENTAL (param_type & ~G_SIGNAL_TYPE_STATIC_SCOPE))
+    {
+    case G_TYPE_CHAR:
+    case G_TYPE_UCHAR:
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_INT:
+    case G_TYPE_UINT:
+    case G_TYPE_LONG:
+    case G_TYPE_ULONG:
+    case G_TYPE_INT64:
+    case G_TYPE_UINT64:
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+    case G_TYPE_POINTER:
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
 static void
 node_update_single_va_closure (SignalNode *node)
 {
   GClosure *closure = NULL;
-  gboolean is_after = FALSE;
 
   /* Fast path single-handler without boxing the arguments in GValues */
   if (G_TYPE_IS_OBJECT (node->itype) &&
@@ -851,43 +1346,54 @@ node_update_single_va_closure (SignalNode *node)
 	      /* Only support *one* of run-first or run-last, not multiple or cleanup */
 	      if (run_type == G_SIGNAL_RUN_FIRST ||
 		  run_type == G_SIGNAL_RUN_LAST)
-		{
-		  closure = cc->closure;
-		  is_after = (run_type == G_SIGNAL_RUN_LAST);
-		}
+		closure = cc->closure;
 	    }
 	}
     }
 
-  node->single_va_closure_is_valid = TRUE;
-  node->single_va_closure = closure;
-  node->single_va_closure_is_after = is_after;
+  g_atomic_pointer_set (&node->single_va_closure, closure);
 }
 
 static inline void
-emission_push (Emission  *emission)
+emission_push (SignalThread *thread,
+               Emission     *emission)
 {
-  emission->next = g_emissions;
-  g_emissions = emission;
+  emission->next = thread->emissions;
+  thread->emissions = emission;
 }
 
 static inline void
-emission_pop (Emission  *emission)
+emission_pop (SignalThread *thread,
+              Emission     *emission)
 {
-  Emission *node, *last = NULL;
+  g_assert (thread->emissions == emission);
 
-  for (node = g_emissions; node; last = node, node = last->next)
-    if (node == emission)
-      {
-	if (last)
-	  last->next = node->next;
-	else
-	  g_emissions = node->next;
-	return;
-      }
-  g_assert_not_reached ();
+  thread->emissions = emission->next;
+}
+
+/* Emissions of G_SIGNAL_NO_RECURSE signals can be asked to restart from
+ * other threads at any time, which must not get lost when moving on to the
+ * next stage; returns %FALSE if the emission should restart instead.
+ */
+static inline gboolean
+emission_set_state (Emission      *emission,
+                    EmissionState  state)
+{
+  gint old_state;
+
+  do
+    {
+      old_state = g_atomic_int_get (&emission->state);
+      if (old_state == EMISSION_RESTART)
+        return FALSE;
+    }
+  while (!g_atomic_int_compare_and_exchange (&emission->state, old_state, state));
+
+  return TRUE;
 }
 
+/* Emissions are tracked per thread, so these only find emissions that are
+ * in progress on the calling thread, which is where handlers run. */
 static inline Emission*
 emission_find (guint     signal_id,
 	       GQuark    detail,
@@ -895,7 +1401,7 @@ emission_find (guint     signal_id,
 {
   Emission *emission;
   
-  for (emission = g_emissions; emission; emission = emission->next)
+  for (emission = signal_thread_get ()->emissions; emission; emission = emission->next)
     if (emission->instance == instance &&
 	emission->ihint.signal_id == signal_id &&
 	emission->ihint.detail == detail)
@@ -908,7 +1414,7 @@ emission_find_innermost (gpointer instance)
 {
   Emission *emission;
   
-  for (emission = g_emissions; emission; emission = emission->next)
+  for (emission = signal_thread_get ()->emissions; emission; emission = emission->next)
     if (emission->instance == instance)
       return emission;
 
@@ -933,14 +1439,10 @@ _g_signal_init (void)
   SIGNAL_LOCK ();
   if (!g_n_signal_nodes)
     {
-      /* setup handler list binary searchable array hash table (in german, that'd be one word ;) */
-      g_handler_list_bsa_ht = g_hash_table_new (g_direct_hash, NULL);
       g_signal_key_bsa = g_bsearch_array_create (&g_signal_key_bconfig);
       
       /* invalid (0) signal_id */
-      g_n_signal_nodes = 1;
-      g_signal_nodes = g_renew (SignalNode*, g_signal_nodes, g_n_signal_nodes);
-      g_signal_nodes[0] = NULL;
+      signal_node_append (NULL);
       g_handlers = g_hash_table_new (handler_hash, handler_equal);
     }
   SIGNAL_UNLOCK ();
@@ -982,6 +1484,11 @@ _g_signals_destroy (GType itype)
  * flag).
  *
  * Prints a warning if used on a signal which isn't being emitted.
+ *
+ * Emissions are tracked per thread, so this only stops an emission that is
+ * running on the calling thread, typically from one of its handlers.  An
+ * emission that is running on another thread is not found, and the warning
+ * is printed.
  */
 void
 g_signal_stop_emission (gpointer instance,
@@ -1007,11 +1514,11 @@ g_signal_stop_emission (gpointer instance,
       
       if (emission)
         {
-          if (emission->state == EMISSION_HOOK)
+          if (g_atomic_int_get (&emission->state) == EMISSION_HOOK)
             g_critical (G_STRLOC ": emission of signal \"%s\" for instance '%p' cannot be stopped from emission hook",
                         node->name, instance);
-          else if (emission->state == EMISSION_RUN)
-            emission->state = EMISSION_STOP;
+          else
+            g_atomic_int_compare_and_exchange (&emission->state, EMISSION_RUN, EMISSION_STOP);
         }
       else
         g_critical (G_STRLOC ": no emission of signal \"%s\" to stop for instance '%p'",
@@ -1086,7 +1593,6 @@ g_signal_add_emission_hook (guint               signal_id,
       SIGNAL_UNLOCK ();
       return 0;
     }
-    node->single_va_closure_is_valid = FALSE;
   if (!node->emission_hooks)
     {
       node->emission_hooks = g_new (GHookList, 1);
@@ -1105,6 +1611,7 @@ g_signal_add_emission_hook (guint               signal_id,
   node->emission_hooks->seq_id = seq_hook_id;
   g_hook_append (node->emission_hooks, hook);
   seq_hook_id = node->emission_hooks->seq_id;
+  node_update_single_va_closure (node);
 
   SIGNAL_UNLOCK ();
 
@@ -1138,7 +1645,7 @@ g_signal_remove_emission_hook (guint  signal_id,
   else if (!node->emission_hooks || !g_hook_destroy (node->emission_hooks, hook_id))
     g_critical ("%s: signal \"%s\" had no hook (%lu) to remove", G_STRLOC, node->name, hook_id);
 
-  node->single_va_closure_is_valid = FALSE;
+  node_update_single_va_closure (node);
 
  out:
   SIGNAL_UNLOCK ();
@@ -1248,7 +1755,8 @@ g_signal_parse_name (const gchar *detailed_signal,
  * Stops a signal's current emission.
  *
  * This is just like g_signal_stop_emission() except it will look up the
- * signal id for you.
+ * signal id for you.  Like it, this only stops an emission that is running
+ * on the calling thread.
  */
 void
 g_signal_stop_emission_by_name (gpointer     instance,
@@ -1279,11 +1787,11 @@ g_signal_stop_emission_by_name (gpointer     instance,
 	  
 	  if (emission)
 	    {
-	      if (emission->state == EMISSION_HOOK)
+	      if (g_atomic_int_get (&emission->state) == EMISSION_HOOK)
 		g_critical (G_STRLOC ": emission of signal \"%s\" for instance '%p' cannot be stopped from emission hook",
 			    node->name, instance);
-	      else if (emission->state == EMISSION_RUN)
-		emission->state = EMISSION_STOP;
+	      else
+		g_atomic_int_compare_and_exchange (&emission->state, EMISSION_RUN, EMISSION_STOP);
 	    }
 	  else
 	    g_critical (G_STRLOC ": no emission of signal \"%s\" to stop for instance '%p'",
@@ -1604,7 +2112,7 @@ static inline ClassClosure*
 signal_find_class_closure (SignalNode *node,
 			   GType       itype)
 {
-  GBSearchArray *bsa = node->class_closure_bsa;
+  GBSearchArray *bsa = g_atomic_pointer_get (&node->class_closure_bsa);
   ClassClosure *cc;
 
   if (bsa)
@@ -1648,17 +2156,17 @@ signal_add_class_closure (SignalNode *node,
 			  GType       itype,
 			  GClosure   *closure)
 {
+  GBSearchArray *old_bsa = node->class_closure_bsa, *bsa;
   ClassClosure key;
 
-  node->single_va_closure_is_valid = FALSE;
-
-  if (!node->class_closure_bsa)
-    node->class_closure_bsa = g_bsearch_array_create (&g_class_closure_bconfig);
+  /* emissions look class closures up without locking, so copy on write */
+  if (old_bsa)
+    bsa = g_memdup2 (old_bsa, sizeof (GBSearchArray) + old_bsa->n_nodes * g_class_closure_bconfig.sizeof_node);
+  else
+    bsa = g_bsearch_array_create (&g_class_closure_bconfig);
   key.instance_type = itype;
   key.closure = g_closure_ref (closure);
-  node->class_closure_bsa = g_bsearch_array_insert (node->class_closure_bsa,
-						    &g_class_closure_bconfig,
-						    &key);
+  bsa = g_bsearch_array_insert (bsa, &g_class_closure_bconfig, &key);
   g_closure_sink (closure);
   if (node->c_marshaller && closure && G_CLOSURE_NEEDS_MARSHAL (closure))
     {
@@ -1666,6 +2174,189 @@ signal_add_class_closure (SignalNode *node,
       if (node->va_marshaller)
 	_g_closure_set_va_marshal (closure, node->va_marshaller);
     }
+
+  g_atomic_pointer_set (&node->class_closure_bsa, bsa);
+  node_update_single_va_closure (node);
+  if (old_bsa)
+    {
+      signal_synchronize ();
+      g_bsearch_array_free (old_bsa, &g_class_closure_bconfig);
+    }
+}
+
+#ifdef HAVE_SPECIALISED_MARSHALLERS
+typedef struct
+{
+  GSignalCMarshaller c_marshaller;
+  GSignalCVaMarshaller va_marshaller;
+} SpecialisedMarshaller;
+
+#include "gmarshal-specialised-table.h"
+
+/* Argument classes, in the order gen-specialised-marshallers.py uses */
+enum
+{
+  ARG_CLASS_POINTER,
+  ARG_CLASS_INT,
+  ARG_CLASS_INT64,
+  ARG_CLASS_DOUBLE,
+  ARG_CLASS_NONE = -1
+};
+
+/* Which generated argument type @type can be passed as. The GValue based
+ * marshaller reads it from the same union member as for that argument type,
+ * and the va_list based one collects it as the same promoted C type.
+ * Sets @needs_copy if the generic marshaller copies or references the
+ * argument for the duration of the emission, which the generated va_list
+ * marshallers do not do.
+ */
+static gint
+specialised_marshaller_arg_class (GType     type,
+                                  gboolean *needs_copy)
+{
+  gboolean static_scope = (type & G_SIGNAL_TYPE_STATIC_SCOPE) != 0;
+
+  type &= ~G_SIGNAL_TYPE_STATIC_SCOPE;
+
+  switch (G_TYPE_FUNDAMENTAL (type))
+    {
+    case G_TYPE_POINTER:
+      return ARG_CLASS_POINTER;
+    case G_TYPE_STRING:
+    case G_TYPE_PARAM:
+    case G_TYPE_BOXED:
+    case G_TYPE_VARIANT:
+      if (!static_scope)
+        *needs_copy = TRUE;
+      return ARG_CLASS_POINTER;
+    case G_TYPE_OBJECT:
+    case G_TYPE_INTERFACE:
+      *needs_copy = TRUE;
+      return ARG_CLASS_POINTER;
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_CHAR:
+    case G_TYPE_UCHAR:
+    case G_TYPE_INT:
+    case G_TYPE_UINT:
+      return ARG_CLASS_INT;
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    /* these are stored as longs, whose low half is the int */
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+      return ARG_CLASS_INT;
+#endif
+#if GLIB_SIZEOF_LONG == 8
+    case G_TYPE_LONG:
+    case G_TYPE_ULONG:
+#endif
+    case G_TYPE_INT64:
+    case G_TYPE_UINT64:
+      return ARG_CLASS_INT64;
+    case G_TYPE_DOUBLE:
+      return ARG_CLASS_DOUBLE;
+    default:
+      return ARG_CLASS_NONE;
+    }
+}
+
+/* Picks a generated marshaller to use instead of the libffi based generic
+ * one, if there is one for the signature. */
+static gboolean
+specialised_marshaller_lookup (guint                 n_params,
+                               const GType          *param_types,
+                               GType                 return_type,
+                               GSignalCMarshaller   *c_marshaller,
+                               GSignalCVaMarshaller *va_marshaller)
+{
+  const SpecialisedMarshaller *marshaller;
+  gboolean needs_copy = FALSE;
+  guint index, n_shorter, i;
+
+  if (n_params > SPECIALISED_MARSHALLER_MAX_ARGS)
+    return FALSE;
+
+  /* signatures with fewer arguments come first, the argument classes of
+   * the rest are read as digits */
+  n_shorter = 0;
+  index = 0;
+  for (i = 0; i < n_params; i++)
+    {
+      gint arg_class = specialised_marshaller_arg_class (param_types[i], &needs_copy);
+
+      if (arg_class == ARG_CLASS_NONE)
+        return FALSE;
+      n_shorter = n_shorter * SPECIALISED_MARSHALLER_N_ARG_CLASSES + 1;
+      index = index * SPECIALISED_MARSHALLER_N_ARG_CLASSES + arg_class;
+    }
+  index += n_shorter;
+
+  if (return_type == G_TYPE_NONE)
+    ;
+  else if (return_type == G_TYPE_BOOLEAN)
+    index += G_N_ELEMENTS (specialised_marshallers) / 2;
+  else
+    return FALSE;
+
+  marshaller = &specialised_marshallers[index];
+  *c_marshaller = marshaller->c_marshaller;
+  /* without a va_list marshaller emissions collect the arguments into
+   * GValues, which takes care of the copies */
+  *va_marshaller = needs_copy ? NULL : marshaller->va_marshaller;
+
+  return TRUE;
+}
+#else
+static gboolean
+specialised_marshaller_lookup (guint                 n_params,
+                               const GType          *param_types,
+                               GType                 return_type,
+                               GSignalCMarshaller   *c_marshaller,
+                               GSignalCVaMarshaller *va_marshaller)
+{
+  return FALSE;
+}
+#endif
+
+/* The va_list variant of one of the marshallers from gmarshal.h, so that
+ * signals created with one of those get the va_list emission paths too. */
+static GSignalCVaMarshaller
+builtin_va_marshaller_lookup (GSignalCMarshaller c_marshaller)
+{
+  static const struct
+  {
+    GSignalCMarshaller c_marshaller;
+    GSignalCVaMarshaller va_marshaller;
+  } builtin_marshallers[] = {
+    { g_cclosure_marshal_VOID__VOID, g_cclosure_marshal_VOID__VOIDv },
+    { g_cclosure_marshal_VOID__BOOLEAN, g_cclosure_marshal_VOID__BOOLEANv },
+    { g_cclosure_marshal_VOID__CHAR, g_cclosure_marshal_VOID__CHARv },
+    { g_cclosure_marshal_VOID__UCHAR, g_cclosure_marshal_VOID__UCHARv },
+    { g_cclosure_marshal_VOID__INT, g_cclosure_marshal_VOID__INTv },
+    { g_cclosure_marshal_VOID__UINT, g_cclosure_marshal_VOID__UINTv },
+    { g_cclosure_marshal_VOID__LONG, g_cclosure_marshal_VOID__LONGv },
+    { g_cclosure_marshal_VOID__ULONG, g_cclosure_marshal_VOID__ULONGv },
+    { g_cclosure_marshal_VOID__ENUM, g_cclosure_marshal_VOID__ENUMv },
+    { g_cclosure_marshal_VOID__FLAGS, g_cclosure_marshal_VOID__FLAGSv },
+    { g_cclosure_marshal_VOID__FLOAT, g_cclosure_marshal_VOID__FLOATv },
+    { g_cclosure_marshal_VOID__DOUBLE, g_cclosure_marshal_VOID__DOUBLEv },
+    { g_cclosure_marshal_VOID__STRING, g_cclosure_marshal_VOID__STRINGv },
+    { g_cclosure_marshal_VOID__PARAM, g_cclosure_marshal_VOID__PARAMv },
+    { g_cclosure_marshal_VOID__BOXED, g_cclosure_marshal_VOID__BOXEDv },
+    { g_cclosure_marshal_VOID__POINTER, g_cclosure_marshal_VOID__POINTERv },
+    { g_cclosure_marshal_VOID__OBJECT, g_cclosure_marshal_VOID__OBJECTv },
+    { g_cclosure_marshal_VOID__VARIANT, g_cclosure_marshal_VOID__VARIANTv },
+    { g_cclosure_marshal_VOID__UINT_POINTER, g_cclosure_marshal_VOID__UINT_POINTERv },
+    { g_cclosure_marshal_BOOLEAN__FLAGS, g_cclosure_marshal_BOOLEAN__FLAGSv },
+    { g_cclosure_marshal_STRING__OBJECT_POINTER, g_cclosure_marshal_STRING__OBJECT_POINTERv },
+    { g_cclosure_marshal_BOOLEAN__BOXED_BOXED, g_cclosure_marshal_BOOLEAN__BOXED_BOXEDv },
+  };
+  gsize i;
+
+  for (i = 0; i < G_N_ELEMENTS (builtin_marshallers); i++)
+    if (builtin_marshallers[i].c_marshaller == c_marshaller)
+      return builtin_marshallers[i].va_marshaller;
+
+  return NULL;
 }
 
 /**
@@ -1788,11 +2479,9 @@ g_signal_newv (const gchar       *signal_name,
     {
       SignalKey key;
       
-      signal_id = g_n_signal_nodes++;
       node = g_new (SignalNode, 1);
+      signal_id = signal_node_append (node);
       node->signal_id = signal_id;
-      g_signal_nodes = g_renew (SignalNode*, g_signal_nodes, g_n_signal_nodes);
-      g_signal_nodes[signal_id] = node;
       node->itype = itype;
       key.itype = itype;
       key.signal_id = signal_id;
@@ -1805,10 +2494,13 @@ g_signal_newv (const gchar       *signal_name,
   node->destroyed = FALSE;
 
   /* setup reinitializable portion */
-  node->single_va_closure_is_valid = FALSE;
+  node->single_va_closure = NULL;
   node->flags = signal_flags & G_SIGNAL_FLAGS_MASK;
   node->n_params = n_params;
   node->param_types = g_memdup2 (param_types, sizeof (GType) * n_params);
+  node->plain_params = (signal_flags & G_SIGNAL_MUST_COLLECT) == 0;
+  for (i = 0; i < n_params; i++)
+    node->plain_params &= signal_param_is_plain (param_types[i]);
   node->return_type = return_type;
   node->class_closure_bsa = NULL;
   if (accumulator)
@@ -1866,20 +2558,23 @@ g_signal_newv (const gchar       *signal_name,
 	  c_marshaller = builtin_c_marshaller;
           va_marshaller = builtin_va_marshaller;
         }
-      else
+      else if (!specialised_marshaller_lookup (n_params, param_types, return_type,
+                                                &c_marshaller, &va_marshaller))
 	{
 	  c_marshaller = g_cclosure_marshal_generic;
 	  va_marshaller = g_cclosure_marshal_generic_va;
 	}
     }
   else
-    va_marshaller = NULL;
+    va_marshaller = builtin_va_marshaller_lookup (c_marshaller);
 
   node->c_marshaller = c_marshaller;
   node->va_marshaller = va_marshaller;
   node->emission_hooks = NULL;
   if (class_closure)
     signal_add_class_closure (node, 0, class_closure);
+  else
+    node_update_single_va_closure (node);
 
   SIGNAL_UNLOCK ();
 
@@ -1923,7 +2618,7 @@ g_signal_set_va_marshaller (guint              signal_id,
 	    _g_closure_set_va_marshal (cc->closure, va_marshaller);
 	}
 
-      node->single_va_closure_is_valid = FALSE;
+      node_update_single_va_closure (node);
     }
 
   SIGNAL_UNLOCK ();
@@ -2007,11 +2702,11 @@ signal_destroy_R (SignalNode *signal_node)
   signal_node->destroyed = TRUE;
   
   /* reentrancy caution, zero out real contents first */
-  signal_node->single_va_closure_is_valid = FALSE;
+  g_atomic_pointer_set (&signal_node->single_va_closure, NULL);
   signal_node->n_params = 0;
   signal_node->param_types = NULL;
   signal_node->return_type = 0;
-  signal_node->class_closure_bsa = NULL;
+  g_atomic_pointer_set (&signal_node->class_closure_bsa, NULL);
   signal_node->accumulator = NULL;
   signal_node->c_marshaller = NULL;
   signal_node->va_marshaller = NULL;
@@ -2022,7 +2717,7 @@ signal_destroy_R (SignalNode *signal_node)
   {
     Emission *emission;
     
-    for (emission = g_emissions; emission; emission = emission->next)
+    for (emission = signal_thread_get ()->emissions; emission; emission = emission->next)
       if (emission->ihint.signal_id == node.signal_id)
         g_critical (G_STRLOC ": signal \"%s\" being destroyed is currently in emission (instance '%p')",
                     node.name, emission->instance);
@@ -2031,6 +2726,7 @@ signal_destroy_R (SignalNode *signal_node)
   
   /* free contents that need to
    */
+  signal_synchronize ();
   SIGNAL_UNLOCK ();
   g_free (node.param_types);
   if (node.class_closure_bsa)
@@ -2386,9 +3082,7 @@ g_signal_get_invocation_hint (gpointer instance)
   
   g_return_val_if_fail (G_TYPE_CHECK_INSTANCE (instance), NULL);
 
-  SIGNAL_LOCK ();
   emission = emission_find_innermost (instance);
-  SIGNAL_UNLOCK ();
   
   return emission ? &emission->ihint : NULL;
 }
@@ -2447,6 +3141,7 @@ g_signal_connect_closure_by_id (gpointer  instance,
 	      if (node->va_marshaller)
 		_g_closure_set_va_marshal (closure, node->va_marshaller);
 	    }
+	  handler_list_publish_R (signal_id, instance);
 	}
     }
   else
@@ -2514,6 +3209,7 @@ g_signal_connect_closure (gpointer     instance,
 	      if (node->va_marshaller)
 		_g_closure_set_va_marshal (handler->closure, node->va_marshaller);
 	    }
+	  handler_list_publish_R (signal_id, instance);
 	}
     }
   else
@@ -2617,6 +3313,7 @@ g_signal_connect_data (gpointer       instance,
 	      if (node->va_marshaller)
 		_g_closure_set_va_marshal (handler->closure, node->va_marshaller);
 	    }
+	  handler_list_publish_R (signal_id, instance);
         }
     }
   else
@@ -2670,7 +3367,7 @@ signal_handler_block_unlocked (gpointer instance,
       if (handler->block_count >= HANDLER_MAX_BLOCK_COUNT - 1)
         g_error (G_STRLOC ": handler block_count overflow, %s", REPORT_BUG);
 #endif
-      handler->block_count += 1;
+      g_atomic_int_inc (&handler->block_count);
     }
   else
     g_critical ("%s: instance '%p' has no handler with id '%lu'", G_STRLOC, instance, handler_id);
@@ -2721,7 +3418,7 @@ signal_handler_unblock_unlocked (gpointer instance,
   if (handler)
     {
       if (handler->block_count)
-        handler->block_count -= 1;
+        g_atomic_int_add (&handler->block_count, -1);
       else
         g_critical (G_STRLOC ": handler '%lu' of instance '%p' is not blocked", handler_id, instance);
     }
@@ -2768,8 +3465,9 @@ signal_handler_disconnect_unlocked (gpointer instance,
     {
       g_hash_table_remove (g_handlers, handler);
       handler->sequential_number = 0;
-      handler->block_count = 1;
+      g_atomic_int_set (&handler->block_count, 1);
       remove_invalid_closure_notify (handler, instance);
+      handler_list_publish_R (handler->signal_id, instance);
       handler_unref_R (handler->signal_id, instance, handler);
     }
   else
@@ -2802,6 +3500,100 @@ g_signal_handler_is_connected (gpointer instance,
   return connected;
 }
 
+/* Disconnects all handlers of @instance. A GObject keeps its (then empty)
+ * handler list array until @finalizing, so emissions only need to be waited
+ * out if a handler snapshot was taken down; other instances give it up
+ * right away.
+ */
+static void
+handler_lists_destroy_R (gpointer instance,
+                         gboolean finalizing)
+{
+  GBSearchArray **location, *hlbsa;
+  InstanceHandlers *entry = NULL;
+  gboolean is_object, wait_for_readers = FALSE;
+  Handler **chains;
+  HandlerSnapshot **snapshots;
+  guint i, n_lists;
+
+  location = handler_list_bsa_location (instance);
+  hlbsa = location ? *location : NULL;
+  if (!hlbsa)
+    return;
+
+  is_object = G_TYPE_CHECK_INSTANCE_TYPE (instance, G_TYPE_OBJECT);
+  if (!is_object || finalizing)
+    {
+      /* reentrancy caution, delete instance trace first */
+      g_atomic_pointer_set (location, NULL);
+      if (!is_object)
+        {
+          entry = G_STRUCT_MEMBER_P (location, -G_STRUCT_OFFSET (InstanceHandlers, hlbsa));
+          instance_handlers_table_remove (entry);
+          wait_for_readers = TRUE;
+        }
+    }
+
+  /* take everything off the lists before any handler gets unreferenced, as
+   * that drops the lock */
+  n_lists = hlbsa->n_nodes;
+  chains = g_new (Handler *, n_lists);
+  snapshots = g_new (HandlerSnapshot *, n_lists);
+  for (i = 0; i < n_lists; i++)
+    {
+      HandlerList *hlist = g_bsearch_array_get_nth (hlbsa, &g_signal_hlbsa_bconfig, i);
+
+      chains[i] = hlist->handlers;
+      hlist->handlers = NULL;
+      hlist->tail_before = NULL;
+      hlist->tail_after = NULL;
+
+      snapshots[i] = hlist->snapshot;
+      if (snapshots[i] != NULL)
+        {
+          g_atomic_pointer_set (&hlist->snapshot, NULL);
+          wait_for_readers = TRUE;
+        }
+    }
+
+  for (i = 0; i < n_lists; i++)
+    {
+      Handler *handler = chains[i];
+
+      while (handler)
+        {
+          Handler *tmp = handler;
+
+          handler = tmp->next;
+          g_atomic_int_set (&tmp->block_count, 1);
+          /* cruel unlink, this works because _all_ handlers vanish */
+          tmp->next = NULL;
+          tmp->prev = tmp;
+          if (tmp->sequential_number)
+            {
+              g_hash_table_remove (g_handlers, tmp);
+              remove_invalid_closure_notify (tmp, instance);
+              tmp->sequential_number = 0;
+              handler_unref_R (0, NULL, tmp);
+            }
+        }
+    }
+
+  /* emissions that are already underway may still be looking at them */
+  if (wait_for_readers)
+    signal_synchronize ();
+  for (i = 0; i < n_lists; i++)
+    {
+      if (snapshots[i] != NULL)
+        handler_snapshot_unref_R (snapshots[i]);
+    }
+  if (!is_object || finalizing)
+    g_bsearch_array_free (hlbsa, &g_signal_hlbsa_bconfig);
+  g_free (entry);
+  g_free (snapshots);
+  g_free (chains);
+}
+
 /**
  * g_signal_handlers_destroy:
  * @instance: (type GObject.Object): The instance whose signal handlers are destroyed
@@ -2813,44 +3605,23 @@ g_signal_handler_is_connected (gpointer instance,
 void
 g_signal_handlers_destroy (gpointer instance)
 {
-  GBSearchArray *hlbsa;
-  
   g_return_if_fail (G_TYPE_CHECK_INSTANCE (instance));
-  
+
   SIGNAL_LOCK ();
-  hlbsa = g_hash_table_lookup (g_handler_list_bsa_ht, instance);
-  if (hlbsa)
-    {
-      guint i;
-      
-      /* reentrancy caution, delete instance trace first */
-      g_hash_table_remove (g_handler_list_bsa_ht, instance);
-      
-      for (i = 0; i < hlbsa->n_nodes; i++)
-        {
-          HandlerList *hlist = g_bsearch_array_get_nth (hlbsa, &g_signal_hlbsa_bconfig, i);
-          Handler *handler = hlist->handlers;
-	  
-          while (handler)
-            {
-              Handler *tmp = handler;
-	      
-              handler = tmp->next;
-              tmp->block_count = 1;
-              /* cruel unlink, this works because _all_ handlers vanish */
-              tmp->next = NULL;
-              tmp->prev = tmp;
-              if (tmp->sequential_number)
-		{
-                  g_hash_table_remove (g_handlers, tmp);
-		  remove_invalid_closure_notify (tmp, instance);
-		  tmp->sequential_number = 0;
-		  handler_unref_R (0, NULL, tmp);
-		}
-            }
-        }
-      g_bsearch_array_free (hlbsa, &g_signal_hlbsa_bconfig);
-    }
+  handler_lists_destroy_R (instance, FALSE);
+  SIGNAL_UNLOCK ();
+}
+
+/* Like g_signal_handlers_destroy(), but also frees the handler list array
+ * that a GObject keeps around after that, so that disposing it does not
+ * have to wait for emissions. Called from g_object_finalize(), when no
+ * emission can be looking at @object anymore.
+ */
+void
+_g_signal_handlers_finalize (GObject *object)
+{
+  SIGNAL_LOCK ();
+  handler_lists_destroy_R (object, TRUE);
   SIGNAL_UNLOCK ();
 }
 
@@ -3176,6 +3947,7 @@ g_signal_emitv (const GValue *instance_and_params,
 {
   gpointer instance;
   SignalNode *node;
+  GClosure *single_va_closure;
 #ifdef G_ENABLE_DEBUG
   const GValue *param_values;
   guint i;
@@ -3190,19 +3962,16 @@ g_signal_emitv (const GValue *instance_and_params,
   param_values = instance_and_params + 1;
 #endif
 
-  SIGNAL_LOCK ();
   node = LOOKUP_SIGNAL_NODE (signal_id);
   if (!node || !g_type_is_a (G_TYPE_FROM_INSTANCE (instance), node->itype))
     {
       g_critical ("%s: signal id '%u' is invalid for instance '%p'", G_STRLOC, signal_id, instance);
-      SIGNAL_UNLOCK ();
       return;
     }
 #ifdef G_ENABLE_DEBUG
   if (detail && !(node->flags & G_SIGNAL_DETAILED))
     {
       g_critical ("%s: signal id '%u' does not support detail (%u)", G_STRLOC, signal_id, detail);
-      SIGNAL_UNLOCK ();
       return;
     }
   for (i = 0; i < node->n_params; i++)
@@ -3214,7 +3983,6 @@ g_signal_emitv (const GValue *instance_and_params,
 		    i,
 		    node->name,
 		    G_VALUE_TYPE_NAME (param_values + i));
-	SIGNAL_UNLOCK ();
 	return;
       }
   if (node->return_type != G_TYPE_NONE)
@@ -3225,7 +3993,6 @@ g_signal_emitv (const GValue *instance_and_params,
 		      G_STRLOC,
 		      type_debug_name (node->return_type),
 		      node->name);
-	  SIGNAL_UNLOCK ();
 	  return;
 	}
       else if (!node->accumulator && !G_TYPE_CHECK_VALUE_TYPE (return_value, node->return_type & ~G_SIGNAL_TYPE_STATIC_SCOPE))
@@ -3235,7 +4002,6 @@ g_signal_emitv (const GValue *instance_and_params,
 		      type_debug_name (node->return_type),
 		      node->name,
 		      G_VALUE_TYPE_NAME (return_value));
-	  SIGNAL_UNLOCK ();
 	  return;
 	}
     }
@@ -3244,31 +4010,28 @@ g_signal_emitv (const GValue *instance_and_params,
 #endif	/* G_ENABLE_DEBUG */
 
   /* optimize NOP emissions */
-  if (!node->single_va_closure_is_valid)
-    node_update_single_va_closure (node);
-
-  if (node->single_va_closure != NULL &&
-      (node->single_va_closure == SINGLE_VA_CLOSURE_EMPTY_MAGIC ||
-       _g_closure_is_void (node->single_va_closure, instance)))
+  single_va_closure = g_atomic_pointer_get (&node->single_va_closure);
+  if (single_va_closure != NULL &&
+      (single_va_closure == SINGLE_VA_CLOSURE_EMPTY_MAGIC ||
+       _g_closure_is_void (single_va_closure, instance)))
     {
-      HandlerList* hlist;
+      HandlerSnapshot *snapshot;
 
       /* single_va_closure is only true for GObjects, so fast path if no handler ever connected to the signal */
       if (_g_object_has_signal_handler ((GObject *)instance))
-        hlist = handler_list_lookup (node->signal_id, instance);
+        snapshot = handler_snapshot_acquire (signal_thread_get (), instance, node->signal_id);
       else
-        hlist = NULL;
+        snapshot = NULL;
 
-      if (hlist == NULL || hlist->handlers == NULL)
+      if (snapshot == NULL)
 	{
 	  /* nothing to do to emit this signal */
-	  SIGNAL_UNLOCK ();
 	  /* g_printerr ("omitting emission of \"%s\"\n", node->name); */
 	  return;
 	}
+      handler_snapshot_release (snapshot);
     }
 
-  SIGNAL_UNLOCK ();
   signal_emit_unlocked_R (node, detail, instance, return_value, instance_and_params);
 }
 
@@ -3291,6 +4054,207 @@ accumulate (GSignalInvocationHint *ihint,
   return continue_emission;
 }
 
+/* Emits @node with its parameters still in @var_args, the way
+ * signal_emit_unlocked_R() does with collected GValues: each closure's
+ * va marshaller reads its own copy of them. That only works if all
+ * parameters are plain (so no handler can invalidate them for the next),
+ * and there are no emission hooks, restarts or class closure overrides,
+ * all of which need GValues. Returns FALSE without emitting otherwise.
+ *
+ * On success, @snapshot is released and the return value, if any, is
+ * stored through @var_args.
+ */
+static gboolean
+signal_emit_valist_R (SignalNode      *node,
+                      GQuark           detail,
+                      gpointer         instance,
+                      SignalThread    *thread,
+                      HandlerSnapshot *snapshot,
+                      va_list          var_args)
+{
+  SignalAccumulator *accumulator;
+  Emission emission;
+  GBSearchArray *bsa;
+  GClosure *class_closure = NULL;
+  GValue *return_accu, accu = G_VALUE_INIT;
+  GValue emission_return = G_VALUE_INIT;
+  GType rtype = node->return_type & ~G_SIGNAL_TYPE_STATIC_SCOPE;
+  gboolean static_scope = node->return_type & G_SIGNAL_TYPE_STATIC_SCOPE;
+  guint i, phase;
+
+  if (!node->plain_params ||
+      (node->flags & G_SIGNAL_NO_RECURSE) != 0 ||
+      g_atomic_pointer_get (&node->emission_hooks) != NULL)
+    return FALSE;
+
+  phase = signal_read_begin (thread);
+  bsa = g_atomic_pointer_get (&node->class_closure_bsa);
+  if (bsa != NULL && bsa->n_nodes > 0)
+    {
+      ClassClosure *cc = g_bsearch_array_get_nth (bsa, &g_class_closure_bconfig, 0);
+
+      if (bsa->n_nodes == 1 && cc->instance_type == 0)
+        class_closure = cc->closure;
+      else
+        class_closure = SINGLE_VA_CLOSURE_EMPTY_MAGIC;
+    }
+  signal_read_end (thread, phase);
+
+  if (class_closure == SINGLE_VA_CLOSURE_EMPTY_MAGIC ||
+      (class_closure != NULL && !_g_closure_supports_invoke_va (class_closure)))
+    return FALSE;
+
+  /* blocked handlers too, as they may be unblocked during the emission */
+  for (i = 0; snapshot != NULL && i < snapshot->n_handlers; i++)
+    if (!_g_closure_supports_invoke_va (snapshot->handlers[i]->closure))
+      return FALSE;
+
+  accumulator = node->accumulator;
+  if (rtype == G_TYPE_NONE)
+    return_accu = NULL;
+  else if (accumulator)
+    return_accu = &accu;
+  else
+    return_accu = &emission_return;
+
+  TRACE(GOBJECT_SIGNAL_EMIT(node->signal_id, detail, instance, G_TYPE_FROM_INSTANCE (instance)));
+
+  emission.instance = instance;
+  emission.ihint.signal_id = node->signal_id;
+  emission.ihint.detail = detail;
+  emission.ihint.run_type = G_SIGNAL_RUN_FIRST | G_SIGNAL_ACCUMULATOR_FIRST_RUN;
+  emission.state = EMISSION_RUN;
+  emission.chain_type = G_TYPE_NONE;
+  emission_push (thread, &emission);
+
+  if (rtype != G_TYPE_NONE)
+    g_value_init (&emission_return, rtype);
+  if (accumulator)
+    g_value_init (&accu, rtype);
+
+  /* the GValue path holds a reference in instance_and_params[0] */
+#ifndef __COVERITY__
+  g_object_ref (instance);
+#endif
+
+  if ((node->flags & G_SIGNAL_RUN_FIRST) && class_closure)
+    {
+      emission.chain_type = G_TYPE_FROM_INSTANCE (instance);
+      _g_closure_invoke_va (class_closure, return_accu, instance, var_args,
+                            node->n_params, node->param_types);
+      if (!accumulate (&emission.ihint, &emission_return, &accu, accumulator))
+        g_atomic_int_compare_and_exchange (&emission.state, EMISSION_RUN, EMISSION_STOP);
+      emission.chain_type = G_TYPE_NONE;
+    }
+
+  for (i = 0; snapshot != NULL && i < snapshot->n_before &&
+              g_atomic_int_get (&emission.state) == EMISSION_RUN; i++)
+    {
+      Handler *handler = snapshot->handlers[i];
+
+      if (!g_atomic_int_get (&handler->block_count) && (!handler->detail || handler->detail == detail))
+        {
+          _g_closure_invoke_va (handler->closure, return_accu, instance, var_args,
+                                node->n_params, node->param_types);
+          if (!accumulate (&emission.ihint, &emission_return, &accu, accumulator))
+            g_atomic_int_compare_and_exchange (&emission.state, EMISSION_RUN, EMISSION_STOP);
+        }
+    }
+
+  emission.ihint.run_type &= ~G_SIGNAL_RUN_FIRST;
+  emission.ihint.run_type |= G_SIGNAL_RUN_LAST;
+
+  if ((node->flags & G_SIGNAL_RUN_LAST) && class_closure &&
+      g_atomic_int_get (&emission.state) == EMISSION_RUN)
+    {
+      emission.chain_type = G_TYPE_FROM_INSTANCE (instance);
+      _g_closure_invoke_va (class_closure, return_accu, instance, var_args,
+                            node->n_params, node->param_types);
+      if (!accumulate (&emission.ihint, &emission_return, &accu, accumulator))
+        g_atomic_int_compare_and_exchange (&emission.state, EMISSION_RUN, EMISSION_STOP);
+      emission.chain_type = G_TYPE_NONE;
+    }
+
+  for (i = snapshot != NULL ? snapshot->n_before : 0;
+       snapshot != NULL && i < snapshot->n_handlers &&
+       g_atomic_int_get (&emission.state) == EMISSION_RUN; i++)
+    {
+      Handler *handler = snapshot->handlers[i];
+
+      if (!g_atomic_int_get (&handler->block_count) && (!handler->detail || handler->detail == detail))
+        {
+          _g_closure_invoke_va (handler->closure, return_accu, instance, var_args,
+                                node->n_params, node->param_types);
+          if (!accumulate (&emission.ihint, &emission_return, &accu, accumulator))
+            g_atomic_int_compare_and_exchange (&emission.state, EMISSION_RUN, EMISSION_STOP);
+        }
+    }
+
+  emission.ihint.run_type &= ~G_SIGNAL_RUN_LAST;
+  emission.ihint.run_type |= G_SIGNAL_RUN_CLEANUP;
+
+  if ((node->flags & G_SIGNAL_RUN_CLEANUP) && class_closure)
+    {
+      gboolean need_unset = FALSE;
+
+      g_atomic_int_set (&emission.state, EMISSION_STOP);
+
+      emission.chain_type = G_TYPE_FROM_INSTANCE (instance);
+      if (rtype != G_TYPE_NONE && !accumulator)
+        {
+          g_value_init (&accu, rtype);
+          need_unset = TRUE;
+        }
+      _g_closure_invoke_va (class_closure, rtype != G_TYPE_NONE ? &accu : NULL,
+                            instance, var_args, node->n_params, node->param_types);
+      accumulate (&emission.ihint, &emission_return, &accu, accumulator);
+      if (need_unset)
+        g_value_unset (&accu);
+      emission.chain_type = G_TYPE_NONE;
+    }
+
+  if (snapshot != NULL)
+    handler_snapshot_release (snapshot);
+
+  emission_pop (thread, &emission);
+  if (accumulator)
+    g_value_unset (&accu);
+
+  if (rtype != G_TYPE_NONE)
+    {
+      gchar *error = NULL;
+
+      for (i = 0; i < node->n_params; i++)
+        {
+          GType ptype = node->param_types[i] & ~G_SIGNAL_TYPE_STATIC_SCOPE;
+          G_VALUE_COLLECT_SKIP (ptype, var_args);
+        }
+
+      G_VALUE_LCOPY (&emission_return,
+                     var_args,
+                     static_scope ? G_VALUE_NOCOPY_CONTENTS : 0,
+                     &error);
+      if (!error)
+        g_value_unset (&emission_return);
+      else
+        {
+          g_critical ("%s: %s", G_STRLOC, error);
+          g_free (error);
+          /* we purposely leak the value here, it might not be
+           * in a correct state if an error condition occurred
+           */
+        }
+    }
+
+  TRACE(GOBJECT_SIGNAL_EMIT_END(node->signal_id, detail, instance, G_TYPE_FROM_INSTANCE (instance)));
+
+#ifndef __COVERITY__
+  g_object_unref (instance);
+#endif
+
+  return TRUE;
+}
+
 /**
  * g_signal_emit_valist: (skip)
  * @instance: (type GObject.TypeInstance): the instance the signal is being
@@ -3317,47 +4281,42 @@ g_signal_emit_valist (gpointer instance,
   GType signal_return_type;
   GValue *param_values;
   SignalNode *node;
+  GClosure *single_va_closure;
   guint i, n_params;
 
   g_return_if_fail (G_TYPE_CHECK_INSTANCE (instance));
   g_return_if_fail (signal_id > 0);
 
-  SIGNAL_LOCK ();
   node = LOOKUP_SIGNAL_NODE (signal_id);
   if (!node || !g_type_is_a (G_TYPE_FROM_INSTANCE (instance), node->itype))
     {
       g_critical ("%s: signal id '%u' is invalid for instance '%p'", G_STRLOC, signal_id, instance);
-      SIGNAL_UNLOCK ();
       return;
     }
 #ifndef G_DISABLE_CHECKS
   if (detail && !(node->flags & G_SIGNAL_DETAILED))
     {
       g_critical ("%s: signal id '%u' does not support detail (%u)", G_STRLOC, signal_id, detail);
-      SIGNAL_UNLOCK ();
       return;
     }
 #endif  /* !G_DISABLE_CHECKS */
 
-  if (!node->single_va_closure_is_valid)
-    node_update_single_va_closure (node);
-
-  if (node->single_va_closure != NULL)
+  single_va_closure = g_atomic_pointer_get (&node->single_va_closure);
+  if (single_va_closure != NULL)
     {
-      HandlerList* hlist;
-      Handler *fastpath_handler = NULL;
-      Handler *l;
+      SignalThread *thread = signal_thread_get ();
+      HandlerSnapshot *snapshot;
       GClosure *closure = NULL;
       gboolean fastpath = TRUE;
       GSignalFlags run_type = G_SIGNAL_RUN_FIRST;
 
-      if (node->single_va_closure != SINGLE_VA_CLOSURE_EMPTY_MAGIC &&
-	  !_g_closure_is_void (node->single_va_closure, instance))
+      if (single_va_closure != SINGLE_VA_CLOSURE_EMPTY_MAGIC &&
+	  !_g_closure_is_void (single_va_closure, instance))
 	{
-	  if (_g_closure_supports_invoke_va (node->single_va_closure))
+	  if (_g_closure_supports_invoke_va (single_va_closure))
 	    {
-	      closure = node->single_va_closure;
-	      if (node->single_va_closure_is_after)
+	      closure = single_va_closure;
+	      if (node->flags & G_SIGNAL_RUN_LAST)
 		run_type = G_SIGNAL_RUN_LAST;
 	      else
 		run_type = G_SIGNAL_RUN_FIRST;
@@ -3368,13 +4327,15 @@ g_signal_emit_valist (gpointer instance,
 
       /* single_va_closure is only true for GObjects, so fast path if no handler ever connected to the signal */
       if (_g_object_has_signal_handler ((GObject *)instance))
-        hlist = handler_list_lookup (node->signal_id, instance);
+        snapshot = handler_snapshot_acquire (thread, instance, node->signal_id);
       else
-        hlist = NULL;
+        snapshot = NULL;
 
-      for (l = hlist ? hlist->handlers : NULL; fastpath && l != NULL; l = l->next)
+      for (i = 0; fastpath && snapshot != NULL && i < snapshot->n_handlers; i++)
 	{
-	  if (!l->block_count &&
+	  Handler *l = snapshot->handlers[i];
+
+	  if (!g_atomic_int_get (&l->block_count) &&
 	      (!l->detail || l->detail == detail))
 	    {
 	      if (closure != NULL || !_g_closure_supports_invoke_va (l->closure))
@@ -3384,7 +4345,6 @@ g_signal_emit_valist (gpointer instance,
 		}
 	      else
 		{
-                  fastpath_handler = l;
 		  closure = l->closure;
 		  if (l->after)
 		    run_type = G_SIGNAL_RUN_LAST;
@@ -3396,7 +4356,8 @@ g_signal_emit_valist (gpointer instance,
 
       if (fastpath && closure == NULL && node->return_type == G_TYPE_NONE)
 	{
-	  SIGNAL_UNLOCK ();
+	  if (snapshot != NULL)
+	    handler_snapshot_release (snapshot);
 	  return;
 	}
 
@@ -3430,12 +4391,7 @@ g_signal_emit_valist (gpointer instance,
 	  emission.ihint.run_type = run_type | G_SIGNAL_ACCUMULATOR_FIRST_RUN;
 	  emission.state = EMISSION_RUN;
 	  emission.chain_type = instance_type;
-	  emission_push (&emission);
-
-          if (fastpath_handler)
-            handler_ref (fastpath_handler);
-
-	  SIGNAL_UNLOCK ();
+	  emission_push (thread, &emission);
 
 	  TRACE(GOBJECT_SIGNAL_EMIT(signal_id, detail, instance, instance_type));
 
@@ -3466,15 +4422,12 @@ g_signal_emit_valist (gpointer instance,
 	      accumulate (&emission.ihint, &emission_return, &accu, accumulator);
 	    }
 
-	  SIGNAL_LOCK ();
-
 	  emission.chain_type = G_TYPE_NONE;
-	  emission_pop (&emission);
+	  emission_pop (thread, &emission);
 
-          if (fastpath_handler)
-            handler_unref_R (signal_id, instance, fastpath_handler);
-
-	  SIGNAL_UNLOCK ();
+	  /* this is what kept the handler we invoked alive */
+	  if (snapshot != NULL)
+	    handler_snapshot_release (snapshot);
 
 	  if (accumulator)
 	    g_value_unset (&accu);
@@ -3514,8 +4467,27 @@ g_signal_emit_valist (gpointer instance,
 
 	  return;
 	}
+
+      if (signal_emit_valist_R (node, detail, instance, thread, snapshot, var_args))
+        return;
+
+      if (snapshot != NULL)
+	handler_snapshot_release (snapshot);
+    }
+  else if (node->plain_params && G_TYPE_IS_OBJECT (node->itype))
+    {
+      SignalThread *thread = signal_thread_get ();
+      HandlerSnapshot *snapshot = NULL;
+
+      if (_g_object_has_signal_handler ((GObject *)instance))
+        snapshot = handler_snapshot_acquire (thread, instance, node->signal_id);
+
+      if (signal_emit_valist_R (node, detail, instance, thread, snapshot, var_args))
+        return;
+
+      if (snapshot != NULL)
+        handler_snapshot_release (snapshot);
     }
-  SIGNAL_UNLOCK ();
 
   n_params = node->n_params;
   signal_return_type = node->return_type;
@@ -3665,92 +4637,97 @@ signal_emit_unlocked_R (SignalNode   *node,
 			const GValue *instance_and_params)
 {
   SignalAccumulator *accumulator;
+  SignalThread *thread;
   Emission emission;
   GClosure *class_closure;
-  HandlerList *hlist;
-  Handler *handler_list = NULL;
+  HandlerSnapshot *snapshot = NULL;
   GValue *return_accu, accu = G_VALUE_INIT;
-  guint signal_id;
-  gulong max_sequential_handler_number;
+  guint signal_id, i, phase;
   gboolean return_value_altered = FALSE;
   
   TRACE(GOBJECT_SIGNAL_EMIT(node->signal_id, detail, instance, G_TYPE_FROM_INSTANCE (instance)));
 
-  SIGNAL_LOCK ();
+  thread = signal_thread_get ();
   signal_id = node->signal_id;
 
+  emission.instance = instance;
+  emission.ihint.signal_id = node->signal_id;
+  emission.ihint.detail = detail;
+  emission.ihint.run_type = 0;
+  emission.state = 0;
+  emission.chain_type = G_TYPE_NONE;
+
+  /* restarting is the one thing emissions on other threads can do to us */
   if (node->flags & G_SIGNAL_NO_RECURSE)
     {
-      Emission *emission_node = emission_find (signal_id, detail, instance);
+      Emission *emission_node;
 
-      if (emission_node)
-        {
-          emission_node->state = EMISSION_RESTART;
-          SIGNAL_UNLOCK ();
-          return return_value_altered;
-        }
+      SIGNAL_LOCK ();
+      for (emission_node = g_no_recurse_emissions; emission_node; emission_node = emission_node->next_no_recurse)
+        if (emission_node->instance == instance &&
+            emission_node->ihint.signal_id == signal_id &&
+            emission_node->ihint.detail == detail)
+          {
+            g_atomic_int_set (&emission_node->state, EMISSION_RESTART);
+            SIGNAL_UNLOCK ();
+            return return_value_altered;
+          }
+      emission.next_no_recurse = g_no_recurse_emissions;
+      g_no_recurse_emissions = &emission;
+      SIGNAL_UNLOCK ();
     }
   accumulator = node->accumulator;
   if (accumulator)
     {
-      SIGNAL_UNLOCK ();
       g_value_init (&accu, node->return_type & ~G_SIGNAL_TYPE_STATIC_SCOPE);
       return_accu = &accu;
-      SIGNAL_LOCK ();
     }
   else
     return_accu = emission_return;
-  emission.instance = instance;
-  emission.ihint.signal_id = node->signal_id;
-  emission.ihint.detail = detail;
-  emission.ihint.run_type = 0;
-  emission.state = 0;
-  emission.chain_type = G_TYPE_NONE;
-  emission_push (&emission);
+  emission_push (thread, &emission);
+  phase = signal_read_begin (thread);
   class_closure = signal_lookup_closure (node, instance);
+  signal_read_end (thread, phase);
   
  EMIT_RESTART:
   
-  if (handler_list)
-    handler_unref_R (signal_id, instance, handler_list);
-  max_sequential_handler_number = g_handler_sequential_number;
-  hlist = handler_list_lookup (signal_id, instance);
-  handler_list = hlist ? hlist->handlers : NULL;
-  if (handler_list)
-    handler_ref (handler_list);
+  g_atomic_int_set (&emission.state, EMISSION_RUN);
+  if (snapshot)
+    handler_snapshot_release (snapshot);
+  snapshot = handler_snapshot_acquire (thread, instance, signal_id);
   
   emission.ihint.run_type = G_SIGNAL_RUN_FIRST | G_SIGNAL_ACCUMULATOR_FIRST_RUN;
   
   if ((node->flags & G_SIGNAL_RUN_FIRST) && class_closure)
     {
-      emission.state = EMISSION_RUN;
+      if (!emission_set_state (&emission, EMISSION_RUN))
+        goto EMIT_RESTART;
 
       emission.chain_type = G_TYPE_FROM_INSTANCE (instance);
-      SIGNAL_UNLOCK ();
       g_closure_invoke (class_closure,
 			return_accu,
 			node->n_params + 1,
 			instance_and_params,
 			&emission.ihint);
-      if (!accumulate (&emission.ihint, emission_return, &accu, accumulator) &&
-	  emission.state == EMISSION_RUN)
-	emission.state = EMISSION_STOP;
-      SIGNAL_LOCK ();
+      if (!accumulate (&emission.ihint, emission_return, &accu, accumulator))
+	g_atomic_int_compare_and_exchange (&emission.state, EMISSION_RUN, EMISSION_STOP);
       emission.chain_type = G_TYPE_NONE;
       return_value_altered = TRUE;
       
-      if (emission.state == EMISSION_STOP)
+      if (g_atomic_int_get (&emission.state) == EMISSION_STOP)
 	goto EMIT_CLEANUP;
-      else if (emission.state == EMISSION_RESTART)
+      else if (g_atomic_int_get (&emission.state) == EMISSION_RESTART)
 	goto EMIT_RESTART;
     }
   
-  if (node->emission_hooks)
+  if (g_atomic_pointer_get (&node->emission_hooks))
     {
       gboolean need_destroy, was_in_call, may_recurse = TRUE;
       GHook *hook;
 
-      emission.state = EMISSION_HOOK;
+      if (!emission_set_state (&emission, EMISSION_HOOK))
+        goto EMIT_RESTART;
+      SIGNAL_LOCK ();
       hook = g_hook_first_valid (node->emission_hooks, may_recurse);
       while (hook)
 	{
@@ -3772,58 +4749,39 @@ signal_emit_unlocked_R (SignalNode   *node,
 	    }
 	  hook = g_hook_next_valid (node->emission_hooks, hook, may_recurse);
 	}
+      SIGNAL_UNLOCK ();
       
-      if (emission.state == EMISSION_RESTART)
+      if (g_atomic_int_get (&emission.state) == EMISSION_RESTART)
 	goto EMIT_RESTART;
     }
   
-  if (handler_list)
+  if (snapshot)
     {
-      Handler *handler = handler_list;
-      
-      emission.state = EMISSION_RUN;
-      handler_ref (handler);
-      do
+      if (!emission_set_state (&emission, EMISSION_RUN))
+        goto EMIT_RESTART;
+      for (i = 0; i < snapshot->n_before; i++)
 	{
-	  Handler *tmp;
-	  
-	  if (handler->after)
-	    {
-	      handler_unref_R (signal_id, instance, handler_list);
-	      handler_list = handler;
-	      break;
-	    }
-	  else if (!handler->block_count && (!handler->detail || handler->detail == detail) &&
-		   handler->sequential_number < max_sequential_handler_number)
+	  Handler *handler = snapshot->handlers[i];
+
+	  if (!g_atomic_int_get (&handler->block_count) && (!handler->detail || handler->detail == detail))
 	    {
-	      SIGNAL_UNLOCK ();
 	      g_closure_invoke (handler->closure,
 				return_accu,
 				node->n_params + 1,
 				instance_and_params,
 				&emission.ihint);
-	      if (!accumulate (&emission.ihint, emission_return, &accu, accumulator) &&
-		  emission.state == EMISSION_RUN)
-		emission.state = EMISSION_STOP;
-	      SIGNAL_LOCK ();
+	      if (!accumulate (&emission.ihint, emission_return, &accu, accumulator))
+		g_atomic_int_compare_and_exchange (&emission.state, EMISSION_RUN, EMISSION_STOP);
 	      return_value_altered = TRUE;
 	      
-	      tmp = emission.state == EMISSION_RUN ? handler->next : NULL;
+	      if (g_atomic_int_get (&emission.state) != EMISSION_RUN)
+		break;
 	    }
-	  else
-	    tmp = handler->next;
-	  
-	  if (tmp)
-	    handler_ref (tmp);
-	  handler_unref_R (signal_id, instance, handler_list);
-	  handler_list = handler;
-	  handler = tmp;
 	}
-      while (handler);
       
-      if (emission.state == EMISSION_STOP)
+      if (g_atomic_int_get (&emission.state) == EMISSION_STOP)
 	goto EMIT_CLEANUP;
-      else if (emission.state == EMISSION_RESTART)
+      else if (g_atomic_int_get (&emission.state) == EMISSION_RESTART)
 	goto EMIT_RESTART;
     }
   
@@ -3832,68 +4790,53 @@ signal_emit_unlocked_R (SignalNode   *node,
   
   if ((node->flags & G_SIGNAL_RUN_LAST) && class_closure)
     {
-      emission.state = EMISSION_RUN;
+      if (!emission_set_state (&emission, EMISSION_RUN))
+        goto EMIT_RESTART;
       
       emission.chain_type = G_TYPE_FROM_INSTANCE (instance);
-      SIGNAL_UNLOCK ();
       g_closure_invoke (class_closure,
 			return_accu,
 			node->n_params + 1,
 			instance_and_params,
 			&emission.ihint);
-      if (!accumulate (&emission.ihint, emission_return, &accu, accumulator) &&
-	  emission.state == EMISSION_RUN)
-	emission.state = EMISSION_STOP;
-      SIGNAL_LOCK ();
+      if (!accumulate (&emission.ihint, emission_return, &accu, accumulator))
+	g_atomic_int_compare_and_exchange (&emission.state, EMISSION_RUN, EMISSION_STOP);
       emission.chain_type = G_TYPE_NONE;
       return_value_altered = TRUE;
       
-      if (emission.state == EMISSION_STOP)
+      if (g_atomic_int_get (&emission.state) == EMISSION_STOP)
 	goto EMIT_CLEANUP;
-      else if (emission.state == EMISSION_RESTART)
+      else if (g_atomic_int_get (&emission.state) == EMISSION_RESTART)
 	goto EMIT_RESTART;
     }
   
-  if (handler_list)
+  if (snapshot)
     {
-      Handler *handler = handler_list;
-      
-      emission.state = EMISSION_RUN;
-      handler_ref (handler);
-      do
+      if (!emission_set_state (&emission, EMISSION_RUN))
+        goto EMIT_RESTART;
+      for (i = snapshot->n_before; i < snapshot->n_handlers; i++)
 	{
-	  Handler *tmp;
-	  
-	  if (handler->after && !handler->block_count && (!handler->detail || handler->detail == detail) &&
-	      handler->sequential_number < max_sequential_handler_number)
+	  Handler *handler = snapshot->handlers[i];
+
+	  if (!g_atomic_int_get (&handler->block_count) && (!handler->detail || handler->detail == detail))
 	    {
-	      SIGNAL_UNLOCK ();
 	      g_closure_invoke (handler->closure,
 				return_accu,
 				node->n_params + 1,
 				instance_and_params,
 				&emission.ihint);
-	      if (!accumulate (&emission.ihint, emission_return, &accu, accumulator) &&
-		  emission.state == EMISSION_RUN)
-		emission.state = EMISSION_STOP;
-	      SIGNAL_LOCK ();
+	      if (!accumulate (&emission.ihint, emission_return, &accu, accumulator))
+		g_atomic_int_compare_and_exchange (&emission.state, EMISSION_RUN, EMISSION_STOP);
 	      return_value_altered = TRUE;
 	      
-	      tmp = emission.state == EMISSION_RUN ? handler->next : NULL;
+	      if (g_atomic_int_get (&emission.state) != EMISSION_RUN)
+		break;
 	    }
-	  else
-	    tmp = handler->next;
-	  
-	  if (tmp)
-	    handler_ref (tmp);
-	  handler_unref_R (signal_id, instance, handler);
-	  handler = tmp;
 	}
-      while (handler);
       
-      if (emission.state == EMISSION_STOP)
+      if (g_atomic_int_get (&emission.state) == EMISSION_STOP)
 	goto EMIT_CLEANUP;
-      else if (emission.state == EMISSION_RESTART)
+      else if (g_atomic_int_get (&emission.state) == EMISSION_RESTART)
 	goto EMIT_RESTART;
     }
   
@@ -3906,10 +4849,10 @@ signal_emit_unlocked_R (SignalNode   *node,
     {
       gboolean need_unset = FALSE;
       
-      emission.state = EMISSION_STOP;
+      if (!emission_set_state (&emission, EMISSION_STOP))
+        goto EMIT_RESTART;
       
       emission.chain_type = G_TYPE_FROM_INSTANCE (instance);
-      SIGNAL_UNLOCK ();
       if (node->return_type != G_TYPE_NONE && !accumulator)
 	{
 	  g_value_init (&accu, node->return_type & ~G_SIGNAL_TYPE_STATIC_SCOPE);
@@ -3920,25 +4863,38 @@ signal_emit_unlocked_R (SignalNode   *node,
 			node->n_params + 1,
 			instance_and_params,
 			&emission.ihint);
-      if (!accumulate (&emission.ihint, emission_return, &accu, accumulator) &&
-          emission.state == EMISSION_RUN)
-        emission.state = EMISSION_STOP;
+      if (!accumulate (&emission.ihint, emission_return, &accu, accumulator))
+        g_atomic_int_compare_and_exchange (&emission.state, EMISSION_RUN, EMISSION_STOP);
       if (need_unset)
 	g_value_unset (&accu);
-      SIGNAL_LOCK ();
       return_value_altered = TRUE;
 
       emission.chain_type = G_TYPE_NONE;
       
-      if (emission.state == EMISSION_RESTART)
+      if (g_atomic_int_get (&emission.state) == EMISSION_RESTART)
 	goto EMIT_RESTART;
     }
   
-  if (handler_list)
-    handler_unref_R (signal_id, instance, handler_list);
+  if (node->flags & G_SIGNAL_NO_RECURSE)
+    {
+      Emission **link;
+
+      SIGNAL_LOCK ();
+      if (g_atomic_int_get (&emission.state) == EMISSION_RESTART)
+        {
+          SIGNAL_UNLOCK ();
+          goto EMIT_RESTART;
+        }
+      for (link = &g_no_recurse_emissions; *link != &emission; link = &(*link)->next_no_recurse)
+        ;
+      *link = emission.next_no_recurse;
+      SIGNAL_UNLOCK ();
+    }
+  
+  if (snapshot)
+    handler_snapshot_release (snapshot);
   
-  emission_pop (&emission);
-  SIGNAL_UNLOCK ();
+  emission_pop (thread, &emission);
   if (accumulator)
     g_value_unset (&accu);
 
@@ -3982,7 +4938,8 @@ invalid_closure_notify (gpointer  instance,
 
   g_hash_table_remove (g_handlers, handler);
   handler->sequential_number = 0;
-  handler->block_count = 1;
+  g_atomic_int_set (&handler->block_count, 1);
+  handler_list_publish_R (signal_id, instance);
   handler_unref_R (signal_id, instance, handler);
 
   SIGNAL_UNLOCK ();
@@ -98,6 +98,8 @@ void        _g_closure_invoke_va (GClosure       *closure,
 gboolean    _g_object_has_signal_handler     (GObject     *object);
 void        _g_object_set_has_signal_handler (GObject     *object,
                                               guint        signal_id);
+gpointer   *_g_object_get_signal_handlers_location (GObject *object);
+void        _g_signal_handlers_finalize      (GObject     *object);
 
 /**
  * _G_DEFINE_TYPE_EXTENDED_WITH_PRELUDE:
@@ -147,7 +147,7 @@
 #define INVALID_RECURSION(func, arg, type_name)
 #endif
 #define g_assert_type_system_initialized() \
-  g_assert (static_quark_type_flags)
+  g_assert (static_quark_iface_holder)
 
 #define TYPE_FUNDAMENTAL_FLAG_MASK (G_TYPE_FLAG_CLASSED | \
 				    G_TYPE_FLAG_INSTANTIATABLE | \
@@ -229,6 +229,11 @@ typedef enum
 } InitState;
 
 /* --- structures --- */
+
+/* Number of interface types an instantiatable type remembers it conforms
+ * to, so that repeated interface checks skip the iface entries lookup. */
+#define IFACE_CACHE_SIZE			(8)
+
 struct _TypeNode
 {
   guint        ref_count;  /* (atomic) */
@@ -238,11 +243,11 @@ struct _TypeNode
   GTypePlugin *plugin;
   guint        n_children; /* writable with lock */
   guint        n_supers : 8;
-  guint        n_prerequisites : 9;
   guint        is_classed : 1;
   guint        is_instantiatable : 1;
   guint        mutatable_check_cache : 1;	/* combines some common path checks */
   GType       *children; /* writable with lock */
+  guint        flags;  /* (atomic) GTypeFlags within TYPE_FLAG_MASK, writable with lock */
   TypeData    *data;
   GQuark       qname;
   GData       *global_gdata;
@@ -250,7 +255,8 @@ struct _TypeNode
     GAtomicArray iface_entries;		/* for !iface types */
     GAtomicArray offsets;
   } _prot;
-  GType       *prerequisites;
+  GAtomicArray prerequisites;		/* for iface types */
+  gpointer     iface_cache[IFACE_CACHE_SIZE]; /* (atomic) interfaces known to be implemented */
   GType        supers[1]; /* flexible array */
 };
 
@@ -259,6 +265,7 @@ struct _TypeNode
 #define MAX_N_CHILDREN				(G_MAXUINT)
 #define	MAX_N_INTERFACES			(255) /* Limited by offsets being 8 bits */
 #define	MAX_N_PREREQUISITES			(511)
+#define	MAX_N_INSTANCE_POOLS			(32)
 #define NODE_TYPE(node)				(node->supers[0])
 #define NODE_PARENT_TYPE(node)			(node->supers[1])
 #define NODE_FUNDAMENTAL_TYPE(node)		(node->supers[node->n_supers])
@@ -268,8 +275,10 @@ struct _TypeNode
 #define	NODE_IS_IFACE(node)			(NODE_FUNDAMENTAL_TYPE (node) == G_TYPE_INTERFACE)
 #define	CLASSED_NODE_IFACES_ENTRIES(node)	(&(node)->_prot.iface_entries)
 #define	CLASSED_NODE_IFACES_ENTRIES_LOCKED(node)(G_ATOMIC_ARRAY_GET_LOCKED(CLASSED_NODE_IFACES_ENTRIES((node)), IFaceEntries))
-#define	IFACE_NODE_N_PREREQUISITES(node)	((node)->n_prerequisites)
-#define	IFACE_NODE_PREREQUISITES(node)		((node)->prerequisites)
+#define	IFACE_NODE_PREREQUISITES(node)		(G_ATOMIC_ARRAY_GET_LOCKED (&(node)->prerequisites, GType))
+#define	IFACE_NODE_N_PREREQUISITES(node)	(IFACE_NODE_PREREQUISITES (node) ? \
+						 (guint) (G_ATOMIC_ARRAY_DATA_SIZE (IFACE_NODE_PREREQUISITES (node)) / sizeof (GType)) : 0)
+#define	NODE_FLAGS(node)			((guint) g_atomic_int_get ((int *) &(node)->flags))
 #define	iface_node_get_holders_L(node)		((IFaceHolder*) type_get_qdata_L ((node), static_quark_iface_holder))
 #define	iface_node_set_holders_W(node, holders)	(type_set_qdata_W ((node), static_quark_iface_holder, (holders)))
 #define	iface_node_get_dependants_array_L(n)	((GType*) type_get_qdata_L ((n), static_quark_dependants_array))
@@ -357,6 +366,8 @@ struct _InstanceData
   guint16            private_size;
   guint16            n_preallocs;
   GInstanceInitFunc  instance_init;
+  guint              pool_slot;  /* (atomic) index + 1 into the per-thread instance pools, 0 if not pooled */
+  guint              pool_size;  /* (atomic) maximum number of instances kept per thread */
 };
 
 union _TypeData
@@ -386,10 +397,11 @@ static guint           static_n_class_cache_funcs = 0;
 static ClassCacheFunc *static_class_cache_funcs = NULL;
 static guint           static_n_iface_check_funcs = 0;
 static IFaceCheckFunc *static_iface_check_funcs = NULL;
-static GQuark          static_quark_type_flags = 0;
 static GQuark          static_quark_iface_holder = 0;
 static GQuark          static_quark_dependants_array = 0;
 static guint           type_registration_serial = 0;
+static TypeNode       *static_pooled_type_nodes[MAX_N_INSTANCE_POOLS] = { NULL, };
+static guint           static_n_pooled_types = 0;
 
 G_GNUC_BEGIN_IGNORE_DEPRECATIONS
 GTypeDebugFlags	       _g_type_debug_flags = 0;
@@ -472,10 +484,7 @@ type_node_any_new_W (TypeNode             *pnode,
       node->is_instantiatable = (type_flags & G_TYPE_FLAG_INSTANTIATABLE) != 0;
       
       if (NODE_IS_IFACE (node))
-	{
-          IFACE_NODE_N_PREREQUISITES (node) = 0;
-	  IFACE_NODE_PREREQUISITES (node) = NULL;
-	}
+	_g_atomic_array_init (&node->prerequisites);
       else
 	_g_atomic_array_init (CLASSED_NODE_IFACES_ENTRIES (node));
     }
@@ -488,10 +497,7 @@ type_node_any_new_W (TypeNode             *pnode,
       node->is_instantiatable = pnode->is_instantiatable;
       
       if (NODE_IS_IFACE (node))
-	{
-	  IFACE_NODE_N_PREREQUISITES (node) = 0;
-	  IFACE_NODE_PREREQUISITES (node) = NULL;
-	}
+	_g_atomic_array_init (&node->prerequisites);
       else
 	{
 	  guint j;
@@ -668,36 +674,96 @@ type_lookup_iface_vtable_I (TypeNode *node,
 }
 
 static inline gboolean
-type_lookup_prerequisite_L (TypeNode *iface,
-			    GType     prerequisite_type)
+prerequisites_contain_I (const GType *prerequisites,
+                         guint        n_prerequisites,
+                         GType        prerequisite_type)
 {
-  if (NODE_IS_IFACE (iface) && IFACE_NODE_N_PREREQUISITES (iface))
+  prerequisites -= 1;
+
+  while (n_prerequisites)
     {
-      GType *prerequisites = IFACE_NODE_PREREQUISITES (iface) - 1;
-      guint n_prerequisites = IFACE_NODE_N_PREREQUISITES (iface);
-      
-      do
+      guint i;
+      const GType *check;
+
+      i = (n_prerequisites + 1) >> 1;
+      check = prerequisites + i;
+      if (prerequisite_type == *check)
+	return TRUE;
+      else if (prerequisite_type > *check)
 	{
-	  guint i;
-	  GType *check;
-	  
-	  i = (n_prerequisites + 1) >> 1;
-	  check = prerequisites + i;
-	  if (prerequisite_type == *check)
-	    return TRUE;
-	  else if (prerequisite_type > *check)
-	    {
-	      n_prerequisites -= i;
-	      prerequisites = check;
-	    }
-	  else /* if (prerequisite_type < *check) */
-	    n_prerequisites = i - 1;
+	  n_prerequisites -= i;
+	  prerequisites = check;
 	}
-      while (n_prerequisites);
+      else /* if (prerequisite_type < *check) */
+	n_prerequisites = i - 1;
     }
+
   return FALSE;
 }
 
+static inline GType
+prerequisites_find_instantiatable_I (const GType *prerequisites,
+                                     guint        n_prerequisites)
+{
+  guint i;
+
+  for (i = 0; i < n_prerequisites; i++)
+    if (lookup_type_node_I (prerequisites[i])->is_instantiatable)
+      return prerequisites[i];
+
+  return 0;
+}
+
+static inline gboolean
+type_lookup_prerequisite_I (TypeNode *iface,
+			    GType     prerequisite_type)
+{
+  gboolean found;
+
+  if (!NODE_IS_IFACE (iface))
+    return FALSE;
+
+  G_ATOMIC_ARRAY_DO_TRANSACTION
+    (&iface->prerequisites, GType,
+
+     found = transaction_data != NULL &&
+             prerequisites_contain_I (transaction_data,
+                                      G_ATOMIC_ARRAY_DATA_SIZE (transaction_data) / sizeof (GType),
+                                      prerequisite_type);
+     );
+
+  return found;
+}
+
+static inline guint
+iface_cache_slot (GType iface_type)
+{
+  return (guint) ((iface_type >> 4) ^ (iface_type >> 10)) % IFACE_CACHE_SIZE;
+}
+
+static inline gboolean
+type_node_iface_cache_lookup_I (TypeNode *node,
+                                GType     iface_type)
+{
+  guint slot = iface_cache_slot (iface_type);
+
+  return g_atomic_pointer_get (&node->iface_cache[slot]) == (gpointer) iface_type ||
+         g_atomic_pointer_get (&node->iface_cache[(slot + 1) % IFACE_CACHE_SIZE]) == (gpointer) iface_type;
+}
+
+/* Entries are never replaced: a type keeps implementing an interface
+ * once it does, and never evicting avoids threads checking different
+ * interfaces bouncing the cache line between them. */
+static inline void
+type_node_iface_cache_insert_I (TypeNode *node,
+                                GType     iface_type)
+{
+  guint slot = iface_cache_slot (iface_type);
+
+  if (!g_atomic_pointer_compare_and_exchange (&node->iface_cache[slot], NULL, (gpointer) iface_type))
+    g_atomic_pointer_compare_and_exchange (&node->iface_cache[(slot + 1) % IFACE_CACHE_SIZE], NULL, (gpointer) iface_type);
+}
+
 #ifndef G_DISABLE_CHECKS
 
 static const gchar*
@@ -818,7 +884,7 @@ check_derivation_I (GType        parent_type,
 		  NODE_NAME (pnode));
       return FALSE;
     }
-  if ((G_TYPE_FLAG_FINAL & GPOINTER_TO_UINT (type_get_qdata_L (pnode, static_quark_type_flags))) == G_TYPE_FLAG_FINAL)
+  if ((G_TYPE_FLAG_FINAL & NODE_FLAGS (pnode)) == G_TYPE_FLAG_FINAL)
     {
       g_critical ("cannot derive '%s' from final parent type '%s'",
                   type_name,
@@ -1163,6 +1229,8 @@ type_data_make_W (TypeNode              *node,
         data->instance.class_private_size = pnode->data->instance.class_private_size;
       data->instance.n_preallocs = MIN (info->n_preallocs, 1024);
       data->instance.instance_init = info->instance_init;
+      data->instance.pool_slot = 0;
+      data->instance.pool_size = 0;
     }
   else if (node->is_classed) /* only classed */
     {
@@ -1237,7 +1305,7 @@ type_data_make_W (TypeNode              *node,
   node->data->common.value_table = vtable;
   node->mutatable_check_cache = (node->data->common.value_table->value_init != NULL &&
 				 !((G_TYPE_FLAG_VALUE_ABSTRACT | G_TYPE_FLAG_ABSTRACT) &
-				   GPOINTER_TO_UINT (type_get_qdata_L (node, static_quark_type_flags))));
+				   NODE_FLAGS (node)));
   
   g_assert (node->data->common.value_table != NULL); /* paranoid */
 
@@ -1530,26 +1598,27 @@ type_iface_add_prerequisite_W (TypeNode *iface,
 {
   GType prerequisite_type = NODE_TYPE (prerequisite_node);
   GType *prerequisites, *dependants;
-  guint n_dependants, i;
-  
+  guint n_prerequisites, n_dependants, i;
+
+  n_prerequisites = IFACE_NODE_N_PREREQUISITES (iface);
   g_assert (NODE_IS_IFACE (iface) &&
-	    IFACE_NODE_N_PREREQUISITES (iface) < MAX_N_PREREQUISITES &&
+	    n_prerequisites < MAX_N_PREREQUISITES &&
 	    (prerequisite_node->is_instantiatable || NODE_IS_IFACE (prerequisite_node)));
-  
+
   prerequisites = IFACE_NODE_PREREQUISITES (iface);
-  for (i = 0; i < IFACE_NODE_N_PREREQUISITES (iface); i++)
+  for (i = 0; i < n_prerequisites; i++)
     if (prerequisites[i] == prerequisite_type)
       return;			/* we already have that prerequisiste */
     else if (prerequisites[i] > prerequisite_type)
       break;
-  IFACE_NODE_N_PREREQUISITES (iface) += 1;
-  IFACE_NODE_PREREQUISITES (iface) = g_renew (GType,
-					      IFACE_NODE_PREREQUISITES (iface),
-					      IFACE_NODE_N_PREREQUISITES (iface));
-  prerequisites = IFACE_NODE_PREREQUISITES (iface);
+
+  /* Publish a new array rather than growing this one in place, so that
+   * type_lookup_prerequisite_I() can search it without the lock. */
+  prerequisites = _g_atomic_array_copy (&iface->prerequisites, 0, sizeof (GType));
   memmove (prerequisites + i + 1, prerequisites + i,
-           sizeof (prerequisites[0]) * (IFACE_NODE_N_PREREQUISITES (iface) - i - 1));
+           sizeof (prerequisites[0]) * (n_prerequisites - i));
   prerequisites[i] = prerequisite_type;
+  _g_atomic_array_update (&iface->prerequisites, prerequisites);
   
   /* we want to get notified when prerequisites get added to prerequisite_node */
   if (NODE_IS_IFACE (prerequisite_node))
@@ -1836,6 +1905,157 @@ type_iface_blow_holder_info_Wm (TypeNode *iface,
     }
 }
 
+/* --- instance pools --- */
+typedef struct {
+  gpointer free_list;
+  guint    n_free;
+} InstancePool;
+
+static void instance_pools_free (gpointer data);
+
+static GPrivate instance_pools_private = G_PRIVATE_INIT (instance_pools_free);
+
+/* Every thread's pools, so that they can all be emptied on teardown */
+G_LOCK_DEFINE_STATIC (instance_pools);
+static GSList *all_instance_pools = NULL;
+
+#ifdef G_HAS_CONSTRUCTORS
+#ifdef G_DEFINE_DESTRUCTOR_NEEDS_PRAGMA
+#pragma G_DEFINE_DESTRUCTOR_PRAGMA_ARGS(instance_pools_deinit)
+#endif
+G_DEFINE_DESTRUCTOR(instance_pools_deinit)
+#endif /* G_HAS_CONSTRUCTORS */
+
+static void
+instance_pools_drain (InstancePool *pools)
+{
+  guint i;
+
+  for (i = 0; i < MAX_N_INSTANCE_POOLS; i++)
+    {
+      InstancePool *pool = &pools[i];
+      TypeNode *node;
+      gsize block_size;
+
+      if (pool->free_list == NULL)
+        continue;
+
+      node = static_pooled_type_nodes[i];
+      block_size = node->data->instance.private_size + node->data->instance.instance_size;
+
+      while (pool->free_list != NULL)
+        {
+          gpointer block = pool->free_list;
+
+          pool->free_list = *(gpointer *) block;
+          g_slice_free1 (block_size, block);
+        }
+      pool->n_free = 0;
+    }
+}
+
+static void
+instance_pools_deinit (void)
+{
+  GSList *l;
+  guint i;
+
+  g_private_replace (&instance_pools_private, NULL);
+
+  /* The pools of threads that are still around stay allocated, as their
+   * threads own them, but must not hold on to blocks of types whose pool
+   * slots are about to be handed out afresh.
+   */
+  G_LOCK (instance_pools);
+  for (l = all_instance_pools; l != NULL; l = l->next)
+    instance_pools_drain (l->data);
+  G_UNLOCK (instance_pools);
+
+  /* Forget the pooled types too, so that pool slots are handed out afresh
+   * after glib_init(). The class references taken by
+   * g_type_set_instance_pool_size() are kept, as static classes are never
+   * finalized.
+   */
+  G_WRITE_LOCK (&type_rw_lock);
+  for (i = 0; i < static_n_pooled_types; i++)
+    {
+      TypeNode *node = static_pooled_type_nodes[i];
+
+      g_atomic_int_set (&node->data->instance.pool_slot, 0);
+      g_atomic_int_set (&node->data->instance.pool_size, 0);
+      static_pooled_type_nodes[i] = NULL;
+    }
+  static_n_pooled_types = 0;
+  G_WRITE_UNLOCK (&type_rw_lock);
+}
+
+static void
+instance_pools_free (gpointer data)
+{
+  InstancePool *pools = data;
+
+  G_LOCK (instance_pools);
+  all_instance_pools = g_slist_remove (all_instance_pools, pools);
+  instance_pools_drain (pools);
+  G_UNLOCK (instance_pools);
+
+  g_free (pools);
+}
+
+static inline gpointer
+instance_pool_pop (guint pool_slot,
+                   gsize block_size)
+{
+  InstancePool *pools, *pool;
+  gpointer block;
+
+  pools = g_private_get (&instance_pools_private);
+  if (pools == NULL)
+    return NULL;
+
+  pool = &pools[pool_slot - 1];
+  block = pool->free_list;
+  if (block == NULL)
+    return NULL;
+
+  pool->free_list = *(gpointer *) block;
+  pool->n_free--;
+
+  return memset (block, 0, block_size);
+}
+
+static inline gboolean
+instance_pool_push (guint    pool_slot,
+                    guint    pool_size,
+                    gpointer block)
+{
+  InstancePool *pools, *pool;
+
+  pools = g_private_get (&instance_pools_private);
+  if (G_UNLIKELY (pools == NULL))
+    {
+      if (pool_size == 0)
+        return FALSE;
+
+      pools = g_new0 (InstancePool, MAX_N_INSTANCE_POOLS);
+      g_private_set (&instance_pools_private, pools);
+
+      G_LOCK (instance_pools);
+      all_instance_pools = g_slist_prepend (all_instance_pools, pools);
+      G_UNLOCK (instance_pools);
+    }
+
+  pool = &pools[pool_slot - 1];
+  if (pool->n_free >= pool_size)
+    return FALSE;
+
+  *(gpointer *) block = pool->free_list;
+  pool->free_list = block;
+  pool->n_free++;
+
+  return TRUE;
+}
+
 /**
  * g_type_create_instance: (skip)
  * @type: an instantiatable type to create an instance for
@@ -1869,6 +2089,7 @@ g_type_create_instance (GType type)
   gchar *allocated;
   gint private_size;
   gint ivar_size;
+  guint pool_slot;
   guint i;
 
   node = lookup_type_node_I (type);
@@ -1885,6 +2106,7 @@ g_type_create_instance (GType type)
     }
   
   class = g_type_class_ref (type);
+  pool_slot = g_atomic_int_get (&node->data->instance.pool_slot);
 
   /* We allocate the 'private' areas before the normal instance data, in
    * reverse order.  This allows the private area of a particular class
@@ -1922,7 +2144,13 @@ g_type_create_instance (GType type)
     }
   else
 #endif
-    allocated = g_slice_alloc0 (private_size + ivar_size);
+    {
+      allocated = NULL;
+      if (pool_slot != 0)
+        allocated = instance_pool_pop (pool_slot, private_size + ivar_size);
+      if (allocated == NULL)
+        allocated = g_slice_alloc0 (private_size + ivar_size);
+    }
 
   instance = (GTypeInstance *) (allocated + private_size);
 
@@ -1972,6 +2200,7 @@ g_type_free_instance (GTypeInstance *instance)
   gchar *allocated;
   gint private_size;
   gint ivar_size;
+  guint pool_slot;
 
   g_return_if_fail (instance != NULL && instance->g_class != NULL);
   
@@ -1992,6 +2221,7 @@ g_type_free_instance (GTypeInstance *instance)
     }
   
   instance->g_class = NULL;
+  pool_slot = g_atomic_int_get (&node->data->instance.pool_slot);
   private_size = node->data->instance.private_size;
   ivar_size = node->data->instance.instance_size;
   allocated = ((gchar *) instance) - private_size;
@@ -2019,7 +2249,9 @@ g_type_free_instance (GTypeInstance *instance)
     }
   else
 #endif
-    g_slice_free1 (private_size + ivar_size, allocated);
+    if (pool_slot == 0 ||
+        !instance_pool_push (pool_slot, g_atomic_int_get (&node->data->instance.pool_size), allocated))
+      g_slice_free1 (private_size + ivar_size, allocated);
 
 #ifdef	G_ENABLE_DEBUG
   IF_DEBUG (INSTANCE_COUNT)
@@ -2031,6 +2263,66 @@ g_type_free_instance (GTypeInstance *instance)
   g_type_class_unref (class);
 }
 
+/**
+ * g_type_set_instance_pool_size:
+ * @type: a static, instantiatable type
+ * @n_instances: the maximum number of freed instances to keep per thread
+ *
+ * Lets g_type_free_instance() keep up to @n_instances freed instances of
+ * @type in a pool owned by the calling thread, so that later calls to
+ * g_type_create_instance() on that thread can reuse their memory instead
+ * of going back to the slice allocator.
+ *
+ * This is worthwhile for types whose instances are created and destroyed
+ * at a high rate, and is opt-in because every thread that frees instances
+ * of @type may hold on to up to @n_instances of them until it exits.
+ * Passing 0 stops further instances from being pooled.
+ *
+ * Pooling a type keeps its class alive for the rest of the program, so
+ * only types registered with g_type_register_static() may be pooled.
+ *
+ * Since: 2.76
+ */
+void
+g_type_set_instance_pool_size (GType type,
+                               guint n_instances)
+{
+  TypeNode *node;
+  gpointer class;
+
+  node = lookup_type_node_I (type);
+  g_return_if_fail (node != NULL && node->is_instantiatable);
+  g_return_if_fail (node->plugin == NULL);
+
+  /* Initializes the class, which fixes the instance size, and keeps it
+   * around for the pooled instances.
+   */
+  class = g_type_class_ref (type);
+
+  G_WRITE_LOCK (&type_rw_lock);
+  if (node->data->instance.pool_slot == 0)
+    {
+      if (static_n_pooled_types == MAX_N_INSTANCE_POOLS)
+        {
+          G_WRITE_UNLOCK (&type_rw_lock);
+          g_type_class_unref (class);
+          g_warning ("cannot pool instances of type '%s': too many pooled types",
+                     NODE_NAME (node));
+          return;
+        }
+      static_pooled_type_nodes[static_n_pooled_types++] = node;
+      g_atomic_int_set (&node->data->instance.pool_size, n_instances);
+      g_atomic_int_set (&node->data->instance.pool_slot, static_n_pooled_types);
+      class = NULL;
+    }
+  else
+    g_atomic_int_set (&node->data->instance.pool_size, n_instances);
+  G_WRITE_UNLOCK (&type_rw_lock);
+
+  if (class != NULL)
+    g_type_class_unref (class);
+}
+
 static void
 type_iface_ensure_dflt_vtable_Wm (TypeNode *iface)
 {
@@ -3538,6 +3830,9 @@ type_node_check_conformities_UorL (TypeNode *node,
   match = FALSE;
   if (support_interfaces)
     {
+      if (type_node_iface_cache_lookup_I (node, NODE_TYPE (iface_node)))
+        return TRUE;
+
       if (have_lock)
 	{
 	  if (type_lookup_iface_entry_L (node, iface_node))
@@ -3548,17 +3843,14 @@ type_node_check_conformities_UorL (TypeNode *node,
 	  if (type_lookup_iface_vtable_I (node, iface_node, NULL))
 	    match = TRUE;
 	}
+
+      if (match)
+        type_node_iface_cache_insert_I (node, NODE_TYPE (iface_node));
     }
   if (!match &&
-      support_prerequisites)
-    {
-      if (!have_lock)
-	G_READ_LOCK (&type_rw_lock);
-      if (support_prerequisites && type_lookup_prerequisite_L (node, NODE_TYPE (iface_node)))
-	match = TRUE;
-      if (!have_lock)
-	G_READ_UNLOCK (&type_rw_lock);
-    }
+      support_prerequisites &&
+      type_lookup_prerequisite_I (node, NODE_TYPE (iface_node)))
+    match = TRUE;
   return match;
 }
 
@@ -3854,16 +4146,12 @@ static void
 type_add_flags_W (TypeNode  *node,
 		  GTypeFlags flags)
 {
-  guint dflags;
-  
   g_return_if_fail ((flags & ~TYPE_FLAG_MASK) == 0);
   g_return_if_fail (node != NULL);
   
   if ((flags & TYPE_FLAG_MASK) && node->is_classed && node->data && node->data->class.class)
     g_critical ("tagging type '%s' as abstract after class initialization", NODE_NAME (node));
-  dflags = GPOINTER_TO_UINT (type_get_qdata_L (node, static_quark_type_flags));
-  dflags |= flags;
-  type_set_qdata_W (node, static_quark_type_flags, GUINT_TO_POINTER (dflags));
+  g_atomic_int_or (&node->flags, flags);
 }
 
 /**
@@ -3958,11 +4246,7 @@ g_type_test_flags (GType type,
 	fflags = TRUE;
       
       if (tflags)
-	{
-	  G_READ_LOCK (&type_rw_lock);
-	  tflags = (tflags & GPOINTER_TO_UINT (type_get_qdata_L (node, static_quark_type_flags))) == tflags;
-	  G_READ_UNLOCK (&type_rw_lock);
-	}
+	tflags = (tflags & NODE_FLAGS (node)) == tflags;
       else
 	tflags = TRUE;
       
@@ -4233,37 +4517,52 @@ type_check_is_value_type_U (GType type)
   GTypeFlags tflags = G_TYPE_FLAG_VALUE_ABSTRACT;
   TypeNode *node;
   
+  gboolean have_lock = FALSE;
+  
   /* common path speed up */
   node = lookup_type_node_I (type);
   if (node && node->mutatable_check_cache)
     return TRUE;
   
-  G_READ_LOCK (&type_rw_lock);
  restart_check:
   if (node)
     {
+      /* The data of a static type is complete by the time the type is
+       * registered and is never freed, so only dynamic types need the
+       * lock here.
+       */
+      if (node->plugin && !have_lock)
+        {
+          G_READ_LOCK (&type_rw_lock);
+          have_lock = TRUE;
+        }
+
       if (node->data && NODE_REFCOUNT (node) > 0 &&
 	  node->data->common.value_table->value_init)
-	tflags = GPOINTER_TO_UINT (type_get_qdata_L (node, static_quark_type_flags));
+	tflags = NODE_FLAGS (node);
       else if (NODE_IS_IFACE (node))
 	{
-	  guint i;
-	  
-	  for (i = 0; i < IFACE_NODE_N_PREREQUISITES (node); i++)
+	  GType prtype = 0;
+
+	  G_ATOMIC_ARRAY_DO_TRANSACTION
+	    (&node->prerequisites, GType,
+
+	     prtype = transaction_data != NULL
+	         ? prerequisites_find_instantiatable_I (transaction_data,
+	                                                G_ATOMIC_ARRAY_DATA_SIZE (transaction_data) / sizeof (GType))
+	         : 0;
+	     );
+
+	  if (prtype != 0)
 	    {
-	      GType prtype = IFACE_NODE_PREREQUISITES (node)[i];
-	      TypeNode *prnode = lookup_type_node_I (prtype);
-	      
-	      if (prnode->is_instantiatable)
-		{
-		  type = prtype;
-		  node = lookup_type_node_I (type);
-		  goto restart_check;
-		}
+	      type = prtype;
+	      node = lookup_type_node_I (type);
+	      goto restart_check;
 	    }
 	}
     }
-  G_READ_UNLOCK (&type_rw_lock);
+  if (have_lock)
+    G_READ_UNLOCK (&type_rw_lock);
   
   return !(tflags & G_TYPE_FLAG_VALUE_ABSTRACT);
 }
@@ -4478,7 +4777,6 @@ gobject_perform_init (void)
 #endif
 
   /* quarks */
-  static_quark_type_flags = g_quark_from_static_string ("-g-type-private--GTypeFlags");
   static_quark_iface_holder = g_quark_from_static_string ("-g-type-private--IFaceHolder");
   static_quark_dependants_array = g_quark_from_static_string ("-g-type-private--dependants-array");
 
@@ -2444,6 +2444,9 @@ GOBJECT_AVAILABLE_IN_ALL
 GTypeInstance*   g_type_create_instance         (GType               type);
 GOBJECT_AVAILABLE_IN_ALL
 void             g_type_free_instance           (GTypeInstance      *instance);
+GOBJECT_AVAILABLE_IN_2_76
+void             g_type_set_instance_pool_size  (GType               type,
+                                                 guint               n_instances);
 
 GOBJECT_AVAILABLE_IN_ALL
 void		 g_type_add_class_cache_func    (gpointer	     cache_data,
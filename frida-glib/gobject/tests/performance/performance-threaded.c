@@ -48,6 +48,7 @@ simple_register_class (const char *name, GType parent, ...)
 
 static GType liststore;
 static GType liststore_interfaces[6];
+static GType liststore_dependant;
 
 static gpointer 
 register_types (void)
@@ -66,6 +67,11 @@ register_types (void)
           liststore_interfaces[0], liststore_interfaces[1], liststore_interfaces[2],
           liststore_interfaces[3], liststore_interfaces[4], (GType) 0);
 
+      liststore_dependant = simple_register_class ("GtkTreeModelDependant", G_TYPE_INTERFACE, 0);
+      g_type_interface_add_prerequisite (liststore_dependant, G_TYPE_OBJECT);
+      g_type_interface_add_prerequisite (liststore_dependant, liststore_interfaces[2]);
+      g_type_interface_add_prerequisite (liststore_dependant, liststore_interfaces[4]);
+
       g_once_init_leave (&inited, 1);
     }
   return NULL;
@@ -87,6 +93,45 @@ liststore_is_a_run (gpointer data)
     }
 }
 
+static gpointer
+liststore_new (void)
+{
+  register_types ();
+  return g_object_new (liststore, NULL);
+}
+
+static void
+liststore_instance_is_a_run (gpointer instance)
+{
+  guint i;
+
+  for (i = 0; i < 1000; i++)
+    {
+      g_assert (G_TYPE_CHECK_INSTANCE_TYPE (instance, liststore_interfaces[0]));
+      g_assert (G_TYPE_CHECK_INSTANCE_TYPE (instance, liststore_interfaces[1]));
+      g_assert (G_TYPE_CHECK_INSTANCE_TYPE (instance, liststore_interfaces[2]));
+      g_assert (G_TYPE_CHECK_INSTANCE_TYPE (instance, liststore_interfaces[3]));
+      g_assert (G_TYPE_CHECK_INSTANCE_TYPE (instance, liststore_interfaces[4]));
+      g_assert (!G_TYPE_CHECK_INSTANCE_TYPE (instance, liststore_interfaces[5]));
+    }
+}
+
+static void
+liststore_prerequisite_is_a_run (gpointer data)
+{
+  guint i;
+
+  for (i = 0; i < 1000; i++)
+    {
+      g_assert (g_type_is_a (liststore_dependant, G_TYPE_OBJECT));
+      g_assert (g_type_is_a (liststore_dependant, liststore_interfaces[2]));
+      g_assert (g_type_is_a (liststore_dependant, liststore_interfaces[4]));
+      g_assert (!g_type_is_a (liststore_dependant, liststore_interfaces[0]));
+      g_assert (!g_type_is_a (liststore_dependant, liststore_interfaces[5]));
+      g_assert (!G_TYPE_IS_ABSTRACT (liststore));
+    }
+}
+
 static gpointer
 liststore_get_class (void)
 {
@@ -136,6 +181,286 @@ liststore_interface_peek_same_run (gpointer klass)
     }
 }
 
+/* test emitting handled signals from several threads at once, both on an
+ * object per thread and on one object shared between all of them */
+
+typedef struct {
+  GObject parent;
+} EmitterObject;
+
+typedef struct {
+  GObjectClass parent_class;
+
+  void (*signal) (EmitterObject *obj);
+} EmitterObjectClass;
+
+static GType emitter_object_get_type (void);
+G_DEFINE_TYPE (EmitterObject, emitter_object, G_TYPE_OBJECT)
+
+enum {
+  EMITTER_SIGNAL,
+  EMITTER_SIGNAL_EMPTY,
+  EMITTER_LAST_SIGNAL
+};
+
+static guint emitter_signals[EMITTER_LAST_SIGNAL] = { 0 };
+
+static void
+emitter_object_real_signal (EmitterObject *obj)
+{
+}
+
+static void
+emitter_object_class_init (EmitterObjectClass *class)
+{
+  class->signal = emitter_object_real_signal;
+
+  emitter_signals[EMITTER_SIGNAL] =
+    g_signal_new ("signal",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  G_STRUCT_OFFSET (EmitterObjectClass, signal),
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
+  emitter_signals[EMITTER_SIGNAL_EMPTY] =
+    g_signal_new ("signal-empty",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
+}
+
+static void
+emitter_object_init (EmitterObject *obj)
+{
+}
+
+static void
+emitter_handler (EmitterObject *obj, gpointer data)
+{
+}
+
+static gpointer
+emitter_new (void)
+{
+  gpointer object = g_object_new (emitter_object_get_type (), NULL);
+
+  g_signal_connect (object, "signal", G_CALLBACK (emitter_handler), NULL);
+  g_signal_connect (object, "signal-empty", G_CALLBACK (emitter_handler), NULL);
+
+  return object;
+}
+
+static gpointer
+emitter_get_shared (void)
+{
+  static gpointer shared = NULL;
+
+  if (g_once_init_enter (&shared))
+    g_once_init_leave (&shared, emitter_new ());
+
+  return g_object_ref (shared);
+}
+
+static void
+emit_handled_run (gpointer object)
+{
+  guint i;
+
+  for (i = 0; i < 1000; i++)
+    g_signal_emit (object, emitter_signals[EMITTER_SIGNAL], 0);
+}
+
+static void
+emit_handled_empty_run (gpointer object)
+{
+  guint i;
+
+  for (i = 0; i < 1000; i++)
+    g_signal_emit (object, emitter_signals[EMITTER_SIGNAL_EMPTY], 0);
+}
+
+/* test adding and removing toggle refs and getting weak refs from several
+ * threads at once, each on an object of its own */
+
+static void
+toggle_notify (gpointer  data,
+               GObject  *object,
+               gboolean  is_last_ref)
+{
+}
+
+static gpointer
+object_new (void)
+{
+  return g_object_new (G_TYPE_OBJECT, NULL);
+}
+
+static void
+toggle_ref_run (gpointer object)
+{
+  guint i;
+
+  for (i = 0; i < 1000; i++)
+    {
+      g_object_add_toggle_ref (object, toggle_notify, NULL);
+      g_object_remove_toggle_ref (object, toggle_notify, NULL);
+    }
+}
+
+typedef struct {
+  GObject *object;
+  GWeakRef weak_ref;
+} WeakRefTest;
+
+static gpointer
+weak_ref_setup (void)
+{
+  WeakRefTest *data = g_new (WeakRefTest, 1);
+
+  data->object = g_object_new (G_TYPE_OBJECT, NULL);
+  g_weak_ref_init (&data->weak_ref, data->object);
+
+  return data;
+}
+
+static void
+weak_ref_get_run (gpointer d)
+{
+  WeakRefTest *data = d;
+  guint i;
+
+  for (i = 0; i < 1000; i++)
+    {
+      GObject *object = g_weak_ref_get (&data->weak_ref);
+
+      g_assert (object == data->object);
+      g_object_unref (object);
+    }
+}
+
+static void
+weak_ref_teardown (gpointer d)
+{
+  WeakRefTest *data = d;
+
+  g_weak_ref_clear (&data->weak_ref);
+  g_object_unref (data->object);
+  g_free (data);
+}
+
+/* test notifying property changes from several threads at once, each on
+ * an object of its own, both directly and through a frozen queue */
+
+typedef struct {
+  GObject parent;
+  int foo;
+  int bar;
+} NotifierObject;
+
+typedef struct {
+  GObjectClass parent_class;
+} NotifierObjectClass;
+
+static GType notifier_object_get_type (void);
+G_DEFINE_TYPE (NotifierObject, notifier_object, G_TYPE_OBJECT)
+
+enum {
+  NOTIFIER_PROP_0,
+  NOTIFIER_PROP_FOO,
+  NOTIFIER_PROP_BAR,
+  NOTIFIER_N_PROPS
+};
+
+static GParamSpec *notifier_props[NOTIFIER_N_PROPS] = { NULL };
+
+static void
+notifier_object_set_property (GObject      *object,
+                              guint         prop_id,
+                              const GValue *value,
+                              GParamSpec   *pspec)
+{
+  NotifierObject *obj = (NotifierObject *) object;
+
+  if (prop_id == NOTIFIER_PROP_FOO)
+    obj->foo = g_value_get_int (value);
+  else
+    obj->bar = g_value_get_int (value);
+}
+
+static void
+notifier_object_get_property (GObject    *object,
+                              guint       prop_id,
+                              GValue     *value,
+                              GParamSpec *pspec)
+{
+  NotifierObject *obj = (NotifierObject *) object;
+
+  g_value_set_int (value, prop_id == NOTIFIER_PROP_FOO ? obj->foo : obj->bar);
+}
+
+static void
+notifier_object_class_init (NotifierObjectClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+
+  object_class->set_property = notifier_object_set_property;
+  object_class->get_property = notifier_object_get_property;
+
+  notifier_props[NOTIFIER_PROP_FOO] =
+    g_param_spec_int ("foo", NULL, NULL, 0, G_MAXINT, 0, G_PARAM_READWRITE);
+  notifier_props[NOTIFIER_PROP_BAR] =
+    g_param_spec_int ("bar", NULL, NULL, 0, G_MAXINT, 0, G_PARAM_READWRITE);
+  g_object_class_install_properties (object_class, NOTIFIER_N_PROPS, notifier_props);
+}
+
+static void
+notifier_object_init (NotifierObject *obj)
+{
+}
+
+static void
+notifier_handler (GObject *object, GParamSpec *pspec, gpointer data)
+{
+}
+
+static gpointer
+notifier_new (void)
+{
+  gpointer object = g_object_new (notifier_object_get_type (), NULL);
+
+  g_signal_connect (object, "notify", G_CALLBACK (notifier_handler), NULL);
+
+  return object;
+}
+
+static void
+notify_run (gpointer object)
+{
+  guint i;
+
+  for (i = 0; i < 1000; i++)
+    g_object_notify_by_pspec (object, notifier_props[NOTIFIER_PROP_FOO]);
+}
+
+static void
+notify_frozen_run (gpointer object)
+{
+  guint i;
+
+  for (i = 0; i < 1000; i++)
+    {
+      g_object_freeze_notify (object);
+      g_object_notify_by_pspec (object, notifier_props[NOTIFIER_PROP_FOO]);
+      g_object_notify_by_pspec (object, notifier_props[NOTIFIER_PROP_BAR]);
+      g_object_notify_by_pspec (object, notifier_props[NOTIFIER_PROP_FOO]);
+      g_object_thaw_notify (object);
+    }
+}
+
 #if 0
 /* DUMB test doing nothing */
 
@@ -177,6 +502,16 @@ static const PerformanceTest tests[] = {
     liststore_is_a_run,
     no_reset,
     no_teardown },
+  { "liststore-instance-is-a",
+    liststore_new,
+    liststore_instance_is_a_run,
+    no_reset,
+    g_object_unref },
+  { "liststore-prerequisite-is-a",
+    register_types,
+    liststore_prerequisite_is_a_run,
+    no_reset,
+    no_teardown },
   { "liststore-interface-peek",
     liststore_get_class,
     liststore_interface_peek_run,
@@ -187,6 +522,46 @@ static const PerformanceTest tests[] = {
     liststore_interface_peek_same_run,
     no_reset,
     g_type_class_unref },
+  { "emit-handled",
+    emitter_new,
+    emit_handled_run,
+    no_reset,
+    g_object_unref },
+  { "emit-handled-empty",
+    emitter_new,
+    emit_handled_empty_run,
+    no_reset,
+    g_object_unref },
+  { "emit-handled-shared",
+    emitter_get_shared,
+    emit_handled_run,
+    no_reset,
+    g_object_unref },
+  { "emit-handled-empty-shared",
+    emitter_get_shared,
+    emit_handled_empty_run,
+    no_reset,
+    g_object_unref },
+  { "toggle-ref",
+    object_new,
+    toggle_ref_run,
+    no_reset,
+    g_object_unref },
+  { "weak-ref-get",
+    weak_ref_setup,
+    weak_ref_get_run,
+    no_reset,
+    weak_ref_teardown },
+  { "notify",
+    notifier_new,
+    notify_run,
+    no_reset,
+    g_object_unref },
+  { "notify-frozen",
+    notifier_new,
+    notify_frozen_run,
+    no_reset,
+    g_object_unref },
 #if 0
   { "nothing",
     no_setup,
@@ -208,6 +208,27 @@ simple_object_init (SimpleObject *simple_object)
   simple_object->val = 42;
 }
 
+/*************************************************************
+ * Pooled object is a simple object whose instances are
+ * recycled through a per-thread instance pool
+ *************************************************************/
+
+static GType pooled_object_get_type (void);
+typedef struct _SimpleObject      PooledObject;
+typedef struct _SimpleObjectClass PooledObjectClass;
+
+G_DEFINE_TYPE (PooledObject, pooled_object, SIMPLE_TYPE_OBJECT)
+
+static void
+pooled_object_class_init (PooledObjectClass *class)
+{
+}
+
+static void
+pooled_object_init (PooledObject *pooled_object)
+{
+}
+
 typedef struct _TestIfaceClass TestIfaceClass;
 typedef struct _TestIfaceClass TestIface1Class;
 typedef struct _TestIfaceClass TestIface2Class;
@@ -293,6 +314,7 @@ enum {
   COMPLEX_SIGNAL_GENERIC,
   COMPLEX_SIGNAL_GENERIC_EMPTY,
   COMPLEX_SIGNAL_ARGS,
+  COMPLEX_SIGNAL_GENERIC_ARGS,
   COMPLEX_LAST_SIGNAL
 };
 
@@ -412,6 +434,14 @@ complex_object_class_init (ComplexObjectClass *class)
                   NULL, NULL,
                   g_cclosure_marshal_VOID__UINT_POINTER,
                   G_TYPE_NONE, 2, G_TYPE_UINT, G_TYPE_POINTER);
+  complex_signals[COMPLEX_SIGNAL_GENERIC_ARGS] =
+    g_signal_new ("signal-generic-args",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_FIRST,
+                  G_STRUCT_OFFSET (ComplexObjectClass, signal),
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE, 2, G_TYPE_UINT, G_TYPE_POINTER);
 
   pspecs[PROP_VAL1] = g_param_spec_int ("val1", "val1", "val1",
                                         0, G_MAXINT, 42,
@@ -454,8 +484,12 @@ struct ConstructionTest {
   GObject **objects;
   int n_objects;
   GType type;
+  GObjectPreparedNew *prepared;
+  GValue values[2];
 };
 
+static const char *complex_construction_names[] = { "val1", "val2" };
+
 static gpointer
 test_construction_setup (PerformanceTest *test)
 {
@@ -467,6 +501,17 @@ test_construction_setup (PerformanceTest *test)
   return data;
 }
 
+static gpointer
+test_pooled_construction_setup (PerformanceTest *test)
+{
+  struct ConstructionTest *data;
+
+  data = test_construction_setup (test);
+  g_type_set_instance_pool_size (data->type, NUM_OBJECT_TO_CONSTRUCT);
+
+  return data;
+}
+
 static void
 test_construction_init (PerformanceTest *test,
 			gpointer _data,
@@ -560,6 +605,37 @@ test_complex_construction_run2 (PerformanceTest *test,
     }
 }
 
+static void
+test_complex_construction_run_with_properties (PerformanceTest *test,
+                                               gpointer _data)
+{
+  struct ConstructionTest *data = _data;
+  GObject **objects = data->objects;
+  GType type = data->type;
+  int i, n_objects;
+
+  n_objects = data->n_objects;
+  for (i = 0; i < n_objects; i++)
+    objects[i] = g_object_new_with_properties (type,
+                                               G_N_ELEMENTS (complex_construction_names),
+                                               complex_construction_names,
+                                               data->values);
+}
+
+static void
+test_complex_construction_run_prepared (PerformanceTest *test,
+                                        gpointer _data)
+{
+  struct ConstructionTest *data = _data;
+  GObject **objects = data->objects;
+  GObjectPreparedNew *prepared = data->prepared;
+  int i, n_objects;
+
+  n_objects = data->n_objects;
+  for (i = 0; i < n_objects; i++)
+    objects[i] = g_object_new_prepared (prepared, data->values);
+}
+
 static void
 test_construction_finish (PerformanceTest *test,
 			  gpointer _data)
@@ -582,6 +658,23 @@ test_construction_finish1 (PerformanceTest *test,
     g_slice_free (SimpleObject, (SimpleObject *)data->objects[i]);
 }
 
+static gpointer
+test_complex_construction_values_setup (PerformanceTest *test)
+{
+  struct ConstructionTest *data;
+
+  data = test_construction_setup (test);
+  data->prepared = g_object_prepare_new (data->type,
+                                         G_N_ELEMENTS (complex_construction_names),
+                                         complex_construction_names);
+  g_value_init (&data->values[0], G_TYPE_INT);
+  g_value_set_int (&data->values[0], 5);
+  g_value_init (&data->values[1], G_TYPE_STRING);
+  g_value_set_static_string (&data->values[1], "thousand");
+
+  return data;
+}
+
 static void
 test_construction_teardown (PerformanceTest *test,
 			    gpointer _data)
@@ -591,6 +684,18 @@ test_construction_teardown (PerformanceTest *test,
   g_free (data);
 }
 
+static void
+test_complex_construction_values_teardown (PerformanceTest *test,
+                                           gpointer _data)
+{
+  struct ConstructionTest *data = _data;
+
+  g_value_unset (&data->values[0]);
+  g_value_unset (&data->values[1]);
+  g_object_prepared_new_free (data->prepared);
+  test_construction_teardown (test, data);
+}
+
 static void
 test_finalization_init (PerformanceTest *test,
 			gpointer _data,
@@ -755,6 +860,9 @@ struct EmissionTest {
   GObject *object;
   int n_checks;
   int signal_id;
+  GObject **objects;
+  int n_objects;
+  int next_object;
 };
 
 static void
@@ -781,6 +889,34 @@ test_emission_run_args (PerformanceTest *test,
     g_signal_emit (object, data->signal_id, 0, 0, NULL);
 }
 
+static void
+test_emission_run_many (PerformanceTest *test,
+                        gpointer _data)
+{
+  struct EmissionTest *data = _data;
+  int i;
+
+  for (i = 0; i < data->n_checks; i++)
+    {
+      g_signal_emit (data->objects[data->next_object], data->signal_id, 0);
+      data->next_object = (data->next_object + 1) % data->n_objects;
+    }
+}
+
+static void
+test_emission_run_many_args (PerformanceTest *test,
+                             gpointer _data)
+{
+  struct EmissionTest *data = _data;
+  int i;
+
+  for (i = 0; i < data->n_checks; i++)
+    {
+      g_signal_emit (data->objects[data->next_object], data->signal_id, 0, 0, NULL);
+      data->next_object = (data->next_object + 1) % data->n_objects;
+    }
+}
+
 /*************************************************************
  * Test signal unhandled emissions performance
  *************************************************************/
@@ -865,6 +1001,9 @@ test_emission_handled_setup (PerformanceTest *test)
   g_signal_connect (data->object, "signal-args",
                     G_CALLBACK (test_emission_handled_handler),
                     NULL);
+  g_signal_connect (data->object, "signal-generic-args",
+                    G_CALLBACK (test_emission_handled_handler),
+                    NULL);
 
   return data;
 }
@@ -906,6 +1045,48 @@ test_emission_handled_teardown (PerformanceTest *test,
   g_free (data);
 }
 
+/*************************************************************
+ * Test signal handled emissions performance, with many live
+ * instances that have handlers connected
+ *************************************************************/
+
+#define NUM_EMISSION_INSTANCES (1024 * 1024)
+
+static gpointer
+test_emission_handled_many_setup (PerformanceTest *test)
+{
+  struct EmissionTest *data;
+  const char *signal_name;
+  int i;
+
+  data = test_emission_handled_setup (test);
+  signal_name = g_signal_name (data->signal_id);
+  data->n_objects = NUM_EMISSION_INSTANCES;
+  data->objects = g_new (GObject *, data->n_objects);
+  for (i = 0; i < data->n_objects; i++)
+    {
+      data->objects[i] = g_object_new (COMPLEX_TYPE_OBJECT, NULL);
+      g_signal_connect (data->objects[i], signal_name,
+                        G_CALLBACK (test_emission_handled_handler),
+                        NULL);
+    }
+
+  return data;
+}
+
+static void
+test_emission_handled_many_teardown (PerformanceTest *test,
+                                     gpointer _data)
+{
+  struct EmissionTest *data = _data;
+  int i;
+
+  for (i = 0; i < data->n_objects; i++)
+    g_object_unref (data->objects[i]);
+  g_free (data->objects);
+  test_emission_handled_teardown (test, data);
+}
+
 /*************************************************************
  * Test object refcount performance
  *************************************************************/
@@ -1003,6 +1184,16 @@ static PerformanceTest tests[] = {
     test_construction_teardown,
     test_construction_print_result
   },
+  {
+    "simple-construction-pooled",
+    pooled_object_get_type,
+    test_pooled_construction_setup,
+    test_construction_init,
+    test_construction_run,
+    test_construction_finish,
+    test_construction_teardown,
+    test_construction_print_result
+  },
   {
     "simple-construction1",
     simple_object_get_type,
@@ -1023,6 +1214,26 @@ static PerformanceTest tests[] = {
     test_construction_teardown,
     test_construction_print_result
   },
+  {
+    "complex-construction-with-properties",
+    complex_object_get_type,
+    test_complex_construction_values_setup,
+    test_construction_init,
+    test_complex_construction_run_with_properties,
+    test_construction_finish,
+    test_complex_construction_values_teardown,
+    test_construction_print_result
+  },
+  {
+    "complex-construction-prepared",
+    complex_object_get_type,
+    test_complex_construction_values_setup,
+    test_construction_init,
+    test_complex_construction_run_prepared,
+    test_construction_finish,
+    test_complex_construction_values_teardown,
+    test_construction_print_result
+  },
   {
     "complex-construction1",
     complex_object_get_type,
@@ -1053,6 +1264,16 @@ static PerformanceTest tests[] = {
     test_construction_teardown,
     test_finalization_print_result
   },
+  {
+    "finalization-pooled",
+    pooled_object_get_type,
+    test_pooled_construction_setup,
+    test_finalization_init,
+    test_finalization_run,
+    test_finalization_finish,
+    test_construction_teardown,
+    test_finalization_print_result
+  },
   {
     "type-check",
     NULL,
@@ -1113,6 +1334,16 @@ static PerformanceTest tests[] = {
     test_emission_unhandled_teardown,
     test_emission_unhandled_print_result
   },
+  {
+    "emit-unhandled-generic-args",
+    GINT_TO_POINTER (COMPLEX_SIGNAL_GENERIC_ARGS),
+    test_emission_unhandled_setup,
+    test_emission_unhandled_init,
+    test_emission_run_args,
+    test_emission_unhandled_finish,
+    test_emission_unhandled_teardown,
+    test_emission_unhandled_print_result
+  },
   {
     "emit-handled",
     GINT_TO_POINTER (COMPLEX_SIGNAL),
@@ -1163,6 +1394,66 @@ static PerformanceTest tests[] = {
     test_emission_handled_teardown,
     test_emission_handled_print_result
   },
+  {
+    "emit-handled-generic-args",
+    GINT_TO_POINTER (COMPLEX_SIGNAL_GENERIC_ARGS),
+    test_emission_handled_setup,
+    test_emission_handled_init,
+    test_emission_run_args,
+    test_emission_handled_finish,
+    test_emission_handled_teardown,
+    test_emission_handled_print_result
+  },
+  {
+    "emit-handled-many",
+    GINT_TO_POINTER (COMPLEX_SIGNAL),
+    test_emission_handled_many_setup,
+    test_emission_handled_init,
+    test_emission_run_many,
+    test_emission_handled_finish,
+    test_emission_handled_many_teardown,
+    test_emission_handled_print_result
+  },
+  {
+    "emit-handled-empty-many",
+    GINT_TO_POINTER (COMPLEX_SIGNAL_EMPTY),
+    test_emission_handled_many_setup,
+    test_emission_handled_init,
+    test_emission_run_many,
+    test_emission_handled_finish,
+    test_emission_handled_many_teardown,
+    test_emission_handled_print_result
+  },
+  {
+    "emit-handled-generic-many",
+    GINT_TO_POINTER (COMPLEX_SIGNAL_GENERIC),
+    test_emission_handled_many_setup,
+    test_emission_handled_init,
+    test_emission_run_many,
+    test_emission_handled_finish,
+    test_emission_handled_many_teardown,
+    test_emission_handled_print_result
+  },
+  {
+    "emit-handled-generic-empty-many",
+    GINT_TO_POINTER (COMPLEX_SIGNAL_GENERIC_EMPTY),
+    test_emission_handled_many_setup,
+    test_emission_handled_init,
+    test_emission_run_many,
+    test_emission_handled_finish,
+    test_emission_handled_many_teardown,
+    test_emission_handled_print_result
+  },
+  {
+    "emit-handled-args-many",
+    GINT_TO_POINTER (COMPLEX_SIGNAL_ARGS),
+    test_emission_handled_many_setup,
+    test_emission_handled_init,
+    test_emission_run_many_args,
+    test_emission_handled_finish,
+    test_emission_handled_many_teardown,
+    test_emission_handled_print_result
+  },
   {
     "refcount",
     NULL,
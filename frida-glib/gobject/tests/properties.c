@@ -821,6 +821,208 @@ properties_testv_notify_queue (void)
   g_object_unref (test_obj);
 }
 
+typedef struct {
+  GObject parent_instance;
+  int id;
+  char *name;
+  int count;
+  guint n_notify_id;
+  guint n_notify_name;
+  guint n_notify_count;
+} ConstructProps;
+
+typedef GObjectClass ConstructPropsClass;
+
+enum {
+  CONSTRUCT_PROP_0,
+  CONSTRUCT_PROP_ID,
+  CONSTRUCT_PROP_NAME,
+  CONSTRUCT_PROP_COUNT,
+  N_CONSTRUCT_PROPS
+};
+
+static GParamSpec *construct_props[N_CONSTRUCT_PROPS];
+
+GType construct_props_get_type (void) G_GNUC_CONST;
+
+G_DEFINE_TYPE (ConstructProps, construct_props, G_TYPE_OBJECT)
+
+static void
+construct_props_init (ConstructProps *self)
+{
+}
+
+static void
+construct_props_finalize (GObject *object)
+{
+  ConstructProps *cp = (ConstructProps *) object;
+
+  g_free (cp->name);
+
+  G_OBJECT_CLASS (construct_props_parent_class)->finalize (object);
+}
+
+static void
+construct_props_get_property (GObject    *object,
+                              guint       prop_id,
+                              GValue     *value,
+                              GParamSpec *pspec)
+{
+  ConstructProps *cp = (ConstructProps *) object;
+
+  switch (prop_id)
+    {
+    case CONSTRUCT_PROP_ID:
+      g_value_set_int (value, cp->id);
+      break;
+    case CONSTRUCT_PROP_NAME:
+      g_value_set_string (value, cp->name);
+      break;
+    case CONSTRUCT_PROP_COUNT:
+      g_value_set_int (value, cp->count);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+construct_props_set_property (GObject      *object,
+                              guint         prop_id,
+                              const GValue *value,
+                              GParamSpec   *pspec)
+{
+  ConstructProps *cp = (ConstructProps *) object;
+
+  switch (prop_id)
+    {
+    case CONSTRUCT_PROP_ID:
+      cp->id = g_value_get_int (value);
+      break;
+    case CONSTRUCT_PROP_NAME:
+      g_free (cp->name);
+      cp->name = g_value_dup_string (value);
+      break;
+    case CONSTRUCT_PROP_COUNT:
+      cp->count = g_value_get_int (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+construct_props_notify (GObject    *object,
+                        GParamSpec *pspec)
+{
+  ConstructProps *cp = (ConstructProps *) object;
+
+  if (pspec == construct_props[CONSTRUCT_PROP_ID])
+    cp->n_notify_id++;
+  else if (pspec == construct_props[CONSTRUCT_PROP_NAME])
+    cp->n_notify_name++;
+  else if (pspec == construct_props[CONSTRUCT_PROP_COUNT])
+    cp->n_notify_count++;
+}
+
+static void
+construct_props_class_init (ConstructPropsClass *class)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (class);
+
+  gobject_class->finalize = construct_props_finalize;
+  gobject_class->get_property = construct_props_get_property;
+  gobject_class->set_property = construct_props_set_property;
+  gobject_class->notify = construct_props_notify;
+
+  construct_props[CONSTRUCT_PROP_ID] =
+      g_param_spec_int ("id", NULL, NULL,
+                        0, 100, 7,
+                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+  construct_props[CONSTRUCT_PROP_NAME] =
+      g_param_spec_string ("name", NULL, NULL,
+                           "unnamed",
+                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS);
+  construct_props[CONSTRUCT_PROP_COUNT] =
+      g_param_spec_int ("count", NULL, NULL,
+                        0, 100, 0,
+                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_properties (gobject_class, N_CONSTRUCT_PROPS, construct_props);
+}
+
+static void
+properties_prepared_new (void)
+{
+  const char *names[] = { "count", "id", "bogus" };
+  GObjectPreparedNew *prepared;
+  GValue values[3] = { G_VALUE_INIT, G_VALUE_INIT, G_VALUE_INIT };
+  ConstructProps *obj;
+  TestObject *test_obj;
+  guint n_notify_id, n_notify_name, n_notify_count;
+
+  g_test_summary ("g_object_new_prepared() sets the same properties, and "
+                  "emits the same notifications, as "
+                  "g_object_new_with_properties()");
+
+  g_test_expect_message ("GLib-GObject", G_LOG_LEVEL_CRITICAL,
+                         "*has no property named 'bogus'*");
+  prepared = g_object_prepare_new (construct_props_get_type (),
+                                   G_N_ELEMENTS (names), names);
+  g_test_assert_expected_messages ();
+
+  g_value_set_int (g_value_init (&values[0], G_TYPE_INT), 3);
+  g_value_set_int (g_value_init (&values[1], G_TYPE_INT), 42);
+
+  obj = (ConstructProps *) g_object_new_with_properties (construct_props_get_type (),
+                                                        2, names, values);
+  n_notify_id = obj->n_notify_id;
+  n_notify_name = obj->n_notify_name;
+  n_notify_count = obj->n_notify_count;
+  g_object_unref (obj);
+
+  obj = (ConstructProps *) g_object_new_prepared (prepared, values);
+  g_assert_cmpint (obj->id, ==, 42);
+  g_assert_cmpstr (obj->name, ==, "unnamed");
+  g_assert_cmpint (obj->count, ==, 3);
+  g_assert_cmpuint (obj->n_notify_id, ==, 1);
+  g_assert_cmpuint (obj->n_notify_name, ==, 1);
+  g_assert_cmpuint (obj->n_notify_count, ==, 1);
+  g_assert_cmpuint (obj->n_notify_id, ==, n_notify_id);
+  g_assert_cmpuint (obj->n_notify_name, ==, n_notify_name);
+  g_assert_cmpuint (obj->n_notify_count, ==, n_notify_count);
+  g_object_unref (obj);
+
+  /* Values of another type than the property's are converted. */
+  g_value_unset (&values[1]);
+  g_value_set_uint (g_value_init (&values[1], G_TYPE_UINT), 99);
+
+  obj = (ConstructProps *) g_object_new_prepared (prepared, values);
+  g_assert_cmpint (obj->id, ==, 99);
+  g_assert_cmpint (obj->count, ==, 3);
+  g_object_unref (obj);
+
+  g_value_unset (&values[0]);
+  g_value_unset (&values[1]);
+  g_object_prepared_new_free (prepared);
+
+  /* Properties installed on TestObject have no construct flags. */
+  names[0] = "baz";
+  names[1] = "foo";
+  prepared = g_object_prepare_new (test_object_get_type (), 2, names);
+  g_value_set_static_string (g_value_init (&values[0], G_TYPE_STRING), "prepared");
+  g_value_set_int (g_value_init (&values[1], G_TYPE_INT), 17);
+
+  test_obj = (TestObject *) g_object_new_prepared (prepared, values);
+  g_assert_cmpstr (test_obj->baz, ==, "prepared");
+  g_assert_cmpint (test_obj->foo, ==, 17);
+  g_assert_true (test_obj->bar);
+  g_object_unref (test_obj);
+
+  g_value_unset (&values[0]);
+  g_value_unset (&values[1]);
+  g_object_prepared_new_free (prepared);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -845,6 +1047,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/properties/testv_getv", properties_testv_getv);
   g_test_add_func ("/properties/testv_notify_queue",
       properties_testv_notify_queue);
+  g_test_add_func ("/properties/prepared-new", properties_prepared_new);
 
   return g_test_run ();
 }
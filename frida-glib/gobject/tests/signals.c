@@ -351,6 +351,28 @@ test_class_init (TestClass *klass)
                 0);
   g_signal_set_va_marshaller (s, G_TYPE_FROM_CLASS (klass),
 			      test_INT__VOIDv);
+  g_signal_new ("generic-marshaller-specialised",
+                G_TYPE_FROM_CLASS (klass),
+                G_SIGNAL_RUN_LAST,
+                0,
+                NULL, NULL,
+                NULL,
+                G_TYPE_BOOLEAN,
+                4,
+                G_TYPE_INT64,
+                test_enum_get_type (),
+                G_TYPE_DOUBLE,
+                G_TYPE_POINTER);
+  g_signal_new ("generic-marshaller-interface-arg",
+                G_TYPE_FROM_CLASS (klass),
+                G_SIGNAL_RUN_LAST,
+                0,
+                NULL, NULL,
+                NULL,
+                G_TYPE_NONE,
+                2,
+                foo_get_type (),
+                G_TYPE_INT);
   g_signal_new ("generic-marshaller-uint-return",
                 G_TYPE_FROM_CLASS (klass),
                 G_SIGNAL_RUN_LAST,
@@ -652,6 +674,61 @@ test_generic_marshaller_signal_2 (void)
   g_object_unref (test);
 }
 
+static void
+on_generic_marshaller_2_count (Test             *obj,
+                               gint              v_int1,
+                               TestEnum          v_enum,
+                               gint              v_int2,
+                               TestUnsignedEnum  v_uenum,
+                               gint              v_int3,
+                               gpointer          data)
+{
+  guint *count = data;
+
+  on_generic_marshaller_2 (obj, v_int1, v_enum, v_int2, v_uenum, v_int3);
+  (*count)++;
+}
+
+static void
+on_generic_marshaller_2_stop (Test             *obj,
+                              gint              v_int1,
+                              TestEnum          v_enum,
+                              gint              v_int2,
+                              TestUnsignedEnum  v_uenum,
+                              gint              v_int3,
+                              gpointer          data)
+{
+  g_signal_stop_emission_by_name (obj, "generic-marshaller-2");
+}
+
+/* Several handlers for a signal with only plain parameters, which are
+ * invoked straight from the va_list */
+static void
+test_generic_marshaller_signal_2_multiple (void)
+{
+  Test *test;
+  guint count = 0;
+  gulong blocked;
+
+  test = g_object_new (test_get_type (), NULL);
+
+  g_signal_connect (test, "generic-marshaller-2", G_CALLBACK (on_generic_marshaller_2_count), &count);
+  blocked = g_signal_connect (test, "generic-marshaller-2", G_CALLBACK (on_generic_marshaller_2_count), &count);
+  g_signal_connect (test, "generic-marshaller-2", G_CALLBACK (on_generic_marshaller_2_count), &count);
+  g_signal_connect_after (test, "generic-marshaller-2", G_CALLBACK (on_generic_marshaller_2_count), &count);
+  g_signal_handler_block (test, blocked);
+
+  g_signal_emit_by_name (test, "generic-marshaller-2", 42, TEST_ENUM_BAR, 43, TEST_UNSIGNED_ENUM_BAR, 44);
+  g_assert_cmpuint (count, ==, 3);
+
+  g_signal_connect (test, "generic-marshaller-2", G_CALLBACK (on_generic_marshaller_2_stop), NULL);
+
+  g_signal_emit_by_name (test, "generic-marshaller-2", 42, TEST_ENUM_BAR, 43, TEST_UNSIGNED_ENUM_BAR, 44);
+  g_assert_cmpuint (count, ==, 5);
+
+  g_object_unref (test);
+}
+
 static TestEnum
 on_generic_marshaller_enum_return_signed_1 (Test *obj)
 {
@@ -893,6 +970,99 @@ test_generic_marshaller_signal_interface_return (void)
   g_object_unref (test);
 }
 
+static gboolean
+on_generic_marshaller_specialised (Test     *obj,
+                                   gint64    v_int64,
+                                   TestEnum  v_enum,
+                                   gdouble   v_double,
+                                   gpointer  v_pointer,
+                                   gpointer  user_data)
+{
+  g_assert_cmpint (v_int64, ==, G_MININT64 + 1);
+  g_assert_cmpint (v_enum, ==, TEST_ENUM_NEGATIVE);
+  g_assert_cmpfloat (v_double, ==, -0.5);
+  g_assert_true (v_pointer == user_data);
+
+  return TRUE;
+}
+
+static void
+test_generic_marshaller_signal_specialised (void)
+{
+  Test *test;
+  guint id;
+  gboolean retval = FALSE;
+  GValue args[5] = { G_VALUE_INIT, };
+  GValue return_value = G_VALUE_INIT;
+  guint i;
+
+  test = g_object_new (test_get_type (), NULL);
+
+  id = g_signal_connect (test,
+                         "generic-marshaller-specialised",
+                         G_CALLBACK (on_generic_marshaller_specialised),
+                         &retval);
+  g_signal_emit_by_name (test, "generic-marshaller-specialised",
+                         G_MININT64 + 1, TEST_ENUM_NEGATIVE, -0.5, &retval,
+                         &retval);
+  g_assert_true (retval);
+
+  /* Same test without the va_list fast path */
+  g_value_init_from_instance (&args[0], test);
+  g_value_set_int64 (g_value_init (&args[1], G_TYPE_INT64), G_MININT64 + 1);
+  g_value_set_enum (g_value_init (&args[2], test_enum_get_type ()), TEST_ENUM_NEGATIVE);
+  g_value_set_double (g_value_init (&args[3], G_TYPE_DOUBLE), -0.5);
+  g_value_set_pointer (g_value_init (&args[4], G_TYPE_POINTER), &retval);
+  g_value_init (&return_value, G_TYPE_BOOLEAN);
+  g_signal_emitv (args, g_signal_lookup ("generic-marshaller-specialised", test_get_type ()),
+                  0, &return_value);
+  g_assert_true (g_value_get_boolean (&return_value));
+
+  for (i = 0; i < G_N_ELEMENTS (args); i++)
+    g_value_unset (&args[i]);
+  g_signal_handler_disconnect (test, id);
+
+  g_object_unref (test);
+}
+
+static void
+on_generic_marshaller_interface_arg (Test     *obj,
+                                     GObject  *v_foo,
+                                     gint      v_int,
+                                     gpointer  user_data)
+{
+  GObject **weak_foo = user_data;
+
+  g_assert_cmpint (v_int, ==, 42);
+
+  /* the emission holds a reference of its own until this returns */
+  g_object_unref (v_foo);
+  g_assert_nonnull (*weak_foo);
+  g_assert_true (G_TYPE_CHECK_INSTANCE_TYPE (v_foo, foo_get_type ()));
+}
+
+static void
+test_generic_marshaller_signal_interface_arg (void)
+{
+  Test *test;
+  GObject *foo;
+  gulong id;
+
+  test = g_object_new (test_get_type (), NULL);
+  foo = g_object_new (baa_get_type (), NULL);
+  g_object_add_weak_pointer (foo, (gpointer *) &foo);
+
+  /* a single handler, so that the va_list marshaller gets used, and a
+   * second argument, so that it is not the built-in VOID:OBJECT one */
+  id = g_signal_connect (test, "generic-marshaller-interface-arg",
+                         G_CALLBACK (on_generic_marshaller_interface_arg), &foo);
+  g_signal_emit_by_name (test, "generic-marshaller-interface-arg", foo, 42);
+  g_assert_null (foo);
+
+  g_signal_handler_disconnect (test, id);
+  g_object_unref (test);
+}
+
 static const GSignalInvocationHint dont_use_this = { 0, };
 
 static void
@@ -1390,6 +1560,8 @@ test_introspection (void)
     "generic-marshaller-enum-return-unsigned",
     "generic-marshaller-int-return",
     "va-marshaller-int-return",
+    "generic-marshaller-specialised",
+    "generic-marshaller-interface-arg",
     "generic-marshaller-uint-return",
     "generic-marshaller-interface-return",
     "va-marshaller-uint-return",
@@ -1529,6 +1701,36 @@ test_stop_emission (void)
   g_object_unref (test1);
 }
 
+static void
+test_handlers_destroy (void)
+{
+  GObject *test_obj;
+  gulong handler1, handler2;
+  gint count1 = 0, count2 = 0;
+
+  test_obj = g_object_new (test_get_type (), NULL);
+
+  handler1 = g_signal_connect (test_obj, "simple", G_CALLBACK (test_handler), &count1);
+  g_signal_connect (test_obj, "simple-2", G_CALLBACK (test_handler), &count1);
+  g_signal_emit_by_name (test_obj, "simple");
+  g_assert_cmpint (count1, ==, 1);
+
+  /* disposing disconnects everything, but the object can still be used */
+  g_object_run_dispose (test_obj);
+  g_assert_false (g_signal_handler_is_connected (test_obj, handler1));
+  g_signal_emit_by_name (test_obj, "simple");
+  g_signal_emit_by_name (test_obj, "simple-2");
+  g_assert_cmpint (count1, ==, 1);
+
+  handler2 = g_signal_connect (test_obj, "simple", G_CALLBACK (test_handler), &count2);
+  g_signal_emit_by_name (test_obj, "simple");
+  g_assert_cmpint (count1, ==, 1);
+  g_assert_cmpint (count2, ==, 1);
+  g_assert_true (g_signal_handler_is_connected (test_obj, handler2));
+
+  g_object_unref (test_obj);
+}
+
 static void
 test_signal_disconnect_wrong_object (void)
 {
@@ -1801,11 +2003,14 @@ main (int argc,
   g_test_add_func ("/gobject/signals/destroy-target-object", test_destroy_target_object);
   g_test_add_func ("/gobject/signals/generic-marshaller-1", test_generic_marshaller_signal_1);
   g_test_add_func ("/gobject/signals/generic-marshaller-2", test_generic_marshaller_signal_2);
+  g_test_add_func ("/gobject/signals/generic-marshaller-2-multiple", test_generic_marshaller_signal_2_multiple);
   g_test_add_func ("/gobject/signals/generic-marshaller-enum-return-signed", test_generic_marshaller_signal_enum_return_signed);
   g_test_add_func ("/gobject/signals/generic-marshaller-enum-return-unsigned", test_generic_marshaller_signal_enum_return_unsigned);
   g_test_add_func ("/gobject/signals/generic-marshaller-int-return", test_generic_marshaller_signal_int_return);
   g_test_add_func ("/gobject/signals/generic-marshaller-uint-return", test_generic_marshaller_signal_uint_return);
   g_test_add_func ("/gobject/signals/generic-marshaller-interface-return", test_generic_marshaller_signal_interface_return);
+  g_test_add_func ("/gobject/signals/generic-marshaller-specialised", test_generic_marshaller_signal_specialised);
+  g_test_add_func ("/gobject/signals/generic-marshaller-interface-arg", test_generic_marshaller_signal_interface_arg);
   g_test_add_func ("/gobject/signals/custom-marshaller", test_custom_marshaller);
   g_test_add_func ("/gobject/signals/connect", test_connect);
   g_test_add_func ("/gobject/signals/emission-hook", test_emission_hook);
@@ -1815,6 +2020,7 @@ main (int argc,
   g_test_add_func ("/gobject/signals/block-handler", test_block_handler);
   g_test_add_func ("/gobject/signals/stop-emission", test_stop_emission);
   g_test_add_func ("/gobject/signals/invocation-hint", test_invocation_hint);
+  g_test_add_func ("/gobject/signals/handlers-destroy", test_handlers_destroy);
   g_test_add_func ("/gobject/signals/test-disconnection-wrong-object", test_signal_disconnect_wrong_object);
   g_test_add_func ("/gobject/signals/clear-signal-handler", test_clear_signal_handler);
   g_test_add_func ("/gobject/signals/lookup", test_lookup);
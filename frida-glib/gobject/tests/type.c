@@ -215,6 +215,106 @@ test_is_a (void)
   g_assert_false ((g_type_is_a) (bar_get_type (), bibi_get_type ()));
 }
 
+typedef struct {
+  GObject parent;
+  gint value;
+} Pooled;
+
+typedef struct {
+  GObjectClass parent_class;
+} PooledClass;
+
+typedef struct {
+  gint private_value;
+} PooledPrivate;
+
+GType pooled_get_type (void);
+
+G_DEFINE_TYPE_WITH_PRIVATE (Pooled, pooled, G_TYPE_OBJECT)
+
+static void
+pooled_class_init (PooledClass *klass)
+{
+}
+
+static void
+pooled_init (Pooled *self)
+{
+  PooledPrivate *priv = pooled_get_instance_private (self);
+
+  g_assert_cmpint (self->value, ==, 0);
+  g_assert_cmpint (priv->private_value, ==, 0);
+
+  self->value = 42;
+}
+
+static gpointer
+unref_in_thread (gpointer data)
+{
+  g_object_unref (data);
+
+  return NULL;
+}
+
+/* Test that instances of a pooled type are recycled, and come back
+ * zeroed and initialized as if freshly allocated
+ */
+static void
+test_instance_pool (void)
+{
+  Pooled *objects[3];
+  gpointer freed[2];
+  Pooled *recycled;
+  GThread *thread;
+  guint i;
+
+  g_type_set_instance_pool_size (pooled_get_type (), 2);
+
+  for (i = 0; i < G_N_ELEMENTS (objects); i++)
+    {
+      PooledPrivate *priv;
+
+      objects[i] = g_object_new (pooled_get_type (), NULL);
+      priv = pooled_get_instance_private (objects[i]);
+      priv->private_value = 7;
+      objects[i]->value = 13;
+    }
+
+  freed[0] = objects[0];
+  freed[1] = objects[1];
+  for (i = 0; i < G_N_ELEMENTS (objects); i++)
+    g_object_unref (objects[i]);
+
+  /* Only two instances fit in the pool, and both come back. */
+  for (i = 0; i < 2; i++)
+    {
+      PooledPrivate *priv;
+
+      objects[i] = g_object_new (pooled_get_type (), NULL);
+      g_assert_true ((gpointer) objects[i] == freed[0] ||
+                     (gpointer) objects[i] == freed[1]);
+      priv = pooled_get_instance_private (objects[i]);
+      g_assert_cmpint (objects[i]->value, ==, 42);
+      g_assert_cmpint (priv->private_value, ==, 0);
+    }
+  g_assert_true (objects[0] != objects[1]);
+
+  /* Instances freed on another thread go to that thread's pool, which
+   * is released when the thread exits.
+   */
+  thread = g_thread_new ("unref", unref_in_thread, objects[0]);
+  g_thread_join (thread);
+
+  recycled = g_object_new (pooled_get_type (), NULL);
+  g_assert_cmpint (recycled->value, ==, 42);
+
+  g_type_set_instance_pool_size (pooled_get_type (), 0);
+  g_object_unref (recycled);
+  g_object_unref (objects[1]);
+
+  g_assert_nonnull (g_type_class_peek (pooled_get_type ()));
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -225,6 +325,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/type/interface-check", test_interface_check);
   g_test_add_func ("/type/next-base", test_next_base);
   g_test_add_func ("/type/is-a", test_is_a);
+  g_test_add_func ("/type/instance-pool", test_instance_pool);
 
   return g_test_run ();
 }